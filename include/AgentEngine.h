@@ -0,0 +1,791 @@
+/**
+ * @file AgentEngine.h
+ * @brief In-process engine running the warehouse roles as 100k agents.
+ *
+ * The role binaries give every worker and truck its own process blocked in
+ * System V calls, which caps a simulation at a few dozen of them. The
+ * engine runs the same roles as resumable agents over one in-process
+ * SharedState: an agent runs until it would block, records where to
+ * continue and returns; the event it waits for puts it back on a run queue.
+ * A small pool of threads, each with its own queue and stealing from the
+ * others when idle, resumes whichever agents are ready.
+ *
+ * Suspension points replace the blocking calls of the processes:
+ * - belt slots and packages: AgentSemaphore (SEM_EMPTY_SLOTS/SEM_FULL_SLOTS),
+ * - the dock: an AgentSemaphore of one permit, handed from the departing
+ *   truck to the next queued one (the processes poll every second),
+ * - a docked truck: its mailbox, filled by the loaders' send callback (the
+ *   message queue),
+ * - a dispatcher holding a package that does not fit: AgentEvent of the
+ *   next docking (the processes retry every 200 ms),
+ * - arrivals, routes and the express period: the engine's timers.
+ *
+ * Belt, the fit check (DockController), package and truck generation
+ * (drawPackage, dockTruck) and the express batch (Express) are the code the
+ * processes run; only the waits differ.
+ *
+ * Agents are stackless state machines: the tree is C++17, so instead of
+ * coroutines each `resume` is a switch over the agent's resume points. A
+ * wait that returns false has suspended the agent, and `resume` must return
+ * without touching it again: another thread may already be running it.
+ */
+#pragma once
+
+#include "ArrivalProcess.h"
+#include "Belt.h"
+#include "DockController.h"
+#include "Express.h"
+#include "Probes.h"
+#include "Shared.h"
+#include "Telemetry.h"
+#include "Truck.h"
+#include "Worker.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief splitmix64 random engine (8 bytes of state).
+ *
+ * Satisfies UniformRandomBitGenerator. A Mersenne Twister per agent would
+ * cost 2.5-5 KB each, more than the rest of the agent by far.
+ */
+class SplitMix64 {
+private:
+  uint64_t state;
+
+public:
+  using result_type = uint64_t;
+
+  explicit SplitMix64(uint64_t seed = 1) : state(seed) {}
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return ~result_type{0}; }
+
+  result_type operator()() {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+};
+
+class AgentEngine;
+
+/**
+ * @class Agent
+ * @brief A resumable role instance.
+ */
+class Agent {
+public:
+  virtual ~Agent() = default;
+
+  /** @brief Runs the agent from `pc` until it suspends. */
+  virtual void resume(AgentEngine &engine) = 0;
+
+protected:
+  int pc = 0; /**< Resume point, an agent-specific enum. */
+};
+
+/**
+ * @class AgentEngine
+ * @brief Work-stealing thread pool resuming ready agents.
+ *
+ * Every thread pops its own queue first; an idle thread moves due timers to
+ * its queue, then steals half of another thread's queue, then sleeps until
+ * the next timer or until an agent is scheduled.
+ */
+class AgentEngine {
+private:
+  /** @brief Ready agents of one thread. */
+  struct RunQueue {
+    std::mutex m;
+    std::deque<Agent *> q;
+  };
+
+  /** @brief A sleeping agent. */
+  struct Timer {
+    uint64_t due_ns;
+    Agent *agent;
+    bool operator>(const Timer &o) const { return due_ns > o.due_ns; }
+  };
+
+  std::vector<std::unique_ptr<RunQueue>> queues;
+  std::vector<std::thread> threads;
+  std::atomic<bool> running{false};
+  std::atomic<uint64_t> spread{0}; /**< Round robin for outside threads. */
+
+  /** @name Timers
+   * @{ */
+  std::mutex timer_m;
+  std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+  std::atomic<uint64_t> next_due{UINT64_MAX}; /**< Earliest due time. */
+  /** @} */
+
+  /** @name Idle Threads
+   * @{ */
+  std::mutex idle_m;
+  std::condition_variable idle_cv;
+  std::atomic<int> idle{0};     /**< Threads sleeping on `idle_cv`. */
+  std::atomic<int64_t> ready{0}; /**< Agents in the run queues. */
+  /** @} */
+
+  /** @name Statistics
+   * @{ */
+  std::atomic<uint64_t> resumes{0}; /**< Agent resumptions. */
+  std::atomic<uint64_t> steals{0};  /**< Agents taken from other queues. */
+  /** @} */
+
+  /** @brief Engine and queue of the calling pool thread. */
+  inline static thread_local AgentEngine *current = nullptr;
+  inline static thread_local int self = -1;
+
+  /** @brief Longest idle sleep; bounds the cost of a missed wake-up. */
+  static constexpr uint64_t IDLE_MAX_NS = 10000000;
+
+  void push(int q, Agent *a) {
+    {
+      std::lock_guard<std::mutex> lock(queues[q]->m);
+      queues[q]->q.push_back(a);
+    }
+    ready.fetch_add(1);
+    if (idle.load() > 0) {
+      std::lock_guard<std::mutex> lock(idle_m);
+      idle_cv.notify_one();
+    }
+  }
+
+  Agent *popLocal(int me) {
+    std::lock_guard<std::mutex> lock(queues[me]->m);
+    std::deque<Agent *> &q = queues[me]->q;
+    if (q.empty())
+      return nullptr;
+    Agent *a = q.front();
+    q.pop_front();
+    ready.fetch_sub(1);
+    return a;
+  }
+
+  /** @brief Takes half of another queue; returns one, keeps the rest. */
+  Agent *steal(int me, SplitMix64 &rng) {
+    int n = static_cast<int>(queues.size());
+    int start = static_cast<int>(rng() % n);
+    for (int i = 0; i < n; ++i) {
+      int victim = (start + i) % n;
+      if (victim == me)
+        continue;
+      std::vector<Agent *> taken;
+      {
+        std::lock_guard<std::mutex> lock(queues[victim]->m);
+        std::deque<Agent *> &q = queues[victim]->q;
+        size_t half = (q.size() + 1) / 2;
+        for (size_t k = 0; k < half; ++k) {
+          taken.push_back(q.back());
+          q.pop_back();
+        }
+      }
+      if (taken.empty())
+        continue;
+      steals.fetch_add(taken.size(), std::memory_order_relaxed);
+      ready.fetch_sub(1);
+      if (taken.size() > 1) {
+        std::lock_guard<std::mutex> lock(queues[me]->m);
+        queues[me]->q.insert(queues[me]->q.end(), taken.begin() + 1,
+                             taken.end());
+      }
+      return taken.front();
+    }
+    return nullptr;
+  }
+
+  /** @brief Moves the timers due by now to queue `me`. */
+  void fireTimers(int me) {
+    uint64_t now = monotonicNowNs();
+    if (now < next_due.load(std::memory_order_relaxed))
+      return;
+
+    std::vector<Agent *> due;
+    {
+      std::lock_guard<std::mutex> lock(timer_m);
+      while (!timers.empty() && timers.top().due_ns <= now) {
+        due.push_back(timers.top().agent);
+        timers.pop();
+      }
+      next_due.store(timers.empty() ? UINT64_MAX : timers.top().due_ns);
+    }
+    if (due.empty())
+      return;
+    {
+      std::lock_guard<std::mutex> lock(queues[me]->m);
+      queues[me]->q.insert(queues[me]->q.end(), due.begin(), due.end());
+    }
+    ready.fetch_add(static_cast<int64_t>(due.size()));
+    if (due.size() > 1 && idle.load() > 0) {
+      std::lock_guard<std::mutex> lock(idle_m);
+      idle_cv.notify_all();
+    }
+  }
+
+  /** @brief Sleeps until work is scheduled or the next timer is due. */
+  void park() {
+    std::unique_lock<std::mutex> lock(idle_m);
+    idle.fetch_add(1);
+    if (ready.load() <= 0 && running.load()) {
+      uint64_t now = monotonicNowNs();
+      uint64_t due = next_due.load();
+      uint64_t wait = due > now ? std::min(due - now, IDLE_MAX_NS) : 0;
+      if (wait > 0)
+        idle_cv.wait_for(lock, std::chrono::nanoseconds(wait));
+    }
+    idle.fetch_sub(1);
+  }
+
+  void loop(int me) {
+    current = this;
+    self = me;
+    SplitMix64 rng(me + 1);
+    uint64_t local_resumes = 0;
+
+    while (running.load(std::memory_order_relaxed)) {
+      fireTimers(me);
+      Agent *a = popLocal(me);
+      if (!a)
+        a = steal(me, rng);
+      if (!a) {
+        park();
+        continue;
+      }
+      a->resume(*this);
+      local_resumes++;
+    }
+
+    resumes.fetch_add(local_resumes);
+    current = nullptr;
+    self = -1;
+  }
+
+public:
+  /** @param thread_count Pool size (at least one). */
+  explicit AgentEngine(int thread_count) {
+    for (int i = 0; i < std::max(1, thread_count); ++i)
+      queues.push_back(std::make_unique<RunQueue>());
+  }
+
+  ~AgentEngine() { stop(); }
+
+  AgentEngine(const AgentEngine &) = delete;
+  AgentEngine &operator=(const AgentEngine &) = delete;
+
+  /**
+   * @brief Makes an agent ready.
+   *
+   * From a pool thread the agent goes to that thread's queue (it is likely
+   * to touch what the thread just touched); otherwise round robin.
+   */
+  void schedule(Agent *a) {
+    int n = static_cast<int>(queues.size());
+    int q = current == this ? self
+                            : static_cast<int>(spread.fetch_add(1) % n);
+    push(q, a);
+  }
+
+  /** @brief Suspends `a` until the monotonic time `due_ns`. */
+  void sleepUntil(Agent &a, uint64_t due_ns) {
+    std::lock_guard<std::mutex> lock(timer_m);
+    timers.push({due_ns, &a});
+    if (due_ns < next_due.load())
+      next_due.store(due_ns);
+  }
+
+  /** @brief Suspends `a` for `ns` nanoseconds. */
+  void sleepFor(Agent &a, uint64_t ns) {
+    sleepUntil(a, monotonicNowNs() + ns);
+  }
+
+  /** @brief Starts the pool; agents scheduled before start right away. */
+  void start() {
+    if (running.exchange(true))
+      return;
+    for (int i = 0; i < static_cast<int>(queues.size()); ++i)
+      threads.emplace_back([this, i]() { loop(i); });
+  }
+
+  /**
+   * @brief Stops and joins the pool.
+   * Suspended agents stay where they are; they are not resumed again.
+   */
+  void stop() {
+    if (!running.exchange(false))
+      return;
+    {
+      std::lock_guard<std::mutex> lock(idle_m);
+      idle_cv.notify_all();
+    }
+    for (std::thread &t : threads)
+      t.join();
+    threads.clear();
+  }
+
+  int threadCount() const { return static_cast<int>(queues.size()); }
+
+  /** @brief Resumptions so far (counted when the pool stops). */
+  uint64_t resumeCount() const { return resumes.load(); }
+
+  /** @brief Agents taken from another thread's queue. */
+  uint64_t stealCount() const { return steals.load(); }
+};
+
+/**
+ * @class AgentSemaphore
+ * @brief Counting semaphore whose waiters are suspended agents.
+ *
+ * `release` hands the permit directly to the oldest waiter, so a resumed
+ * agent owns it without re-checking.
+ */
+class AgentSemaphore {
+private:
+  AgentEngine *engine;
+  std::mutex m;
+  int permits;
+  std::deque<Agent *> waiters;
+
+public:
+  AgentSemaphore(AgentEngine *e, int initial) : engine(e), permits(initial) {}
+
+  /**
+   * @brief Takes a permit, or suspends `a` until one is handed to it.
+   * @return true if taken now; false if `a` is suspended.
+   */
+  bool acquire(Agent &a) {
+    std::lock_guard<std::mutex> lock(m);
+    if (permits > 0) {
+      permits--;
+      return true;
+    }
+    waiters.push_back(&a);
+    return false;
+  }
+
+  /** @brief Returns a permit, resuming the oldest waiter with it. */
+  void release() {
+    Agent *next = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(m);
+      if (waiters.empty()) {
+        permits++;
+      } else {
+        next = waiters.front();
+        waiters.pop_front();
+      }
+    }
+    if (next)
+      engine->schedule(next);
+  }
+
+  /** @brief Permits available (snapshot). */
+  int available() {
+    std::lock_guard<std::mutex> lock(m);
+    return permits;
+  }
+
+  /** @brief Agents suspended on the semaphore (snapshot). */
+  size_t waiting() {
+    std::lock_guard<std::mutex> lock(m);
+    return waiters.size();
+  }
+};
+
+/**
+ * @class AgentEvent
+ * @brief Broadcast event with a generation count.
+ *
+ * A waiter reads `generation()` before checking its condition and passes it
+ * to `wait`; a notification in between makes `wait` return true instead of
+ * being lost.
+ */
+class AgentEvent {
+private:
+  AgentEngine *engine;
+  std::mutex m;
+  uint64_t gen = 0;
+  std::vector<Agent *> waiters;
+
+public:
+  explicit AgentEvent(AgentEngine *e) : engine(e) {}
+
+  uint64_t generation() {
+    std::lock_guard<std::mutex> lock(m);
+    return gen;
+  }
+
+  /**
+   * @brief Suspends `a` until the generation moves past `seen`.
+   * @return true if it already has; false if `a` is suspended.
+   */
+  bool wait(Agent &a, uint64_t seen) {
+    std::lock_guard<std::mutex> lock(m);
+    if (gen != seen)
+      return true;
+    waiters.push_back(&a);
+    return false;
+  }
+
+  /** @brief Advances the generation and resumes every waiter. */
+  void notifyAll() {
+    std::vector<Agent *> woken;
+    {
+      std::lock_guard<std::mutex> lock(m);
+      gen++;
+      woken.swap(waiters);
+    }
+    for (Agent *a : woken)
+      engine->schedule(a);
+  }
+};
+
+/**
+ * @struct AgentSimOptions
+ * @brief Size and pacing of an in-process simulation.
+ */
+struct AgentSimOptions {
+  int threads = 4;
+  int workers = 1000;
+  int trucks = 1000;
+  int dispatchers = 4;
+  int express = 1;
+  ArrivalSpec arrival; /**< Per worker; rate_hz must be positive. */
+  int route_min_ms = 3000;
+  int route_max_ms = 8000;
+  int express_period_ms = 1000; /**< Express batch every period, 0 = none. */
+  uint64_t seed = 1;
+};
+
+/**
+ * @class AgentWarehouse
+ * @brief One warehouse (belt, dock, roles) run by an AgentEngine.
+ *
+ * Construct, `start`, let it run, `stop`; the SharedState then holds the
+ * same counters a process-based run leaves in shared memory.
+ */
+class AgentWarehouse {
+public:
+  /** @name Shared Resources
+   * @{ */
+  std::unique_ptr<SharedState> shm;
+  AgentEngine engine;
+  std::mutex belt_m;
+  std::mutex dock_m;
+  AgentSemaphore slots;    /**< Free belt slots (SEM_EMPTY_SLOTS). */
+  AgentSemaphore packages; /**< Packages on the belt (SEM_FULL_SLOTS). */
+  AgentSemaphore dock;     /**< The dock, one truck at a time. */
+  AgentEvent docked;       /**< A truck docked. */
+  Belt belt;
+  /** @} */
+
+  class TruckAgent;
+
+private:
+  AgentSimOptions opt;
+  std::vector<std::unique_ptr<Agent>> agents;
+  std::vector<TruckAgent *> trucks; /**< By truck id - 1. */
+
+  void lockDock() { dock_m.lock(); }
+  void unlockDock() { dock_m.unlock(); }
+
+public:
+  /**
+   * @class WorkerAgent
+   * @brief Worker::run as an agent: sleep to the next arrival, draw a
+   * package, wait for a free slot, push.
+   */
+  class WorkerAgent : public Agent {
+  private:
+    enum { Arrive, Produce, Push };
+    AgentWarehouse &w;
+    int id;
+    SplitMix64 gen;
+    BasicArrivalProcess<SplitMix64> arrivals;
+    uint64_t next_ns;
+    Package pkg = {};
+
+  public:
+    WorkerAgent(AgentWarehouse &wh, int worker_id, uint64_t seed)
+        : w(wh), id(worker_id), gen(seed), arrivals(wh.opt.arrival, ~seed),
+          next_ns(monotonicNowNs()) {}
+
+    void resume(AgentEngine &engine) override {
+      for (;;) {
+        switch (pc) {
+        case Arrive:
+          next_ns += static_cast<uint64_t>(arrivals.nextGap() * 1e9);
+          pc = Produce;
+          engine.sleepUntil(*this, next_ns);
+          return;
+        case Produce:
+          pkg = drawPackage(gen, w.shm->schedule);
+          pkg.creator_pid = id;
+          pc = Push;
+          if (!w.slots.acquire(*this))
+            return;
+          break;
+        case Push:
+          w.belt.push(pkg);
+          pc = Arrive;
+          break;
+        }
+      }
+    }
+  };
+
+  /**
+   * @class TruckAgent
+   * @brief Truck::run as an agent: queue for the dock, dock, wait for the
+   * departure request, depart, drive the route.
+   */
+  class TruckAgent : public Agent {
+  private:
+    enum { Queue, Dock, Depart };
+    AgentWarehouse &w;
+    int id;
+    SplitMix64 gen;
+    uint64_t docked_at = 0;
+
+    /** @name Mailbox (the truck's message queue)
+     * @{ */
+    std::mutex mail_m;
+    SignalType pending = SIGNAL_NONE;
+    bool waiting = false;
+    /** @} */
+
+    /** @brief Takes the pending message, or suspends until one is posted. */
+    bool awaitSignal() {
+      std::lock_guard<std::mutex> lock(mail_m);
+      if (pending != SIGNAL_NONE) {
+        pending = SIGNAL_NONE;
+        return true;
+      }
+      waiting = true;
+      return false;
+    }
+
+  public:
+    TruckAgent(AgentWarehouse &wh, int truck_id, uint64_t seed)
+        : w(wh), id(truck_id), gen(seed) {}
+
+    int truckId() const { return id; }
+
+    /** @brief Delivers a message, resuming the truck if it waits for one. */
+    void post(SignalType sig) {
+      bool wake = false;
+      {
+        std::lock_guard<std::mutex> lock(mail_m);
+        if (waiting) {
+          waiting = false;
+          wake = true;
+        } else {
+          pending = sig;
+        }
+      }
+      if (wake)
+        w.engine.schedule(this);
+    }
+
+    void resume(AgentEngine &engine) override {
+      for (;;) {
+        switch (pc) {
+        case Queue:
+          atomicAdd(w.shm->trucks_waiting, 1);
+          pc = Dock;
+          if (!w.dock.acquire(*this))
+            return;
+          break;
+        case Dock:
+          atomicAdd(w.shm->trucks_waiting, -1);
+          w.lockDock();
+          {
+            std::lock_guard<std::mutex> lock(mail_m);
+            if (pending != SIGNAL_NONE) {
+              atomicAdd(w.shm->stats.departures_stale, uint64_t{1});
+              pending = SIGNAL_NONE;
+            }
+          }
+          dockTruck(w.shm->dock_truck, id, gen);
+          docked_at = monotonicNowNs();
+          WAREHOUSE_PROBE2(truck__dock, id, w.shm->dock_truck.max_load);
+          w.unlockDock();
+          w.docked.notifyAll();
+          pc = Depart;
+          if (!awaitSignal())
+            return;
+          break;
+        case Depart: {
+          TruckState &dock = w.shm->dock_truck;
+          w.lockDock();
+          w.shm->trucks_completed++;
+          if (dock.current_load == 0 && dock.current_weight <= 0.0)
+            atomicAdd(w.shm->stats.departures_empty, uint64_t{1});
+          dock.is_present = false;
+          dock.phase = DockPhase::Docked;
+          WAREHOUSE_PROBE3(truck__depart, id, dock.current_load,
+                           static_cast<int>(dock.departure_reason));
+          atomicAdd(w.shm->stats.dock_ns_total, monotonicNowNs() - docked_at);
+          w.unlockDock();
+          w.dock.release();
+
+          int span = w.opt.route_max_ms - w.opt.route_min_ms;
+          uint64_t route_ms =
+              w.opt.route_min_ms + (span > 0 ? gen() % span : 0);
+          pc = Queue;
+          engine.sleepFor(*this, route_ms * 1000000ULL);
+          return;
+        }
+        }
+      }
+    }
+  };
+
+  /**
+   * @class DispatcherAgent
+   * @brief Dispatcher::processNextPackage as an agent: wait for a package,
+   * pop it, load it; if it does not fit, wait for the next truck to dock.
+   */
+  class DispatcherAgent : public Agent {
+  private:
+    enum { Take, Pop, Load };
+    AgentWarehouse &w;
+    DockController loader;
+    Package pkg = {};
+
+  public:
+    explicit DispatcherAgent(AgentWarehouse &wh)
+        : w(wh), loader(&wh.shm->dock_truck, wh.shm.get(),
+                        [&wh]() { wh.lockDock(); },
+                        [&wh]() { wh.unlockDock(); },
+                        [&wh](pid_t id, SignalType sig) {
+                          wh.deliver(id, sig);
+                        }) {}
+
+    void resume(AgentEngine &) override {
+      for (;;) {
+        switch (pc) {
+        case Take:
+          pc = Pop;
+          if (!w.packages.acquire(*this))
+            return;
+          break;
+        case Pop:
+          pkg = w.belt.pop();
+          if (pkg.id == 0) {
+            pc = Take;
+            break;
+          }
+          atomicAdd(w.shm->stats.packages_in_dispatch, 1);
+          pc = Load;
+          break;
+        case Load: {
+          uint64_t seen = w.docked.generation();
+          const LoadSlot &r = loader.load(&pkg.weight, &pkg.volume, 1, true,
+                                          true, DepartureReason::NoFit);
+          if (r.departure_repeated)
+            atomicAdd(w.shm->stats.departures_coalesced, uint64_t{1});
+          if (r.outcome == LoadOutcome::Loaded) {
+            atomicAdd(w.shm->stats.packages_in_dispatch, -1);
+            atomicAdd(w.shm->stats.packages_loaded, uint64_t{1});
+            uint64_t now = monotonicNowNs();
+            recordLatency(w.shm->stats, now - pkg.created_ns);
+            recordDeadline(w.shm->stats, pkg, now);
+            pc = Take;
+            break;
+          }
+          if (!w.docked.wait(*this, seen))
+            return;
+          break;
+        }
+        }
+      }
+    }
+  };
+
+  /**
+   * @class ExpressAgent
+   * @brief The P4 worker as an agent: one Express batch per period (the
+   * processes wait for SIGNAL_EXPRESS_LOAD instead).
+   */
+  class ExpressAgent : public Agent {
+  private:
+    AgentWarehouse &w;
+    Express express;
+
+  public:
+    explicit ExpressAgent(AgentWarehouse &wh)
+        : w(wh), express(wh.shm.get(), [&wh]() { wh.lockDock(); },
+                         [&wh]() { wh.unlockDock(); },
+                         [&wh](pid_t id, SignalType sig) {
+                           wh.deliver(id, sig);
+                         }) {}
+
+    void resume(AgentEngine &engine) override {
+      if (pc++ > 0)
+        express.deliverExpressBatch();
+      engine.sleepFor(*this, w.opt.express_period_ms * 1000000ULL);
+    }
+  };
+
+  /**
+   * @param options Sizes and pacing; `arrival.rate_hz` must be positive.
+   */
+  explicit AgentWarehouse(const AgentSimOptions &options)
+      : shm(std::make_unique<SharedState>()), engine(options.threads),
+        slots(&engine, MAX_BELT_CAPACITY_K), packages(&engine, 0),
+        dock(&engine, 1), docked(&engine),
+        belt(
+            shm.get(), []() {}, [this]() { slots.release(); }, []() {},
+            [this]() { packages.release(); }, [this]() { belt_m.lock(); },
+            [this]() { belt_m.unlock(); }),
+        opt(options) {
+    std::memset(shm.get(), 0, sizeof(SharedState));
+    shm->running = true;
+    belt.setWorkloadSimulation(false);
+
+    SplitMix64 seeds(opt.seed);
+    for (int i = 0; i < opt.workers; ++i)
+      agents.push_back(std::make_unique<WorkerAgent>(*this, i + 1, seeds()));
+    for (int i = 0; i < opt.trucks; ++i) {
+      auto truck = std::make_unique<TruckAgent>(*this, i + 1, seeds());
+      trucks.push_back(truck.get());
+      agents.push_back(std::move(truck));
+    }
+    for (int i = 0; i < opt.dispatchers; ++i)
+      agents.push_back(std::make_unique<DispatcherAgent>(*this));
+    for (int i = 0; opt.express_period_ms > 0 && i < opt.express; ++i)
+      agents.push_back(std::make_unique<ExpressAgent>(*this));
+
+    for (auto &a : agents)
+      engine.schedule(a.get());
+  }
+
+  ~AgentWarehouse() { stop(); }
+
+  /** @brief Sends a message to a truck (the loaders' send callback). */
+  void deliver(pid_t truck_id, SignalType sig) {
+    if (truck_id >= 1 && truck_id <= static_cast<int>(trucks.size()))
+      trucks[truck_id - 1]->post(sig);
+  }
+
+  void start() { engine.start(); }
+
+  /** @brief Stops the engine; every agent stays suspended where it was. */
+  void stop() {
+    engine.stop();
+    shm->running = false;
+  }
+
+  size_t agentCount() const { return agents.size(); }
+};
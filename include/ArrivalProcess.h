@@ -0,0 +1,208 @@
+/**
+ * @file ArrivalProcess.h
+ * @brief Inter-arrival time generators that shape the Workers' intake.
+ *
+ * A Worker asks its process for the gap to the next package and adds it to
+ * an absolute deadline, so time spent blocked on a full belt is caught up
+ * afterwards instead of shifting the whole curve. The process keeps its own
+ * clock (the sum of the gaps), which makes a seeded schedule identical from
+ * run to run regardless of how the belt behaved.
+ *
+ * `WORKER_ARRIVAL` selects the process; RATE is the worker's base rate
+ * (`WORKER_RATE_HZ`):
+ * - `fixed`: one package every 1/RATE s (the default).
+ * - `poisson`: exponential gaps with mean 1/RATE.
+ * - `bursty:FACTOR:CALM_S:BURST_S`: two-state Markov-modulated Poisson
+ *   process. Calm periods run at RATE, bursts at FACTOR x RATE; their
+ *   lengths are exponential with means CALM_S and BURST_S.
+ * - `onoff:ON_S:OFF_S`: Poisson at RATE during on periods, silent during
+ *   off periods (exponential lengths with the given means).
+ * - `diurnal:PERIOD_S:AMPLITUDE`: Poisson with the rate following
+ *   RATE * (1 + AMPLITUDE * sin(2 pi t / PERIOD_S)), AMPLITUDE in [0, 1].
+ */
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+
+/** @brief Shape of an arrival process. */
+enum class ArrivalKind : uint8_t { Fixed, Poisson, Bursty, OnOff, Diurnal };
+
+/** @brief Parameters of an arrival process (see file documentation). */
+struct ArrivalSpec {
+  ArrivalKind kind = ArrivalKind::Fixed;
+  double rate_hz = 0.0;    /**< Base rate. */
+  double burst_factor = 1; /**< Bursty: rate multiplier while bursting. */
+  double dwell_s[2] = {};  /**< Bursty/OnOff: mean length of each state. */
+  double period_s = 0.0;   /**< Diurnal: length of one cycle. */
+  double amplitude = 0.0;  /**< Diurnal: relative swing of the rate. */
+};
+
+/**
+ * @brief Parses a `WORKER_ARRIVAL` specification.
+ * @param text Specification (see file documentation).
+ * @param rate_hz Base rate of the worker; must be positive.
+ * @param out Parsed process; untouched on failure.
+ * @return true if the specification is valid.
+ */
+inline bool parseArrivalSpec(const char *text, double rate_hz,
+                             ArrivalSpec &out) {
+  if (!(rate_hz > 0))
+    return false;
+
+  ArrivalSpec spec;
+  spec.rate_hz = rate_hz;
+  double args[3] = {};
+  int expected = 0;
+  const char *rest = nullptr;
+
+  if (std::strcmp(text, "fixed") == 0) {
+    spec.kind = ArrivalKind::Fixed;
+  } else if (std::strcmp(text, "poisson") == 0) {
+    spec.kind = ArrivalKind::Poisson;
+  } else if (std::strncmp(text, "bursty:", 7) == 0) {
+    spec.kind = ArrivalKind::Bursty;
+    rest = text + 7;
+    expected = 3;
+  } else if (std::strncmp(text, "onoff:", 6) == 0) {
+    spec.kind = ArrivalKind::OnOff;
+    rest = text + 6;
+    expected = 2;
+  } else if (std::strncmp(text, "diurnal:", 8) == 0) {
+    spec.kind = ArrivalKind::Diurnal;
+    rest = text + 8;
+    expected = 2;
+  } else {
+    return false;
+  }
+
+  for (int i = 0; i < expected; ++i) {
+    char *end = nullptr;
+    args[i] = std::strtod(rest, &end);
+    if (end == rest || !(args[i] > 0))
+      return false;
+    bool last = i == expected - 1;
+    if (last ? *end != '\0' : *end != ':')
+      return false;
+    rest = end + 1;
+  }
+
+  switch (spec.kind) {
+  case ArrivalKind::Bursty:
+    spec.burst_factor = args[0];
+    spec.dwell_s[0] = args[1];
+    spec.dwell_s[1] = args[2];
+    break;
+  case ArrivalKind::OnOff:
+    spec.dwell_s[0] = args[0];
+    spec.dwell_s[1] = args[1];
+    break;
+  case ArrivalKind::Diurnal:
+    if (args[1] > 1)
+      return false;
+    spec.period_s = args[0];
+    spec.amplitude = args[1];
+    break;
+  default:
+    break;
+  }
+
+  out = spec;
+  return true;
+}
+
+/**
+ * @class BasicArrivalProcess
+ * @brief Draws successive inter-arrival gaps of one worker.
+ *
+ * @tparam Gen Random engine. Worker processes use the Mersenne Twister;
+ * the agent engine (AgentEngine.h) runs 100k workers and needs a smaller one.
+ */
+template <class Gen = std::mt19937_64> class BasicArrivalProcess {
+private:
+  ArrivalSpec spec;
+  Gen gen;
+  double now_s = 0.0; /**< Process clock: time of the last arrival. */
+  int state = 0;      /**< Modulated processes: 0 calm/on, 1 burst/off. */
+  double state_end_s; /**< Modulated processes: end of the state. */
+
+  double exponential(double rate) {
+    return std::exponential_distribution<double>(rate)(gen);
+  }
+
+  /** @brief Rate of a modulated process in `state`. */
+  double stateRate() const {
+    if (spec.kind == ArrivalKind::OnOff)
+      return state == 0 ? spec.rate_hz : 0.0;
+    return state == 0 ? spec.rate_hz : spec.rate_hz * spec.burst_factor;
+  }
+
+public:
+  /**
+   * @param s Process parameters (see parseArrivalSpec).
+   * @param seed Seed of the schedule.
+   */
+  BasicArrivalProcess(const ArrivalSpec &s, uint64_t seed)
+      : spec(s), gen(seed) {
+    state_end_s = spec.dwell_s[0] > 0 ? exponential(1.0 / spec.dwell_s[0])
+                                      : std::numeric_limits<double>::max();
+  }
+
+  /** @brief Instantaneous rate at process time `t_s` (for diurnal). */
+  double rateAt(double t_s) const {
+    if (spec.kind != ArrivalKind::Diurnal)
+      return spec.rate_hz;
+    return spec.rate_hz *
+           (1.0 + spec.amplitude * std::sin(2.0 * M_PI * t_s / spec.period_s));
+  }
+
+  /** @brief Process time of the last arrival [s]. */
+  double clock() const { return now_s; }
+
+  /** @brief Seconds from the previous arrival to the next one. */
+  double nextGap() {
+    double start = now_s;
+
+    switch (spec.kind) {
+    case ArrivalKind::Fixed:
+      now_s += 1.0 / spec.rate_hz;
+      break;
+    case ArrivalKind::Poisson:
+      now_s += exponential(spec.rate_hz);
+      break;
+    case ArrivalKind::Bursty:
+    case ArrivalKind::OnOff:
+      // Memoryless: a gap that crosses a state change is redrawn there.
+      for (;;) {
+        double rate = stateRate();
+        double gap = rate > 0 ? exponential(rate)
+                              : std::numeric_limits<double>::max();
+        if (now_s + gap < state_end_s) {
+          now_s += gap;
+          break;
+        }
+        now_s = state_end_s;
+        state ^= 1;
+        state_end_s = now_s + exponential(1.0 / spec.dwell_s[state]);
+      }
+      break;
+    case ArrivalKind::Diurnal: {
+      // Thinning of a Poisson process at the peak rate.
+      double peak = spec.rate_hz * (1.0 + spec.amplitude);
+      std::uniform_real_distribution<double> accept(0.0, peak);
+      do {
+        now_s += exponential(peak);
+      } while (accept(gen) >= rateAt(now_s));
+      break;
+    }
+    }
+    return now_s - start;
+  }
+};
+
+/** @brief Arrival process of a Worker process. */
+using ArrivalProcess = BasicArrivalProcess<>;
@@ -0,0 +1,359 @@
+/**
+ * @file AuditJournal.h
+ * @brief Append-only, memory-mapped audit journal of package events.
+ *
+ * The journal replaces the fixed per-package history. Every event is a
+ * fixed-size `JournalRecord` in a series of memory-mapped segment files
+ * (`<dir>/journal.NNNNNN.seg`). Writers reserve a slot with one atomic
+ * increment of `SharedState::journal_cursor`, so processes never take a
+ * semaphore to log. Records are published by setting their `committed` byte
+ * last, so a reader never sees a half-written entry.
+ */
+#pragma once
+
+#include "Shared.h"
+#include "Telemetry.h"
+#include "spdlog/spdlog.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+/** @name Journal Layout
+ * @{ */
+constexpr uint32_t JOURNAL_MAGIC = 0x4C4E524A; /**< "JRNL" little-endian. */
+constexpr uint32_t JOURNAL_VERSION = 1;
+constexpr uint64_t JOURNAL_SEGMENT_RECORDS = 1 << 16; /**< Records/segment. */
+constexpr int JOURNAL_MAX_SEGMENTS = 4096; /**< ~268M records in total. */
+/** @} */
+
+/**
+ * @struct JournalRecord
+ * @brief One audit event (24 bytes).
+ */
+struct JournalRecord {
+  uint64_t timestamp_ns; /**< CLOCK_REALTIME of the event. */
+  uint32_t package_id;   /**< Package ID (0 for anonymous express items). */
+  int32_t pid;           /**< Process that performed the action. */
+  uint8_t action;        /**< ActionType bitmask. */
+  uint8_t committed;     /**< Set to 1 (release) once the record is valid. */
+  uint8_t reserved[6];
+};
+static_assert(sizeof(JournalRecord) == 24, "JournalRecord must stay compact");
+
+/**
+ * @struct JournalSegmentHeader
+ * @brief Self-describing header at the start of every segment file.
+ */
+struct JournalSegmentHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t segment;      /**< Segment number. */
+  uint64_t first_record; /**< Global index of the first record. */
+  uint8_t reserved[40];
+};
+static_assert(sizeof(JournalSegmentHeader) == 64, "Header is one cache line");
+
+/** @brief Size in bytes of one segment file. */
+constexpr size_t JOURNAL_SEGMENT_BYTES =
+    sizeof(JournalSegmentHeader) +
+    JOURNAL_SEGMENT_RECORDS * sizeof(JournalRecord);
+
+/**
+ * @brief Formats an ActionType bitmask as `CREATED|ON_BELT|BY_WORKER`.
+ * @return `buf`, for convenience.
+ */
+inline const char *describeAction(uint8_t action, char *buf, size_t cap) {
+  static const char *names[8] = {"CREATED",   "ON_BELT",    "PICKED_UP",
+                                 "LOADED",    "BY_WORKER",  "BY_EXPRESS",
+                                 "BY_TRUCK",  "FORCED"};
+  size_t len = 0;
+  buf[0] = '\0';
+  for (int bit = 0; bit < 8; ++bit) {
+    if (!(action & (1u << bit)))
+      continue;
+    int n = std::snprintf(buf + len, cap - len, "%s%s", len ? "|" : "",
+                          names[bit]);
+    if (n < 0 || len + n >= cap)
+      break;
+    len += n;
+  }
+  if (len == 0)
+    std::snprintf(buf, cap, "NONE");
+  return buf;
+}
+
+/**
+ * @brief Builds the path of a segment file into a caller buffer.
+ */
+inline void journalSegmentPath(const std::string &dir, int segment, char *buf,
+                               size_t cap) {
+  std::snprintf(buf, cap, "%s/journal.%06d.seg", dir.c_str(), segment);
+}
+
+/**
+ * @class AuditJournal
+ * @brief Writer side of the journal, one instance per process.
+ *
+ * Segments are created and mapped lazily by whichever process first reserves
+ * a slot in them. The mapping table is process-local and fixed-size, so the
+ * append path performs no heap allocation.
+ */
+class AuditJournal {
+private:
+  /** @brief Segment holding the shared cursor. */
+  SharedState *shm;
+
+  /** @brief Directory of the segment files. */
+  std::string dir;
+
+  /** @brief PID stamped on records appended without an explicit actor. */
+  pid_t my_pid;
+
+  /** @brief Process-local mappings, published with release stores. */
+  JournalRecord *segments[JOURNAL_MAX_SEGMENTS] = {};
+
+  /** @brief Serializes the (rare) segment mapping slow path. */
+  std::mutex map_mutex;
+
+  /**
+   * @brief Maps a segment, creating and sizing its file if needed.
+   * @return Pointer to the first record, or nullptr on failure.
+   */
+  JournalRecord *mapSegment(int segment) {
+    std::lock_guard<std::mutex> guard(map_mutex);
+    if (segments[segment])
+      return segments[segment];
+
+    char path[512];
+    journalSegmentPath(dir, segment, path, sizeof(path));
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd == -1) {
+      spdlog::error("[journal] Cannot open {}: {}", path, std::strerror(errno));
+      return nullptr;
+    }
+    if (ftruncate(fd, JOURNAL_SEGMENT_BYTES) == -1) {
+      spdlog::error("[journal] Cannot size {}: {}", path, std::strerror(errno));
+      close(fd);
+      return nullptr;
+    }
+
+    void *base = mmap(nullptr, JOURNAL_SEGMENT_BYTES, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+      spdlog::error("[journal] mmap {} failed: {}", path, std::strerror(errno));
+      return nullptr;
+    }
+
+    auto *header = static_cast<JournalSegmentHeader *>(base);
+    header->magic = JOURNAL_MAGIC;
+    header->version = JOURNAL_VERSION;
+    header->record_size = sizeof(JournalRecord);
+    header->segment = segment;
+    header->first_record = segment * JOURNAL_SEGMENT_RECORDS;
+
+    auto *records = reinterpret_cast<JournalRecord *>(header + 1);
+    __atomic_store_n(&segments[segment], records, __ATOMIC_RELEASE);
+    return records;
+  }
+
+public:
+  /**
+   * @brief Opens the journal in `directory`, creating it if necessary.
+   * @param s Shared segment holding the global cursor.
+   * @param directory Location of the segment files.
+   */
+  AuditJournal(SharedState *s, const std::string &directory)
+      : shm(s), dir(directory), my_pid(getpid()) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+  }
+
+  ~AuditJournal() {
+    for (JournalRecord *records : segments) {
+      if (records) {
+        munmap(reinterpret_cast<JournalSegmentHeader *>(records) - 1,
+               JOURNAL_SEGMENT_BYTES);
+      }
+    }
+  }
+
+  AuditJournal(const AuditJournal &) = delete;
+  AuditJournal &operator=(const AuditJournal &) = delete;
+
+  /**
+   * @brief Deletes the segments of a previous run.
+   * * Called by the IPC owner together with zeroing the cursor, so a fresh
+   * simulation never interleaves with stale records.
+   */
+  static void reset(const std::string &directory) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+
+    std::vector<std::filesystem::path> stale;
+    for (const auto &entry :
+         std::filesystem::directory_iterator(directory, ec)) {
+      const std::string name = entry.path().filename().string();
+      if (name.rfind("journal.", 0) == 0 && entry.path().extension() == ".seg")
+        stale.push_back(entry.path());
+    }
+    for (const auto &path : stale)
+      std::filesystem::remove(path, ec);
+  }
+
+  /**
+   * @brief Appends one event.
+   * @param package_id Package concerned (0 if it has no ID).
+   * @param action Bitmask describing the event.
+   * @param pid Actor; defaults to the calling process.
+   * @return false if the journal is full or a segment could not be mapped.
+   */
+  bool append(uint32_t package_id, ActionType action, pid_t pid = 0) {
+    uint64_t index = atomicAdd(shm->journal_cursor, uint64_t{1});
+    uint64_t segment = index / JOURNAL_SEGMENT_RECORDS;
+    if (segment >= JOURNAL_MAX_SEGMENTS)
+      return false;
+
+    JournalRecord *records =
+        __atomic_load_n(&segments[segment], __ATOMIC_ACQUIRE);
+    if (!records && !(records = mapSegment(static_cast<int>(segment))))
+      return false;
+
+    JournalRecord &rec = records[index % JOURNAL_SEGMENT_RECORDS];
+    rec.timestamp_ns = realtimeNowNs();
+    rec.package_id = package_id;
+    rec.pid = pid ? pid : my_pid;
+    rec.action = static_cast<uint8_t>(action);
+    __atomic_store_n(&rec.committed, uint8_t{1}, __ATOMIC_RELEASE);
+    return true;
+  }
+
+  /** @brief Number of slots reserved so far (committed or in flight). */
+  uint64_t size() const { return atomicLoad(shm->journal_cursor); }
+
+  /** @brief Directory of the segment files. */
+  const std::string &directory() const { return dir; }
+};
+
+/**
+ * @class JournalReader
+ * @brief Read-only, indexed view over the segment files.
+ *
+ * Maps every consecutive segment present in the directory. `buildIndex`
+ * makes one sequential pass to group record positions by package, after
+ * which `history` answers per-package queries without rescanning.
+ */
+class JournalReader {
+private:
+  std::vector<const JournalRecord *> segments; /**< Mapped record arrays. */
+  std::unordered_map<uint32_t, std::vector<uint64_t>> index;
+
+public:
+  /**
+   * @brief Maps the journal stored in `dir`.
+   * * Stops at the first missing or foreign segment file.
+   */
+  explicit JournalReader(const std::string &dir) {
+    char path[512];
+    for (int seg = 0; seg < JOURNAL_MAX_SEGMENTS; ++seg) {
+      journalSegmentPath(dir, seg, path, sizeof(path));
+      int fd = open(path, O_RDONLY);
+      if (fd == -1)
+        break;
+
+      void *base = mmap(nullptr, JOURNAL_SEGMENT_BYTES, PROT_READ, MAP_SHARED,
+                        fd, 0);
+      close(fd);
+      if (base == MAP_FAILED)
+        break;
+
+      auto *header = static_cast<const JournalSegmentHeader *>(base);
+      if (header->magic != JOURNAL_MAGIC ||
+          header->version != JOURNAL_VERSION ||
+          header->record_size != sizeof(JournalRecord)) {
+        munmap(base, JOURNAL_SEGMENT_BYTES);
+        break;
+      }
+      segments.push_back(reinterpret_cast<const JournalRecord *>(header + 1));
+    }
+  }
+
+  ~JournalReader() {
+    for (const JournalRecord *records : segments) {
+      munmap(const_cast<JournalSegmentHeader *>(
+                 reinterpret_cast<const JournalSegmentHeader *>(records) - 1),
+             JOURNAL_SEGMENT_BYTES);
+    }
+  }
+
+  JournalReader(const JournalReader &) = delete;
+  JournalReader &operator=(const JournalReader &) = delete;
+
+  /** @brief Number of record slots covered by the mapped segments. */
+  uint64_t capacity() const {
+    return segments.size() * JOURNAL_SEGMENT_RECORDS;
+  }
+
+  /**
+   * @brief Returns a committed record, or nullptr for an empty/in-flight slot.
+   */
+  const JournalRecord *at(uint64_t i) const {
+    if (i >= capacity())
+      return nullptr;
+    const JournalRecord *rec =
+        &segments[i / JOURNAL_SEGMENT_RECORDS][i % JOURNAL_SEGMENT_RECORDS];
+    return __atomic_load_n(&rec->committed, __ATOMIC_ACQUIRE) ? rec : nullptr;
+  }
+
+  /**
+   * @brief Visits every committed record in reservation order.
+   * @param fn Callable taking `(uint64_t index, const JournalRecord &)`.
+   * @return Number of records visited.
+   */
+  template <typename Fn> uint64_t forEach(Fn fn) const {
+    uint64_t visited = 0;
+    for (uint64_t i = 0; i < capacity(); ++i) {
+      if (const JournalRecord *rec = at(i)) {
+        fn(i, *rec);
+        visited++;
+      }
+    }
+    return visited;
+  }
+
+  /**
+   * @brief Groups record positions by package ID.
+   * @return Number of distinct packages indexed.
+   */
+  size_t buildIndex() {
+    index.clear();
+    forEach([this](uint64_t i, const JournalRecord &rec) {
+      index[rec.package_id].push_back(i);
+    });
+    return index.size();
+  }
+
+  /**
+   * @brief Full, unbounded history of a package (requires `buildIndex`).
+   */
+  std::vector<JournalRecord> history(uint32_t package_id) const {
+    std::vector<JournalRecord> out;
+    auto it = index.find(package_id);
+    if (it == index.end())
+      return out;
+    out.reserve(it->second.size());
+    for (uint64_t i : it->second)
+      out.push_back(*at(i));
+    return out;
+  }
+};
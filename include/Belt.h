@@ -6,15 +6,33 @@
  * in shared memory. It acts as the synchronization point between Producers
  * (Workers) and the Consumer (Dispatcher), enforcing capacity limits (K items)
  * and weight limits (M kg).
+ *
+ * With a belt speed configured (`BELT_SPEED_MS`), a pushed package still
+ * takes its slot at once but only becomes poppable when it reaches the end of
+ * the belt: its arrival is filed in the shared timer wheel and the belt
+ * process releases it to the 'Full Slots' semaphore from `runTransit`.
+ *
+ * With `BELT_ORDER=edf` the Dispatchers take the arrived package with the
+ * earliest deadline instead of the oldest one (see BeltSchedule).
  */
 #pragma once
 
+#include "AuditJournal.h"
+#include "EventChannel.h"
+#include "JsonLog.h"
+#include "LockProfiler.h"
+#include "LogThrottle.h"
+#include "Probes.h"
 #include "Shared.h"
+#include "Telemetry.h"
 #include "spdlog/spdlog.h"
 #include <chrono>
+#include <atomic>
+#include <cerrno>
 #include <cstring>
 #include <functional>
 #include <thread>
+#include <time.h>
 
 /**
  * @class Belt
@@ -52,8 +70,70 @@ private:
       lock_fn; /**< Acquires the Belt Mutex (Binary Semaphore). */
   std::function<void()>
       unlock_fn; /**< Releases the Belt Mutex (Binary Semaphore). */
+  std::function<bool()>
+      wait_failed_fn; /**< True if the last wait got no permit (optional). */
   /** @} */
 
+  /** @brief True if the wait just made returned without a permit. */
+  bool waitFailed() const { return wait_failed_fn && wait_failed_fn(); }
+
+  /** @brief If false, `push` skips the artificial per-worker delay. */
+  bool simulate_workload = true;
+
+  /** @brief Audit journal receiving belt events (nullptr = disabled). */
+  AuditJournal *journal = nullptr;
+
+  /** @brief True when packages leave in deadline order (see BeltSchedule). */
+  bool edf() const { return shm->schedule.order == BeltOrder::Edf; }
+
+  /** @brief Slot for a new package (caller holds the belt mutex). */
+  int takeSlot() {
+    BeltSchedule &sched = shm->schedule;
+    if (!edf()) {
+      int slot = shm->tail;
+      shm->tail = (slot + 1) % MAX_BELT_CAPACITY_K;
+      return slot;
+    }
+    if (sched.recycled_count > 0)
+      return static_cast<int>(sched.recycled[--sched.recycled_count]);
+    return sched.used++;
+  }
+
+  /** @brief Makes a package's slot eligible for service. */
+  void markArrived(int slot) {
+    shm->transit.arrived[slot] = 1;
+    if (edf())
+      shm->schedule.ready.push(shm->belt[slot].deadline_ns,
+                               static_cast<uint32_t>(slot));
+  }
+
+  /**
+   * @brief Slot of the next package to serve, -1 if none has arrived.
+   * * Caller holds the belt mutex and frees the slot with `releaseSlot`.
+   */
+  int nextSlot() {
+    if (shm->current_items_count <= 0)
+      return -1;
+    if (edf()) {
+      DeadlineHeap<MAX_BELT_CAPACITY_K>::Entry e;
+      return shm->schedule.ready.pop(e) ? static_cast<int>(e.payload) : -1;
+    }
+    if (shm->transit.speed_ms > 0 && !shm->transit.arrived[shm->head])
+      return -1;
+    return shm->head;
+  }
+
+  /** @brief Returns a served slot (caller holds the belt mutex). */
+  void releaseSlot(int slot) {
+    std::memset(&shm->belt[slot], 0, sizeof(Package));
+    if (edf()) {
+      BeltSchedule &sched = shm->schedule;
+      sched.recycled[sched.recycled_count++] = static_cast<uint32_t>(slot);
+    } else {
+      shm->head = (slot + 1) % MAX_BELT_CAPACITY_K;
+    }
+  }
+
   /**
    * @brief Simulates the time taken to place an item on the belt.
    *
@@ -62,7 +142,7 @@ private:
    * small physical delay to simulate human movement.
    */
   void simulateWorkLoad() {
-    if (!shm)
+    if (!shm || !simulate_workload)
       return;
 
     if (shm->current_workers_count <= 0) {
@@ -105,10 +185,14 @@ public:
   bool registerWorker() {
     if (!shm)
       return false;
+    LockSiteScope site(LockSite::WorkerRegistry);
     bool success = false;
     lock_fn();
+    if (waitFailed())
+      return false;
     if (shm->current_workers_count < MAX_WORKERS_PER_BELT) {
       shm->current_workers_count++;
+      bumpGeneration(shm, StateRegion::Belt);
       spdlog::info("[belt] Worker joined. Total: {}/{}",
                    shm->current_workers_count, MAX_WORKERS_PER_BELT);
       success = true;
@@ -126,9 +210,13 @@ public:
   void unregisterWorker() {
     if (!shm)
       return;
+    LockSiteScope site(LockSite::WorkerRegistry);
     lock_fn();
+    if (waitFailed())
+      return;
     if (shm->current_workers_count > 0) {
       shm->current_workers_count--;
+      bumpGeneration(shm, StateRegion::Belt);
       spdlog::info("[belt] Worker left. Total: {}/{}",
                    shm->current_workers_count, MAX_WORKERS_PER_BELT);
     }
@@ -145,7 +233,9 @@ public:
    * `MAX_BELT_WEIGHT_M`.
    * - If Mass Limit ($M$) is exceeded, the package is rejected, and the worker
    * must retry.
-   * 4. **Writes** the package to the circular buffer at the `tail` index.
+   * 4. **Writes** the package to the circular buffer at the `tail` index
+   * (any free slot in EDF mode), filling in its deadline if the Worker did
+   * not set one.
    * 5. **Updates** statistics (Total created, Current count, Total weight).
    * 6. **Unlocks** the mutex.
    * 7. **Signals** the 'Full Slots' semaphore to wake up the Dispatcher.
@@ -159,9 +249,16 @@ public:
 
     simulateWorkLoad();
 
+    LockSiteScope site(LockSite::BeltPush);
     wait_empty_fn();
+    if (waitFailed())
+      return;
 
     lock_fn();
+    if (waitFailed()) {
+      signal_empty_fn();
+      return;
+    }
 
     if (shm->current_items_count >= MAX_BELT_CAPACITY_K) {
       spdlog::error("[belt] REJECTED: Belt full! Count: {}/{}",
@@ -174,22 +271,65 @@ public:
 
     shm->total_packages_created++;
     pkg.id = shm->total_packages_created;
+    pkg.created_ns = monotonicNowNs();
+    if (pkg.deadline_ns == 0)
+      pkg.deadline_ns = pkg.created_ns + slaBudgetNs(shm->schedule, pkg.tier);
+    WAREHOUSE_PROBE3(package__create, pkg.id, pkg.creator_pid,
+                     static_cast<int>(pkg.tier));
 
-    int current_tail = shm->tail;
-
-    shm->belt[current_tail] = pkg;
+    int slot = takeSlot();
 
-    shm->tail = (current_tail + 1) % MAX_BELT_CAPACITY_K;
+    shm->belt[slot] = pkg;
 
     shm->current_items_count++;
     shm->current_belt_weight += pkg.weight;
 
-    spdlog::info("[belt] Pushed ID {} at {}. Load: {}/{} (Workers: {})", pkg.id,
-                 current_tail, shm->current_items_count, MAX_BELT_CAPACITY_K,
-                 shm->current_workers_count);
+    bool arrived = true;
+    BeltTransit &transit = shm->transit;
+    if (transit.speed_ms > 0) {
+      uint64_t arrive = pkg.created_ns + transit.speed_ms * 1000000ULL;
+      if (transit.wheel.schedule(pkg.created_ns / BELT_TICK_NS,
+                                 (arrive + BELT_TICK_NS - 1) / BELT_TICK_NS,
+                                 slot)) {
+        transit.in_transit++;
+        arrived = false;
+      }
+    }
+    transit.arrived[slot] = 0;
+    if (arrived)
+      markArrived(slot);
+    bumpGeneration(shm, StateRegion::Belt);
+
+    WAREHOUSE_PROBE3(belt__push, pkg.id, slot, shm->current_items_count);
+    if (WAREHOUSE_LOG_ENABLED(LogSubsystem::Belt, spdlog::level::info)) {
+      if (JsonLog::enabled(spdlog::level::info))
+        JsonRecord("push")
+            .field("id", pkg.id)
+            .field("slot", slot)
+            .field("load", shm->current_items_count)
+            .field("cap", MAX_BELT_CAPACITY_K)
+            .field("workers", shm->current_workers_count)
+            .field("kg", pkg.weight)
+            .log(spdlog::level::info);
+      else
+        spdlog::info("[belt] Pushed ID {} at {}. Load: {}/{} (Workers: {})",
+                     pkg.id, slot, shm->current_items_count,
+                     MAX_BELT_CAPACITY_K, shm->current_workers_count);
+    }
 
+    int load = shm->current_items_count;
     unlock_fn();
-    signal_full_fn();
+    if (arrived)
+      signal_full_fn();
+    if (load >= MAX_BELT_CAPACITY_K)
+      publishEvent(shm, EventKind::BeltSaturated, pkg.creator_pid, load);
+
+    if (journal) {
+      journal->append(pkg.id,
+                      ActionType::Created | ActionType::PlacedOnBelt |
+                          ActionType::ByWorker,
+                      pkg.creator_pid);
+    }
   }
 
   /**
@@ -198,7 +338,10 @@ public:
    * This method:
    * 1. **Waits** for a full slot semaphore (blocking).
    * 2. **Locks** the belt mutex.
-   * 3. **Reads** the package from the `head` index.
+   * 3. **Reads** the package from the `head` index, or in EDF mode the
+   * arrived package with the earliest deadline. With a belt speed set, the
+   * semaphore only counts arrived packages, and a head that is not marked
+   * arrived is left in place with the signal handed back.
    * 4. **Clears** the memory slot (memset).
    * 5. **Updates** statistics (Decrements count and weight).
    * 6. **Unlocks** the mutex.
@@ -210,37 +353,187 @@ public:
     if (!shm)
       return {};
 
+    LockSiteScope site(LockSite::BeltPop);
     wait_full_fn();
+    if (waitFailed())
+      return {};
 
     lock_fn();
+    if (waitFailed()) {
+      signal_full_fn();
+      return {};
+    }
 
-    if (shm->current_items_count <= 0) {
+    int slot = nextSlot();
+    if (slot < 0) {
       unlock_fn();
       signal_full_fn();
       return {};
     }
 
-    int current_head = shm->head;
-
-    Package pkg = shm->belt[current_head];
-
-    std::memset(&shm->belt[current_head], 0, sizeof(Package));
-
-    shm->head = (current_head + 1) % MAX_BELT_CAPACITY_K;
+    Package pkg = shm->belt[slot];
+    releaseSlot(slot);
 
     shm->current_items_count--;
     shm->current_belt_weight -= pkg.weight;
-
-    spdlog::info("[belt] Popped ID {} from {}. Load: {}/{} (Workers: {})",
-                 pkg.id, current_head, shm->current_items_count,
-                 MAX_BELT_CAPACITY_K, shm->current_workers_count);
+    bumpGeneration(shm, StateRegion::Belt);
+
+    WAREHOUSE_PROBE3(belt__pop, pkg.id, slot, shm->current_items_count);
+    if (WAREHOUSE_LOG_ENABLED(LogSubsystem::Belt, spdlog::level::info)) {
+      if (JsonLog::enabled(spdlog::level::info))
+        JsonRecord("pop")
+            .field("id", pkg.id)
+            .field("slot", slot)
+            .field("load", shm->current_items_count)
+            .field("cap", MAX_BELT_CAPACITY_K)
+            .field("workers", shm->current_workers_count)
+            .log(spdlog::level::info);
+      else
+        spdlog::info("[belt] Popped ID {} from {}. Load: {}/{} (Workers: {})",
+                     pkg.id, slot, shm->current_items_count,
+                     MAX_BELT_CAPACITY_K, shm->current_workers_count);
+    }
 
     unlock_fn();
 
     signal_empty_fn();
+
+    if (journal)
+      journal->append(pkg.id, ActionType::PickedUp);
     return pkg;
   }
 
+  /**
+   * @brief Releases every package that has reached the end of the belt.
+   *
+   * Advances the transit timer wheel to `now_ns` under the belt mutex, marks
+   * each arrived slot and signals 'Full Slots' once per arrival. O(1) when
+   * nothing is in transit.
+   *
+   * @param now_ns Monotonic time.
+   * @return Number of packages that arrived.
+   */
+  int advanceTransit(uint64_t now_ns) {
+    if (!shm || atomicLoad(shm->transit.in_transit) == 0)
+      return 0;
+
+    LockSiteScope site(LockSite::BeltTransit);
+    lock_fn();
+    if (waitFailed())
+      return 0;
+    BeltTransit &transit = shm->transit;
+    int arrived = transit.wheel.advance(
+        now_ns / BELT_TICK_NS,
+        [this](uint32_t slot) { markArrived(static_cast<int>(slot)); });
+    transit.in_transit -= arrived;
+    if (arrived > 0)
+      bumpGeneration(shm, StateRegion::Belt);
+    unlock_fn();
+
+    for (int i = 0; i < arrived; ++i)
+      signal_full_fn();
+    return arrived;
+  }
+
+  /**
+   * @brief Transit ticker: calls `advanceTransit` every `BELT_TICK_NS`.
+   * * Runs in the belt process until `stop` is set or the system stops.
+   * Overruns are not replayed; the next call catches up on all due ticks.
+   */
+  void runTransit(const std::atomic<bool> &stop) {
+    uint64_t deadline = monotonicNowNs();
+    while (!stop.load() && shm && shm->running) {
+      uint64_t now = monotonicNowNs();
+      advanceTransit(now);
+
+      deadline += BELT_TICK_NS;
+      if (deadline <= now)
+        deadline = now + BELT_TICK_NS;
+      struct timespec next;
+      next.tv_sec = static_cast<time_t>(deadline / 1000000000ULL);
+      next.tv_nsec = static_cast<long>(deadline % 1000000000ULL);
+      while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr) ==
+             EINTR) {
+        if (stop.load())
+          break;
+      }
+    }
+  }
+
+  /** @brief Packages on the belt that have not reached its end yet. */
+  int getInTransit() const { return shm ? shm->transit.in_transit : 0; }
+
+  /**
+   * @brief Enables or disables the artificial delay in `push`.
+   * * Disabled when the caller paces itself (e.g. a Worker with a target
+   * arrival rate), so the two delays do not compound.
+   */
+  void setWorkloadSimulation(bool enabled) { simulate_workload = enabled; }
+
+  /** @brief Attaches the audit journal (nullptr disables auditing). */
+  void setJournal(AuditJournal *j) { journal = j; }
+
+  /**
+   * @brief Lets `push` and `pop` notice a wait interrupted by a signal.
+   * * Without it an interrupted wait is taken as a permit, which skews the
+   * slot semaphores by one each time a role process is stopped mid-wait.
+   * The mutex is only given up at shutdown; every holder then returns
+   * without the V (and hands back a slot permit it already took).
+   */
+  void setWaitFailedCheck(std::function<bool()> check) {
+    wait_failed_fn = std::move(check);
+  }
+
+  /**
+   * @brief Hands a package over to the next Dispatcher of its lane.
+   * * Used by a Dispatcher that stops before it could load the package.
+   * @param pkg The package (still counted in `packages_in_dispatch`).
+   * @param lane Lane it was taken from, -1 for the belt.
+   * @return false if the shelf is full.
+   */
+  bool park(const Package &pkg, int lane) {
+    if (!shm)
+      return false;
+    lock_fn();
+    if (waitFailed())
+      return false;
+    HandoffShelf &shelf = shm->handoff;
+    bool parked = shelf.count < HANDOFF_SLOTS;
+    if (parked) {
+      shelf.lane[shelf.count] = lane;
+      shelf.parked[shelf.count] = pkg;
+      shelf.count++;
+    }
+    unlock_fn();
+    return parked;
+  }
+
+  /**
+   * @brief Takes a package handed over for `lane`, if there is one.
+   * @param lane Lane served by the caller, -1 for the belt.
+   * @param pkg Receives the package.
+   */
+  bool unpark(int lane, Package &pkg) {
+    if (!shm || atomicLoad(shm->handoff.count) == 0)
+      return false;
+    lock_fn();
+    if (waitFailed())
+      return false;
+    HandoffShelf &shelf = shm->handoff;
+    bool found = false;
+    for (int i = 0; i < shelf.count && !found; ++i) {
+      if (shelf.lane[i] != lane)
+        continue;
+      pkg = shelf.parked[i];
+      shelf.count--;
+      shelf.lane[i] = shelf.lane[shelf.count];
+      shelf.parked[i] = shelf.parked[shelf.count];
+      found = true;
+    }
+    unlock_fn();
+    return found;
+  }
+
   /** @brief Returns the current number of items on the belt. */
   int getCount() const { return shm ? shm->current_items_count : 0; }
 
@@ -4,6 +4,7 @@
  */
 
 #pragma once
+#include "JsonLog.h"
 #include "spdlog/sinks/basic_file_sink.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 #include "spdlog/spdlog.h"
@@ -41,10 +42,18 @@ public:
    * @param defaultVal The value to return if the variable is not set in the OS.
    * @return The environment variable's value or the defaultVal.
    */
-  std::string getEnv(const std::string &key,
-                     const std::string &defaultVal = "") {
-    char *raw = std::getenv(key.c_str());
-    return raw ? std::string(raw) : defaultVal;
+  std::string getEnv(const char *key, const char *defaultVal = "") {
+    return getEnvRaw(key, defaultVal);
+  }
+
+  /**
+   * @brief Allocation-free variant of getEnv().
+   * * Returns a pointer into the process environment (or `defaultVal`), so
+   * it is safe to call from hot paths; the pointer is invalidated by setenv.
+   */
+  static const char *getEnvRaw(const char *key, const char *defaultVal = "") {
+    const char *raw = std::getenv(key);
+    return raw ? raw : defaultVal;
   }
 
   /**
@@ -76,6 +85,8 @@ public:
    * - LOG_TO_CONSOLE: "true"/"false" (default: true)
    * - LOG_TO_FILE: "true"/"false" (default: false)
    * - LOG_LEVEL: "trace"..."off" (default: info)
+   * - LOG_FORMAT: "text" or "json" (default: text). JSON writes one object
+   * per line and switches the hot paths to typed fields (see JsonLog.h).
    *
    * * Creates a combined logger that can write to one file simultaneusly.
    *
@@ -88,6 +99,7 @@ public:
     bool to_console = getEnv("LOG_TO_CONSOLE", "true") == "true";
     bool to_file = getEnv("LOG_TO_FILE", "true") == "true";
     std::string level_str = getEnv("LOG_LEVEL", "info");
+    bool json = getEnv("LOG_FORMAT", "text") == "json";
 
     try {
       std::vector<spdlog::sink_ptr> sinks;
@@ -106,7 +118,11 @@ public:
       auto logger = std::make_shared<spdlog::logger>(proc_name, sinks.begin(),
                                                      sinks.end());
 
-      logger->set_pattern("[%H:%M:%S.%e] [%n] [%^%l%$] %v");
+      if (json)
+        logger->set_formatter(std::make_unique<JsonFormatter>());
+      else
+        logger->set_pattern("[%H:%M:%S.%e] [%n] [%^%l%$] %v");
+      JsonLog::setEnabled(json);
       logger->set_level(dispatchLogLevel(level_str));
       spdlog::set_default_logger(logger);
       spdlog::flush_on(spdlog::level::info);
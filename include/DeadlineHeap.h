@@ -0,0 +1,94 @@
+/**
+ * @file DeadlineHeap.h
+ * @brief Bounded d-ary min-heap of deadlines that lives in shared memory.
+ *
+ * Used by the belt to serve packages earliest-deadline-first. A d-ary heap
+ * is shallower than a binary one (log_d n levels), so a push moves fewer
+ * entries and a pop touches d contiguous children per level, which share a
+ * cache line for d = 4. Both are O(log n).
+ *
+ * The structure is POD and valid when zero-filled. Callers serialize access
+ * (the belt keeps it under the belt mutex).
+ */
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @struct DeadlineHeap
+ * @brief Pending entries ordered by deadline, ties broken by sequence.
+ * @tparam Capacity Maximum number of entries.
+ * @tparam Arity Children per node.
+ */
+template <int Capacity, int Arity = 4> struct DeadlineHeap {
+  static_assert(Arity >= 2, "a heap needs at least two children per node");
+
+  /** @brief One pending entry. */
+  struct Entry {
+    uint64_t deadline; /**< Key; smallest is served first. */
+    uint64_t seq;      /**< Insertion order, keeps equal deadlines FIFO. */
+    uint32_t payload;  /**< Caller data (e.g. a belt slot). */
+  };
+
+  int32_t size;      /**< Entries in `entries[0, size)`. */
+  uint64_t next_seq; /**< Sequence of the next push. */
+  Entry entries[Capacity];
+
+  /** @brief True if `a` is served before `b`. */
+  static bool before(const Entry &a, const Entry &b) {
+    return a.deadline != b.deadline ? a.deadline < b.deadline : a.seq < b.seq;
+  }
+
+  /**
+   * @brief Inserts `payload` with `deadline`.
+   * @return false if `Capacity` entries are already pending.
+   */
+  bool push(uint64_t deadline, uint32_t payload) {
+    if (size >= Capacity)
+      return false;
+    Entry e{deadline, next_seq++, payload};
+    int i = size++;
+    while (i > 0) {
+      int parent = (i - 1) / Arity;
+      if (!before(e, entries[parent]))
+        break;
+      entries[i] = entries[parent];
+      i = parent;
+    }
+    entries[i] = e;
+    return true;
+  }
+
+  /** @brief Entry with the earliest deadline, nullptr if empty. */
+  const Entry *top() const { return size > 0 ? &entries[0] : nullptr; }
+
+  /**
+   * @brief Removes the entry with the earliest deadline.
+   * @param out Receives the removed entry.
+   * @return false if the heap is empty.
+   */
+  bool pop(Entry &out) {
+    if (size <= 0)
+      return false;
+    out = entries[0];
+    Entry last = entries[--size];
+    int i = 0;
+    for (;;) {
+      int first = i * Arity + 1;
+      if (first >= size)
+        break;
+      int end = first + Arity < size ? first + Arity : size;
+      int best = first;
+      for (int c = first + 1; c < end; ++c) {
+        if (before(entries[c], entries[best]))
+          best = c;
+      }
+      if (!before(entries[best], last))
+        break;
+      entries[i] = entries[best];
+      i = best;
+    }
+    entries[i] = last;
+    return true;
+  }
+};
@@ -0,0 +1,501 @@
+/**
+ * @file DeliveryLedger.h
+ * @brief Columnar binary ledger of truck departures.
+ *
+ * Every departure is one row. Rows are buffered per truck process and written
+ * as self-contained blocks: a header with the row count and min/max of every
+ * column, followed by one contiguous array per column. Blocks are appended
+ * with a single `writev` on an `O_APPEND` descriptor, so several truck
+ * processes can share one file without interleaving. A block is written
+ * when it is full, when `LEDGER_FLUSH_ROWS` rows or `LEDGER_FLUSH_MS` of
+ * age have accumulated, and on shutdown, which bounds what a killed truck
+ * loses.
+ *
+ * File layout (all offsets 8-byte aligned, native endianness):
+ * @code
+ *   LedgerFileHeader
+ *   { LedgerBlockHeader | f64 columns | i32 columns | u8 column | pad } *
+ * @endcode
+ *
+ * Readers map the file and touch only the columns a query needs; blocks
+ * whose statistics exclude the filter are skipped without reading rows.
+ */
+#pragma once
+
+#include "Shared.h"
+#include "Telemetry.h"
+#include "spdlog/spdlog.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/** @name Ledger Layout
+ * @{ */
+constexpr uint32_t LEDGER_MAGIC = 0x47444C57;       /**< "WLDG". */
+constexpr uint32_t LEDGER_BLOCK_MAGIC = 0x4B4C4257; /**< "WBLK". */
+constexpr uint32_t LEDGER_VERSION = 2;
+constexpr uint32_t LEDGER_BLOCK_ROWS = 4096; /**< Largest block [rows]. */
+constexpr uint32_t LEDGER_FLUSH_ROWS = 256;  /**< Default row threshold. */
+constexpr int LEDGER_FLUSH_MS = 5000;        /**< Default age threshold. */
+/** @} */
+
+/**
+ * @enum LedgerColumn
+ * @brief Column order on disk: 8-byte columns, then 4-byte, then 1-byte.
+ */
+enum LedgerColumn : int {
+  COL_DOCK_NS = 0,    /**< u64, CLOCK_REALTIME ns when the truck docked. */
+  COL_DEPART_NS,      /**< u64, CLOCK_REALTIME ns when it departed. */
+  COL_WEIGHT,         /**< f64, payload weight [kg]. */
+  COL_VOLUME,         /**< f64, payload volume [m3]. */
+  COL_MAX_WEIGHT,     /**< f64, weight capacity W [kg]. */
+  COL_MAX_VOLUME,     /**< f64, volume capacity V [m3]. */
+  COL_TRUCK_ID,       /**< i32, truck PID. */
+  COL_LOAD_COUNT,     /**< i32, packages loaded by the dispatcher. */
+  COL_REASON,         /**< u8, DepartureReason. */
+  LEDGER_COLUMNS
+};
+
+/** @brief Width in bytes of every column. */
+constexpr size_t ledgerColumnWidth(int col) {
+  return col < COL_TRUCK_ID ? 8 : (col < COL_REASON ? 4 : 1);
+}
+
+
+/** @brief Bytes of column data for `rows` rows, padded to 8. */
+constexpr size_t ledgerBlockPayload(uint32_t rows) {
+  size_t bytes = 0;
+  for (int c = 0; c < LEDGER_COLUMNS; ++c)
+    bytes += ledgerColumnWidth(c) * rows;
+  return (bytes + 7) & ~size_t{7};
+}
+
+/**
+ * @struct LedgerFileHeader
+ * @brief First 16 bytes of a ledger file.
+ */
+struct LedgerFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t columns;
+  uint32_t block_rows;
+};
+
+/**
+ * @union LedgerStat
+ * @brief One block statistic in the type of its column.
+ * * Integer and time columns use `u`, so ns timestamps (far beyond the 2^53
+ * a double holds exactly) compare exactly; f64 columns use `f`.
+ */
+union LedgerStat {
+  uint64_t u;
+  double f;
+};
+
+/**
+ * @struct LedgerBlockHeader
+ * @brief Row count and per-column statistics of one block.
+ */
+struct LedgerBlockHeader {
+  uint32_t magic;
+  uint32_t rows;
+  LedgerStat min[LEDGER_COLUMNS];
+  LedgerStat max[LEDGER_COLUMNS];
+};
+static_assert(sizeof(LedgerBlockHeader) % 8 == 0, "Columns must stay aligned");
+
+/**
+ * @struct DeliveryRecord
+ * @brief One departure, in row form.
+ */
+struct DeliveryRecord {
+  int truck_id;
+  uint64_t dock_ns;
+  uint64_t depart_ns;
+  int load_count;
+  double weight;
+  double volume;
+  double max_weight;
+  double max_volume;
+  DepartureReason reason;
+};
+
+/**
+ * @class DeliveryLedger
+ * @brief Writer side, one instance per truck process.
+ *
+ * Rows are buffered in fixed column arrays inside the object, so `append`
+ * never allocates. A block is written when full, when the flush policy is
+ * due (see `flushIfDue`) and on `flush`/destruction.
+ */
+class DeliveryLedger {
+private:
+  int fd = -1;
+  uint32_t rows = 0;
+  LedgerBlockHeader header;
+
+  /** @name Flush Policy
+   * @{ */
+  uint32_t flush_rows = LEDGER_FLUSH_ROWS;
+  uint64_t flush_ns = LEDGER_FLUSH_MS * 1000000ULL;
+  uint64_t oldest_ns = 0; /**< Buffering time of the first pending row. */
+  /** @} */
+
+  uint64_t dock_ns[LEDGER_BLOCK_ROWS];
+  uint64_t depart_ns[LEDGER_BLOCK_ROWS];
+  double weight[LEDGER_BLOCK_ROWS];
+  double volume[LEDGER_BLOCK_ROWS];
+  double max_weight[LEDGER_BLOCK_ROWS];
+  double max_volume[LEDGER_BLOCK_ROWS];
+  int32_t truck_id[LEDGER_BLOCK_ROWS];
+  int32_t load_count[LEDGER_BLOCK_ROWS];
+  uint8_t reason[LEDGER_BLOCK_ROWS];
+
+  void track(int col, uint64_t value) {
+    if (rows == 0 || value < header.min[col].u)
+      header.min[col].u = value;
+    if (rows == 0 || value > header.max[col].u)
+      header.max[col].u = value;
+  }
+
+  void track(int col, double value) {
+    if (rows == 0 || value < header.min[col].f)
+      header.min[col].f = value;
+    if (rows == 0 || value > header.max[col].f)
+      header.max[col].f = value;
+  }
+
+public:
+  /**
+   * @brief Opens (or creates) the ledger at `path` for appending.
+   * * The file header is written by whichever process creates the file.
+   */
+  explicit DeliveryLedger(const std::string &path) {
+    fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd == -1) {
+      spdlog::error("[ledger] Cannot open {}: {}", path, std::strerror(errno));
+      return;
+    }
+
+    LedgerFileHeader file_header = {LEDGER_MAGIC, LEDGER_VERSION,
+                                    LEDGER_COLUMNS, LEDGER_BLOCK_ROWS};
+    // Several trucks may open a fresh file at once; the size is re-checked
+    // under an advisory lock so exactly one of them writes the header.
+    struct stat st;
+    if (flock(fd, LOCK_EX) == 0) {
+      if (fstat(fd, &st) == 0 && st.st_size == 0 &&
+          write(fd, &file_header, sizeof(file_header)) == -1) {
+        spdlog::error("[ledger] Cannot write header: {}", std::strerror(errno));
+      }
+      flock(fd, LOCK_UN);
+    }
+  }
+
+  ~DeliveryLedger() {
+    flush();
+    if (fd != -1)
+      close(fd);
+  }
+
+  DeliveryLedger(const DeliveryLedger &) = delete;
+  DeliveryLedger &operator=(const DeliveryLedger &) = delete;
+
+  /** @brief True if the file could be opened. */
+  bool isOpen() const { return fd != -1; }
+
+  /**
+   * @brief Truncates the ledger of a previous run.
+   * * Called by the IPC owner so each simulation starts with an empty file.
+   */
+  static void reset(const std::string &path) {
+    int f = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (f != -1)
+      close(f);
+  }
+
+  /**
+   * @brief Overrides when partial blocks are written.
+   * @param max_rows Write once this many rows are buffered.
+   * @param max_age_ms Write once the oldest buffered row is this old
+   * (0 = no age limit).
+   */
+  void setFlushPolicy(uint32_t max_rows, int max_age_ms) {
+    flush_rows = max_rows > 0 && max_rows < LEDGER_BLOCK_ROWS
+                     ? max_rows
+                     : LEDGER_BLOCK_ROWS;
+    flush_ns = max_age_ms > 0 ? max_age_ms * 1000000ULL : UINT64_MAX;
+  }
+
+  /**
+   * @brief Buffers one departure; writes the block once the flush policy
+   * is due.
+   */
+  void append(const DeliveryRecord &r) {
+    if (fd == -1)
+      return;
+
+    uint64_t now = monotonicNowNs();
+    if (rows == 0)
+      oldest_ns = now;
+
+    track(COL_DOCK_NS, r.dock_ns);
+    track(COL_DEPART_NS, r.depart_ns);
+    track(COL_WEIGHT, r.weight);
+    track(COL_VOLUME, r.volume);
+    track(COL_MAX_WEIGHT, r.max_weight);
+    track(COL_MAX_VOLUME, r.max_volume);
+    track(COL_TRUCK_ID, static_cast<uint64_t>(r.truck_id));
+    track(COL_LOAD_COUNT, static_cast<uint64_t>(r.load_count));
+    track(COL_REASON, static_cast<uint64_t>(r.reason));
+
+    dock_ns[rows] = r.dock_ns;
+    depart_ns[rows] = r.depart_ns;
+    weight[rows] = r.weight;
+    volume[rows] = r.volume;
+    max_weight[rows] = r.max_weight;
+    max_volume[rows] = r.max_volume;
+    truck_id[rows] = r.truck_id;
+    load_count[rows] = r.load_count;
+    reason[rows] = static_cast<uint8_t>(r.reason);
+
+    ++rows;
+    flushIfDue(now);
+  }
+
+  /**
+   * @brief Writes the pending rows if the row or age threshold is reached.
+   * * Called on every append and periodically by the owner (the truck does
+   * so on every pass of its loop) so rows do not wait for the next
+   * departure.
+   * @param now_ns Current `monotonicNowNs()`.
+   */
+  void flushIfDue(uint64_t now_ns) {
+    if (rows >= flush_rows || (rows > 0 && now_ns - oldest_ns >= flush_ns))
+      flush();
+  }
+
+  /**
+   * @brief Writes the buffered rows as one block.
+   * @return false if the write failed (the rows are dropped).
+   */
+  bool flush() {
+    if (fd == -1 || rows == 0)
+      return true;
+
+    header.magic = LEDGER_BLOCK_MAGIC;
+    header.rows = rows;
+
+    static const uint8_t padding[8] = {};
+    size_t used = 0;
+    for (int c = 0; c < LEDGER_COLUMNS; ++c)
+      used += ledgerColumnWidth(c) * rows;
+
+    struct iovec iov[LEDGER_COLUMNS + 2] = {
+        {&header, sizeof(header)},
+        {dock_ns, rows * sizeof(uint64_t)},
+        {depart_ns, rows * sizeof(uint64_t)},
+        {weight, rows * sizeof(double)},
+        {volume, rows * sizeof(double)},
+        {max_weight, rows * sizeof(double)},
+        {max_volume, rows * sizeof(double)},
+        {truck_id, rows * sizeof(int32_t)},
+        {load_count, rows * sizeof(int32_t)},
+        {reason, rows * sizeof(uint8_t)},
+        {const_cast<uint8_t *>(padding), ledgerBlockPayload(rows) - used}};
+
+    size_t expected = sizeof(header) + ledgerBlockPayload(rows);
+    ssize_t written = writev(fd, iov, LEDGER_COLUMNS + 2);
+    rows = 0;
+
+    if (written != static_cast<ssize_t>(expected)) {
+      spdlog::error("[ledger] Short block write ({} of {} bytes)", written,
+                    expected);
+      return false;
+    }
+    return true;
+  }
+
+  /** @brief Rows waiting for the next block write. */
+  uint32_t pending() const { return rows; }
+};
+
+/**
+ * @struct LedgerFilter
+ * @brief Row predicate of a ledger scan; defaults match everything.
+ */
+struct LedgerFilter {
+  int truck_id = -1;           /**< -1 = any truck. */
+  int reason = -1;             /**< -1 = any reason. */
+  uint64_t from_ns = 0;        /**< Departed at or after. */
+  uint64_t to_ns = UINT64_MAX; /**< Departed before. */
+};
+
+/**
+ * @struct LedgerAggregate
+ * @brief Result of a scan.
+ */
+struct LedgerAggregate {
+  uint64_t departures = 0;
+  uint64_t packages = 0;
+  double weight = 0.0;
+  double volume = 0.0;
+  double weight_utilization = 0.0; /**< Sum of weight / max_weight. */
+  double volume_utilization = 0.0; /**< Sum of volume / max_volume. */
+  double dock_seconds = 0.0;       /**< Sum of time spent at the dock. */
+  uint64_t first_depart_ns = 0;
+  uint64_t last_depart_ns = 0;
+  uint64_t by_reason[static_cast<int>(DepartureReason::Total)] = {};
+  uint64_t blocks_scanned = 0;
+  uint64_t blocks_skipped = 0;
+
+  double meanWeightUtilization() const {
+    return departures ? weight_utilization / departures : 0.0;
+  }
+  double meanVolumeUtilization() const {
+    return departures ? volume_utilization / departures : 0.0;
+  }
+};
+
+/**
+ * @class LedgerReader
+ * @brief Read-only, memory-mapped view of a ledger file.
+ */
+class LedgerReader {
+private:
+  const uint8_t *base = nullptr;
+  size_t size = 0;
+
+  /** @brief True if the block statistics rule out every row. */
+  static bool skippable(const LedgerBlockHeader &h, const LedgerFilter &f) {
+    auto outside = [&h](int col, uint64_t v) {
+      return v < h.min[col].u || v > h.max[col].u;
+    };
+    if (f.truck_id >= 0 &&
+        outside(COL_TRUCK_ID, static_cast<uint64_t>(f.truck_id)))
+      return true;
+    if (f.reason >= 0 && outside(COL_REASON, static_cast<uint64_t>(f.reason)))
+      return true;
+    if (f.from_ns > h.max[COL_DEPART_NS].u ||
+        f.to_ns <= h.min[COL_DEPART_NS].u)
+      return true;
+    return false;
+  }
+
+public:
+  explicit LedgerReader(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+      return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 &&
+        st.st_size >= static_cast<off_t>(sizeof(LedgerFileHeader))) {
+      void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      if (p != MAP_FAILED) {
+        base = static_cast<const uint8_t *>(p);
+        size = st.st_size;
+      }
+    }
+    close(fd);
+
+    if (base) {
+      auto *fh = reinterpret_cast<const LedgerFileHeader *>(base);
+      if (fh->magic != LEDGER_MAGIC || fh->version != LEDGER_VERSION ||
+          fh->columns != LEDGER_COLUMNS) {
+        munmap(const_cast<uint8_t *>(base), size);
+        base = nullptr;
+        size = 0;
+      }
+    }
+  }
+
+  ~LedgerReader() {
+    if (base)
+      munmap(const_cast<uint8_t *>(base), size);
+  }
+
+  LedgerReader(const LedgerReader &) = delete;
+  LedgerReader &operator=(const LedgerReader &) = delete;
+
+  /** @brief True if the file exists and has a valid header. */
+  bool valid() const { return base != nullptr; }
+
+  /**
+   * @brief Visits every complete block.
+   * @param fn Callable taking `(const LedgerBlockHeader &, const uint8_t
+   * *columns[LEDGER_COLUMNS])`.
+   */
+  template <typename Fn> void forEachBlock(Fn fn) const {
+    size_t off = sizeof(LedgerFileHeader);
+    while (base && off + sizeof(LedgerBlockHeader) <= size) {
+      auto *h = reinterpret_cast<const LedgerBlockHeader *>(base + off);
+      if (h->magic != LEDGER_BLOCK_MAGIC || h->rows == 0 ||
+          h->rows > LEDGER_BLOCK_ROWS)
+        break;
+      size_t payload = ledgerBlockPayload(h->rows);
+      if (off + sizeof(LedgerBlockHeader) + payload > size)
+        break;
+
+      const uint8_t *cols[LEDGER_COLUMNS];
+      const uint8_t *p = base + off + sizeof(LedgerBlockHeader);
+      for (int c = 0; c < LEDGER_COLUMNS; ++c) {
+        cols[c] = p;
+        p += ledgerColumnWidth(c) * h->rows;
+      }
+      fn(*h, cols);
+      off += sizeof(LedgerBlockHeader) + payload;
+    }
+  }
+
+  /**
+   * @brief Aggregates the rows matching `filter`.
+   */
+  LedgerAggregate scan(const LedgerFilter &filter = {}) const {
+    LedgerAggregate agg;
+    forEachBlock([&](const LedgerBlockHeader &h, const uint8_t *const *cols) {
+      if (skippable(h, filter)) {
+        agg.blocks_skipped++;
+        return;
+      }
+      agg.blocks_scanned++;
+
+      auto dock = reinterpret_cast<const uint64_t *>(cols[COL_DOCK_NS]);
+      auto depart = reinterpret_cast<const uint64_t *>(cols[COL_DEPART_NS]);
+      auto w = reinterpret_cast<const double *>(cols[COL_WEIGHT]);
+      auto v = reinterpret_cast<const double *>(cols[COL_VOLUME]);
+      auto max_w = reinterpret_cast<const double *>(cols[COL_MAX_WEIGHT]);
+      auto max_v = reinterpret_cast<const double *>(cols[COL_MAX_VOLUME]);
+      auto truck = reinterpret_cast<const int32_t *>(cols[COL_TRUCK_ID]);
+      auto load = reinterpret_cast<const int32_t *>(cols[COL_LOAD_COUNT]);
+      const uint8_t *reason = cols[COL_REASON];
+
+      for (uint32_t i = 0; i < h.rows; ++i) {
+        if ((filter.truck_id >= 0 && truck[i] != filter.truck_id) ||
+            (filter.reason >= 0 && reason[i] != filter.reason) ||
+            depart[i] < filter.from_ns || depart[i] >= filter.to_ns)
+          continue;
+
+        agg.departures++;
+        agg.packages += load[i];
+        agg.weight += w[i];
+        agg.volume += v[i];
+        agg.weight_utilization += max_w[i] > 0 ? w[i] / max_w[i] : 0.0;
+        agg.volume_utilization += max_v[i] > 0 ? v[i] / max_v[i] : 0.0;
+        agg.dock_seconds +=
+            depart[i] > dock[i] ? (depart[i] - dock[i]) / 1e9 : 0.0;
+        if (agg.first_depart_ns == 0 || depart[i] < agg.first_depart_ns)
+          agg.first_depart_ns = depart[i];
+        if (depart[i] > agg.last_depart_ns)
+          agg.last_depart_ns = depart[i];
+        if (reason[i] < static_cast<int>(DepartureReason::Total))
+          agg.by_reason[reason[i]]++;
+      }
+    });
+    return agg;
+  }
+};
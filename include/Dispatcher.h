@@ -9,8 +9,16 @@
  */
 #pragma once
 
+#include "AuditJournal.h"
 #include "Belt.h"
+#include "DockController.h"
+#include "JsonLog.h"
+#include "LockProfiler.h"
+#include "LogThrottle.h"
+#include "Probes.h"
 #include "Shared.h"
+#include "Telemetry.h"
+#include "Watchdog.h"
 #include "spdlog/spdlog.h"
 #include <chrono>
 #include <functional>
@@ -38,15 +46,27 @@ private:
   /** @brief Pointer to the system's Shared Memory state. */
   SharedState *shm;
 
-  /** @name IPC Synchronization Callbacks
-   * Functions injected to handle synchronization without tight coupling to the
-   * Manager.
+  /** @brief Cleared by `stop()` to leave the service loop. */
+  bool active = true;
+
+  /** @brief Audit journal receiving load events (nullptr = disabled). */
+  AuditJournal *journal = nullptr;
+
+  /** @brief Heartbeat target (nullptr = not watched). */
+  ProcessHealth *health = nullptr;
+
+  /** @name Lane Binding
+   * Defaults to the belt and the single dock; see `setLane`.
    * @{ */
-  std::function<void()> lock_dock_fn;   /**< Acquires Dock Mutex. */
-  std::function<void()> unlock_dock_fn; /**< Releases Dock Mutex. */
-  std::function<void(pid_t, SignalType)>
-      send_signal_fn; /**< Sends IPC signals. */
-                      /** @} */
+  std::function<Package()> pop_fn; /**< Source of packages. */
+  LaneState *lane = nullptr;       /**< Lane served (nullptr = belt). */
+  /** @} */
+
+  /** @brief Loads into the dock, combined with the other loaders. */
+  DockController loader;
+
+  /** @brief Index of the lane served, -1 for the belt (handoff key). */
+  int laneIndex() const { return lane ? int(lane - shm->lanes) : -1; }
 
 public:
   /**
@@ -61,29 +81,37 @@ public:
   Dispatcher(Belt *b, SharedState *s, std::function<void()> lock_dock,
              std::function<void()> unlock_dock,
              std::function<void(pid_t, SignalType)> send_signal)
-      : belt(b), shm(s), lock_dock_fn(lock_dock), unlock_dock_fn(unlock_dock),
-        send_signal_fn(send_signal) {}
+      : belt(b), shm(s), pop_fn([b]() { return b->pop(); }),
+        loader(&s->dock_truck, s, std::move(lock_dock), std::move(unlock_dock),
+               std::move(send_signal)) {}
 
   /**
    * @brief Processes a single package from the belt.
    *
    * This method implements the core routing algorithm:
    * 1. **Pop:** Retrieves a package from the belt (blocking if empty).
-   * 2. **Load Loop:** Attempts to load the package onto the current truck.
-   * - **Constraint Check:** Verifies if `current + new <= max` for both Weight
-   * and Volume.
-   * - **Success:** Updates truck state. If truck reaches ~99% capacity or max
-   * item count, sends `SIGNAL_DEPARTURE`.
-   * - **Failure (Does not fit):** Sends `SIGNAL_DEPARTURE` to force the full
-   * truck away, then waits for a new truck.
+   * 2. **Load Loop:** Submits the package to the dock's `DockController`,
+   * which applies the fit check (see `applyLoad`).
+   * - **Success:** The truck state is updated. If the truck reaches ~99%
+   * capacity or max item count, `SIGNAL_DEPARTURE` was sent.
+   * - **Failure (Does not fit):** `SIGNAL_DEPARTURE` forced the full truck
+   * away; waits for a new truck.
    * 3. **Retry:** Loops until the package is successfully loaded onto a
-   * (potentially new) truck.
+   * (potentially new) truck. After `stop()` the package is parked on the
+   * belt's handoff shelf instead, and the next dispatcher of the same lane
+   * takes it before popping.
    *
-   * @note This method handles the synchronization critical section for the
-   * Dock.
+   * @note The dock mutex is taken by whichever loader combines the request.
    */
   void processNextPackage() {
-    Package pkg = belt->pop();
+    LockSiteScope site(LockSite::DockDispatcher);
+    Package pkg;
+    bool handed_over = belt->unpark(laneIndex(), pkg);
+    if (handed_over)
+      spdlog::info("[dispatcher] Took over Pkg {} from a stopped dispatcher.",
+                   pkg.id);
+    else
+      pkg = pop_fn();
 
     if (pkg.id == 0) {
       if (shm->running) {
@@ -92,58 +120,104 @@ public:
       return;
     }
 
+    if (!handed_over)
+      atomicAdd(shm->stats.packages_in_dispatch, 1);
     bool loaded = false;
 
     while (!loaded && shm->running) {
-      lock_dock_fn();
-      TruckState &truck = shm->dock_truck;
-
-      if (truck.is_present) {
-        bool fits_weight =
-            (truck.current_weight + pkg.weight <= truck.max_weight);
-        bool fits_volume =
-            (truck.current_volume + pkg.volume <= truck.max_volume);
-
-        if (fits_weight && fits_volume) {
-          truck.current_weight += pkg.weight;
-          truck.current_volume += pkg.volume;
-          truck.current_load++;
-          loaded = true;
-
-          spdlog::info("[dispatcher] Loaded Pkg {} ({:.1f}kg, {:.3f}m3) -> "
-                       "Truck #{}. State: {:.1f}/{} kg, {:.3f}/{} m3",
-                       pkg.id, pkg.weight, pkg.volume, truck.id,
-                       truck.current_weight, truck.max_weight,
-                       truck.current_volume, truck.max_volume);
-
-          if (truck.current_load >= truck.max_load ||
-              truck.current_weight >= truck.max_weight * 0.99 ||
-              truck.current_volume >= truck.max_volume * 0.99) {
-
-            spdlog::info("[dispatcher] Truck #{} FULL (Limit reached). Sending "
-                         "DEPARTURE.",
-                         truck.id);
-            send_signal_fn(truck.id, SIGNAL_DEPARTURE);
-          }
-        } else {
-          std::string reason = !fits_weight ? "Weight Limit" : "Volume Limit";
-          if (!fits_weight && !fits_volume)
-            reason = "Weight & Volume Limit";
-
-          spdlog::warn("[dispatcher] Pkg {} doesn't fit in Truck #{} ({}). "
-                       "Forcing departure.",
-                       pkg.id, truck.id, reason);
-
-          send_signal_fn(truck.id, SIGNAL_DEPARTURE);
+      const LoadSlot &r = loader.load(&pkg.weight, &pkg.volume, 1, true, true,
+                                      DepartureReason::NoFit);
+
+      if (r.outcome == LoadOutcome::Loaded) {
+        loaded = true;
+
+        atomicAdd(shm->stats.packages_in_dispatch, -1);
+        atomicAdd(shm->stats.packages_loaded, uint64_t{1});
+        bumpGeneration(shm, StateRegion::Fleet);
+        if (lane)
+          atomicAdd(lane->loaded, uint64_t{1});
+        uint64_t now = monotonicNowNs();
+        recordLatency(shm->stats, now - pkg.created_ns);
+        recordDeadline(shm->stats, pkg, now);
+        WAREHOUSE_PROBE3(package__load, pkg.id, r.truck_id,
+                         now - pkg.created_ns);
+
+        if (WAREHOUSE_LOG_ENABLED(LogSubsystem::Dispatcher,
+                                  spdlog::level::info)) {
+          if (JsonLog::enabled(spdlog::level::info))
+            JsonRecord("load")
+                .field("id", pkg.id)
+                .field("kg", pkg.weight)
+                .field("m3", pkg.volume)
+                .field("truck", r.truck_id)
+                .field("truck_kg", r.truck_weight)
+                .field("truck_m3", r.truck_volume)
+                .field("lane", laneIndex())
+                .field("latency_us", (now - pkg.created_ns) / 1000)
+                .log(spdlog::level::info);
+          else
+            spdlog::info("[dispatcher] Loaded Pkg {} ({:.1f}kg, {:.3f}m3) -> "
+                         "Truck #{}. State: {:.1f} kg, {:.3f} m3",
+                         pkg.id, pkg.weight, pkg.volume, r.truck_id,
+                         r.truck_weight, r.truck_volume);
         }
+        if (r.departure_sent)
+          WAREHOUSE_LOG(LogSubsystem::Dispatcher, spdlog::level::info,
+                        "[dispatcher] Truck #{} FULL (Limit reached). "
+                        "Sent DEPARTURE.",
+                        r.truck_id);
+      } else if (r.departure_sent || r.departure_repeated) {
+        WAREHOUSE_LOG_REPEAT(LogSubsystem::Dispatcher, spdlog::level::warn,
+                             pkg.id,
+                             "[dispatcher] Pkg {} doesn't fit in Truck #{}. "
+                             "Forced departure.",
+                             pkg.id, r.truck_id);
       }
+      if (r.departure_repeated)
+        atomicAdd(shm->stats.departures_coalesced, uint64_t{1});
 
-      unlock_dock_fn();
-
+      if (!loaded && !active && belt->park(pkg, laneIndex())) {
+        spdlog::info("[dispatcher] Stopping. Pkg {} handed over.", pkg.id);
+        return;
+      }
       if (!loaded) {
         std::this_thread::sleep_for(std::chrono::milliseconds(200));
       }
     }
+
+    if (loaded && journal)
+      journal->append(pkg.id, ActionType::LoadedToTruck | ActionType::ByTruck);
+  }
+
+  /**
+   * @brief Requests the service loop to finish after the current package.
+   */
+  void stop() { active = false; }
+
+  /** @brief Attaches the audit journal (nullptr disables auditing). */
+  void setJournal(AuditJournal *j) { journal = j; }
+
+  /** @brief See DockController::setWaitFailedCheck. */
+  void setWaitFailedCheck(std::function<bool()> check) {
+    loader.setWaitFailedCheck(std::move(check));
+  }
+
+  /** @brief Beats `h` once per package handled (see Watchdog.h). */
+  void setHealth(ProcessHealth *h) { health = h; }
+
+  /**
+   * @brief Serves a sorter lane instead of the belt and the single dock.
+   * @param pop Pops the next package of the lane.
+   * @param state Shared lane state (its dock is loaded).
+   * @param lock_dock Locks the lane's dock.
+   * @param unlock_dock Unlocks the lane's dock.
+   */
+  void setLane(std::function<Package()> pop, LaneState *state,
+               std::function<void()> lock_dock,
+               std::function<void()> unlock_dock) {
+    pop_fn = std::move(pop);
+    lane = state;
+    loader.rebind(&state->dock, std::move(lock_dock), std::move(unlock_dock));
   }
 
   /**
@@ -155,7 +229,8 @@ public:
   void run() {
     spdlog::info("[dispatcher] Service started. Controlling the dock.");
 
-    while (shm && shm->running) {
+    while (active && shm && shm->running) {
+      heartbeat(health);
       processNextPackage();
     }
 
@@ -0,0 +1,311 @@
+/**
+ * @file DockController.h
+ * @brief Flat-combining controller for loads into one dock.
+ *
+ * Dispatchers and the Express worker used to take the dock mutex for every
+ * package and each carried its own copy of the fit check. With the
+ * controller, a loader publishes its request in its own `LoadSlot` of the
+ * dock and competes for the combiner role. The winner takes the dock mutex
+ * once, applies every pending request of every loader in one pass and
+ * publishes the per-request results; the others just see their request
+ * served. Under contention one mutex hold replaces N lock handoffs.
+ *
+ * The combiner role is a PID in shared memory taken with a compare-and-swap.
+ * A loader that finds it held by a dead process takes it over, so a crash
+ * cannot wedge the dock. Loaders that find no free slot fall back to
+ * applying their request alone under the dock mutex.
+ */
+#pragma once
+
+#include "Probes.h"
+#include "Shared.h"
+#include "Telemetry.h"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <functional>
+#include <sched.h>
+#include <thread>
+#include <unistd.h>
+
+/**
+ * @brief Applies one load request to the docked truck.
+ *
+ * The single fit check shared by every loader: packages are loaded in order
+ * until one exceeds the remaining weight (W) or volume (V); that one and the
+ * rest stay with the caller and a departure is requested with the slot's
+ * `no_fit_reason`. With `check_full`, a departure is also requested once
+ * the truck reaches its package count or 99% of W or V.
+ *
+ * @param truck Dock state (caller holds the dock mutex).
+ * @param slot Request in, result out.
+ * @param send_signal Sends the DEPARTURE if this request made the request.
+ */
+inline void
+applyLoad(TruckState &truck, LoadSlot &slot,
+          const std::function<void(pid_t, SignalType)> &send_signal) {
+  slot.loaded = 0;
+  slot.departure_sent = false;
+  slot.departure_repeated = false;
+  slot.truck_id = truck.id;
+
+  if (!truck.is_present) {
+    slot.outcome = LoadOutcome::NoTruck;
+    return;
+  }
+
+  DepartureReason reason = DepartureReason::Unknown;
+  slot.outcome = LoadOutcome::Loaded;
+  for (int i = 0; i < slot.items; ++i) {
+    if (truck.current_weight + slot.weight[i] > truck.max_weight ||
+        truck.current_volume + slot.volume[i] > truck.max_volume) {
+      slot.outcome = LoadOutcome::NoFit;
+      reason = slot.no_fit_reason;
+      break;
+    }
+    truck.current_weight += slot.weight[i];
+    truck.current_volume += slot.volume[i];
+    if (slot.counts_load)
+      truck.current_load++;
+    slot.loaded++;
+  }
+
+  if (reason == DepartureReason::Unknown && slot.check_full &&
+      (truck.current_load >= truck.max_load ||
+       truck.current_weight >= truck.max_weight * 0.99 ||
+       truck.current_volume >= truck.max_volume * 0.99))
+    reason = DepartureReason::Full;
+
+  if (reason != DepartureReason::Unknown) {
+    if (requestDeparture(truck, reason)) {
+      send_signal(truck.id, SIGNAL_DEPARTURE);
+      slot.departure_sent = true;
+    } else {
+      slot.departure_repeated = true;
+    }
+  }
+
+  slot.truck_weight = truck.current_weight;
+  slot.truck_volume = truck.current_volume;
+  WAREHOUSE_PROBE3(dock__load, truck.id, slot.loaded,
+                   static_cast<int>(slot.outcome));
+}
+
+/**
+ * @class DockController
+ * @brief One loader's handle on a dock's combining slots.
+ *
+ * Each Dispatcher and Express instance owns one controller; it claims a
+ * slot of the dock on first use and releases it on destruction or when
+ * rebound to another dock.
+ */
+class DockController {
+private:
+  TruckState *dock;
+  SharedState *shm;
+  std::function<void()> lock_dock_fn;
+  std::function<void()> unlock_dock_fn;
+  std::function<void(pid_t, SignalType)> send_signal_fn;
+  std::function<bool()> wait_failed_fn; /**< See Belt::setWaitFailedCheck. */
+
+  pid_t my_pid;
+  LoadSlot *slot = nullptr; /**< Claimed slot, nullptr = not claimed yet. */
+  LoadSlot solo = {};       /**< Used when every slot is taken. */
+
+  /** @brief Spins before a waiter starts sleeping between checks. */
+  static constexpr int SPIN_LIMIT = 64;
+
+  static uint32_t loadAcquire(const uint32_t &v) {
+    return __atomic_load_n(&v, __ATOMIC_ACQUIRE);
+  }
+
+  static bool processDead(int pid) {
+    return pid > 0 && kill(pid, 0) == -1 && errno == ESRCH;
+  }
+
+  /** @brief Claims a free slot, or one left by a dead process. */
+  LoadSlot *claim() {
+    DockCombiner &c = dock->loaders;
+    for (LoadSlot &s : c.slots) {
+      int owner = __atomic_load_n(&s.owner, __ATOMIC_ACQUIRE);
+      if (owner == 0 || processDead(owner)) {
+        if (__atomic_compare_exchange_n(&s.owner, &owner, my_pid, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+          // A dead owner may have left a request unserved.
+          __atomic_store_n(&s.served, s.posted, __ATOMIC_RELEASE);
+          return &s;
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  void release() {
+    if (slot)
+      __atomic_store_n(&slot->owner, 0, __ATOMIC_RELEASE);
+    slot = nullptr;
+  }
+
+  /** @brief Takes the combiner role if free or held by a dead process. */
+  bool tryCombine(bool check_owner) {
+    int holder = 0;
+    if (__atomic_compare_exchange_n(&dock->loaders.combiner, &holder, my_pid,
+                                    false, __ATOMIC_ACQUIRE,
+                                    __ATOMIC_RELAXED))
+      return true;
+    return check_owner && processDead(holder) &&
+           __atomic_compare_exchange_n(&dock->loaders.combiner, &holder,
+                                       my_pid, false, __ATOMIC_ACQUIRE,
+                                       __ATOMIC_RELAXED);
+  }
+
+  /** @brief Locks the dock; false if the lock was not taken (shutdown). */
+  bool lockDock() {
+    lock_dock_fn();
+    return !(wait_failed_fn && wait_failed_fn());
+  }
+
+  /** @brief Fills in the result of a request that was never applied. */
+  static void notApplied(LoadSlot &s) {
+    s.outcome = LoadOutcome::NoTruck;
+    s.loaded = 0;
+    s.departure_sent = false;
+    s.departure_repeated = false;
+  }
+
+  /**
+   * @brief One combining pass: every pending request, one mutex hold.
+   * * If the dock lock is not taken (shutdown) the caller's own request is
+   * withdrawn instead; holding the combiner role, nobody else can be
+   * applying it.
+   */
+  void combine() {
+    DockCombiner &c = dock->loaders;
+    if (!lockDock()) {
+      if (loadAcquire(slot->served) != slot->posted) {
+        notApplied(*slot);
+        __atomic_store_n(&slot->served, slot->posted, __ATOMIC_RELEASE);
+      }
+      __atomic_store_n(&c.combiner, 0, __ATOMIC_RELEASE);
+      return;
+    }
+    uint32_t first = c.rotation++;
+    uint64_t applied = 0;
+    for (int n = 0; n < DOCK_CLIENT_SLOTS; ++n) {
+      LoadSlot &s = c.slots[(first + n) % DOCK_CLIENT_SLOTS];
+      uint32_t posted = loadAcquire(s.posted);
+      if (posted == s.served)
+        continue;
+      applyLoad(*dock, s, send_signal_fn);
+      __atomic_store_n(&s.served, posted, __ATOMIC_RELEASE);
+      applied++;
+    }
+    if (shm && applied)
+      bumpGeneration(shm, StateRegion::Dock);
+    unlock_dock_fn();
+    __atomic_store_n(&c.combiner, 0, __ATOMIC_RELEASE);
+
+    if (shm) {
+      atomicAdd(shm->stats.combine_passes, uint64_t{1});
+      atomicAdd(shm->stats.combined_requests, applied);
+    }
+  }
+
+public:
+  /**
+   * @param d Dock to load into.
+   * @param s Shared state holding the statistics (may be nullptr).
+   * @param lock_dock Locks the dock.
+   * @param unlock_dock Unlocks the dock.
+   * @param send_signal Sends DEPARTURE to a truck.
+   */
+  DockController(TruckState *d, SharedState *s,
+                 std::function<void()> lock_dock,
+                 std::function<void()> unlock_dock,
+                 std::function<void(pid_t, SignalType)> send_signal)
+      : dock(d), shm(s), lock_dock_fn(std::move(lock_dock)),
+        unlock_dock_fn(std::move(unlock_dock)),
+        send_signal_fn(std::move(send_signal)), my_pid(getpid()) {}
+
+  ~DockController() { release(); }
+
+  DockController(const DockController &) = delete;
+  DockController &operator=(const DockController &) = delete;
+
+  /**
+   * @brief Moves the controller to another dock (e.g. a sorter lane's).
+   */
+  void rebind(TruckState *d, std::function<void()> lock_dock,
+              std::function<void()> unlock_dock) {
+    release();
+    dock = d;
+    lock_dock_fn = std::move(lock_dock);
+    unlock_dock_fn = std::move(unlock_dock);
+  }
+
+  /** @brief Lets `load` notice a dock lock given up at shutdown. */
+  void setWaitFailedCheck(std::function<bool()> check) {
+    wait_failed_fn = std::move(check);
+  }
+
+  /** @brief Dock this controller loads into. */
+  TruckState *target() const { return dock; }
+
+  /**
+   * @brief Loads up to `DOCK_BATCH_MAX` packages as one request.
+   *
+   * Blocks until a combiner (possibly this caller) has applied the request.
+   *
+   * @param weights Package weights [kg].
+   * @param volumes Package volumes [m3].
+   * @param items Number of packages.
+   * @param counts_load Whether packages count towards the truck's max_load.
+   * @param check_full Whether to request departure once ~full.
+   * @param no_fit_reason Departure reason if a package does not fit.
+   * @return The applied request with its result fields filled in.
+   */
+  const LoadSlot &load(const double *weights, const double *volumes,
+                       int items, bool counts_load, bool check_full,
+                       DepartureReason no_fit_reason) {
+    if (!slot)
+      slot = claim();
+    LoadSlot &s = slot ? *slot : solo;
+
+    s.items = static_cast<uint8_t>(items < DOCK_BATCH_MAX ? items
+                                                          : DOCK_BATCH_MAX);
+    for (int i = 0; i < s.items; ++i) {
+      s.weight[i] = weights[i];
+      s.volume[i] = volumes[i];
+    }
+    s.counts_load = counts_load;
+    s.check_full = check_full;
+    s.no_fit_reason = no_fit_reason;
+
+    if (!slot) {
+      if (!lockDock()) {
+        notApplied(s);
+        return s;
+      }
+      applyLoad(*dock, s, send_signal_fn);
+      if (shm)
+        bumpGeneration(shm, StateRegion::Dock);
+      unlock_dock_fn();
+      return s;
+    }
+
+    uint32_t seq = s.posted + 1;
+    __atomic_store_n(&s.posted, seq, __ATOMIC_RELEASE);
+
+    for (int spins = 0; loadAcquire(s.served) != seq; ++spins) {
+      if (tryCombine(spins % 1024 == 1023)) {
+        combine();
+        continue;
+      }
+      if (spins < SPIN_LIMIT)
+        sched_yield();
+      else
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+    }
+    return s;
+  }
+};
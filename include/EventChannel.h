@@ -0,0 +1,243 @@
+/**
+ * @file EventChannel.h
+ * @brief Operator alerts: a shared-memory event ring with a futex wake.
+ *
+ * Any process publishes an alert with `publishEvent`: it claims a sequence
+ * number, fills the ring slot and bumps the futex word `EventRing::wake`.
+ * The FUTEX_WAKE system call is only made while a reader is blocked, and
+ * alerts are rare (departures, saturation, deaths), so publishing costs the
+ * hot paths a few atomics at most.
+ *
+ * Noisy kinds are rate-limited: `BeltSaturated` and `QuotaExhausted` are
+ * published at most once per `EVENT_COALESCE_NS`; the rest are counted in
+ * `EventRing::coalesced`.
+ *
+ * `EventSubscriber` reads the ring from the sequence current at creation.
+ * A poll() loop cannot wait on a futex, so a helper thread blocks on the
+ * futex word and forwards each wake to an eventfd; the reader then waits on
+ * that eventfd together with its other descriptors (the terminal: stdin)
+ * in one blocking poll(). Idle readers use no CPU.
+ *
+ * A reader that falls more than EVENT_RING_SIZE events behind skips the
+ * overwritten ones and counts them as lost.
+ */
+#pragma once
+
+#include "Shared.h"
+#include "Telemetry.h"
+#include <atomic>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+/** @brief Minimum spacing of the rate-limited kinds. */
+constexpr uint64_t EVENT_COALESCE_NS = 1000000000ULL;
+
+/** @brief Wakes every process blocked on the ring's futex word. */
+inline void wakeEventWaiters(EventRing &ring) {
+  syscall(SYS_futex, &ring.wake, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+/**
+ * @brief Publishes an alert.
+ *
+ * @param shm Shared state holding the ring.
+ * @param kind What happened.
+ * @param pid Process concerned.
+ * @param value Kind-specific detail (see EventKind).
+ * @param subject Session name, may be nullptr.
+ * @return false if the kind was rate-limited.
+ */
+inline bool publishEvent(SharedState *shm, EventKind kind, pid_t pid,
+                         int64_t value, const char *subject = nullptr) {
+  EventRing &ring = shm->events;
+  int k = static_cast<int>(kind);
+  uint64_t now = monotonicNowNs();
+
+  if (kind == EventKind::BeltSaturated || kind == EventKind::QuotaExhausted) {
+    uint64_t last = atomicLoad(ring.last_ns[k]);
+    if ((last && now - last < EVENT_COALESCE_NS) ||
+        !__atomic_compare_exchange_n(&ring.last_ns[k], &last, now, false,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+      atomicAdd(ring.coalesced[k], uint64_t{1});
+      return false;
+    }
+  }
+
+  uint64_t seq = atomicAdd(ring.head, uint64_t{1});
+  SystemEvent &e = ring.slots[seq % EVENT_RING_SIZE];
+  __atomic_store_n(&e.seq, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  e.time_ns = realtimeNowNs();
+  e.kind = k;
+  e.pid = pid;
+  e.value = value;
+  std::memset(e.subject, 0, sizeof(e.subject));
+  if (subject)
+    std::strncpy(e.subject, subject, sizeof(e.subject) - 1);
+  __atomic_store_n(&e.seq, seq + 1, __ATOMIC_RELEASE);
+
+  __atomic_add_fetch(&ring.wake, 1u, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&ring.waiters, __ATOMIC_SEQ_CST) > 0)
+    wakeEventWaiters(ring);
+  return true;
+}
+
+/**
+ * @class EventSubscriber
+ * @brief Reads alerts published after its creation; pollable via fd().
+ */
+class EventSubscriber {
+private:
+  SharedState *shm;
+  uint32_t seen_wake; /**< Futex word read before `next_seq`. */
+  uint64_t next_seq;  /**< Next sequence number to read. */
+  uint64_t lost_count = 0;
+  int efd;
+  std::atomic<bool> stopping{false};
+  std::thread waiter;
+
+  /** @brief Forwards changes of the futex word to the eventfd. */
+  void forward() {
+    EventRing &ring = shm->events;
+    uint32_t seen = seen_wake;
+    while (!stopping.load()) {
+      __atomic_add_fetch(&ring.waiters, 1, __ATOMIC_SEQ_CST);
+      // Returns at once if `wake` moved since `seen` (no lost wake-up).
+      syscall(SYS_futex, &ring.wake, FUTEX_WAIT, seen, nullptr, nullptr, 0);
+      __atomic_sub_fetch(&ring.waiters, 1, __ATOMIC_SEQ_CST);
+
+      uint32_t now = __atomic_load_n(&ring.wake, __ATOMIC_SEQ_CST);
+      if (now != seen) {
+        seen = now;
+        uint64_t one = 1;
+        if (write(efd, &one, sizeof(one)) < 0) {
+        }
+      }
+    }
+  }
+
+public:
+  /** @param s Shared state holding the ring. */
+  explicit EventSubscriber(SharedState *s)
+      : shm(s),
+        seen_wake(__atomic_load_n(&s->events.wake, __ATOMIC_SEQ_CST)),
+        next_seq(atomicLoad(s->events.head)),
+        efd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+    if (efd >= 0)
+      waiter = std::thread([this]() { forward(); });
+  }
+
+  ~EventSubscriber() {
+    if (waiter.joinable()) {
+      stopping.store(true);
+      __atomic_add_fetch(&shm->events.wake, 1u, __ATOMIC_SEQ_CST);
+      wakeEventWaiters(shm->events);
+      waiter.join();
+    }
+    if (efd >= 0)
+      close(efd);
+  }
+
+  EventSubscriber(const EventSubscriber &) = delete;
+  EventSubscriber &operator=(const EventSubscriber &) = delete;
+
+  /** @brief Descriptor readable when events may be pending (-1 on error). */
+  int fd() const { return efd; }
+
+  /** @brief Events skipped because the ring overwrote them. */
+  uint64_t lost() const { return lost_count; }
+
+  /** @brief Clears the eventfd; call before draining with next(). */
+  void acknowledge() {
+    uint64_t count;
+    if (efd >= 0 && read(efd, &count, sizeof(count)) < 0) {
+    }
+  }
+
+  /**
+   * @brief Takes the next unread event.
+   * @return false if none is complete yet.
+   */
+  bool next(SystemEvent &out) {
+    const EventRing &ring = shm->events;
+    while (next_seq < atomicLoad(ring.head)) {
+      if (atomicLoad(ring.head) - next_seq > EVENT_RING_SIZE) {
+        uint64_t oldest = atomicLoad(ring.head) - EVENT_RING_SIZE;
+        lost_count += oldest - next_seq;
+        next_seq = oldest;
+      }
+      const SystemEvent &e = ring.slots[next_seq % EVENT_RING_SIZE];
+      uint64_t seq = __atomic_load_n(&e.seq, __ATOMIC_ACQUIRE);
+      if (seq == 0 || seq < next_seq + 1)
+        return false; // Claimed but still being written.
+      if (seq > next_seq + 1) {
+        lost_count++; // Overwritten by a newer lap.
+        next_seq++;
+        continue;
+      }
+      out = e;
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if (__atomic_load_n(&e.seq, __ATOMIC_RELAXED) != seq)
+        continue; // Overwritten while copying; re-check the lap.
+      next_seq++;
+      return true;
+    }
+    return false;
+  }
+
+  /** @brief Short name of an event kind. */
+  static const char *kindName(int kind) {
+    static const char *const names[EVENT_KINDS] = {
+        "none",           "truck_departed_full", "belt_saturated",
+        "quota_exhausted", "process_died",       "process_stalled",
+        "shutdown"};
+    return kind >= 0 && kind < EVENT_KINDS ? names[kind] : "?";
+  }
+
+  /**
+   * @brief Formats an event as one line for the operator.
+   * @return Length written (snprintf semantics).
+   */
+  static int describe(const SystemEvent &e, char *buf, size_t cap) {
+    time_t secs = static_cast<time_t>(e.time_ns / 1000000000ULL);
+    struct tm local;
+    localtime_r(&secs, &local);
+    char when[16];
+    std::strftime(when, sizeof(when), "%H:%M:%S", &local);
+
+    switch (static_cast<EventKind>(e.kind)) {
+    case EventKind::TruckDepartedFull:
+      return std::snprintf(buf, cap, "[%s] Truck %d departed full (%lld "
+                                      "packages).",
+                           when, e.pid, (long long)e.value);
+    case EventKind::BeltSaturated:
+      return std::snprintf(buf, cap, "[%s] Belt saturated: %lld/%d slots.",
+                           when, (long long)e.value, MAX_BELT_CAPACITY_K);
+    case EventKind::QuotaExhausted:
+      return std::snprintf(buf, cap,
+                           "[%s] Session '%.31s' (PID %d) exhausted its "
+                           "quota of %lld processes.",
+                           when, e.subject, e.pid, (long long)e.value);
+    case EventKind::ProcessDied:
+      return std::snprintf(buf, cap, "[%s] Process %.31s (PID %d) died, "
+                                     "status %lld.",
+                           when, e.subject, e.pid, (long long)e.value);
+    case EventKind::ProcessStalled:
+      return std::snprintf(buf, cap,
+                           "[%s] Process '%.31s' (PID %d) stalled for "
+                           "%lld ms.",
+                           when, e.subject, e.pid, (long long)e.value);
+    case EventKind::Shutdown:
+      return std::snprintf(buf, cap, "[%s] System shutting down.", when);
+    default:
+      return std::snprintf(buf, cap, "[%s] Unknown event %d.", when, e.kind);
+    }
+  }
+};
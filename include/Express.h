@@ -9,7 +9,14 @@
  */
 #pragma once
 
+#include "AuditJournal.h"
+#include "DockController.h"
+#include "JsonLog.h"
+#include "LockProfiler.h"
+#include "LogThrottle.h"
+#include "Probes.h"
 #include "Shared.h"
+#include "Telemetry.h"
 #include "spdlog/spdlog.h"
 #include <functional>
 #include <random>
@@ -37,16 +44,18 @@ private:
   /** @brief Pointer to the system's Shared Memory segment. */
   SharedState *shm;
 
-  /** @name Dependency Injection Callbacks
-   * Functions injected by the Manager to allow interaction with IPC resources
-   * without direct coupling to the Manager class.
-   * @{ */
-  std::function<void()> lock_dock_fn; /**< Callback to lock the Dock Mutex. */
-  std::function<void()>
-      unlock_dock_fn; /**< Callback to unlock the Dock Mutex. */
-  std::function<void(pid_t, SignalType)>
-      send_signal_fn; /**< Callback to send IPC signals. */
-                      /** @} */
+  /**
+   * @brief Batch generator, seeded once.
+   * * Constructing a std::random_device per batch may open /dev/urandom
+   * (a heap-allocated FILE), so the engine lives as long as the worker.
+   */
+  std::mt19937 gen;
+
+  /** @brief Audit journal receiving express loads (nullptr = disabled). */
+  AuditJournal *journal = nullptr;
+
+  /** @brief Loads batches into the dock (see `setDock`). */
+  DockController loader;
 
 public:
   /**
@@ -61,86 +70,102 @@ public:
   Express(SharedState *s, std::function<void()> lock_dock,
           std::function<void()> unlock_dock,
           std::function<void(pid_t, SignalType)> send_signal)
-      : shm(s), lock_dock_fn(lock_dock), unlock_dock_fn(unlock_dock),
-        send_signal_fn(send_signal) {}
+      : shm(s), gen(std::random_device{}()),
+        loader(s ? &s->dock_truck : nullptr, s, std::move(lock_dock),
+               std::move(unlock_dock), std::move(send_signal)) {}
 
   /**
    * @brief Executes the delivery of a VIP package batch.
    *
    * This method contains the core business logic for P4:
-   * 1. **Locking:** Acquires the dock mutex to ensure thread safety against the
-   * Dispatcher.
-   * 2. **Validation:** Checks if a truck is actually present.
-   * 3. **Batch Generation:** Randomly determines a batch size (3-5 items).
-   * 4. **Loading Loop:**
-   * - Generates a package with random Weight (1-15kg) and Type (A, B, or C).
-   * - Checks against Truck Capacity ($W$ and $V$).
-   * - **If fits:** Updates shared memory stats and logs success.
-   * - **If full:** Logs a warning, sends `SIGNAL_DEPARTURE` to the truck, and
-   * aborts the rest of the batch.
-   * 5. **Unlocking:** Releases the dock mutex.
+   * 1. **Batch Generation:** Randomly determines a batch size (3-5 items),
+   * each with random Weight (1-15kg) and Type (A, B, or C).
+   * 2. **Loading:** Submits the batch as one request to the dock's
+   * `DockController`, which checks a truck is present and applies the
+   * Capacity ($W$) and Volume ($V$) limits per package.
+   * 3. **If full:** The first package that does not fit and the rest of the
+   * batch are dropped and `SIGNAL_DEPARTURE` is sent to the truck.
    */
   void deliverExpressBatch() {
     if (!shm)
       return;
 
-    lock_dock_fn();
-
-    TruckState &truck = shm->dock_truck;
-
-    if (!truck.is_present) {
-      spdlog::warn("[P4] Cannot deliver Express - No truck at dock!");
-      unlock_dock_fn();
-      return;
-    }
-
-    spdlog::info("[P4] Delivering EXPRESS BATCH (Priority Order)!");
-
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    LockSiteScope site(LockSite::DockExpress);
 
     std::uniform_int_distribution<> batch_dist(3, 5);
     int batch_size = batch_dist(gen);
+    WAREHOUSE_PROBE1(express__begin, batch_size);
 
     std::uniform_int_distribution<> type_dist(0, 2);
     std::uniform_real_distribution<> weight_dist(1.0, 15.0);
 
+    double weights[DOCK_BATCH_MAX];
+    double volumes[DOCK_BATCH_MAX];
     for (int i = 0; i < batch_size; ++i) {
-      double weight = weight_dist(gen);
+      weights[i] = weight_dist(gen);
+      int t = type_dist(gen);
+      volumes[i] = t == 0 ? VOL_A : t == 1 ? VOL_B : VOL_C;
+    }
 
-      double vol = VOL_A;
-      PackageType type = PackageType::TypeA;
+    const LoadSlot &r = loader.load(weights, volumes, batch_size, false,
+                                    false, DepartureReason::ExpressFull);
+    WAREHOUSE_PROBE3(express__end, r.loaded, r.truck_id,
+                     static_cast<int>(r.outcome));
 
-      int t = type_dist(gen);
-      if (t == 1) {
-        vol = VOL_B;
-        type = PackageType::TypeB;
-      }
-      if (t == 2) {
-        vol = VOL_C;
-        type = PackageType::TypeC;
-      }
-
-      bool fits_W = (truck.current_weight + weight <= truck.max_weight);
-      bool fits_V = (truck.current_volume + vol <= truck.max_volume);
-
-      if (fits_W && fits_V) {
-        truck.current_weight += weight;
-        truck.current_volume += vol;
-
-        spdlog::info("[P4] Express Item {}/{} loaded (Type {}, {:.1f}kg). "
-                     "Truck: {:.1f}% W, {:.1f}% V",
-                     i + 1, batch_size, (int)type, weight,
-                     (truck.current_weight / truck.max_weight) * 100,
-                     (truck.current_volume / truck.max_volume) * 100);
-      } else {
-        spdlog::warn("[P4] Truck FULL during Express load! Batch incomplete. "
-                     "Signaling Departure.");
-        send_signal_fn(truck.id, SIGNAL_DEPARTURE);
-        break;
-      }
+    if (r.outcome == LoadOutcome::NoTruck) {
+      WAREHOUSE_LOG_REPEAT(LogSubsystem::Express, spdlog::level::warn, 0,
+                           "[P4] Cannot deliver Express - No truck at dock!");
+      return;
+    }
+
+    atomicAdd(shm->stats.express_loaded, uint64_t{r.loaded});
+    bumpGeneration(shm, StateRegion::Fleet);
+    for (int i = 0; journal && i < r.loaded; ++i)
+      journal->append(0, ActionType::Created | ActionType::LoadedToTruck |
+                             ActionType::ByExpress);
+
+    if (WAREHOUSE_LOG_ENABLED(LogSubsystem::Express, spdlog::level::info)) {
+      if (JsonLog::enabled(spdlog::level::info))
+        JsonRecord("express")
+            .field("loaded", r.loaded)
+            .field("batch", batch_size)
+            .field("truck", r.truck_id)
+            .field("truck_kg", r.truck_weight)
+            .field("truck_m3", r.truck_volume)
+            .field("complete", r.outcome != LoadOutcome::NoFit)
+            .log(spdlog::level::info);
+      else
+        spdlog::info("[P4] EXPRESS BATCH: {}/{} items loaded into Truck #{}. "
+                     "Truck: {:.1f}kg, {:.3f}m3",
+                     r.loaded, batch_size, r.truck_id, r.truck_weight,
+                     r.truck_volume);
     }
 
-    unlock_dock_fn();
+    if (r.outcome == LoadOutcome::NoFit)
+      WAREHOUSE_LOG_REPEAT(LogSubsystem::Express, spdlog::level::warn,
+                           r.truck_id,
+                           "[P4] Truck FULL during Express load! Batch "
+                           "incomplete. Signaling Departure.");
+    if (r.departure_repeated)
+      atomicAdd(shm->stats.departures_coalesced, uint64_t{1});
+  }
+
+  /** @brief Attaches the audit journal (nullptr disables auditing). */
+  void setJournal(AuditJournal *j) { journal = j; }
+
+  /** @brief See DockController::setWaitFailedCheck. */
+  void setWaitFailedCheck(std::function<bool()> check) {
+    loader.setWaitFailedCheck(std::move(check));
+  }
+
+  /**
+   * @brief Loads into another dock (a sorter lane) than the single one.
+   * @param d Dock state.
+   * @param lock_dock Locks that dock.
+   * @param unlock_dock Unlocks that dock.
+   */
+  void setDock(TruckState *d, std::function<void()> lock_dock,
+               std::function<void()> unlock_dock) {
+    loader.rebind(d, std::move(lock_dock), std::move(unlock_dock));
   }
 };
@@ -0,0 +1,243 @@
+/**
+ * @file FaultInjector.h
+ * @brief Seeded fault and latency injection for the Manager's IPC calls.
+ *
+ * Every component reaches the semaphores and the message queue through the
+ * Manager, so perturbing those few methods disturbs all of them. A plan is
+ * read from `FAULT_PLAN` as rules separated by ';':
+ *
+ *     [ROLE/]SITE:ACTION=PROBABILITY[@MICROSECONDS]
+ *
+ * - SITE: lock_belt, lock_dock, wait_package, wait_slot, send_signal.
+ * - ACTION:
+ *   - delay: sleep MICROSECONDS before the operation.
+ *   - jitter: sleep a uniform [0, MICROSECONDS) before the operation.
+ *   - pause: sleep MICROSECONDS right after it (for the locks: inside the
+ *     critical section, stalling every other process that needs it).
+ *   - kill: SIGKILL the process right after it (mid critical section).
+ *   - fail: send_signal only; the message is dropped as if msgsnd failed.
+ * - ROLE: optional; the rule only applies to processes whose logger name
+ *   contains it (e.g. "dispatcher", "truck-2").
+ *
+ * Example: `lock_dock:pause=0.01@20000;dispatcher/send_signal:fail=0.001`
+ *
+ * Each rule fires with its probability, drawn from a stream seeded by
+ * `FAULT_SEED` (default 1) and the role name, so a role sees the same
+ * schedule of faults in every run. Fired faults are counted per site in
+ * `WarehouseStats::faults_injected`.
+ *
+ * @note The semaphores are not robust (no SEM_UNDO): a role killed while it
+ * holds a mutex leaves it held. `kill` exposes exactly that.
+ */
+#pragma once
+
+#include "Shared.h"
+#include "Telemetry.h"
+#include "spdlog/spdlog.h"
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+/** @brief What a fault rule does when it fires. */
+enum class FaultAction : uint8_t { Delay, Jitter, Pause, Kill, Fail };
+
+/** @brief One rule of a fault plan. */
+struct FaultRule {
+  std::string role;     /**< Logger name filter (empty = every role). */
+  FaultSite site;       /**< Operation perturbed. */
+  FaultAction action;   /**< Effect. */
+  double probability;   /**< Chance per operation, [0, 1]. */
+  uint32_t duration_us; /**< Sleep of delay, jitter and pause. */
+};
+
+/** @brief Name of a site in plans and reports. */
+inline const char *faultSiteName(FaultSite site) {
+  static const char *const names[FAULT_SITES] = {
+      "lock_belt", "lock_dock", "wait_package", "wait_slot", "send_signal"};
+  int i = static_cast<int>(site);
+  return i >= 0 && i < FAULT_SITES ? names[i] : "?";
+}
+
+/**
+ * @brief Parses a `FAULT_PLAN` specification.
+ * @param text Plan text (see file documentation).
+ * @param out Parsed rules; untouched on failure.
+ * @return true if every rule is valid.
+ */
+inline bool parseFaultPlan(const char *text, std::vector<FaultRule> &out) {
+  static const char *const actions[] = {"delay", "jitter", "pause", "kill",
+                                        "fail"};
+  std::vector<FaultRule> rules;
+  std::string plan(text);
+  size_t pos = 0;
+
+  while (pos <= plan.size()) {
+    size_t end = plan.find(';', pos);
+    if (end == std::string::npos)
+      end = plan.size();
+    std::string item = plan.substr(pos, end - pos);
+    pos = end + 1;
+    if (item.empty())
+      continue;
+
+    FaultRule rule = {};
+    size_t slash = item.find('/');
+    if (slash != std::string::npos) {
+      rule.role = item.substr(0, slash);
+      item = item.substr(slash + 1);
+    }
+
+    size_t colon = item.find(':');
+    size_t eq = item.find('=');
+    if (colon == std::string::npos || eq == std::string::npos || eq < colon)
+      return false;
+
+    std::string site = item.substr(0, colon);
+    std::string action = item.substr(colon + 1, eq - colon - 1);
+    int s = 0;
+    while (s < FAULT_SITES && site != faultSiteName(static_cast<FaultSite>(s)))
+      s++;
+    int a = 0;
+    while (a < 5 && action != actions[a])
+      a++;
+    if (s == FAULT_SITES || a == 5)
+      return false;
+    rule.site = static_cast<FaultSite>(s);
+    rule.action = static_cast<FaultAction>(a);
+    if (rule.action == FaultAction::Fail && rule.site != FaultSite::SendSignal)
+      return false;
+
+    const char *value = item.c_str() + eq + 1;
+    char *rest = nullptr;
+    rule.probability = std::strtod(value, &rest);
+    if (rest == value || rule.probability < 0 || rule.probability > 1)
+      return false;
+    if (*rest == '@') {
+      const char *us = rest + 1;
+      long duration = std::strtol(us, &rest, 10);
+      if (rest == us || duration < 0)
+        return false;
+      rule.duration_us = static_cast<uint32_t>(duration);
+    }
+    if (*rest)
+      return false;
+    bool timed = rule.action == FaultAction::Delay ||
+                 rule.action == FaultAction::Jitter ||
+                 rule.action == FaultAction::Pause;
+    if (timed && rule.duration_us == 0)
+      return false;
+
+    rules.push_back(rule);
+  }
+
+  out = std::move(rules);
+  return true;
+}
+
+/**
+ * @class FaultInjector
+ * @brief Applies the rules of a plan that match this process.
+ *
+ * The Manager calls `before` and `after` around each perturbed operation
+ * and asks `dropped` before sending a message.
+ */
+class FaultInjector {
+private:
+  SharedState *shm;
+  std::vector<FaultRule> rules; /**< Rules matching this role. */
+  std::string role;
+  uint64_t state; /**< splitmix64 stream position. */
+
+  /** @brief Next value of the seeded stream (splitmix64). */
+  uint64_t next() {
+    uint64_t z = __atomic_add_fetch(&state, 0x9e3779b97f4a7c15ULL,
+                                    __ATOMIC_RELAXED);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  /** @brief Uniform draw in [0, 1). */
+  double uniform() { return (next() >> 11) * 0x1.0p-53; }
+
+  void note(FaultSite site) {
+    if (shm)
+      atomicAdd(shm->stats.faults_injected[static_cast<int>(site)],
+                uint64_t{1});
+  }
+
+  static void sleepUs(uint64_t us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+  }
+
+public:
+  /**
+   * @param s Shared state receiving the fault counters (may be nullptr).
+   * @param plan Parsed plan; rules for other roles are discarded.
+   * @param role_name This process's role (its logger name).
+   * @param seed Schedule seed (`FAULT_SEED`).
+   */
+  FaultInjector(SharedState *s, const std::vector<FaultRule> &plan,
+                std::string role_name, uint64_t seed)
+      : shm(s), role(std::move(role_name)) {
+    for (const FaultRule &r : plan) {
+      if (r.role.empty() || role.find(r.role) != std::string::npos)
+        rules.push_back(r);
+    }
+    uint64_t h = 1469598103934665603ULL; // FNV-1a of the role name
+    for (char c : role)
+      h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+    state = seed ^ h;
+  }
+
+  /** @brief True if no rule applies to this role. */
+  bool empty() const { return rules.empty(); }
+
+  /** @brief Applies delay and jitter rules of `site`. */
+  void before(FaultSite site) {
+    for (const FaultRule &r : rules) {
+      if (r.site != site ||
+          (r.action != FaultAction::Delay && r.action != FaultAction::Jitter) ||
+          uniform() >= r.probability)
+        continue;
+      note(site);
+      sleepUs(r.action == FaultAction::Delay ? r.duration_us
+                                             : next() % r.duration_us);
+    }
+  }
+
+  /** @brief Applies pause and kill rules of `site`. */
+  void after(FaultSite site) {
+    for (const FaultRule &r : rules) {
+      if (r.site != site ||
+          (r.action != FaultAction::Pause && r.action != FaultAction::Kill) ||
+          uniform() >= r.probability)
+        continue;
+      note(site);
+      if (r.action == FaultAction::Pause) {
+        sleepUs(r.duration_us);
+      } else {
+        spdlog::warn("[faults] Killing {} after {} (injected).", role,
+                     faultSiteName(site));
+        spdlog::default_logger()->flush();
+        raise(SIGKILL);
+      }
+    }
+  }
+
+  /** @brief True if a fail rule of `site` fires for this operation. */
+  bool dropped(FaultSite site) {
+    for (const FaultRule &r : rules) {
+      if (r.site == site && r.action == FaultAction::Fail &&
+          uniform() < r.probability) {
+        note(site);
+        return true;
+      }
+    }
+    return false;
+  }
+};
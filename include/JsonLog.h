@@ -0,0 +1,296 @@
+/**
+ * @file JsonLog.h
+ * @brief Structured JSON log output without heap allocation.
+ *
+ * With LOG_FORMAT=json, `Config::setupLogger` installs `JsonFormatter`, and
+ * every record becomes one JSON object per line:
+ *
+ *   {"ts":"2026-10-18T09:30:00.125Z","proc":"belt","pid":41,"level":"info",
+ *    "event":"push","id":17,"slot":3,"load":4,"cap":10,"workers":3}
+ *
+ * The hot paths (belt push and pop, dispatcher load, truck departure, express
+ * batch) build their fields with `JsonRecord`, a writer over a fixed buffer
+ * on the stack: integers and decimals are printed with std::to_chars and no
+ * format string is parsed. Other messages keep their text, escaped into a
+ * "msg" field, so the output stays valid JSON throughout.
+ *
+ * A structured payload is told apart by a leading record separator (0x1e);
+ * the formatter copies it verbatim after the common fields.
+ */
+#pragma once
+
+#include "spdlog/formatter.h"
+#include "spdlog/spdlog.h"
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <type_traits>
+#include <unistd.h>
+
+/** @brief Capacity of one structured record, marker included. */
+constexpr size_t JSON_RECORD_SIZE = 256;
+
+/** @brief First byte of a structured payload. */
+constexpr char JSON_RECORD_MARK = '\x1e';
+
+/**
+ * @brief Writes `s[0..n)` as the body of a JSON string.
+ * @param put Called with (pointer, length) for each run of output.
+ */
+template <typename Put> void jsonEscape(const char *s, size_t n, Put &&put) {
+  static const char hex[] = "0123456789abcdef";
+  size_t run = 0;
+  for (size_t i = 0; i < n; ++i) {
+    unsigned char c = static_cast<unsigned char>(s[i]);
+    if (c >= 0x20 && c != '"' && c != '\\')
+      continue;
+    put(s + run, i - run);
+    run = i + 1;
+    char esc[6] = {'\\', 0, 0, 0, 0, 0};
+    switch (c) {
+    case '"':
+    case '\\':
+      esc[1] = static_cast<char>(c);
+      put(esc, 2);
+      break;
+    case '\n':
+      esc[1] = 'n';
+      put(esc, 2);
+      break;
+    case '\t':
+      esc[1] = 't';
+      put(esc, 2);
+      break;
+    default:
+      esc[1] = 'u';
+      esc[2] = '0';
+      esc[3] = '0';
+      esc[4] = hex[c >> 4];
+      esc[5] = hex[c & 15];
+      put(esc, 6);
+      break;
+    }
+  }
+  put(s + run, n - run);
+}
+
+/**
+ * @class JsonLog
+ * @brief Process-wide switch between the text and the JSON output.
+ */
+class JsonLog {
+private:
+  static bool &state() {
+    static bool on = false;
+    return on;
+  }
+
+public:
+  /** @brief Set by Config::setupLogger; not thread-safe, call at start-up. */
+  static void setEnabled(bool on) { state() = on; }
+
+  /** @brief True if structured records at `lvl` would be written. */
+  static bool enabled(spdlog::level::level_enum lvl) {
+    return state() && spdlog::default_logger_raw()->should_log(lvl);
+  }
+};
+
+/**
+ * @class JsonRecord
+ * @brief Typed key/value fields of one event, in a fixed stack buffer.
+ *
+ * Keys are written as given (use plain identifiers); string values are
+ * escaped. Fields that do not fit are dropped and `"truncated":true` is
+ * added, so the record is always valid JSON.
+ */
+class JsonRecord {
+private:
+  char buf[JSON_RECORD_SIZE];
+  size_t len = 0;
+  bool truncated = false;
+
+  /** @brief Space kept for the truncation marker. */
+  static constexpr size_t RESERVE = sizeof(",\"truncated\":true") - 1;
+
+  bool room(size_t n) const { return len + n + RESERVE <= sizeof(buf); }
+
+  void put(const char *s, size_t n) {
+    std::memcpy(buf + len, s, n);
+    len += n;
+  }
+
+  /** @brief Writes `,"key":`; false (and truncated) if it cannot fit. */
+  bool key(const char *k, size_t value_room) {
+    size_t n = std::strlen(k);
+    if (truncated || !room(n + 4 + value_room)) {
+      truncated = true;
+      return false;
+    }
+    put(",\"", 2);
+    put(k, n);
+    put("\":", 2);
+    return true;
+  }
+
+public:
+  /** @param event Value of the "event" field (a plain identifier). */
+  explicit JsonRecord(const char *event) {
+    buf[len++] = JSON_RECORD_MARK;
+    put("\"event\":\"", 9);
+    size_t n = std::strlen(event);
+    if (n > 32)
+      n = 32;
+    put(event, n);
+    buf[len++] = '"';
+  }
+
+  /** @brief Adds an integer field. */
+  template <typename T>
+  std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>,
+                   JsonRecord &>
+  field(const char *k, T value) {
+    if (key(k, 20))
+      len = std::to_chars(buf + len, buf + sizeof(buf), value).ptr - buf;
+    return *this;
+  }
+
+  /** @brief Adds a decimal field (null if not finite). */
+  JsonRecord &field(const char *k, double value, int digits = 3) {
+    if (!key(k, 24))
+      return *this;
+    std::to_chars_result r{nullptr, std::errc::value_too_large};
+    if (std::isfinite(value) && std::fabs(value) < 1e15)
+      r = std::to_chars(buf + len, buf + len + 24, value,
+                        std::chars_format::fixed, digits);
+    if (r.ec == std::errc())
+      len = r.ptr - buf;
+    else
+      put("null", 4);
+    return *this;
+  }
+
+  /** @brief Adds a boolean field. */
+  JsonRecord &field(const char *k, bool value) {
+    if (key(k, 5))
+      put(value ? "true" : "false", value ? 4 : 5);
+    return *this;
+  }
+
+  /** @brief Adds a string field, escaped and cut to what fits. */
+  JsonRecord &field(const char *k, const char *value) {
+    if (!key(k, 2))
+      return *this;
+    buf[len++] = '"';
+    jsonEscape(value, std::strlen(value), [this](const char *s, size_t n) {
+      if (truncated)
+        return;
+      if (!room(n + 1)) {
+        truncated = true;
+        // Cut plain text only, and not inside a UTF-8 sequence.
+        size_t fit = sizeof(buf) - RESERVE - 1 - len;
+        if (n == 0 || s[0] == '\\')
+          return;
+        while (fit > 0 && (static_cast<unsigned char>(s[fit]) & 0xc0) == 0x80)
+          fit--;
+        n = fit;
+      }
+      put(s, n);
+    });
+    buf[len++] = '"';
+    return *this;
+  }
+
+  /** @brief The payload handed to spdlog, marker first. */
+  spdlog::string_view_t view() const {
+    return spdlog::string_view_t(buf, len);
+  }
+
+  /** @brief Finishes the record and writes it to the default logger. */
+  void log(spdlog::level::level_enum lvl) {
+    if (truncated)
+      put(",\"truncated\":true", RESERVE);
+    spdlog::default_logger_raw()->log(lvl, view());
+  }
+};
+
+/**
+ * @class JsonFormatter
+ * @brief spdlog formatter printing each record as one JSON line.
+ *
+ * The date and time down to the second are formatted once per second and
+ * reused; everything else is appended directly to spdlog's buffer.
+ */
+class JsonFormatter : public spdlog::formatter {
+private:
+  time_t cached_sec = -1;
+  char cached_ts[24] = {}; /**< "YYYY-MM-DDTHH:MM:SS" of `cached_sec`. */
+  char pid_buf[16] = {};
+  size_t pid_len = 0;
+
+  static void append(spdlog::memory_buf_t &dest, const char *s, size_t n) {
+    dest.append(s, s + n);
+  }
+
+  static void append(spdlog::memory_buf_t &dest, const char *s) {
+    append(dest, s, std::strlen(s));
+  }
+
+  static void appendEscaped(spdlog::memory_buf_t &dest, const char *s,
+                            size_t n) {
+    jsonEscape(s, n, [&dest](const char *p, size_t k) { append(dest, p, k); });
+  }
+
+public:
+  JsonFormatter() {
+    pid_len = std::to_chars(pid_buf, pid_buf + sizeof(pid_buf), getpid()).ptr -
+              pid_buf;
+  }
+
+  void format(const spdlog::details::log_msg &msg,
+              spdlog::memory_buf_t &dest) override {
+    using namespace std::chrono;
+    auto since_epoch = msg.time.time_since_epoch();
+    time_t sec = duration_cast<seconds>(since_epoch).count();
+    int ms = static_cast<int>(
+        duration_cast<milliseconds>(since_epoch).count() % 1000);
+    if (sec != cached_sec) {
+      struct tm utc;
+      gmtime_r(&sec, &utc);
+      std::strftime(cached_ts, sizeof(cached_ts), "%Y-%m-%dT%H:%M:%S", &utc);
+      cached_sec = sec;
+    }
+    char millis[6] = {'.', static_cast<char>('0' + ms / 100),
+                      static_cast<char>('0' + ms / 10 % 10),
+                      static_cast<char>('0' + ms % 10), 'Z', '"'};
+
+    append(dest, "{\"ts\":\"");
+    append(dest, cached_ts);
+    append(dest, millis, sizeof(millis));
+    append(dest, ",\"proc\":\"");
+    appendEscaped(dest, msg.logger_name.data(), msg.logger_name.size());
+    append(dest, "\",\"pid\":");
+    append(dest, pid_buf, pid_len);
+    append(dest, ",\"level\":\"");
+    spdlog::string_view_t level = spdlog::level::to_string_view(msg.level);
+    append(dest, level.data(), level.size());
+    append(dest, "\",");
+
+    const char *payload = msg.payload.data();
+    size_t size = msg.payload.size();
+    if (size > 0 && payload[0] == JSON_RECORD_MARK) {
+      append(dest, payload + 1, size - 1);
+    } else {
+      append(dest, "\"msg\":\"");
+      appendEscaped(dest, payload, size);
+      append(dest, "\"");
+    }
+    append(dest, "}\n");
+  }
+
+  std::unique_ptr<spdlog::formatter> clone() const override {
+    return std::make_unique<JsonFormatter>();
+  }
+};
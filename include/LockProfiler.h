@@ -0,0 +1,289 @@
+/**
+ * @file LockProfiler.h
+ * @brief Per-semaphore, per-call-site lock contention profiler.
+ *
+ * `Manager::semOperation` feeds this profiler on every P/V operation. The
+ * statistics are stored in `SharedState::lock_stats`, so the report covers
+ * all processes attached to the segment, not just the one printing it.
+ */
+#pragma once
+
+#include "Shared.h"
+#include "Telemetry.h"
+#include <algorithm>
+#include <cstdio>
+#include <ostream>
+
+/**
+ * @brief Call site declared by the code currently running on this thread.
+ * * Components never see the Manager, only injected lock callbacks, so the
+ * site travels out-of-band through this thread-local (see LockSiteScope).
+ */
+inline thread_local LockSite current_lock_site = LockSite::Unknown;
+
+/**
+ * @class LockSiteScope
+ * @brief RAII guard attributing the semaphore operations of a scope to a site.
+ *
+ * Scopes nest: the previous site is restored on destruction, so
+ * `Dispatcher::processNextPackage` can call `Belt::pop` (BeltPop) and get
+ * DockDispatcher back afterwards.
+ */
+class LockSiteScope {
+private:
+  LockSite previous; /**< Site restored on destruction. */
+
+public:
+  explicit LockSiteScope(LockSite site) : previous(current_lock_site) {
+    current_lock_site = site;
+  }
+  ~LockSiteScope() { current_lock_site = previous; }
+
+  LockSiteScope(const LockSiteScope &) = delete;
+  LockSiteScope &operator=(const LockSiteScope &) = delete;
+};
+
+/**
+ * @struct LockReportRow
+ * @brief One ranked entry of the contention report.
+ */
+struct LockReportRow {
+  SemIndex sem;    /**< Semaphore. */
+  LockSite site;   /**< Call site (Total = aggregated over all sites). */
+  LockStats stats; /**< Snapshot of the counters. */
+};
+
+/**
+ * @class LockProfiler
+ * @brief Static helpers recording and ranking lock statistics.
+ */
+class LockProfiler {
+private:
+  /** @brief Acquisition time of the mutexes held by this thread. */
+  static inline thread_local uint64_t held_since[SEM_TOTAL] = {};
+
+  /** @brief Site that acquired each mutex held by this thread. */
+  static inline thread_local LockSite held_site[SEM_TOTAL] = {};
+
+  /** @brief Orders rows by total wait, then contended count, then volume. */
+  static bool hotter(const LockReportRow &a, const LockReportRow &b) {
+    if (a.stats.wait_ns_total != b.stats.wait_ns_total)
+      return a.stats.wait_ns_total > b.stats.wait_ns_total;
+    if (a.stats.contended != b.stats.contended)
+      return a.stats.contended > b.stats.contended;
+    return a.stats.acquisitions > b.stats.acquisitions;
+  }
+
+  /** @brief Relaxed copy of a shared LockStats entry. */
+  static LockStats load(const LockStats &src) {
+    LockStats out;
+    out.acquisitions = atomicLoad(src.acquisitions);
+    out.contended = atomicLoad(src.contended);
+    out.wait_ns_total = atomicLoad(src.wait_ns_total);
+    out.wait_ns_max = atomicLoad(src.wait_ns_max);
+    out.hold_ns_total = atomicLoad(src.hold_ns_total);
+    out.hold_ns_max = atomicLoad(src.hold_ns_max);
+    return out;
+  }
+
+public:
+  /**
+   * @brief Tells whether a semaphore is used as a binary mutex.
+   * * Hold time is only meaningful for mutexes; the slot counters are
+   * released by a different party than the one that acquired them.
+   */
+  static constexpr bool isMutex(SemIndex sem) {
+    if (sem >= SEM_LANE_BASE) {
+      int which = (sem - SEM_LANE_BASE) % SEM_PER_LANE;
+      return which == LANE_MUTEX || which == LANE_DOCK;
+    }
+    return sem == SEM_MUTEX_BELT || sem == SEM_DOCK_MUTEX;
+  }
+
+  /** @brief Short, label-friendly name of a semaphore. */
+  static const char *semName(SemIndex sem) {
+    switch (sem) {
+    case SEM_MUTEX_BELT:
+      return "belt_mutex";
+    case SEM_EMPTY_SLOTS:
+      return "empty_slots";
+    case SEM_FULL_SLOTS:
+      return "full_slots";
+    case SEM_DOCK_MUTEX:
+      return "dock_mutex";
+    default:
+      break;
+    }
+
+    static const char *lane_names[MAX_SORTER_LANES * SEM_PER_LANE] = {
+        "lane0_mutex", "lane0_empty", "lane0_full", "lane0_dock",
+        "lane1_mutex", "lane1_empty", "lane1_full", "lane1_dock",
+        "lane2_mutex", "lane2_empty", "lane2_full", "lane2_dock",
+        "lane3_mutex", "lane3_empty", "lane3_full", "lane3_dock"};
+    if (sem >= SEM_LANE_BASE && sem < SEM_TOTAL)
+      return lane_names[sem - SEM_LANE_BASE];
+    return "unknown";
+  }
+
+  /** @brief Short, label-friendly name of a call site. */
+  static const char *siteName(LockSite site) {
+    switch (site) {
+    case LockSite::BeltPush:
+      return "belt_push";
+    case LockSite::BeltPop:
+      return "belt_pop";
+    case LockSite::WorkerRegistry:
+      return "worker_registry";
+    case LockSite::SessionTable:
+      return "session_table";
+    case LockSite::DockDispatcher:
+      return "dock_dispatcher";
+    case LockSite::DockExpress:
+      return "dock_express";
+    case LockSite::DockTruck:
+      return "dock_truck";
+    case LockSite::LanePush:
+      return "lane_push";
+    case LockSite::LanePop:
+      return "lane_pop";
+    case LockSite::BeltTransit:
+      return "belt_transit";
+    case LockSite::Total:
+      return "all";
+    default:
+      return "unknown";
+    }
+  }
+
+  /**
+   * @brief Records a successful P operation.
+   * @param shm Shared segment holding the statistics.
+   * @param sem Semaphore acquired.
+   * @param contended True if the IPC_NOWAIT attempt failed first.
+   * @param wait_ns Time spent blocked (0 if uncontended).
+   */
+  static void onAcquire(SharedState *shm, SemIndex sem, bool contended,
+                        uint64_t wait_ns) {
+    LockSite site = current_lock_site;
+    LockStats &st = shm->lock_stats[sem][static_cast<int>(site)];
+
+    atomicAdd(st.acquisitions, uint64_t{1});
+    if (contended) {
+      atomicAdd(st.contended, uint64_t{1});
+      atomicAdd(st.wait_ns_total, wait_ns);
+      atomicMax(st.wait_ns_max, wait_ns);
+    }
+
+    if (isMutex(sem)) {
+      held_since[sem] = monotonicNowNs();
+      held_site[sem] = site;
+    }
+  }
+
+  /**
+   * @brief Records a V operation, closing the hold interval of a mutex.
+   * @param shm Shared segment holding the statistics.
+   * @param sem Semaphore released.
+   */
+  static void onRelease(SharedState *shm, SemIndex sem) {
+    if (!isMutex(sem) || held_since[sem] == 0)
+      return;
+
+    uint64_t hold = monotonicNowNs() - held_since[sem];
+    held_since[sem] = 0;
+
+    LockStats &st = shm->lock_stats[sem][static_cast<int>(held_site[sem])];
+    atomicAdd(st.hold_ns_total, hold);
+    atomicMax(st.hold_ns_max, hold);
+  }
+
+  /**
+   * @brief Collects non-empty (semaphore, site) entries, hottest first.
+   * @param shm Shared segment holding the statistics.
+   * @param rows Output array.
+   * @param max_rows Capacity of `rows`.
+   * @return Number of rows written.
+   */
+  static int rankSites(const SharedState *shm, LockReportRow *rows,
+                       int max_rows) {
+    int n = 0;
+    for (int s = 0; s < SEM_TOTAL; ++s) {
+      for (int site = 0; site < LOCK_SITE_TOTAL && n < max_rows; ++site) {
+        LockStats st = load(shm->lock_stats[s][site]);
+        if (st.acquisitions == 0)
+          continue;
+        rows[n++] = {static_cast<SemIndex>(s), static_cast<LockSite>(site),
+                     st};
+      }
+    }
+    std::sort(rows, rows + n, hotter);
+    return n;
+  }
+
+  /**
+   * @brief Aggregates every call site per semaphore, hottest first.
+   * @param shm Shared segment holding the statistics.
+   * @param rows Output array with room for SEM_TOTAL rows.
+   * @return Number of rows written.
+   */
+  static int rankLocks(const SharedState *shm, LockReportRow *rows) {
+    int n = 0;
+    for (int s = 0; s < SEM_TOTAL; ++s) {
+      LockStats sum = {};
+      for (int site = 0; site < LOCK_SITE_TOTAL; ++site) {
+        LockStats st = load(shm->lock_stats[s][site]);
+        sum.acquisitions += st.acquisitions;
+        sum.contended += st.contended;
+        sum.wait_ns_total += st.wait_ns_total;
+        sum.wait_ns_max = std::max(sum.wait_ns_max, st.wait_ns_max);
+        sum.hold_ns_total += st.hold_ns_total;
+        sum.hold_ns_max = std::max(sum.hold_ns_max, st.hold_ns_max);
+      }
+      if (sum.acquisitions > 0)
+        rows[n++] = {static_cast<SemIndex>(s), LockSite::Total, sum};
+    }
+    std::sort(rows, rows + n, hotter);
+    return n;
+  }
+
+  /**
+   * @brief Prints the ranked report (locks, then call sites).
+   * @param out Destination stream.
+   * @param shm Shared segment holding the statistics.
+   */
+  static void printReport(std::ostream &out, const SharedState *shm) {
+    LockReportRow rows[SEM_TOTAL * LOCK_SITE_TOTAL];
+    char line[160];
+
+    auto printRow = [&](const LockReportRow &r) {
+      const LockStats &st = r.stats;
+      double contended_pct =
+          st.acquisitions ? 100.0 * st.contended / st.acquisitions : 0.0;
+      double avg_hold_us =
+          st.acquisitions ? st.hold_ns_total / 1e3 / st.acquisitions : 0.0;
+      std::snprintf(line, sizeof(line),
+                    "  %-12s %-16s %10llu %6.1f%% %11.2f %9.2f %10.2f %9.2f\n",
+                    semName(r.sem), siteName(r.site),
+                    (unsigned long long)st.acquisitions, contended_pct,
+                    st.wait_ns_total / 1e6, st.wait_ns_max / 1e6, avg_hold_us,
+                    st.hold_ns_max / 1e6);
+      out << line;
+    };
+
+    const char *header = "  SEMAPHORE    SITE                  ACQUIRED  "
+                         "CONT.  WAIT[ms]  MAXW[ms] AVGHOLD[us]  MAXH[ms]\n";
+
+    out << "  Hottest locks (all processes):\n" << header;
+    int n = rankLocks(shm, rows);
+    for (int i = 0; i < n; ++i)
+      printRow(rows[i]);
+
+    out << "  Hottest call sites:\n" << header;
+    n = rankSites(shm, rows, SEM_TOTAL * LOCK_SITE_TOTAL);
+    for (int i = 0; i < n; ++i)
+      printRow(rows[i]);
+
+    if (n == 0)
+      out << "  (no lock activity recorded yet)\n";
+  }
+};
@@ -0,0 +1,290 @@
+/**
+ * @file LogThrottle.h
+ * @brief Sampled, rate-limited and repeat-folded logging for hot paths.
+ *
+ * Every `WAREHOUSE_LOG*` macro expansion owns a `LogSite` (a static local),
+ * and every site belongs to a subsystem whose `LogPolicy` lives in shared
+ * memory, so one change (LOG_THROTTLE at start-up, or the terminal's `log`
+ * command) applies to all processes at once:
+ *
+ * - **sample=N** keeps 1 call in N at each site,
+ * - **rate=R** and **burst=B** bound each site to R records per second with
+ *   bursts of B (a token bucket, kept as a single "theoretical arrival time"
+ *   updated by compare-and-swap),
+ * - **repeat=MS** folds calls of a `WAREHOUSE_LOG_REPEAT` site that carry
+ *   the same key into one record per window; the next record shown says how
+ *   many were folded ("Last message repeated N times.").
+ *
+ * A zeroed policy logs everything, as before. The checks run after the
+ * level check and cost a few relaxed atomics; the clock is read only when a
+ * rate or a repeat window applies. Counts are approximate when threads of
+ * one process share a site.
+ *
+ * LOG_THROTTLE syntax: "belt:sample=100,dispatcher:rate=20:burst=5".
+ */
+#pragma once
+
+#include "Shared.h"
+#include "Telemetry.h"
+#include "spdlog/spdlog.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+/** @brief Repeat folding window when `LogPolicy::repeat_ms` is 0. */
+constexpr uint32_t LOG_REPEAT_DEFAULT_MS = 5000;
+
+/**
+ * @class LogThrottle
+ * @brief Locates the policies and parses their text form.
+ */
+class LogThrottle {
+private:
+  static LogPolicy *&table() {
+    static LogPolicy *t = nullptr;
+    return t;
+  }
+
+  /** @brief Policies used before a Manager attaches (log everything). */
+  static LogPolicy *fallback() {
+    static LogPolicy local[LOG_SUBSYSTEMS] = {};
+    return local;
+  }
+
+public:
+  /** @brief Uses `policies` (LOG_SUBSYSTEMS entries) from now on. */
+  static void attach(LogPolicy *policies) { table() = policies; }
+
+  /** @brief Reverts to the local policies if `policies` is attached. */
+  static void detach(const LogPolicy *policies) {
+    if (table() == policies)
+      table() = nullptr;
+  }
+
+  /** @brief Policy of a subsystem. */
+  static LogPolicy &policy(LogSubsystem s) {
+    LogPolicy *t = table();
+    return (t ? t : fallback())[static_cast<int>(s)];
+  }
+
+  /** @brief Lower-case name of a subsystem. */
+  static const char *subsystemName(int s) {
+    static const char *const names[LOG_SUBSYSTEMS] = {
+        "belt", "dispatcher", "truck", "express", "session"};
+    return s >= 0 && s < LOG_SUBSYSTEMS ? names[s] : "?";
+  }
+
+  /**
+   * @brief Applies a LOG_THROTTLE specification.
+   *
+   * Only the settings named are changed. Nothing is applied if any entry
+   * is invalid.
+   *
+   * @param spec "subsystem:key=value[:key=value...][,subsystem:...]" with
+   * keys sample, rate, burst and repeat (ms).
+   * @param policies LOG_SUBSYSTEMS policies to update.
+   * @return false on an unknown subsystem or key, or a bad value.
+   */
+  static bool parse(const char *spec, LogPolicy *policies) {
+    struct Change {
+      int subsystem;
+      uint32_t LogPolicy::*field;
+      uint32_t value;
+    };
+    Change changes[LOG_SUBSYSTEMS * 4];
+    int count = 0;
+
+    std::string text(spec ? spec : "");
+    size_t pos = 0;
+    while (pos < text.size()) {
+      size_t end = text.find(',', pos);
+      if (end == std::string::npos)
+        end = text.size();
+      std::string entry = text.substr(pos, end - pos);
+      pos = end + 1;
+      if (entry.empty())
+        continue;
+
+      size_t colon = entry.find(':');
+      std::string name = entry.substr(0, colon);
+      int s = 0;
+      while (s < LOG_SUBSYSTEMS && name != subsystemName(s))
+        s++;
+      if (s == LOG_SUBSYSTEMS || colon == std::string::npos)
+        return false;
+
+      while (colon != std::string::npos) {
+        size_t next = entry.find(':', colon + 1);
+        std::string kv = entry.substr(colon + 1, next - colon - 1);
+        colon = next;
+        size_t eq = kv.find('=');
+        if (eq == std::string::npos || eq + 1 == kv.size() ||
+            count == LOG_SUBSYSTEMS * 4)
+          return false;
+        char *stop = nullptr;
+        unsigned long v = std::strtoul(kv.c_str() + eq + 1, &stop, 10);
+        if (*stop != '\0' || v > 0xffffffffUL)
+          return false;
+
+        std::string key = kv.substr(0, eq);
+        uint32_t LogPolicy::*field = key == "sample"   ? &LogPolicy::sample
+                                     : key == "rate"   ? &LogPolicy::rate
+                                     : key == "burst"  ? &LogPolicy::burst
+                                     : key == "repeat" ? &LogPolicy::repeat_ms
+                                                       : nullptr;
+        if (!field)
+          return false;
+        changes[count++] = {s, field, static_cast<uint32_t>(v)};
+      }
+    }
+
+    for (int i = 0; i < count; ++i)
+      atomicStore(policies[changes[i].subsystem].*changes[i].field,
+                  changes[i].value);
+    return true;
+  }
+
+  /** @brief Prints the policy and the dropped records of each subsystem. */
+  static void printReport(std::ostream &out, const LogPolicy *policies) {
+    char line[120];
+    out << "  subsystem    sample   rate/s  burst  repeat_ms  suppressed\n";
+    for (int s = 0; s < LOG_SUBSYSTEMS; ++s) {
+      const LogPolicy &p = policies[s];
+      uint32_t sample = atomicLoad(p.sample);
+      uint32_t rate = atomicLoad(p.rate);
+      uint32_t burst = atomicLoad(p.burst);
+      uint32_t repeat = atomicLoad(p.repeat_ms);
+      std::string limit = rate ? std::to_string(rate) : "-";
+      std::snprintf(line, sizeof(line),
+                    "  %-10s  1/%-5u  %6s  %5u  %9u  %10llu\n",
+                    subsystemName(s), sample ? sample : 1, limit.c_str(),
+                    burst ? burst : rate,
+                    repeat ? repeat : LOG_REPEAT_DEFAULT_MS,
+                    (unsigned long long)atomicLoad(p.suppressed));
+      out << line;
+    }
+  }
+};
+
+/**
+ * @class LogSite
+ * @brief Throttling state of one log call site.
+ */
+class LogSite {
+private:
+  std::atomic<uint64_t> calls{0};    /**< Calls seen, for sampling. */
+  std::atomic<uint64_t> tat_ns{0};   /**< Token bucket arrival time. */
+  std::atomic<uint64_t> last_key{0}; /**< Key of the last repeat call. */
+  std::atomic<bool> primed{false};   /**< `last_key` is meaningful. */
+  std::atomic<uint64_t> shown_ns{0}; /**< When the last record was shown. */
+  std::atomic<uint64_t> folded{0};   /**< Repeats since then. */
+
+  static void drop(LogPolicy &p) { atomicAdd(p.suppressed, uint64_t{1}); }
+
+  /** @brief Takes a token from a bucket of `rate`/s and depth `burst`. */
+  bool takeToken(uint32_t rate, uint32_t burst, uint64_t now) {
+    uint64_t interval = 1000000000ULL / rate;
+    uint64_t tolerance = (burst ? burst - 1 : rate - 1) * interval;
+    uint64_t tat = tat_ns.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+      uint64_t base = tat > now ? tat : now;
+      if (base - now > tolerance)
+        return false;
+      next = base + interval;
+    } while (!tat_ns.compare_exchange_weak(tat, next,
+                                           std::memory_order_relaxed));
+    return true;
+  }
+
+public:
+  /**
+   * @brief Applies sampling and the rate limit.
+   * @param now_ns Monotonic time, 0 to read the clock only if needed.
+   * @return true if the call should be logged.
+   */
+  bool admit(LogSubsystem sub, uint64_t now_ns = 0) {
+    LogPolicy &p = LogThrottle::policy(sub);
+    uint32_t sample = atomicLoad(p.sample);
+    if (sample > 1 &&
+        calls.fetch_add(1, std::memory_order_relaxed) % sample != 0) {
+      drop(p);
+      return false;
+    }
+    uint32_t rate = atomicLoad(p.rate);
+    if (rate > 0 && !takeToken(rate, atomicLoad(p.burst),
+                               now_ns ? now_ns : monotonicNowNs())) {
+      drop(p);
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Folds repeats of `key`, then applies admit().
+   * @param repeated Set to the calls folded since the last record shown.
+   * @return true if the call should be logged.
+   */
+  bool admitRepeat(LogSubsystem sub, uint64_t key, uint64_t &repeated,
+                   uint64_t now_ns = 0) {
+    LogPolicy &p = LogThrottle::policy(sub);
+    uint64_t now = now_ns ? now_ns : monotonicNowNs();
+    uint32_t window_ms = atomicLoad(p.repeat_ms);
+    uint64_t window =
+        (window_ms ? window_ms : LOG_REPEAT_DEFAULT_MS) * 1000000ULL;
+
+    uint64_t prev = last_key.exchange(key, std::memory_order_relaxed);
+    bool was_primed = primed.exchange(true, std::memory_order_relaxed);
+    if (was_primed && prev == key &&
+        now - shown_ns.load(std::memory_order_relaxed) < window) {
+      folded.fetch_add(1, std::memory_order_relaxed);
+      drop(p);
+      return false;
+    }
+    if (!admit(sub, now))
+      return false;
+    shown_ns.store(now, std::memory_order_relaxed);
+    repeated = folded.exchange(0, std::memory_order_relaxed);
+    return true;
+  }
+};
+
+/** @brief The LogSite of this expansion (a lambda type is unique). */
+#define WAREHOUSE_LOG_SITE()                                                   \
+  ([]() -> LogSite & {                                                         \
+    static LogSite site;                                                       \
+    return site;                                                               \
+  }())
+
+/** @brief True if a record at `lvl` from this call site should be logged. */
+#define WAREHOUSE_LOG_ENABLED(sub, lvl)                                        \
+  (spdlog::default_logger_raw()->should_log(lvl) &&                            \
+   WAREHOUSE_LOG_SITE().admit(sub))
+
+/** @brief spdlog::log with the subsystem's sampling and rate limit. */
+#define WAREHOUSE_LOG(sub, lvl, ...)                                           \
+  do {                                                                         \
+    if (WAREHOUSE_LOG_ENABLED(sub, lvl))                                       \
+      spdlog::log(lvl, __VA_ARGS__);                                           \
+  } while (0)
+
+/**
+ * @brief WAREHOUSE_LOG that also folds consecutive calls with the same
+ * `key` (e.g. a package id) into one record per repeat window.
+ */
+#define WAREHOUSE_LOG_REPEAT(sub, lvl, key, ...)                               \
+  do {                                                                         \
+    uint64_t warehouse_log_repeated_ = 0;                                      \
+    if (spdlog::default_logger_raw()->should_log(lvl) &&                       \
+        WAREHOUSE_LOG_SITE().admitRepeat(sub, static_cast<uint64_t>(key),      \
+                                         warehouse_log_repeated_)) {           \
+      if (warehouse_log_repeated_)                                             \
+        spdlog::log(lvl, "[{}] Last message repeated {} times.",               \
+                    LogThrottle::subsystemName(static_cast<int>(sub)),         \
+                    warehouse_log_repeated_);                                  \
+      spdlog::log(lvl, __VA_ARGS__);                                           \
+    }                                                                          \
+  } while (0)
@@ -11,13 +11,21 @@
 
 #pragma once
 
+#include "AuditJournal.h"
 #include "Belt.h"
 #include "Dispatcher.h"
 #include "Express.h"
+#include "FaultInjector.h"
+#include "LockProfiler.h"
+#include "LogThrottle.h"
+#include "Probes.h"
 #include "SessionManager.h"
 #include "Shared.h"
+#include "Sorter.h"
 #include "Truck.h"
+#include "Watchdog.h"
 #include "spdlog/spdlog.h"
+#include <algorithm>
 #include <cerrno>
 #include <cstdlib>
 #include <cstring>
@@ -27,6 +35,7 @@
 #include <sys/sem.h>
 #include <sys/shm.h>
 #include <unistd.h>
+#include <vector>
 
 /**
  * @class Manager
@@ -37,7 +46,8 @@
  * 1. **Resource Lifecycle:** Creating, attaching, and destroying Shared Memory,
  * Semaphores, and Message Queues.
  * 2. **Component Orchestration:** Initializing and holding ownership of logic
- * controllers (Belt, Truck, Dispatcher, Express, SessionManager).
+ * controllers (Belt, Truck, Dispatcher, Express, SessionManager, and the
+ * Sorter with its lanes when `SORTER_RULE` is set).
  * 3. **Synchronization Primitive Abstraction:** Providing easy-to-use methods
  * for locking/unlocking mutexes (Belt, Dock) and signaling semaphores.
  * 4. **Inter-Process Communication:** Abstracting `msgsnd` and `msgrcv` for
@@ -64,7 +74,28 @@ protected:
    */
   bool is_owner;
 
+  /** @brief Perturbs the IPC calls when `FAULT_PLAN` is set (else nullptr). */
+  std::unique_ptr<FaultInjector> faults;
+
+  /** @brief Health entry of this process's session (nullptr until login). */
+  ProcessHealth *health = nullptr;
+
+  /** @brief Points this process and its components at session `slot`. */
+  void bindHealth(int slot) {
+    health = slot >= 0 ? &shm->health[slot] : nullptr;
+    dispatcher->setHealth(health);
+    truck->setHealth(health);
+    if (sorter)
+      sorter->setHealth(health);
+  }
+
 public:
+  /**
+   * @brief Audit journal, present when `AUDIT_JOURNAL_DIR` is set.
+   * Declared first so it outlives the components that append to it.
+   */
+  std::unique_ptr<AuditJournal> journal;
+
   /** @brief Manages user sessions and authentication logic. */
   std::unique_ptr<SessionManager> session_store;
 
@@ -80,6 +111,54 @@ public:
   /** @brief Manages high-priority Express (P4) deliveries. */
   std::unique_ptr<Express> express;
 
+  /** @brief Sorter lanes, one per configured lane (empty without a sorter). */
+  std::vector<std::unique_ptr<Lane>> lanes;
+
+  /** @brief Routes belt packages into `lanes` (nullptr without a sorter). */
+  std::unique_ptr<Sorter> sorter;
+
+  /** @brief Whether the last P operation of this thread got no permit. */
+  inline static thread_local bool wait_failed = false;
+
+  /**
+   * @brief Refuses to run against a segment laid out by another build.
+   * * Exits the process (EPROTO) if the segment is smaller than its header
+   * or its stamp differs from `currentLayout()`.
+   */
+  void checkLayout() {
+    struct shmid_ds info;
+    const char *why = nullptr;
+    if (shmctl(shm_id, IPC_STAT, &info) == -1 ||
+        info.shm_segsz < sizeof(ShmLayout))
+      why = "segment smaller than its header";
+    else
+      why = layoutMismatch(shm->layout);
+    if (!why)
+      return;
+
+    spdlog::critical("[ipc manager] Incompatible shared memory segment: {} "
+                     "differs (segment ABI {}, binary ABI {}). Restart the "
+                     "warehouse or run a compatible binary.",
+                     why, shm->layout.abi_version, SHM_ABI_VERSION);
+    shmdt(shm);
+    exit(EPROTO);
+  }
+
+  /**
+   * @brief Resolves the System V key of an IPC resource.
+   *
+   * The `IPC_KEY_OFFSET` environment variable shifts every key, which lets
+   * independent instances (e.g. the stress harness) run side by side with a
+   * live simulation. Without it the historical keys are used unchanged.
+   *
+   * @param base One of SHM_KEY_ID, SEM_KEY_ID, MSG_KEY_ID.
+   * @return The key to pass to shmget/semget/msgget.
+   */
+  static key_t ipcKey(int base) {
+    const char *offset = std::getenv("IPC_KEY_OFFSET");
+    return static_cast<key_t>(base + (offset ? std::atoi(offset) : 0));
+  }
+
   /**
    * @brief Constructs the Manager and initializes IPC resources.
    *
@@ -94,13 +173,15 @@ public:
     int flags = is_owner ? (IPC_CREAT | 0600) : 0600;
 
     if (is_owner) {
-      int old_shm = shmget(SHM_KEY_ID, 0, 0);
+      int old_shm = shmget(ipcKey(SHM_KEY_ID), 0, 0);
       if (old_shm != -1) {
         shmctl(old_shm, IPC_RMID, nullptr);
       }
     }
 
-    shm_id = shmget(SHM_KEY_ID, sizeof(SharedState), flags);
+    // Clients attach whatever size exists; the layout stamp is checked below.
+    shm_id = shmget(ipcKey(SHM_KEY_ID), is_owner ? sizeof(SharedState) : 0,
+                    flags);
     if (shm_id == -1) {
       spdlog::critical("[ipc manager] shmget failed: {}", std::strerror(errno));
       exit(errno);
@@ -112,13 +193,23 @@ public:
       exit(errno);
     }
 
-    sem_id = semget(SEM_KEY_ID, is_owner ? SEM_TOTAL : 0, flags);
+    if (!is_owner) {
+      checkLayout();
+      if (std::getenv("SHM_ABI_CHECK")) {
+        spdlog::info("[ipc manager] Segment layout compatible (ABI {}).",
+                     SHM_ABI_VERSION);
+        shmdt(shm);
+        exit(0);
+      }
+    }
+
+    sem_id = semget(ipcKey(SEM_KEY_ID), is_owner ? SEM_TOTAL : 0, flags);
     if (sem_id == -1) {
       spdlog::critical("[ipc manager] semget failed: {}", std::strerror(errno));
       exit(errno);
     }
 
-    msg_id = msgget(MSG_KEY_ID, flags);
+    msg_id = msgget(ipcKey(MSG_KEY_ID), flags);
     if (msg_id == -1) {
       spdlog::critical("[ipc manager] msgget failed: {}", std::strerror(errno));
       exit(errno);
@@ -126,6 +217,7 @@ public:
 
     if (is_owner) {
       std::memset(shm, 0, sizeof(SharedState));
+      shm->layout = currentLayout();
 
       shm->running = true;
       shm->total_packages_created = 0;
@@ -136,14 +228,91 @@ public:
       semctl(sem_id, SEM_DOCK_MUTEX, SETVAL, 1);
       semctl(sem_id, SEM_EMPTY_SLOTS, SETVAL, MAX_BELT_CAPACITY_K);
       semctl(sem_id, SEM_FULL_SLOTS, SETVAL, 0);
+      for (int l = 0; l < MAX_SORTER_LANES; ++l) {
+        semctl(sem_id, laneSem(l, LANE_MUTEX), SETVAL, 1);
+        semctl(sem_id, laneSem(l, LANE_EMPTY), SETVAL, LANE_CAPACITY);
+        semctl(sem_id, laneSem(l, LANE_FULL), SETVAL, 0);
+        semctl(sem_id, laneSem(l, LANE_DOCK), SETVAL, 1);
+      }
+
+      const char *speed = std::getenv("BELT_SPEED_MS");
+      if (speed && *speed)
+        shm->transit.speed_ms = std::max(0, std::atoi(speed));
+
+      const char *order = std::getenv("BELT_ORDER");
+      if (order && std::strcmp(order, "edf") == 0)
+        shm->schedule.order = BeltOrder::Edf;
+
+      // "STANDARD,PRIORITY,URGENT" in ms; missing or 0 keeps the default.
+      const char *budgets = std::getenv("SLA_BUDGET_MS");
+      for (int t = 0; budgets && *budgets && t < SLA_TIERS; ++t) {
+        shm->schedule.budget_ms[t] = std::max(0, std::atoi(budgets));
+        budgets = std::strchr(budgets, ',');
+        if (budgets)
+          budgets++;
+      }
+
+      const char *rule = std::getenv("SORTER_RULE");
+      if (rule && *rule) {
+        if (parseSortRule(rule, shm->sort_rule)) {
+          shm->lane_count = shm->sort_rule.lanes;
+          spdlog::info("[ipc manager] Sorter enabled: '{}' over {} lanes.",
+                       rule, shm->lane_count);
+        } else {
+          spdlog::error("[ipc manager] Invalid SORTER_RULE '{}', running "
+                        "without a sorter.",
+                        rule);
+        }
+      }
+
+      const char *throttle = std::getenv("LOG_THROTTLE");
+      if (throttle && *throttle &&
+          !LogThrottle::parse(throttle, shm->log_policy))
+        spdlog::error("[ipc manager] Invalid LOG_THROTTLE '{}', logging "
+                      "everything.",
+                      throttle);
 
       spdlog::info(
           "[ipc manager] IPC Initialized: SHM ID {}, SEM ID {}, MSG ID {}",
           shm_id, sem_id, msg_id);
     }
 
+    LogThrottle::attach(shm->log_policy);
+
+    const char *fault_plan = std::getenv("FAULT_PLAN");
+    if (fault_plan && *fault_plan) {
+      std::vector<FaultRule> rules;
+      const char *seed = std::getenv("FAULT_SEED");
+      if (!parseFaultPlan(fault_plan, rules)) {
+        spdlog::error("[ipc manager] Invalid FAULT_PLAN '{}', no faults "
+                      "injected.",
+                      fault_plan);
+      } else {
+        faults = std::make_unique<FaultInjector>(
+            shm, rules, spdlog::default_logger()->name(),
+            seed ? std::strtoull(seed, nullptr, 10) : 1);
+        if (faults->empty())
+          faults.reset();
+        else
+          spdlog::warn("[ipc manager] Fault injection active: '{}'.",
+                       fault_plan);
+      }
+    }
+
+    const char *journal_dir = std::getenv("AUDIT_JOURNAL_DIR");
+    if (journal_dir && *journal_dir) {
+      if (is_owner)
+        AuditJournal::reset(journal_dir);
+      journal = std::make_unique<AuditJournal>(shm, journal_dir);
+    }
+
+    const char *ledger_path = std::getenv("DELIVERY_LEDGER");
+    if (is_owner && ledger_path && *ledger_path)
+      DeliveryLedger::reset(ledger_path);
+
     session_store = std::make_unique<SessionManager>(
         shm, [this]() { this->lockBelt(); }, [this]() { this->unlockBelt(); });
+    session_store->setSessionHook([this](int slot) { bindHealth(slot); });
 
     belt = std::make_unique<Belt>(
         shm, [this]() { this->waitForEmptySlot(); },
@@ -151,10 +320,13 @@ public:
         [this]() { this->waitForPackage(); },
         [this]() { this->signalPackageAdded(); },
         [this]() { this->lockBelt(); }, [this]() { this->unlockBelt(); });
+    belt->setWaitFailedCheck([]() { return Manager::lastWaitFailed(); });
 
     truck = std::make_unique<Truck>(
         shm, [this]() { this->lockDock(); }, [this]() { this->unlockDock(); },
         [this](pid_t pid) { return this->receiveSignalBlocking(pid); });
+    truck->setSignalDrain(
+        [this](pid_t pid) { return this->receiveSignalNonBlocking(pid); });
 
     express = std::make_unique<Express>(
         shm, [this]() { this->lockDock(); }, [this]() { this->unlockDock(); },
@@ -164,12 +336,44 @@ public:
         belt.get(), shm, [this]() { this->lockDock(); },
         [this]() { this->unlockDock(); },
         [this](pid_t target, SignalType s) { this->sendSignal(target, s); });
+
+    auto wait_failed_check = []() { return Manager::lastWaitFailed(); };
+    truck->setWaitFailedCheck(wait_failed_check);
+    express->setWaitFailedCheck(wait_failed_check);
+    dispatcher->setWaitFailedCheck(wait_failed_check);
+    session_store->setWaitFailedCheck(wait_failed_check);
+
+    belt->setJournal(journal.get());
+    express->setJournal(journal.get());
+    dispatcher->setJournal(journal.get());
+
+    std::vector<Lane *> lane_ptrs;
+    for (int l = 0; l < shm->lane_count; ++l) {
+      lanes.push_back(std::make_unique<Lane>(
+          shm, l, [this, l]() { semOperation(laneSem(l, LANE_EMPTY), -1); },
+          [this, l]() { semOperation(laneSem(l, LANE_EMPTY), 1); },
+          [this, l]() { semOperation(laneSem(l, LANE_FULL), -1); },
+          [this, l]() { semOperation(laneSem(l, LANE_FULL), 1); },
+          [this, l]() { waitMutex(laneSem(l, LANE_MUTEX)); },
+          [this, l]() { semOperation(laneSem(l, LANE_MUTEX), 1); }));
+      lanes.back()->setWaitFailedCheck(
+          []() { return Manager::lastWaitFailed(); });
+      lane_ptrs.push_back(lanes.back().get());
+    }
+    if (!lanes.empty())
+      sorter = std::make_unique<Sorter>(belt.get(), shm, std::move(lane_ptrs));
   }
 
   /**
    * @brief Destructor. Detaches shared memory and removes resources if owner.
    */
   virtual ~Manager() {
+    // The loaders release their dock slots in shared memory.
+    dispatcher.reset();
+    express.reset();
+
+    if (shm)
+      LogThrottle::detach(shm->log_policy);
     if (shmdt(shm) == -1) {
       spdlog::warn("[ipc manager] shmdt failed: {}", std::strerror(errno));
     }
@@ -188,57 +392,204 @@ public:
    */
   SharedState *getState() { return shm; }
 
+  /** @brief Health entry of this process (nullptr without a session). */
+  ProcessHealth *processHealth() { return health; }
+
+  /** @brief Records one unit of progress of this process (see Watchdog.h). */
+  void heartbeat() { ::heartbeat(health); }
+
   /**
-   * @brief Generic wrapper for `semop` system call.
+   * @brief Executes a single `semop` call.
    * Handles EINTR (interrupts) and errors gracefully.
    *
+   * @param sb The operation to perform.
+   * @return true if the operation was applied. false on interruption, on a
+   * failed IPC_NOWAIT attempt (errno == EAGAIN) or after shutdown.
+   */
+  bool semCall(struct sembuf &sb) {
+    if (semop(sem_id, &sb, 1) == 0)
+      return true;
+
+    if (errno == EAGAIN && (sb.sem_flg & IPC_NOWAIT))
+      return false;
+
+    if (errno == EIDRM || errno == EINVAL) {
+      if (!shm->running)
+        return false;
+    }
+
+    if (errno != EINTR) {
+      spdlog::critical("[ipc manager] semop failed: {}", std::strerror(errno));
+      exit(errno);
+    }
+    return false;
+  }
+
+  /**
+   * @brief Generic wrapper for `semop` system call with contention profiling.
+   *
+   * P operations first try `IPC_NOWAIT`; only if that fails does the call
+   * block, and the blocked time is charged to the (semaphore, call site)
+   * pair in `SharedState::lock_stats` (see LockProfiler.h). Every call
+   * fires the `sem__enter` and `sem__exit` probes (see Probes.h). Mutexes
+   * held and blocked waits are recorded in the session's ProcessHealth for
+   * the watchdog.
+   *
    * @param semIdx The index of the semaphore in the set (enum SemIndex).
    * @param op The operation to perform (-1 for Wait/P, +1 for Signal/V).
    */
   void semOperation(SemIndex semIdx, int op) {
+    WAREHOUSE_PROBE2(sem__enter, semIdx, op);
+    semApply(semIdx, op);
+    WAREHOUSE_PROBE3(sem__exit, semIdx, op, op < 0 && wait_failed);
+  }
+
+  /** @brief Body of `semOperation`, without the probes. */
+  void semApply(SemIndex semIdx, int op) {
     struct sembuf sb;
     sb.sem_num = static_cast<int>(semIdx);
     sb.sem_op = op;
     sb.sem_flg = 0;
 
-    if (semop(sem_id, &sb, 1) == -1) {
-      if (errno == EIDRM || errno == EINVAL) {
-        if (!shm->running)
-          return;
-      }
+    bool mutex = health && LockProfiler::isMutex(semIdx);
+    uint32_t bit = 1u << semIdx;
 
-      if (errno != EINTR) {
-        spdlog::critical("[ipc manager] semop failed: {}",
-                         std::strerror(errno));
-        exit(errno);
-      }
+    if (op > 0) {
+      if (mutex)
+        __atomic_fetch_and(&health->held, ~bit, __ATOMIC_RELAXED);
+      if (semCall(sb))
+        LockProfiler::onRelease(shm, semIdx);
+      return;
+    }
+
+    wait_failed = false;
+    sb.sem_flg = IPC_NOWAIT;
+    if (semCall(sb)) {
+      if (mutex)
+        __atomic_fetch_or(&health->held, bit, __ATOMIC_RELAXED);
+      LockProfiler::onAcquire(shm, semIdx, false, 0);
+      return;
+    }
+    wait_failed = true;
+    if (errno != EAGAIN)
+      return;
+
+    uint64_t wait_start = monotonicNowNs();
+    if (health) {
+      atomicStore(health->wait_since_ns, wait_start);
+      atomicStore(health->waiting, static_cast<int32_t>(semIdx) + 1);
+    }
+    sb.sem_flg = 0;
+    bool acquired = semCall(sb);
+    if (health) {
+      atomicStore(health->waiting, 0);
+      if (acquired && mutex)
+        __atomic_fetch_or(&health->held, bit, __ATOMIC_RELAXED);
+    }
+    if (acquired) {
+      wait_failed = false;
+      LockProfiler::onAcquire(shm, semIdx, true,
+                              monotonicNowNs() - wait_start);
     }
   }
 
+  /**
+   * @brief Whether the calling thread's last P operation returned without a
+   * permit (interrupted by a signal or the semaphore set was removed).
+   * * For mutexes (see waitMutex) only the latter, at shutdown: the caller
+   * must then return without the matching V.
+   */
+  static bool lastWaitFailed() { return wait_failed; }
+
+  /**
+   * @brief P on a mutex semaphore, retried while a signal interrupts it.
+   * * A mutex wait cut short by e.g. SIGTERM during a rolling restart must
+   * not be taken as a hold: the caller's V would raise the mutex to 2.
+   * Gives up only once `running` is cleared or the set is removed, with
+   * `lastWaitFailed()` set.
+   */
+  void waitMutex(SemIndex semIdx) {
+    do
+      semOperation(semIdx, -1);
+    while (wait_failed && shm->running);
+  }
+
+  /**
+   * @brief Runs a P operation with the faults planned for `site` around it.
+   */
+  void perturbedWait(FaultSite site, SemIndex semIdx) {
+    if (faults)
+      faults->before(site);
+    if (LockProfiler::isMutex(semIdx))
+      waitMutex(semIdx);
+    else
+      semOperation(semIdx, -1);
+    if (faults)
+      faults->after(site);
+  }
+
   /** @brief Acquires the Belt Mutex (Critical Section Entry). */
-  void lockBelt() { semOperation(SEM_MUTEX_BELT, -1); }
+  void lockBelt() { perturbedWait(FaultSite::LockBelt, SEM_MUTEX_BELT); }
 
   /** @brief Releases the Belt Mutex (Critical Section Exit). */
   void unlockBelt() { semOperation(SEM_MUTEX_BELT, 1); }
 
   /** @brief Decrements Empty Slots semaphore (Producer Wait). */
-  void waitForEmptySlot() { semOperation(SEM_EMPTY_SLOTS, -1); }
+  void waitForEmptySlot() {
+    perturbedWait(FaultSite::WaitForSlot, SEM_EMPTY_SLOTS);
+  }
 
   /** @brief Increments Empty Slots semaphore (Consumer Signal). */
   void signalSlotFreed() { semOperation(SEM_EMPTY_SLOTS, 1); }
 
   /** @brief Decrements Full Slots semaphore (Consumer Wait). */
-  void waitForPackage() { semOperation(SEM_FULL_SLOTS, -1); }
+  void waitForPackage() {
+    perturbedWait(FaultSite::WaitForPackage, SEM_FULL_SLOTS);
+  }
 
   /** @brief Increments Full Slots semaphore (Producer Signal). */
   void signalPackageAdded() { semOperation(SEM_FULL_SLOTS, 1); }
 
   /** @brief Acquires the Loading Dock Mutex. */
-  void lockDock() { semOperation(SEM_DOCK_MUTEX, -1); }
+  void lockDock() { perturbedWait(FaultSite::LockDock, SEM_DOCK_MUTEX); }
 
   /** @brief Releases the Loading Dock Mutex. */
   void unlockDock() { semOperation(SEM_DOCK_MUTEX, 1); }
 
+  /** @brief Acquires the mutex of dock `i` (see dockAt). */
+  void lockDockAt(int i) {
+    perturbedWait(FaultSite::LockDock,
+                  shm->lane_count > 0 ? laneSem(i, LANE_DOCK) : SEM_DOCK_MUTEX);
+  }
+
+  /** @brief Releases the mutex of dock `i`. */
+  void unlockDockAt(int i) {
+    semOperation(shm->lane_count > 0 ? laneSem(i, LANE_DOCK) : SEM_DOCK_MUTEX,
+                 1);
+  }
+
+  /**
+   * @brief Binds the Dispatcher, Truck and Express of this process to a
+   * sorter lane: the Dispatcher drains the lane ring and all three use the
+   * lane's dock. No-op without a sorter.
+   *
+   * @param l Lane index; wrapped into `[0, lane_count)`.
+   */
+  void useLane(int l) {
+    if (lanes.empty())
+      return;
+    l = ((l % (int)lanes.size()) + (int)lanes.size()) % (int)lanes.size();
+
+    auto lock = [this, l]() { lockDockAt(l); };
+    auto unlock = [this, l]() { unlockDockAt(l); };
+    Lane *lane = lanes[l].get();
+
+    dispatcher->setLane([lane]() { return lane->pop(); }, &lane->shared(),
+                        lock, unlock);
+    truck->setDock(&lane->shared().dock, lock, unlock);
+    express->setDock(&lane->shared().dock, lock, unlock);
+  }
+
   /**
    * @brief Sends a command signal to a specific process via Message Queue.
    *
@@ -250,6 +601,15 @@ public:
     msg.mtype = target_pid;
     msg.command_id = static_cast<int>(type);
 
+    if (faults) {
+      faults->before(FaultSite::SendSignal);
+      if (faults->dropped(FaultSite::SendSignal)) {
+        spdlog::error("[ipc manager] msgsnd failed (target {}): injected "
+                      "fault",
+                      target_pid);
+        return;
+      }
+    }
     if (msgsnd(msg_id, &msg, sizeof(int), 0) == -1) {
       spdlog::error("[ipc manager] msgsnd failed (target {}): {}", target_pid,
                     std::strerror(errno));
@@ -261,11 +621,13 @@ public:
 
   /**
    * @brief Blocking wait for a signal addressed to this process.
+   * * The process counts as parked for the watchdog while it waits.
    *
    * @param my_pid The PID of the calling process (used to filter messages).
    * @return The received SignalType.
    */
   SignalType receiveSignalBlocking(pid_t my_pid) {
+    HealthParkScope parked(health);
     CommandMessage msg;
     if (msgrcv(msg_id, &msg, sizeof(int), my_pid, 0) != -1) {
       return static_cast<SignalType>(msg.command_id);
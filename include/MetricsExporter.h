@@ -0,0 +1,873 @@
+/**
+ * @file MetricsExporter.h
+ * @brief Prometheus text-format exporter for the shared warehouse state.
+ *
+ * This file defines the `MetricsExporter` class, which renders belt, dock,
+ * fleet, session and latency metrics straight out of Shared Memory in the
+ * Prometheus exposition format (version 0.0.4). The rendered page can be
+ * served over HTTP on the loopback interface, over a UNIX domain socket, or
+ * written periodically to a file picked up by node-exporter's textfile
+ * collector.
+ */
+#pragma once
+
+#include "FaultInjector.h"
+#include "LockProfiler.h"
+#include "LogThrottle.h"
+#include "QueueAnalytics.h"
+#include "ResourceSampler.h"
+#include "Shared.h"
+#include "Telemetry.h"
+#include "spdlog/spdlog.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/** @brief Size of the pre-allocated page buffer (fits all 210 sessions). */
+constexpr size_t METRICS_BUFFER_SIZE = 128 * 1024;
+
+/**
+ * @class MetricsExporter
+ * @brief Renders and serves warehouse metrics without touching the semaphores.
+ *
+ * Rendering reads every counter with relaxed atomic loads and never takes
+ * the Belt or Dock mutex, so scraping cannot slow down Workers or the
+ * Dispatcher. Gauges read this way are not a consistent snapshot of the whole
+ * segment, which is acceptable for monitoring purposes.
+ *
+ * The page is formatted into a buffer owned by the exporter; no heap memory
+ * is allocated per scrape.
+ */
+class MetricsExporter {
+private:
+  /**
+   * @struct PageWriter
+   * @brief Bounded append-only writer over the exporter's page buffer.
+   */
+  struct PageWriter {
+    char *buf;         /**< Destination buffer. */
+    size_t cap;        /**< Buffer capacity in bytes. */
+    size_t len = 0;    /**< Bytes written so far. */
+    bool full = false; /**< Set once any append was truncated. */
+
+    void put(const char *text) { put(text, std::strlen(text)); }
+
+    void put(const char *text, size_t n) {
+      if (len + n > cap) {
+        full = true;
+        return;
+      }
+      std::memcpy(buf + len, text, n);
+      len += n;
+    }
+
+    void putInt(long long value) {
+      char tmp[24];
+      auto res = std::to_chars(tmp, tmp + sizeof(tmp), value);
+      put(tmp, res.ptr - tmp);
+    }
+
+    void putUnsigned(unsigned long long value) {
+      char tmp[24];
+      auto res = std::to_chars(tmp, tmp + sizeof(tmp), value);
+      put(tmp, res.ptr - tmp);
+    }
+
+    void putDouble(double value) {
+      char tmp[32];
+      int n = std::snprintf(tmp, sizeof(tmp), "%.6g", value);
+      put(tmp, n > 0 ? static_cast<size_t>(n) : 0);
+    }
+
+    /** @brief Writes a label value, escaping backslash, quote and newline. */
+    void putLabel(const char *value, size_t max_len) {
+      for (size_t i = 0; i < max_len && value[i]; ++i) {
+        char c = value[i];
+        if (c == '\\' || c == '"') {
+          char esc[2] = {'\\', c};
+          put(esc, 2);
+        } else if (c == '\n') {
+          put("\\n", 2);
+        } else {
+          put(&c, 1);
+        }
+      }
+    }
+  };
+
+  /** @brief Pointer to the system's Shared Memory state. */
+  SharedState *shm;
+
+  /** @brief Pre-allocated page buffer (HTTP header + body). */
+  char page[METRICS_BUFFER_SIZE];
+
+  /** @name Listener State
+   * @{ */
+  int tcp_fd = -1;       /**< Loopback HTTP listener. */
+  int unix_fd = -1;      /**< UNIX domain socket listener. */
+  std::string unix_path; /**< Socket path, unlinked on destruction. */
+  /** @} */
+
+  /** @name Textfile Collector Output
+   * @{ */
+  std::string textfile_path;    /**< Destination file (empty = disabled). */
+  std::string textfile_tmp;     /**< Staging file renamed over the target. */
+  int textfile_interval_ms = 0; /**< Rewrite period in milliseconds. */
+  /** @} */
+
+  /** @brief Emits the `# HELP` and `# TYPE` preamble of a metric family. */
+  static void family(PageWriter &w, const char *name, const char *type,
+                     const char *help) {
+    w.put("# HELP ");
+    w.put(name);
+    w.put(" ");
+    w.put(help);
+    w.put("\n# TYPE ");
+    w.put(name);
+    w.put(" ");
+    w.put(type);
+    w.put("\n");
+  }
+
+  /** @brief Emits a single unlabelled integer sample with its preamble. */
+  static void metric(PageWriter &w, const char *name, const char *type,
+                     const char *help, long long value) {
+    family(w, name, type, help);
+    w.put(name);
+    w.put(" ");
+    w.putInt(value);
+    w.put("\n");
+  }
+
+  /** @brief Emits a single unlabelled floating-point sample. */
+  static void metric(PageWriter &w, const char *name, const char *type,
+                     const char *help, double value) {
+    family(w, name, type, help);
+    w.put(name);
+    w.put(" ");
+    w.putDouble(value);
+    w.put("\n");
+  }
+
+  /** @brief Renders a histogram kept in the latency buckets. */
+  static void histogram(PageWriter &w, const char *name, const char *help,
+                        const uint64_t (&buckets)[LATENCY_BUCKETS],
+                        uint64_t sum_ns, uint64_t count) {
+    family(w, name, "histogram", help);
+
+    unsigned long long cumulative = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; ++i) {
+      cumulative += atomicLoad(buckets[i]);
+      w.put(name);
+      w.put("_bucket{le=\"");
+      long long bound_ms = latencyBucketBoundMs(i);
+      if (bound_ms < 0) {
+        w.put("+Inf");
+      } else {
+        w.putDouble(bound_ms / 1000.0);
+      }
+      w.put("\"} ");
+      w.putUnsigned(cumulative);
+      w.put("\n");
+    }
+
+    w.put(name);
+    w.put("_sum ");
+    w.putDouble(sum_ns / 1e9);
+    w.put("\n");
+    w.put(name);
+    w.put("_count ");
+    w.putUnsigned(count);
+    w.put("\n");
+  }
+
+  /** @brief Renders the belt-to-truck latency histogram. */
+  void renderLatency(PageWriter &w) const {
+    const WarehouseStats &st = shm->stats;
+    histogram(w, "warehouse_package_latency_seconds",
+              "Time from belt push to truck load of a package.",
+              st.latency_buckets, atomicLoad(st.latency_sum_ns),
+              atomicLoad(st.latency_count));
+  }
+
+  /** @brief Renders per-tier deadline outcomes and the tardiness histogram. */
+  void renderDeadlines(PageWriter &w) const {
+    static const char *const tiers[SLA_TIERS] = {"standard", "priority",
+                                                 "urgent"};
+    const WarehouseStats &st = shm->stats;
+
+    family(w, "warehouse_sla_loaded_total", "counter",
+           "Belt packages loaded, by SLA tier.");
+    for (int t = 0; t < SLA_TIERS; ++t) {
+      w.put("warehouse_sla_loaded_total{tier=\"");
+      w.put(tiers[t]);
+      w.put("\"} ");
+      w.putUnsigned(atomicLoad(st.sla_loaded[t]));
+      w.put("\n");
+    }
+    family(w, "warehouse_sla_missed_total", "counter",
+           "Belt packages loaded after their deadline, by SLA tier.");
+    uint64_t missed = 0;
+    for (int t = 0; t < SLA_TIERS; ++t) {
+      uint64_t n = atomicLoad(st.sla_missed[t]);
+      missed += n;
+      w.put("warehouse_sla_missed_total{tier=\"");
+      w.put(tiers[t]);
+      w.put("\"} ");
+      w.putUnsigned(n);
+      w.put("\n");
+    }
+
+    histogram(w, "warehouse_sla_tardiness_seconds",
+              "Lateness of packages loaded after their deadline.",
+              st.tardiness_buckets, atomicLoad(st.tardiness_sum_ns), missed);
+  }
+
+  /** @brief Renders the faults injected so far, by site. */
+  void renderFaults(PageWriter &w) const {
+    family(w, "warehouse_faults_injected_total", "counter",
+           "Faults injected into IPC operations (FAULT_PLAN), by site.");
+    for (int f = 0; f < FAULT_SITES; ++f) {
+      w.put("warehouse_faults_injected_total{site=\"");
+      w.put(faultSiteName(static_cast<FaultSite>(f)));
+      w.put("\"} ");
+      w.putUnsigned(atomicLoad(shm->stats.faults_injected[f]));
+      w.put("\n");
+    }
+  }
+
+  /** @brief Renders per-session quota usage, labelled by username. */
+  void renderSessions(PageWriter &w) const {
+    int active = 0;
+    for (int i = 0; i < MAX_USERS_SESSIONS; ++i) {
+      if (atomicLoad(shm->users[i].active))
+        active++;
+    }
+    metric(w, "warehouse_sessions_active", "gauge",
+           "Occupied slots in the session table.", (long long)active);
+    metric(w, "warehouse_sessions_capacity", "gauge",
+           "Size of the session table.", (long long)MAX_USERS_SESSIONS);
+
+    family(w, "warehouse_session_processes", "gauge",
+           "Sub-processes currently running per session.");
+    for (int i = 0; i < MAX_USERS_SESSIONS; ++i) {
+      const UserSession &u = shm->users[i];
+      if (!atomicLoad(u.active))
+        continue;
+      w.put("warehouse_session_processes{user=\"");
+      w.putLabel(u.username, sizeof(u.username));
+      w.put("\"} ");
+      w.putInt(atomicLoad(u.current_processes));
+      w.put("\n");
+    }
+
+    family(w, "warehouse_session_process_quota", "gauge",
+           "Maximum sub-processes allowed per session.");
+    for (int i = 0; i < MAX_USERS_SESSIONS; ++i) {
+      const UserSession &u = shm->users[i];
+      if (!atomicLoad(u.active))
+        continue;
+      w.put("warehouse_session_process_quota{user=\"");
+      w.putLabel(u.username, sizeof(u.username));
+      w.put("\"} ");
+      w.putInt(atomicLoad(u.max_processes));
+      w.put("\n");
+    }
+  }
+
+  /** @brief Renders the stall watchdog counters (see Watchdog.h). */
+  void renderWatchdog(PageWriter &w) const {
+    const WatchdogState &wd = shm->watchdog;
+    if (atomicLoad(wd.passes) == 0)
+      return;
+    metric(w, "warehouse_processes_stalled", "gauge",
+           "Processes without progress beyond the watchdog threshold.",
+           (long long)atomicLoad(wd.stalled));
+    metric(w, "warehouse_watchdog_stalls_total", "counter",
+           "Processes found stalled by the watchdog.",
+           (long long)atomicLoad(wd.stalls));
+    metric(w, "warehouse_watchdog_recoveries_total", "counter",
+           "Mutexes released and processes killed by the watchdog.",
+           (long long)atomicLoad(wd.recoveries));
+  }
+
+  /** @brief Renders the records dropped by log throttling. */
+  void renderLogThrottle(PageWriter &w) const {
+    const char *name = "warehouse_log_suppressed_total";
+    family(w, name, "counter",
+           "Log records dropped by sampling, rate limits or repeat folding.");
+    for (int s = 0; s < LOG_SUBSYSTEMS; ++s) {
+      w.put(name);
+      w.put("{subsystem=\"");
+      w.put(LogThrottle::subsystemName(s));
+      w.put("\"} ");
+      w.putUnsigned(atomicLoad(shm->log_policy[s].suppressed));
+      w.put("\n");
+    }
+  }
+
+  /** @brief Renders one labelled family of the lock profiler counters. */
+  void renderLockFamily(PageWriter &w, const char *name, const char *type,
+                        const char *help, bool seconds,
+                        uint64_t LockStats::*field) const {
+    family(w, name, type, help);
+    for (int s = 0; s < SEM_TOTAL; ++s) {
+      for (int site = 0; site < LOCK_SITE_TOTAL; ++site) {
+        const LockStats &st = shm->lock_stats[s][site];
+        if (atomicLoad(st.acquisitions) == 0)
+          continue;
+        w.put(name);
+        w.put("{sem=\"");
+        w.put(LockProfiler::semName(static_cast<SemIndex>(s)));
+        w.put("\",site=\"");
+        w.put(LockProfiler::siteName(static_cast<LockSite>(site)));
+        w.put("\"} ");
+        uint64_t value = atomicLoad(st.*field);
+        if (seconds) {
+          w.putDouble(value / 1e9);
+        } else {
+          w.putUnsigned(value);
+        }
+        w.put("\n");
+      }
+    }
+  }
+
+  /** @brief Renders one per-stage family of the flow analysis. */
+  void renderStageFamily(PageWriter &w, const char *name, const char *help,
+                         double StageEstimate::*field) const {
+    family(w, name, "gauge", help);
+    for (int i = 0; i < STAGE_TOTAL; ++i) {
+      w.put(name);
+      w.put("{stage=\"");
+      w.put(QueueAnalytics::stageName(i));
+      w.put("\"} ");
+      w.putDouble(atomicLoad(shm->analytics.stages[i].*field));
+      w.put("\n");
+    }
+  }
+
+  /** @brief Renders one role-labelled family; `value` reads a RoleUsage. */
+  template <typename F>
+  void renderRoleFamily(PageWriter &w, const char *name, const char *type,
+                        const char *help, F value) const {
+    family(w, name, type, help);
+    for (int r = 0; r < PROCESS_ROLES; ++r) {
+      w.put(name);
+      w.put("{role=\"");
+      w.put(ResourceSampler::roleName(r));
+      w.put("\"} ");
+      w.putDouble(value(shm->resources.roles[r]));
+      w.put("\n");
+    }
+  }
+
+  /** @brief Renders per-role OS resource usage (see ResourceSampler.h). */
+  void renderResources(PageWriter &w) const {
+    if (atomicLoad(shm->resources.samples) == 0)
+      return;
+
+    renderRoleFamily(w, "warehouse_role_processes", "gauge",
+                     "Live sessions per role.", [](const RoleUsage &u) {
+                       return static_cast<double>(atomicLoad(u.processes));
+                     });
+    renderRoleFamily(w, "warehouse_role_cpu_user_seconds_total", "counter",
+                     "User CPU time used by the processes of a role.",
+                     [](const RoleUsage &u) {
+                       return atomicLoad(u.cpu_user_ns) / 1e9;
+                     });
+    renderRoleFamily(w, "warehouse_role_cpu_system_seconds_total", "counter",
+                     "Kernel CPU time used by the processes of a role.",
+                     [](const RoleUsage &u) {
+                       return atomicLoad(u.cpu_system_ns) / 1e9;
+                     });
+    renderRoleFamily(w, "warehouse_role_cpu_cores", "gauge",
+                     "CPUs kept busy over the last sampling interval.",
+                     [](const RoleUsage &u) {
+                       return atomicLoad(u.cpu_cores);
+                     });
+    renderRoleFamily(w, "warehouse_role_resident_bytes", "gauge",
+                     "Resident set size summed over a role.",
+                     [](const RoleUsage &u) {
+                       return static_cast<double>(atomicLoad(u.rss_bytes));
+                     });
+    renderRoleFamily(w, "warehouse_role_pss_bytes", "gauge",
+                     "Proportional set size summed over a role.",
+                     [](const RoleUsage &u) {
+                       return static_cast<double>(atomicLoad(u.pss_bytes));
+                     });
+    renderRoleFamily(w, "warehouse_role_voluntary_switches_total", "counter",
+                     "Context switches of a role while blocking.",
+                     [](const RoleUsage &u) {
+                       return static_cast<double>(
+                           atomicLoad(u.voluntary_switches));
+                     });
+    renderRoleFamily(w, "warehouse_role_involuntary_switches_total", "counter",
+                     "Context switches of a role by preemption.",
+                     [](const RoleUsage &u) {
+                       return static_cast<double>(
+                           atomicLoad(u.preempted_switches));
+                     });
+    renderRoleFamily(w, "warehouse_role_runqueue_wait_seconds_total",
+                     "counter",
+                     "Time the threads of a role were runnable but waiting "
+                     "for a CPU.",
+                     [](const RoleUsage &u) {
+                       return atomicLoad(u.runqueue_wait_ns) / 1e9;
+                     });
+  }
+
+  /** @brief Renders one lane-labelled family; `value` reads lane `l`. */
+  template <typename F>
+  void renderLaneFamily(PageWriter &w, const char *name, const char *type,
+                        const char *help, F value) const {
+    family(w, name, type, help);
+    for (int l = 0; l < atomicLoad(shm->lane_count); ++l) {
+      w.put(name);
+      w.put("{lane=\"");
+      w.putInt(l);
+      w.put("\"} ");
+      w.putInt(value(shm->lanes[l]));
+      w.put("\n");
+    }
+  }
+
+  /** @brief Renders the sorter lanes (nothing without a sorter). */
+  void renderLanes(PageWriter &w) const {
+    if (atomicLoad(shm->lane_count) == 0)
+      return;
+
+    metric(w, "warehouse_packages_in_sorter", "gauge",
+           "Packages taken off the belt by the sorter, not yet in a lane.",
+           (long long)atomicLoad(shm->stats.packages_in_sorter));
+    renderLaneFamily(w, "warehouse_lane_packages", "gauge",
+                     "Packages waiting in the lane ring.",
+                     [](const LaneState &l) {
+                       return (long long)atomicLoad(l.count);
+                     });
+    renderLaneFamily(w, "warehouse_lane_routed_total", "counter",
+                     "Packages routed into the lane by the sorter.",
+                     [](const LaneState &l) {
+                       return (long long)atomicLoad(l.routed);
+                     });
+    renderLaneFamily(w, "warehouse_lane_loaded_total", "counter",
+                     "Lane packages loaded into the lane's trucks.",
+                     [](const LaneState &l) {
+                       return (long long)atomicLoad(l.loaded);
+                     });
+    renderLaneFamily(w, "warehouse_lane_dock_truck_present", "gauge",
+                     "1 if a truck occupies the lane's dock.",
+                     [](const LaneState &l) {
+                       return (long long)atomicLoad(l.dock.is_present);
+                     });
+    renderLaneFamily(w, "warehouse_lane_dock_load_packages", "gauge",
+                     "Packages loaded into the lane's docked truck.",
+                     [](const LaneState &l) {
+                       return (long long)atomicLoad(l.dock.current_load);
+                     });
+  }
+
+  /** @brief Renders the queueing estimates published by QueueAnalytics. */
+  void renderAnalytics(PageWriter &w) const {
+    const AnalyticsState &a = shm->analytics;
+    if (atomicLoad(a.samples) == 0)
+      return;
+
+    renderStageFamily(w, "warehouse_stage_arrival_rate",
+                      "Smoothed items entering the stage per second.",
+                      &StageEstimate::arrival_rate);
+    renderStageFamily(w, "warehouse_stage_throughput",
+                      "Smoothed items leaving the stage per second.",
+                      &StageEstimate::throughput);
+    renderStageFamily(w, "warehouse_stage_utilization",
+                      "Fraction of time the stage is neither starved nor "
+                      "blocked.",
+                      &StageEstimate::utilization);
+    renderStageFamily(w, "warehouse_stage_occupancy",
+                      "Smoothed number of items in the stage.",
+                      &StageEstimate::occupancy);
+    renderStageFamily(w, "warehouse_stage_sojourn_seconds",
+                      "Mean time in the stage by Little's law.",
+                      &StageEstimate::sojourn_s);
+
+    const char *little = "warehouse_little_law_ratio";
+    family(w, little, "gauge",
+           "Observed occupancy over arrival rate times measured wait.");
+    w.put(little);
+    w.put("{queue=\"belt\"} ");
+    w.putDouble(atomicLoad(a.little_belt));
+    w.put("\n");
+    w.put(little);
+    w.put("{queue=\"dock\"} ");
+    w.putDouble(atomicLoad(a.little_dock));
+    w.put("\n");
+
+    const char *name = "warehouse_bottleneck";
+    family(w, name, "gauge", "1 for the stage currently limiting throughput.");
+    int b = atomicLoad(a.bottleneck);
+    for (int i = 0; i < STAGE_TOTAL; ++i) {
+      w.put(name);
+      w.put("{stage=\"");
+      w.put(QueueAnalytics::stageName(i));
+      w.put("\"} ");
+      w.putInt(i == b ? 1 : 0);
+      w.put("\n");
+    }
+    metric(w, "warehouse_bottleneck_confidence", "gauge",
+           "Confidence in the named bottleneck stage (0..1).",
+           atomicLoad(a.confidence));
+  }
+
+  /** @brief Renders the lock contention profiler counters. */
+  void renderLocks(PageWriter &w) const {
+    renderLockFamily(w, "warehouse_lock_acquisitions_total", "counter",
+                     "Semaphore P operations per call site.", false,
+                     &LockStats::acquisitions);
+    renderLockFamily(w, "warehouse_lock_contended_total", "counter",
+                     "P operations that had to block.", false,
+                     &LockStats::contended);
+    renderLockFamily(w, "warehouse_lock_wait_seconds_total", "counter",
+                     "Time spent blocked on the semaphore.", true,
+                     &LockStats::wait_ns_total);
+    renderLockFamily(w, "warehouse_lock_wait_max_seconds", "gauge",
+                     "Longest single wait on the semaphore.", true,
+                     &LockStats::wait_ns_max);
+    renderLockFamily(w, "warehouse_lock_hold_seconds_total", "counter",
+                     "Time the mutex was held.", true,
+                     &LockStats::hold_ns_total);
+  }
+
+  /** @brief Opens, configures and starts listening on a socket. */
+  static int openListener(int domain, const sockaddr *addr, socklen_t len) {
+    int fd = socket(domain, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+      return -1;
+
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    if (bind(fd, addr, len) == -1 || listen(fd, 16) == -1) {
+      close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
+  /** @brief Sends the whole buffer, retrying on short writes. */
+  static bool sendAll(int fd, const char *data, size_t len) {
+    while (len > 0) {
+      ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+      if (n < 0) {
+        if (errno == EINTR)
+          continue;
+        return false;
+      }
+      data += n;
+      len -= static_cast<size_t>(n);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Serves one scrape on an accepted connection.
+   * * The request is read (with a short timeout) and ignored: every path
+   * returns the metrics page, which is what Prometheus expects.
+   */
+  void handleClient(int client) {
+    struct pollfd pfd = {client, POLLIN, 0};
+    if (poll(&pfd, 1, 200) > 0) {
+      char request[1024];
+      ssize_t ignored = recv(client, request, sizeof(request), 0);
+      (void)ignored;
+    }
+
+    const char header_fmt[] =
+        "HTTP/1.0 200 OK\r\n"
+        "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+        "Content-Length: %zu\r\n"
+        "Connection: close\r\n\r\n";
+
+    constexpr size_t header_reserve = 160;
+    size_t body_len =
+        render(page + header_reserve, sizeof(page) - header_reserve);
+
+    char header[header_reserve];
+    int hlen = std::snprintf(header, sizeof(header), header_fmt, body_len);
+    char *start = page + header_reserve - hlen;
+    std::memcpy(start, header, hlen);
+
+    sendAll(client, start, hlen + body_len);
+    close(client);
+  }
+
+public:
+  /**
+   * @brief Constructs the exporter.
+   * @param shared_state Pointer to the Shared Memory segment.
+   */
+  explicit MetricsExporter(SharedState *shared_state) : shm(shared_state) {}
+
+  MetricsExporter(const MetricsExporter &) = delete;
+  MetricsExporter &operator=(const MetricsExporter &) = delete;
+
+  /** @brief Closes listeners and removes the UNIX socket file. */
+  ~MetricsExporter() {
+    if (tcp_fd != -1)
+      close(tcp_fd);
+    if (unix_fd != -1) {
+      close(unix_fd);
+      unlink(unix_path.c_str());
+    }
+  }
+
+  /**
+   * @brief Renders the full metrics page into a caller-supplied buffer.
+   *
+   * The output is truncated (never overflowed) if the buffer is too small.
+   *
+   * @param buf Destination buffer.
+   * @param cap Capacity of the destination buffer.
+   * @return Number of bytes written.
+   */
+  size_t render(char *buf, size_t cap) const {
+    PageWriter w{buf, cap};
+    if (!shm)
+      return 0;
+
+    metric(w, "warehouse_running", "gauge",
+           "1 while the simulation run-loop flag is set.",
+           (long long)atomicLoad(shm->running));
+
+    metric(w, "warehouse_belt_items", "gauge",
+           "Packages currently on the conveyor belt.",
+           (long long)atomicLoad(shm->current_items_count));
+    metric(w, "warehouse_belt_in_transit", "gauge",
+           "Packages on the belt that have not reached its end yet.",
+           (long long)atomicLoad(shm->transit.in_transit));
+    metric(w, "warehouse_belt_capacity", "gauge",
+           "Maximum number of packages on the belt (K).",
+           (long long)MAX_BELT_CAPACITY_K);
+    metric(w, "warehouse_belt_weight_kg", "gauge",
+           "Total weight currently on the belt.",
+           atomicLoad(shm->current_belt_weight));
+    metric(w, "warehouse_belt_weight_limit_kg", "gauge",
+           "Maximum weight allowed on the belt (M).", MAX_BELT_WEIGHT_M);
+    metric(w, "warehouse_workers_active", "gauge",
+           "Workers registered on the belt.",
+           (long long)atomicLoad(shm->current_workers_count));
+
+    const WarehouseStats &st = shm->stats;
+    metric(w, "warehouse_packages_created_total", "counter",
+           "Packages pushed onto the belt.",
+           (long long)atomicLoad(shm->total_packages_created));
+    metric(w, "warehouse_packages_loaded_total", "counter",
+           "Belt packages loaded into trucks.",
+           (long long)atomicLoad(st.packages_loaded));
+    metric(w, "warehouse_express_packages_loaded_total", "counter",
+           "Express (P4) packages loaded into trucks.",
+           (long long)atomicLoad(st.express_loaded));
+    metric(w, "warehouse_packages_in_dispatch", "gauge",
+           "Packages taken off the belt but not yet loaded.",
+           (long long)atomicLoad(st.packages_in_dispatch));
+
+    const TruckState &dock = shm->dock_truck;
+    metric(w, "warehouse_dock_truck_present", "gauge",
+           "1 if a truck occupies the dock.",
+           (long long)atomicLoad(dock.is_present));
+    metric(w, "warehouse_dock_load_packages", "gauge",
+           "Packages loaded into the docked truck.",
+           (long long)atomicLoad(dock.current_load));
+    metric(w, "warehouse_dock_load_limit_packages", "gauge",
+           "Package capacity of the docked truck.",
+           (long long)atomicLoad(dock.max_load));
+    metric(w, "warehouse_dock_weight_kg", "gauge",
+           "Weight loaded into the docked truck.",
+           atomicLoad(dock.current_weight));
+    metric(w, "warehouse_dock_weight_limit_kg", "gauge",
+           "Weight capacity (W) of the docked truck.",
+           atomicLoad(dock.max_weight));
+    metric(w, "warehouse_dock_volume_m3", "gauge",
+           "Volume loaded into the docked truck.",
+           atomicLoad(dock.current_volume));
+    metric(w, "warehouse_dock_volume_limit_m3", "gauge",
+           "Volume capacity (V) of the docked truck.",
+           atomicLoad(dock.max_volume));
+
+    metric(w, "warehouse_trucks_completed_total", "counter",
+           "Trucks that departed from the dock.",
+           (long long)atomicLoad(shm->trucks_completed));
+
+    renderLanes(w);
+    renderSessions(w);
+    renderWatchdog(w);
+    renderLogThrottle(w);
+    renderLatency(w);
+    renderDeadlines(w);
+    renderFaults(w);
+    renderAnalytics(w);
+    renderResources(w);
+    renderLocks(w);
+
+    if (w.full) {
+      spdlog::warn("[metrics] Page truncated at {} bytes.", w.len);
+    }
+    return w.len;
+  }
+
+  /**
+   * @brief Starts an HTTP listener bound to 127.0.0.1.
+   * @param port TCP port (0 picks an ephemeral port).
+   * @return The bound port, or -1 on failure.
+   */
+  int listenLoopback(uint16_t port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    tcp_fd = openListener(AF_INET, reinterpret_cast<sockaddr *>(&addr),
+                          sizeof(addr));
+    if (tcp_fd == -1) {
+      spdlog::error("[metrics] Cannot listen on 127.0.0.1:{}: {}", port,
+                    std::strerror(errno));
+      return -1;
+    }
+
+    socklen_t len = sizeof(addr);
+    getsockname(tcp_fd, reinterpret_cast<sockaddr *>(&addr), &len);
+    int bound = ntohs(addr.sin_port);
+    spdlog::info("[metrics] Serving on http://127.0.0.1:{}/metrics", bound);
+    return bound;
+  }
+
+  /**
+   * @brief Starts an HTTP listener on a UNIX domain socket.
+   * @param path Filesystem path of the socket (replaced if stale).
+   * @return true on success.
+   */
+  bool listenUnix(const std::string &path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+      spdlog::error("[metrics] Socket path too long: {}", path);
+      return false;
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+
+    unix_fd = openListener(AF_UNIX, reinterpret_cast<sockaddr *>(&addr),
+                           sizeof(addr));
+    if (unix_fd == -1) {
+      spdlog::error("[metrics] Cannot listen on {}: {}", path,
+                    std::strerror(errno));
+      return false;
+    }
+    unix_path = path;
+    spdlog::info("[metrics] Serving on unix:{}", path);
+    return true;
+  }
+
+  /**
+   * @brief Enables periodic output for node-exporter's textfile collector.
+   * @param path Target `.prom` file.
+   * @param interval_ms Rewrite period in milliseconds.
+   */
+  void setTextfile(const std::string &path, int interval_ms) {
+    textfile_path = path;
+    textfile_tmp = path + ".tmp";
+    textfile_interval_ms = interval_ms > 0 ? interval_ms : 1000;
+  }
+
+  /**
+   * @brief Writes the page to the textfile target atomically.
+   * * The collector may read the file at any moment, so the page is written
+   * to a staging file and renamed over the target.
+   * @return true on success (or if the textfile output is disabled).
+   */
+  bool writeTextfile() {
+    if (textfile_path.empty())
+      return true;
+
+    size_t len = render(page, sizeof(page));
+
+    FILE *f = std::fopen(textfile_tmp.c_str(), "w");
+    if (!f) {
+      spdlog::error("[metrics] Cannot open {}: {}", textfile_tmp,
+                    std::strerror(errno));
+      return false;
+    }
+    bool ok = std::fwrite(page, 1, len, f) == len;
+    ok = (std::fclose(f) == 0) && ok;
+    return ok && std::rename(textfile_tmp.c_str(), textfile_path.c_str()) == 0;
+  }
+
+  /**
+   * @brief Waits for scrapes on the listeners and serves them.
+   * @param timeout_ms Maximum time to block.
+   * @return Number of requests served.
+   */
+  int serveOnce(int timeout_ms) {
+    struct pollfd fds[2];
+    int n = 0;
+    if (tcp_fd != -1)
+      fds[n++] = {tcp_fd, POLLIN, 0};
+    if (unix_fd != -1)
+      fds[n++] = {unix_fd, POLLIN, 0};
+
+    if (n == 0) {
+      if (timeout_ms > 0)
+        poll(nullptr, 0, timeout_ms);
+      return 0;
+    }
+
+    if (poll(fds, n, timeout_ms) <= 0)
+      return 0;
+
+    int served = 0;
+    for (int i = 0; i < n; ++i) {
+      if (!(fds[i].revents & POLLIN))
+        continue;
+      int client = accept4(fds[i].fd, nullptr, nullptr, SOCK_CLOEXEC);
+      if (client != -1) {
+        handleClient(client);
+        served++;
+      }
+    }
+    return served;
+  }
+
+  /**
+   * @brief Exporter service loop (meant for a dedicated thread).
+   *
+   * Serves scrapes and refreshes the textfile every `textfile_interval_ms`
+   * until `stop` is set or the simulation stops running.
+   *
+   * @param stop Flag owned by the hosting process.
+   */
+  void run(const std::atomic<bool> &stop) {
+    int interval = textfile_interval_ms > 0 ? textfile_interval_ms : 1000;
+    uint64_t next_write = monotonicNowNs();
+
+    while (!stop.load() && shm && shm->running) {
+      uint64_t now = monotonicNowNs();
+      if (now >= next_write) {
+        writeTextfile();
+        next_write = now + static_cast<uint64_t>(interval) * 1000000ULL;
+      }
+
+      int wait_ms = static_cast<int>((next_write - now) / 1000000ULL);
+      serveOnce(wait_ms < 100 ? wait_ms : 100);
+    }
+
+    writeTextfile();
+  }
+};
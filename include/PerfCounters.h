@@ -0,0 +1,206 @@
+/**
+ * @file PerfCounters.h
+ * @brief Optional hardware and software counters for the benchmark tools.
+ *
+ * Wraps `perf_event_open` for the stress harness and the agent benchmark:
+ * cycles, instructions, cache misses, context switches and page faults of
+ * the calling process, its threads and (with `inherit`) the children it
+ * forks afterwards. Counts of a child are folded into the parent's counter
+ * when the child exits, so read after reaping.
+ *
+ * Each counter is opened on its own: a VM without a PMU or a container
+ * that blocks the syscall (seccomp, `perf_event_paranoid`) loses only the
+ * counters it cannot provide, and those are reported as unavailable.
+ * Hardware counters are user space only, which an unprivileged process
+ * may open with `perf_event_paranoid` up to 2; software counters include
+ * the kernel where allowed.
+ */
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/** @brief Counters captured by PerfCounters, in report order. */
+enum class PerfCounter : int {
+  Cycles = 0,
+  Instructions,
+  CacheMisses,
+  ContextSwitches,
+  PageFaults,
+  Total
+};
+
+constexpr int PERF_COUNTERS = static_cast<int>(PerfCounter::Total);
+
+/**
+ * @class PerfCounters
+ * @brief A set of counters started and stopped together.
+ */
+class PerfCounters {
+private:
+  int fds[PERF_COUNTERS];
+  int open_errno[PERF_COUNTERS] = {};
+
+  static const char *const *names() {
+    static const char *const n[PERF_COUNTERS] = {
+        "cycles", "instructions", "cache-misses", "context-switches",
+        "page-faults"};
+    return n;
+  }
+
+  static int openCounter(PerfCounter c, bool inherit) {
+    static const struct {
+      uint32_t type;
+      uint64_t config;
+    } events[PERF_COUNTERS] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+        {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS}};
+
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = events[static_cast<int>(c)].type;
+    attr.config = events[static_cast<int>(c)].config;
+    attr.disabled = 1;
+    attr.inherit = inherit ? 1 : 0;
+    attr.exclude_kernel = attr.type == PERF_TYPE_HARDWARE;
+    attr.exclude_hv = 1;
+    attr.read_format =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    int fd = static_cast<int>(
+        syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    if (fd < 0 && (errno == EACCES || errno == EPERM)) {
+      // Software events happen in the kernel; count user space if that is
+      // all perf_event_paranoid allows.
+      attr.exclude_kernel = 1;
+      fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1,
+                                    PERF_FLAG_FD_CLOEXEC));
+    }
+    return fd;
+  }
+
+public:
+  /**
+   * @brief Opens every counter (stopped).
+   * @param inherit Also count threads and child processes created later.
+   */
+  explicit PerfCounters(bool inherit = true) {
+    for (int i = 0; i < PERF_COUNTERS; ++i) {
+      fds[i] = openCounter(static_cast<PerfCounter>(i), inherit);
+      open_errno[i] = fds[i] < 0 ? errno : 0;
+    }
+  }
+
+  ~PerfCounters() {
+    for (int fd : fds) {
+      if (fd >= 0)
+        close(fd);
+    }
+  }
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  /** @brief Name of a counter in reports. */
+  static const char *name(PerfCounter c) {
+    return names()[static_cast<int>(c)];
+  }
+
+  /** @brief True if the counter could be opened. */
+  bool available(PerfCounter c) const { return fds[static_cast<int>(c)] >= 0; }
+
+  /** @brief True if at least one counter could be opened. */
+  bool anyAvailable() const {
+    for (int fd : fds) {
+      if (fd >= 0)
+        return true;
+    }
+    return false;
+  }
+
+  /** @brief Why a counter is unavailable (strerror of the open). */
+  const char *error(PerfCounter c) const {
+    return std::strerror(open_errno[static_cast<int>(c)]);
+  }
+
+  /** @brief Zeroes and starts every open counter. */
+  void start() {
+    for (int fd : fds) {
+      if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+  }
+
+  /** @brief Stops every open counter. */
+  void stop() {
+    for (int fd : fds) {
+      if (fd >= 0)
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+
+  /**
+   * @brief Current value of a counter.
+   *
+   * Scaled by enabled/running time when the kernel multiplexed it with
+   * other events.
+   *
+   * @return The count, or -1 if the counter is unavailable.
+   */
+  double value(PerfCounter c) const {
+    int fd = fds[static_cast<int>(c)];
+    uint64_t data[3];
+    if (fd < 0 || read(fd, data, sizeof(data)) != sizeof(data))
+      return -1;
+    if (data[2] == 0)
+      return 0;
+    return data[2] < data[1]
+               ? static_cast<double>(data[0]) * data[1] / data[2]
+               : static_cast<double>(data[0]);
+  }
+
+  /**
+   * @brief Prints one report line: ns/op and each counter per operation.
+   *
+   * @param out Stream written to.
+   * @param ops Operations performed in the window (e.g. packages loaded).
+   * @param wall_ns Length of the window [ns].
+   */
+  void report(FILE *out, uint64_t ops, double wall_ns) const {
+    double n = ops > 0 ? static_cast<double>(ops) : 1.0;
+    std::fprintf(out, "Counters:     %.0f ns/op", wall_ns / n);
+    for (int i = 0; i < PERF_COUNTERS; ++i) {
+      PerfCounter c = static_cast<PerfCounter>(i);
+      double v = value(c);
+      if (v < 0)
+        std::fprintf(out, ", %s n/a", name(c));
+      else
+        std::fprintf(out, ", %s %.1f", name(c), v / n);
+    }
+    double cycles = value(PerfCounter::Cycles);
+    double instructions = value(PerfCounter::Instructions);
+    if (cycles > 0 && instructions >= 0)
+      std::fprintf(out, " (IPC %.2f)", instructions / cycles);
+    std::fprintf(out, " per op (%llu ops)\n",
+                 static_cast<unsigned long long>(ops));
+
+    for (int i = 0; i < PERF_COUNTERS; ++i) {
+      PerfCounter c = static_cast<PerfCounter>(i);
+      if (!available(c))
+        std::fprintf(out, "              %s unavailable: %s\n", name(c),
+                     error(c));
+    }
+  }
+};
@@ -0,0 +1,112 @@
+/**
+ * @file Probes.h
+ * @brief Static tracepoints (USDT) for perf, bpftrace and SystemTap.
+ *
+ * A probe is a single `nop` at the call site plus an entry in the
+ * `.note.stapsdt` ELF section naming it (provider `warehouse`) and telling
+ * the tracer where its arguments live. That is the SystemTap SDT format
+ * read by perf, bpftrace and bcc: attaching turns the nop into a
+ * breakpoint, no rebuild and no log level involved. Detached, a probe costs
+ * the nop and keeping its arguments in registers.
+ *
+ * The system's <sys/sdt.h> is used when installed. Otherwise the note is
+ * emitted here on x86-64 in the same format. On other targets, or with
+ * `-DWAREHOUSE_NO_PROBES`, the probes compile to nothing.
+ *
+ * Probes (arguments are 64-bit signed, in order):
+ * | Probe           | Arguments                   | Site                     |
+ * |-----------------|-----------------------------|--------------------------|
+ * | package__create | id, creator pid, SLA tier   | Belt::push, id assigned  |
+ * | belt__push      | id, slot, items on belt     | Belt::push               |
+ * | belt__pop       | id, slot, items on belt     | Belt::pop                |
+ * | dock__load      | truck pid, loaded, outcome  | applyLoad (any loader)   |
+ * | package__load   | id, truck pid, latency [ns] | Dispatcher, loaded       |
+ * | truck__dock     | truck pid, max load         | Truck, docked            |
+ * | truck__depart   | truck pid, load, reason     | Truck, leaving the dock  |
+ * | express__begin  | batch size                  | Express batch            |
+ * | express__end    | loaded, truck pid, outcome  | Express batch            |
+ * | sem__enter      | SemIndex, op                | Manager::semOperation    |
+ * | sem__exit       | SemIndex, op, wait failed   | Manager::semOperation    |
+ *
+ * Probes without a pid argument fire in the calling process; tracers
+ * report it themselves (`pid` in bpftrace).
+ *
+ * Examples:
+ *
+ *     perf probe -x build/dispatcher sdt_warehouse:belt__pop
+ *     bpftrace -e 'usdt:build/worker:warehouse:sem__exit /arg2/ {
+ *                      @failed[arg0] = count(); }'
+ */
+#pragma once
+
+#include <cstdint>
+
+#if !defined(WAREHOUSE_NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define WAREHOUSE_PROBES_SDT 1
+#elif defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define WAREHOUSE_PROBES_NOTE 1
+#endif
+#endif
+
+#if defined(WAREHOUSE_PROBES_SDT)
+#include <sys/sdt.h>
+
+#define WAREHOUSE_PROBE0(name) STAP_PROBE(warehouse, name)
+#define WAREHOUSE_PROBE1(name, a) STAP_PROBE1(warehouse, name, (int64_t)(a))
+#define WAREHOUSE_PROBE2(name, a, b)                                          \
+  STAP_PROBE2(warehouse, name, (int64_t)(a), (int64_t)(b))
+#define WAREHOUSE_PROBE3(name, a, b, c)                                       \
+  STAP_PROBE3(warehouse, name, (int64_t)(a), (int64_t)(b), (int64_t)(c))
+
+#elif defined(WAREHOUSE_PROBES_NOTE)
+/*
+ * SDT v3 note: probe address, base (to relocate prelinked binaries), no
+ * is-enabled semaphore, then provider, name and argument specifications.
+ * The "?" flag keeps the note in the section group of the function, so
+ * inline functions discarded by the linker take their notes with them.
+ */
+#define WAREHOUSE_SDT_NOTE(name, args)                                        \
+  "990: nop\n"                                                                \
+  ".pushsection .note.stapsdt,\"?\",\"note\"\n"                               \
+  ".balign 4\n"                                                               \
+  ".4byte 992f-991f, 994f-993f, 3\n"                                          \
+  "991: .asciz \"stapsdt\"\n"                                                 \
+  "992: .balign 4\n"                                                          \
+  "993: .8byte 990b\n"                                                        \
+  ".8byte _.stapsdt.base\n"                                                   \
+  ".8byte 0\n"                                                                \
+  ".asciz \"warehouse\"\n"                                                    \
+  ".asciz \"" #name "\"\n"                                                    \
+  ".asciz \"" args "\"\n"                                                     \
+  "994: .balign 4\n"                                                          \
+  ".popsection\n"                                                             \
+  ".ifndef _.stapsdt.base\n"                                                  \
+  ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"     \
+  ".weak _.stapsdt.base\n"                                                    \
+  ".hidden _.stapsdt.base\n"                                                  \
+  "_.stapsdt.base: .space 1\n"                                                \
+  ".size _.stapsdt.base, 1\n"                                                 \
+  ".popsection\n"                                                             \
+  ".endif\n"
+
+#define WAREHOUSE_PROBE0(name)                                                \
+  __asm__ __volatile__(WAREHOUSE_SDT_NOTE(name, ""))
+#define WAREHOUSE_PROBE1(name, a)                                             \
+  __asm__ __volatile__(WAREHOUSE_SDT_NOTE(name, "-8@%0")::"nor"(            \
+      (int64_t)(a)))
+#define WAREHOUSE_PROBE2(name, a, b)                                          \
+  __asm__ __volatile__(WAREHOUSE_SDT_NOTE(name, "-8@%0 -8@%1")::"nor"(      \
+                           (int64_t)(a)),                                     \
+                       "nor"((int64_t)(b)))
+#define WAREHOUSE_PROBE3(name, a, b, c)                                       \
+  __asm__ __volatile__(WAREHOUSE_SDT_NOTE(name, "-8@%0 -8@%1 -8@%2")::"nor"( \
+                           (int64_t)(a)),                                     \
+                       "nor"((int64_t)(b)), "nor"((int64_t)(c)))
+
+#else
+#define WAREHOUSE_PROBE0(name) ((void)0)
+#define WAREHOUSE_PROBE1(name, a) ((void)0)
+#define WAREHOUSE_PROBE2(name, a, b) ((void)0)
+#define WAREHOUSE_PROBE3(name, a, b, c) ((void)0)
+#endif
@@ -0,0 +1,300 @@
+/**
+ * @file QueueAnalytics.h
+ * @brief Online queueing estimates and bottleneck detection for the flow line.
+ *
+ * `QueueAnalytics` is fed periodic snapshots of the shared counters by the
+ * belt process. Each update is O(1): rates, occupancies and activity
+ * fractions are exponentially weighted moving averages with time constant
+ * `tau`, so no sample history is kept.
+ *
+ * The bottleneck is found with the active-period method: every snapshot
+ * classifies each stage as active (working at its own pace) or waiting on a
+ * neighbour, and the stage active for the largest fraction of time is the one
+ * limiting throughput.
+ *
+ * | Stage      | Active when                                           |
+ * |------------|-------------------------------------------------------|
+ * | Workers    | the belt can take another package                     |
+ * | Belt       | the weight limit M refuses packages while slots remain |
+ * | Dispatcher | packages wait on the belt and a truck is docked       |
+ * | Dock       | packages wait, no truck docked, trucks queue for it   |
+ * | Fleet      | packages wait, no truck docked and none queued        |
+ *
+ * With sorter lanes, "packages wait" includes the lane rings and "a truck is
+ * docked" means at any lane dock.
+ *
+ * Results are published to `SharedState::analytics` for the terminal and
+ * the metrics exporter.
+ */
+#pragma once
+
+#include "Shared.h"
+#include "Telemetry.h"
+#include <cmath>
+#include <cstdio>
+#include <ostream>
+
+/** @brief Weight of the heaviest package (type C), used as belt headroom. */
+constexpr double ANALYTICS_BELT_HEADROOM_KG = 25.0;
+
+/**
+ * @class QueueAnalytics
+ * @brief Incremental estimator of stage rates, utilization and bottleneck.
+ */
+class QueueAnalytics {
+private:
+  SharedState *shm;
+  double tau_s; /**< Smoothing time constant. */
+
+  AnalyticsState est = {};
+  uint64_t start_ns = 0;
+  uint64_t last_ns = 0;
+
+  /** @name Counters at the previous update
+   * @{ */
+  long long prev_created = 0;
+  long long prev_loaded = 0;
+  long long prev_in_dispatch = 0;
+  long long prev_departed = 0;
+  uint64_t prev_latency_sum = 0;
+  uint64_t prev_latency_count = 0;
+  uint64_t prev_dock_ns = 0;
+  /** @} */
+
+  double belt_wait_s = 0.0;  /**< Smoothed measured belt-to-truck latency. */
+  double dock_dwell_s = 0.0; /**< Smoothed measured truck dwell at the dock. */
+  double in_line = 0.0; /**< Smoothed packages between belt entry and truck. */
+
+  /** @brief Little's-law ratio L / (lambda * W), 0 if undefined. */
+  static double littleRatio(double l, double lambda, double w) {
+    double predicted = lambda * w;
+    return predicted > 1e-9 ? l / predicted : 0.0;
+  }
+
+  /** @brief Copies the estimates into shared memory field by field. */
+  void publish() {
+    AnalyticsState &out = shm->analytics;
+    for (int i = 0; i < STAGE_TOTAL; ++i) {
+      atomicStore(out.stages[i].arrival_rate, est.stages[i].arrival_rate);
+      atomicStore(out.stages[i].throughput, est.stages[i].throughput);
+      atomicStore(out.stages[i].utilization, est.stages[i].utilization);
+      atomicStore(out.stages[i].occupancy, est.stages[i].occupancy);
+      atomicStore(out.stages[i].sojourn_s, est.stages[i].sojourn_s);
+    }
+    atomicStore(out.little_belt, est.little_belt);
+    atomicStore(out.little_dock, est.little_dock);
+    atomicStore(out.bottleneck, est.bottleneck);
+    atomicStore(out.confidence, est.confidence);
+    atomicStore(out.samples, est.samples);
+  }
+
+public:
+  /**
+   * @param s Shared state to read counters from and publish results to.
+   * @param tau Smoothing time constant in seconds.
+   */
+  explicit QueueAnalytics(SharedState *s, double tau = 10.0)
+      : shm(s), tau_s(tau > 0 ? tau : 10.0) {
+    est.bottleneck = -1;
+  }
+
+  /** @brief Latest estimates of this instance. */
+  const AnalyticsState &current() const { return est; }
+
+  /** @brief Folds in a snapshot taken now. */
+  void update() { update(monotonicNowNs()); }
+
+  /**
+   * @brief Folds in a snapshot of the shared counters.
+   * @param now_ns Monotonic time of the snapshot.
+   */
+  void update(uint64_t now_ns) {
+    const WarehouseStats &st = shm->stats;
+    long long created = atomicLoad(shm->total_packages_created);
+    long long loaded = static_cast<long long>(atomicLoad(st.packages_loaded));
+    long long in_dispatch = atomicLoad(st.packages_in_dispatch);
+    long long departed = atomicLoad(shm->trucks_completed);
+    uint64_t latency_sum = atomicLoad(st.latency_sum_ns);
+    uint64_t latency_count = atomicLoad(st.latency_count);
+    uint64_t dock_ns = atomicLoad(st.dock_ns_total);
+
+    int count = atomicLoad(shm->current_items_count);
+    double weight = atomicLoad(shm->current_belt_weight);
+    int workers = atomicLoad(shm->current_workers_count);
+    bool present = false;
+    for (int i = 0; i < dockCount(shm); ++i)
+      present = present || atomicLoad(dockAt(shm, i).is_present);
+    int queued = atomicLoad(shm->trucks_waiting);
+
+    if (last_ns == 0 || now_ns <= last_ns) {
+      if (last_ns == 0)
+        start_ns = now_ns;
+      last_ns = now_ns;
+      prev_created = created;
+      prev_loaded = loaded;
+      prev_in_dispatch = in_dispatch;
+      prev_departed = departed;
+      prev_latency_sum = latency_sum;
+      prev_latency_count = latency_count;
+      prev_dock_ns = dock_ns;
+      return;
+    }
+
+    double dt = (now_ns - last_ns) / 1e9;
+    double alpha = 1.0 - std::exp(-dt / tau_s);
+    auto smooth = [alpha](double &x, double v) { x += alpha * (v - x); };
+
+    double created_rate = (created - prev_created) / dt;
+    double loaded_rate = (loaded - prev_loaded) / dt;
+    double popped_rate =
+        (loaded - prev_loaded + in_dispatch - prev_in_dispatch) / dt;
+    double depart_rate = (departed - prev_departed) / dt;
+
+    if (latency_count > prev_latency_count) {
+      double w = (latency_sum - prev_latency_sum) / 1e9 /
+                 (latency_count - prev_latency_count);
+      if (belt_wait_s == 0.0)
+        belt_wait_s = w;
+      smooth(belt_wait_s, w);
+    }
+    if (departed > prev_departed) {
+      double w = (dock_ns - prev_dock_ns) / 1e9 / (departed - prev_departed);
+      if (dock_dwell_s == 0.0)
+        dock_dwell_s = w;
+      smooth(dock_dwell_s, w);
+    }
+
+    int waiting = count;
+    for (int i = 0; i < atomicLoad(shm->lane_count); ++i)
+      waiting += atomicLoad(shm->lanes[i].count);
+
+    // The latency behind belt_wait_s runs from belt entry to the truck, so
+    // Little's L counts every package in that span, not only the belt.
+    long long between =
+        waiting + atomicLoad(st.packages_in_sorter) + in_dispatch;
+
+    bool empty = waiting == 0;
+    bool weight_bound = weight > MAX_BELT_WEIGHT_M - ANALYTICS_BELT_HEADROOM_KG;
+    bool full = count >= MAX_BELT_CAPACITY_K || weight_bound;
+    bool active[STAGE_TOTAL] = {
+        workers > 0 && !full,
+        weight_bound && count < MAX_BELT_CAPACITY_K,
+        !empty && present,
+        !empty && !present && queued > 0,
+        !empty && !present && queued == 0,
+    };
+    double occupancy[STAGE_TOTAL] = {
+        static_cast<double>(workers), static_cast<double>(count),
+        static_cast<double>(in_dispatch), present ? 1.0 : 0.0,
+        static_cast<double>(queued)};
+    double arrival[STAGE_TOTAL] = {created_rate, created_rate, popped_rate,
+                                   depart_rate, depart_rate};
+    double leaving[STAGE_TOTAL] = {created_rate, popped_rate, loaded_rate,
+                                   depart_rate, depart_rate};
+
+    for (int i = 0; i < STAGE_TOTAL; ++i) {
+      StageEstimate &e = est.stages[i];
+      smooth(e.arrival_rate, arrival[i]);
+      smooth(e.throughput, leaving[i]);
+      smooth(e.utilization, active[i] ? 1.0 : 0.0);
+      smooth(e.occupancy, occupancy[i]);
+      e.sojourn_s = e.arrival_rate > 1e-9 ? e.occupancy / e.arrival_rate : 0.0;
+    }
+    est.stages[static_cast<int>(Stage::Workers)].sojourn_s = 0.0;
+    smooth(in_line, between);
+
+    const StageEstimate &belt = est.stages[static_cast<int>(Stage::Belt)];
+    const StageEstimate &dock = est.stages[static_cast<int>(Stage::Dock)];
+    est.little_belt = littleRatio(in_line, belt.arrival_rate, belt_wait_s);
+    est.little_dock =
+        littleRatio(dock.occupancy, dock.arrival_rate, dock_dwell_s);
+
+    int top = 0, second = -1;
+    for (int i = 1; i < STAGE_TOTAL; ++i) {
+      double u = est.stages[i].utilization;
+      if (u > est.stages[top].utilization) {
+        second = top;
+        top = i;
+      } else if (second < 0 || u > est.stages[second].utilization) {
+        second = i;
+      }
+    }
+    double u1 = est.stages[top].utilization;
+    double u2 = est.stages[second].utilization;
+    double warm = 1.0 - std::exp(-((now_ns - start_ns) / 1e9) / tau_s);
+    if (u1 < 0.05) {
+      est.bottleneck = -1;
+      est.confidence = 0.0;
+    } else {
+      est.bottleneck = top;
+      est.confidence = (u1 - u2) / u1 * warm;
+    }
+    est.samples++;
+
+    last_ns = now_ns;
+    prev_created = created;
+    prev_loaded = loaded;
+    prev_in_dispatch = in_dispatch;
+    prev_departed = departed;
+    prev_latency_sum = latency_sum;
+    prev_latency_count = latency_count;
+    prev_dock_ns = dock_ns;
+
+    publish();
+  }
+
+  /** @brief Lower-case stage name used in reports and metric labels. */
+  static const char *stageName(int stage) {
+    static const char *names[STAGE_TOTAL] = {"workers", "belt", "dispatcher",
+                                             "dock", "fleet"};
+    return stage >= 0 && stage < STAGE_TOTAL ? names[stage] : "none";
+  }
+
+  /** @brief Unit counted by a stage's rates and occupancy. */
+  static const char *stageUnit(int stage) {
+    return stage >= static_cast<int>(Stage::Dock) ? "truck" : "pkg";
+  }
+
+  /**
+   * @brief Prints the published analysis as a table.
+   * @param out Destination stream.
+   * @param shm Shared state holding the published estimates.
+   */
+  static void printReport(std::ostream &out, const SharedState *shm) {
+    const AnalyticsState &a = shm->analytics;
+    char line[160];
+
+    if (atomicLoad(a.samples) == 0) {
+      out << "  (no flow analysis published yet)\n";
+      return;
+    }
+
+    out << "  STAGE        UNIT    ARRIVAL/s   THRU/s    UTIL   OCCUPANCY"
+           "  SOJOURN[s]\n";
+    for (int i = 0; i < STAGE_TOTAL; ++i) {
+      const StageEstimate &e = a.stages[i];
+      std::snprintf(line, sizeof(line),
+                    "  %-12s %-6s %10.2f %9.2f %6.1f%% %11.2f %11.3f\n",
+                    stageName(i), stageUnit(i), atomicLoad(e.arrival_rate),
+                    atomicLoad(e.throughput),
+                    100.0 * atomicLoad(e.utilization), atomicLoad(e.occupancy),
+                    atomicLoad(e.sojourn_s));
+      out << line;
+    }
+
+    std::snprintf(line, sizeof(line),
+                  "  Little's law L/(lambda*W): belt %.2f, dock %.2f\n",
+                  atomicLoad(a.little_belt), atomicLoad(a.little_dock));
+    out << line;
+
+    int b = atomicLoad(a.bottleneck);
+    if (b < 0) {
+      out << "  Bottleneck: none (line mostly idle)\n";
+    } else {
+      std::snprintf(line, sizeof(line),
+                    "  Bottleneck: \033[33m%s\033[0m (confidence %.0f%%)\n",
+                    stageName(b), 100.0 * atomicLoad(a.confidence));
+      out << line;
+    }
+  }
+};
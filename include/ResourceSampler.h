@@ -0,0 +1,384 @@
+/**
+ * @file ResourceSampler.h
+ * @brief Per-role CPU, memory and scheduler usage read from procfs.
+ *
+ * `ResourceSampler` runs in the belt process. Every interval it walks the
+ * session table and, for each live `session_pid`, reads:
+ *
+ * | File                               | Fields                            |
+ * |------------------------------------|-----------------------------------|
+ * | `/proc/<pid>/stat`                 | utime, stime (all threads)        |
+ * | `/proc/<pid>/status`               | VmRSS                             |
+ * | `/proc/<pid>/smaps_rollup`         | Pss (skipped if not readable)     |
+ * | `/proc/<pid>/task/<tid>/status`    | (non)voluntary_ctxt_switches      |
+ * | `/proc/<pid>/task/<tid>/schedstat` | run-queue wait                    |
+ *
+ * The role of a session is derived from its username (see roleOf). CPU
+ * time, context switches and run-queue wait are turned into per-process
+ * deltas and accumulated per role, so the role counters only grow as
+ * processes come and go. Switches and waits of a thread that exited between
+ * two samples are lost, as is whatever a process used after its last
+ * sample. A process seen for the first time contributes everything it used
+ * so far.
+ *
+ * Results are published to `SharedState::resources` for the terminal
+ * (`usage`) and the metrics exporter.
+ */
+#pragma once
+
+#include "Shared.h"
+#include "Telemetry.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <ostream>
+#include <thread>
+#include <unistd.h>
+
+/**
+ * @struct ProcSample
+ * @brief Cumulative usage of one process as read from procfs.
+ */
+struct ProcSample {
+  uint64_t user_ns = 0;   /**< utime. */
+  uint64_t system_ns = 0; /**< stime. */
+  uint64_t rss_bytes = 0; /**< VmRSS. */
+  uint64_t pss_bytes = 0; /**< Pss from smaps_rollup, 0 if unreadable. */
+  uint64_t voluntary = 0; /**< Sum over threads. */
+  uint64_t preempted = 0; /**< Sum over threads. */
+  uint64_t wait_ns = 0;   /**< Run-queue wait summed over threads. */
+};
+
+/**
+ * @class ResourceSampler
+ * @brief Periodic procfs reader aggregating usage per ProcessRole.
+ */
+class ResourceSampler {
+private:
+  SharedState *shm;
+  uint64_t interval_ns;
+  uint64_t tick_ns; /**< Length of a clock tick (stat times). */
+
+  /**
+   * @struct Tracked
+   * @brief Last sample of the process in one session slot.
+   */
+  struct Tracked {
+    pid_t pid;       /**< 0 = slot not tracked. */
+    ProcSample last; /**< Counters at the previous pass. */
+  };
+
+  Tracked tracked[MAX_USERS_SESSIONS] = {};
+  ResourceState usage = {};
+  uint64_t last_ns = 0;
+  char buf[4096]; /**< Contents of the file being parsed. */
+
+  /** @brief Reads a small procfs file into `buf`; false if it is gone. */
+  bool slurp(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      return false;
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0)
+      return false;
+    buf[n] = '\0';
+    return true;
+  }
+
+  /** @brief Value after `key` in a "Key:   value" file, 0 if missing. */
+  static uint64_t field(const char *text, const char *key) {
+    const char *p = std::strstr(text, key);
+    return p ? std::strtoull(p + std::strlen(key), nullptr, 10) : 0;
+  }
+
+  /** @brief Difference of two cumulative counters, 0 if one went back. */
+  static uint64_t delta(uint64_t now, uint64_t before) {
+    return now > before ? now - before : 0;
+  }
+
+  /** @brief Adds the context switches and run-queue waits of all threads. */
+  void readThreads(pid_t pid, ProcSample &out) {
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/task", static_cast<int>(pid));
+    DIR *dir = opendir(path);
+    if (!dir)
+      return;
+    while (dirent *e = readdir(dir)) {
+      if (e->d_name[0] < '0' || e->d_name[0] > '9')
+        continue;
+      std::snprintf(path, sizeof(path), "/proc/%d/task/%.16s/status",
+                    static_cast<int>(pid), e->d_name);
+      if (slurp(path))
+        parseStatus(buf, out);
+      std::snprintf(path, sizeof(path), "/proc/%d/task/%.16s/schedstat",
+                    static_cast<int>(pid), e->d_name);
+      if (slurp(path))
+        parseSchedstat(buf, out);
+    }
+    closedir(dir);
+  }
+
+  /** @brief Copies the aggregates into shared memory field by field. */
+  void publish() {
+    ResourceState &out = shm->resources;
+    for (int r = 0; r < PROCESS_ROLES; ++r) {
+      const RoleUsage &u = usage.roles[r];
+      RoleUsage &o = out.roles[r];
+      atomicStore(o.processes, u.processes);
+      atomicStore(o.cpu_user_ns, u.cpu_user_ns);
+      atomicStore(o.cpu_system_ns, u.cpu_system_ns);
+      atomicStore(o.cpu_cores, u.cpu_cores);
+      atomicStore(o.rss_bytes, u.rss_bytes);
+      atomicStore(o.pss_bytes, u.pss_bytes);
+      atomicStore(o.voluntary_switches, u.voluntary_switches);
+      atomicStore(o.preempted_switches, u.preempted_switches);
+      atomicStore(o.runqueue_wait_ns, u.runqueue_wait_ns);
+    }
+    atomicStore(out.samples, usage.samples);
+  }
+
+public:
+  /**
+   * @param s Shared state holding the session table and the results.
+   * @param interval_ms Sampling period used by run().
+   */
+  explicit ResourceSampler(SharedState *s, int interval_ms = 1000)
+      : shm(s), interval_ns(static_cast<uint64_t>(
+                    interval_ms > 0 ? interval_ms : 1000) *
+                1000000ULL) {
+    long hz = sysconf(_SC_CLK_TCK);
+    tick_ns = 1000000000ULL / static_cast<uint64_t>(hz > 0 ? hz : 100);
+  }
+
+  /** @brief Latest aggregates of this instance. */
+  const ResourceState &current() const { return usage; }
+
+  /** @brief Role of a session, by the username its process logs in with. */
+  static ProcessRole roleOf(const char *username) {
+    static const struct {
+      const char *prefix;
+      ProcessRole role;
+    } prefixes[] = {{"Worker_", ProcessRole::Worker},
+                    {"Truck_", ProcessRole::Truck},
+                    {"System-Dispatcher", ProcessRole::Dispatcher},
+                    {"System-Belt", ProcessRole::Belt},
+                    {"System-Express", ProcessRole::Express},
+                    {"System-Sorter", ProcessRole::Sorter},
+                    {"AdminConsole", ProcessRole::Terminal}};
+    for (const auto &p : prefixes) {
+      if (std::strncmp(username, p.prefix, std::strlen(p.prefix)) == 0)
+        return p.role;
+    }
+    return ProcessRole::Other;
+  }
+
+  /** @brief Label of a role in reports and metrics. */
+  static const char *roleName(int role) {
+    static const char *const names[PROCESS_ROLES] = {
+        "worker",  "truck",  "dispatcher", "belt",
+        "express", "sorter", "terminal",   "other"};
+    return role >= 0 && role < PROCESS_ROLES ? names[role] : "?";
+  }
+
+  /** @name procfs Parsers
+   * Each adds what it finds to `out` and returns false on malformed input.
+   * @{ */
+  /** @brief utime and stime of `/proc/<pid>/stat`. */
+  static bool parseStat(const char *text, uint64_t tick_ns, ProcSample &out) {
+    // The command name may contain spaces and parentheses: skip past the
+    // last ')' and count fields from the state (field 3).
+    const char *p = std::strrchr(text, ')');
+    if (!p)
+      return false;
+    p++;
+    for (int f = 3; f < 14; ++f) {
+      while (*p == ' ')
+        p++;
+      while (*p && *p != ' ')
+        p++;
+      if (!*p)
+        return false;
+    }
+    char *end;
+    uint64_t utime = std::strtoull(p, &end, 10);
+    uint64_t stime = std::strtoull(end, &end, 10);
+    if (end == p)
+      return false;
+    out.user_ns += utime * tick_ns;
+    out.system_ns += stime * tick_ns;
+    return true;
+  }
+
+  /** @brief VmRSS and the context switch counters of a `status` file. */
+  static bool parseStatus(const char *text, ProcSample &out) {
+    if (!std::strstr(text, "voluntary_ctxt_switches:"))
+      return false;
+    out.voluntary += field(text, "\nvoluntary_ctxt_switches:");
+    out.preempted += field(text, "\nnonvoluntary_ctxt_switches:");
+    return true;
+  }
+
+  /** @brief Resident set size of a process `status` file. */
+  static bool parseRss(const char *text, ProcSample &out) {
+    if (!std::strstr(text, "VmRSS:"))
+      return false;
+    out.rss_bytes += field(text, "VmRSS:") * 1024;
+    return true;
+  }
+
+  /** @brief Run-queue wait, the second field of `schedstat` [ns]. */
+  static bool parseSchedstat(const char *text, ProcSample &out) {
+    char *end;
+    std::strtoull(text, &end, 10);
+    if (end == text)
+      return false;
+    out.wait_ns += std::strtoull(end, nullptr, 10);
+    return true;
+  }
+
+  /** @brief Proportional set size of `smaps_rollup`. */
+  static bool parsePss(const char *text, ProcSample &out) {
+    if (!std::strstr(text, "\nPss:"))
+      return false;
+    out.pss_bytes += field(text, "\nPss:") * 1024;
+    return true;
+  }
+  /** @} */
+
+  /**
+   * @brief Reads the current usage of a process.
+   * @return false if the process is gone.
+   */
+  bool readProcess(pid_t pid, ProcSample &out) {
+    char path[64];
+    out = ProcSample{};
+    std::snprintf(path, sizeof(path), "/proc/%d/stat", static_cast<int>(pid));
+    if (!slurp(path) || !parseStat(buf, tick_ns, out))
+      return false;
+    std::snprintf(path, sizeof(path), "/proc/%d/status",
+                  static_cast<int>(pid));
+    if (slurp(path))
+      parseRss(buf, out);
+    std::snprintf(path, sizeof(path), "/proc/%d/smaps_rollup",
+                  static_cast<int>(pid));
+    if (slurp(path))
+      parsePss(buf, out);
+    readThreads(pid, out);
+    return true;
+  }
+
+  /** @brief Samples every session now. */
+  void update() { update(monotonicNowNs()); }
+
+  /**
+   * @brief Samples every live session and publishes the per-role totals.
+   * @param now_ns Monotonic time of the pass.
+   */
+  void update(uint64_t now_ns) {
+    uint64_t cpu_ns[PROCESS_ROLES] = {};
+    for (RoleUsage &u : usage.roles) {
+      u.processes = 0;
+      u.rss_bytes = 0;
+      u.pss_bytes = 0;
+    }
+
+    for (int i = 0; i < MAX_USERS_SESSIONS; ++i) {
+      const UserSession &s = shm->users[i];
+      Tracked &t = tracked[i];
+      pid_t pid = atomicLoad(s.session_pid);
+      if (!atomicLoad(s.active) || pid <= 0) {
+        t.pid = 0;
+        continue;
+      }
+      char name[sizeof(s.username)];
+      std::memcpy(name, s.username, sizeof(name));
+      name[sizeof(name) - 1] = '\0';
+
+      bool known = t.pid == pid;
+      if (!known)
+        t = Tracked{pid, ProcSample{}};
+
+      ProcSample now;
+      if (!readProcess(pid, now)) {
+        t.pid = 0;
+        continue;
+      }
+
+      int role = static_cast<int>(roleOf(name));
+      RoleUsage &u = usage.roles[role];
+      uint64_t user = delta(now.user_ns, t.last.user_ns);
+      uint64_t system = delta(now.system_ns, t.last.system_ns);
+      u.processes++;
+      u.cpu_user_ns += user;
+      u.cpu_system_ns += system;
+      u.rss_bytes += now.rss_bytes;
+      u.pss_bytes += now.pss_bytes;
+      u.voluntary_switches += delta(now.voluntary, t.last.voluntary);
+      u.preempted_switches += delta(now.preempted, t.last.preempted);
+      u.runqueue_wait_ns += delta(now.wait_ns, t.last.wait_ns);
+      if (known)
+        cpu_ns[role] += user + system;
+      t.last = now;
+    }
+
+    double elapsed_ns = last_ns ? static_cast<double>(now_ns - last_ns) : 0;
+    for (int r = 0; r < PROCESS_ROLES; ++r) {
+      usage.roles[r].cpu_cores =
+          elapsed_ns > 0 ? static_cast<double>(cpu_ns[r]) / elapsed_ns : 0.0;
+    }
+    last_ns = now_ns;
+    usage.samples++;
+    publish();
+  }
+
+  /** @brief Samples every interval until `stop` is set. */
+  void run(const std::atomic<bool> &stop) {
+    uint64_t next = monotonicNowNs();
+    while (!stop.load()) {
+      update();
+      next += interval_ns;
+      uint64_t now;
+      while (!stop.load() && (now = monotonicNowNs()) < next) {
+        uint64_t nap = next - now < 50000000ULL ? next - now : 50000000ULL;
+        std::this_thread::sleep_for(std::chrono::nanoseconds(nap));
+      }
+    }
+  }
+
+  /** @brief Prints the published usage table (terminal `usage` command). */
+  static void printReport(std::ostream &out, const SharedState *shm) {
+    const ResourceState &res = shm->resources;
+    char line[160];
+
+    if (atomicLoad(res.samples) == 0) {
+      out << "  (no resource usage published yet)\n";
+      return;
+    }
+
+    out << "  ROLE        PROCS   CORES   USER[s]    SYS[s]   RSS[MiB]"
+           "  PSS[MiB]   VOL-CS  INVOL-CS  RUNQ[s]\n";
+    for (int r = 0; r < PROCESS_ROLES; ++r) {
+      const RoleUsage &u = res.roles[r];
+      int procs = atomicLoad(u.processes);
+      uint64_t cpu = atomicLoad(u.cpu_user_ns) + atomicLoad(u.cpu_system_ns);
+      if (procs == 0 && cpu == 0)
+        continue;
+      std::snprintf(
+          line, sizeof(line),
+          "  %-10s %6d %7.2f %9.2f %9.2f %10.1f %9.1f %8llu %9llu %8.2f\n",
+          roleName(r), procs, atomicLoad(u.cpu_cores),
+          atomicLoad(u.cpu_user_ns) / 1e9, atomicLoad(u.cpu_system_ns) / 1e9,
+          atomicLoad(u.rss_bytes) / 1048576.0,
+          atomicLoad(u.pss_bytes) / 1048576.0,
+          (unsigned long long)atomicLoad(u.voluntary_switches),
+          (unsigned long long)atomicLoad(u.preempted_switches),
+          atomicLoad(u.runqueue_wait_ns) / 1e9);
+      out << line;
+    }
+  }
+};
@@ -5,6 +5,9 @@
 
 #pragma once
 
+#include "EventChannel.h"
+#include "LockProfiler.h"
+#include "LogThrottle.h"
 #include "Shared.h"
 #include "spdlog/spdlog.h"
 #include <cstring>
@@ -34,7 +37,14 @@ private:
    * @{ */
   std::function<void()> lock_fn;
   std::function<void()> unlock_fn;
+  std::function<bool()> wait_failed_fn; /**< See Belt::setWaitFailedCheck. */
   /** @} */
+
+  bool waitFailed() const { return wait_failed_fn && wait_failed_fn(); }
+
+  /** @brief Told the new slot after login and -1 after logout. */
+  std::function<void(int)> session_hook;
+
 public:
   /**
    * @brief Constructs a SessionManager.
@@ -46,6 +56,19 @@ public:
                  std::function<void()> unlock)
       : shm(shared_state), lock_fn(lock), unlock_fn(unlock) {}
 
+  /**
+   * @brief Sets a callback run after login (with the slot) and logout (-1),
+   * outside the registry lock.
+   */
+  void setSessionHook(std::function<void(int)> hook) {
+    session_hook = std::move(hook);
+  }
+
+  /** @brief Lets the registry calls notice a lock given up at shutdown. */
+  void setWaitFailedCheck(std::function<bool()> check) {
+    wait_failed_fn = std::move(check);
+  }
+
   /**
    * @brief Registers a new process session in Shared Memory.
    * * Scans for duplicate usernames and available slots. If successful,
@@ -62,7 +85,10 @@ public:
     if (!shm)
       return false;
 
+    LockSiteScope site(LockSite::SessionTable);
     lock_fn();
+    if (waitFailed())
+      return false;
 
     for (int i = 0; i < MAX_USERS_SESSIONS; ++i) {
       if (shm->users[i].active &&
@@ -89,6 +115,7 @@ public:
     }
 
     std::memset(&shm->users[free_slot], 0, sizeof(UserSession));
+    std::memset(&shm->health[free_slot], 0, sizeof(ProcessHealth));
 
     shm->users[free_slot].active = true;
     std::strncpy(shm->users[free_slot].username, name.c_str(), 31);
@@ -101,11 +128,15 @@ public:
     shm->users[free_slot].session_pid = getpid();
 
     current_session = free_slot;
+    bumpGeneration(shm, StateRegion::Sessions);
 
-    spdlog::info("[session] Logged in: '{}' (Org: {}, RoleMask: {}) @ Slot {}",
-                 name, orgId, (int)role, free_slot);
+    WAREHOUSE_LOG(LogSubsystem::Session, spdlog::level::info,
+                  "[session] Logged in: '{}' (Org: {}, RoleMask: {}) @ Slot {}",
+                  name, orgId, (int)role, free_slot);
 
     unlock_fn();
+    if (session_hook)
+      session_hook(free_slot);
     return true;
   }
 
@@ -118,9 +149,13 @@ public:
     if (current_session == -1 || !shm)
       return;
 
+    LockSiteScope site(LockSite::SessionTable);
     lock_fn();
-    spdlog::info("[session] Logging out: '{}'",
-                 shm->users[current_session].username);
+    if (waitFailed())
+      return;
+    WAREHOUSE_LOG(LogSubsystem::Session, spdlog::level::info,
+                  "[session] Logging out: '{}'",
+                  shm->users[current_session].username);
 
     shm->users[current_session].active = false;
 
@@ -129,8 +164,11 @@ public:
 
     shm->users[current_session].current_processes = 0;
     current_session = -1;
+    bumpGeneration(shm, StateRegion::Sessions);
 
     unlock_fn();
+    if (session_hook)
+      session_hook(-1);
   }
 
   /**
@@ -140,14 +178,29 @@ public:
   bool trySpawnProcess() {
     if (current_session == -1 || !shm)
       return false;
+    LockSiteScope site(LockSite::SessionTable);
     bool success = false;
     lock_fn();
+    if (waitFailed())
+      return false;
     UserSession &user = shm->users[current_session];
     if (user.current_processes < user.max_processes) {
       user.current_processes++;
+      bumpGeneration(shm, StateRegion::Sessions);
       success = true;
     }
+    int quota = user.max_processes;
+    char name[sizeof(user.username)];
+    std::memcpy(name, user.username, sizeof(name));
     unlock_fn();
+    if (!success) {
+      publishEvent(shm, EventKind::QuotaExhausted, getpid(), quota, name);
+      WAREHOUSE_LOG_REPEAT(LogSubsystem::Session, spdlog::level::warn,
+                           current_session,
+                           "[session] '{:.31s}' is at its quota of {} "
+                           "processes.",
+                           name, quota);
+    }
     return success;
   }
 
@@ -158,9 +211,13 @@ public:
   void reportProcessFinished() {
     if (current_session == -1 || !shm)
       return;
+    LockSiteScope site(LockSite::SessionTable);
     lock_fn();
+    if (waitFailed())
+      return;
     if (shm->users[current_session].current_processes > 0) {
       shm->users[current_session].current_processes--;
+      bumpGeneration(shm, StateRegion::Sessions);
     }
     unlock_fn();
   }
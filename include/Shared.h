@@ -11,6 +11,9 @@
 #ifndef SHARED_H
 #define SHARED_H
 
+#include "DeadlineHeap.h"
+#include "TimerWheel.h"
+#include <cstddef>
 #include <cstdint>
 #include <ctime>
 #include <iostream>
@@ -28,6 +31,14 @@ constexpr double MAX_BELT_WEIGHT_M =
     1000.0; /**< Maximum total weight allowed on the belt. */
 /** @} */
 
+/** @name Sorter Lanes
+ * Optional stage between the belt and per-lane docks (see Sorter.h).
+ * @{ */
+constexpr int MAX_SORTER_LANES = 4; /**< Upper bound on configured lanes. */
+constexpr int LANE_CAPACITY =
+    MAX_BELT_CAPACITY_K; /**< Slots in the ring of every lane. */
+/** @} */
+
 /** @name Package Volume Constants
  * Standardized volumes converted to cubic meters (m3).
  * Calculation: (cm * cm * cm) / 1,000,000
@@ -52,10 +63,10 @@ constexpr int MSG_KEY_ID = 9012; /**< Key for Message Queue allocation. */
 
 /** @name System Limits */
 /** @{ */
-constexpr int MAX_PACKAGE_HISTORY =
-    6; /**< Maximum number of audit entries per package. */
 constexpr int MAX_USERS_SESSIONS =
     210; /**< Maximum number of concurrent process sessions. */
+constexpr int LATENCY_BUCKETS =
+    16; /**< Power-of-two latency histogram buckets (last one is +Inf). */
 /** @} */
 
 /** @brief Type alias for Organization Identifier. It was MEANT to be used but
@@ -74,9 +85,55 @@ enum SemIndex {
   SEM_FULL_SLOTS,  /**< Counting semaphore tracks available items (Consumer
                       wait). */
   SEM_DOCK_MUTEX,  /**< Binary semaphore (Mutex) protecting dock/truck state. */
-  SEM_TOTAL        /**< Total number of semaphores in the set. */
+  SEM_LANE_BASE,   /**< First per-lane semaphore (see LaneSem). */
+  SEM_TOTAL = SEM_LANE_BASE + 4 * MAX_SORTER_LANES /**< Total number of
+                                                      semaphores in the set. */
+};
+
+/**
+ * @enum LaneSem
+ * @brief Semaphores owned by every sorter lane, mirroring the belt and dock.
+ */
+enum LaneSem {
+  LANE_MUTEX = 0, /**< Protects the lane ring. */
+  LANE_EMPTY,     /**< Free slots in the ring (Sorter wait). */
+  LANE_FULL,      /**< Packages in the ring (Dispatcher wait). */
+  LANE_DOCK,      /**< Protects the lane's dock. */
+  SEM_PER_LANE
+};
+
+static_assert(SEM_PER_LANE == 4, "SEM_TOTAL assumes four semaphores per lane");
+
+/** @brief Index of semaphore `which` of sorter lane `lane`. */
+constexpr SemIndex laneSem(int lane, LaneSem which) {
+  return static_cast<SemIndex>(SEM_LANE_BASE + lane * SEM_PER_LANE + which);
+}
+
+/**
+ * @enum LockSite
+ * @brief Call sites attributed by the lock contention profiler.
+ * * Several subsystems share one semaphore (e.g. `SEM_MUTEX_BELT` guards the
+ * belt, worker registration and the session table), so statistics are kept
+ * per (SemIndex, LockSite) pair.
+ */
+enum class LockSite : uint8_t {
+  Unknown = 0,    /**< Caller did not declare a site. */
+  BeltPush,       /**< Belt::push (Workers). */
+  BeltPop,        /**< Belt::pop (Dispatcher). */
+  WorkerRegistry, /**< Belt::registerWorker / unregisterWorker. */
+  SessionTable,   /**< SessionManager login/logout/quota. */
+  DockDispatcher, /**< Dispatcher loading from the belt. */
+  DockExpress,    /**< Express batch loading. */
+  DockTruck,      /**< Truck docking and departure. */
+  LanePush,       /**< Lane::push (Sorter). */
+  LanePop,        /**< Lane::pop (lane Dispatcher). */
+  BeltTransit,    /**< Belt::advanceTransit (belt process ticker). */
+  Total           /**< Number of call sites. */
 };
 
+/** @brief Number of distinct lock call sites. */
+constexpr int LOCK_SITE_TOTAL = static_cast<int>(LockSite::Total);
+
 /**
  * @enum SignalType
  * @brief Commands sent via the System V Message Queue.
@@ -198,6 +255,28 @@ inline constexpr bool hasFlag(PackageStatus value, PackageStatus flag) {
 }
 /** @} */
 
+/**
+ * @enum SlaTier
+ * @brief Delivery promise of a package, assigned by the Worker.
+ * * Each tier maps to a belt-to-truck budget (see slaBudgetNs); the
+ * package's deadline is its creation time plus that budget.
+ */
+enum class SlaTier : uint8_t {
+  Standard = 0, /**< Bulk traffic. */
+  Priority,     /**< Next-day promise. */
+  Urgent,       /**< Same-day promise. */
+  Total         /**< Number of tiers (not a tier). */
+};
+
+constexpr int SLA_TIERS = static_cast<int>(SlaTier::Total);
+
+/** @brief Default belt-to-truck budget of a tier [ms]. */
+inline constexpr long long slaBudgetMs(SlaTier tier) {
+  return tier == SlaTier::Urgent     ? 2000
+         : tier == SlaTier::Priority ? 5000
+                                     : 15000;
+}
+
 /**
  * @enum ActionType
  * @brief Event types for the package audit trail.
@@ -234,21 +313,12 @@ inline constexpr bool hasFlag(ActionType value, ActionType flag) {
 }
 /** @} */
 
-/**
- * @struct ActionRecord
- * @brief A single entry in the package's history log.
- */
-struct ActionRecord {
-  ActionType type;  /**< Type of action performed. */
-  pid_t actor_pid;  /**< PID of the process performing the action. */
-  time_t timestamp; /**< Time of the event. */
-};
-
 /**
  * @struct Package
  * @brief The core unit of data in the system.
  * * Represents a physical package moving through the warehouse.
- * Includes properties and a fixed-size history buffer for audit trails.
+ * Its audit trail is not stored here but in the append-only journal
+ * (see AuditJournal.h), keeping the struct small for belt copies.
  */
 struct Package {
   int id; /**< Global Unique ID. */
@@ -258,6 +328,7 @@ struct Package {
 
   PackageType type;     /**< Physical classification (A, B, C). */
   PackageStatus status; /**< Current status flags. */
+  SlaTier tier;         /**< Delivery promise. */
 
   double weight; /**< Weight in kg. */
   double volume; /**< Volume in arbitrary units. */
@@ -265,24 +336,8 @@ struct Package {
   time_t created_at; /**< Creation timestamp. */
   time_t updated_at; /**< Last modification timestamp. */
 
-  ActionRecord
-      history[MAX_PACKAGE_HISTORY]; /**< Circular buffer of history events. */
-  int history_count;                /**< Current number of history records. */
-
-  /**
-   * @brief Appends a new action to the package's history.
-   * @param action Bitmask of the action performed.
-   * @param pid PID of the actor.
-   */
-  void pushAction(ActionType action, pid_t pid) {
-    if (history_count < MAX_PACKAGE_HISTORY) {
-      history[history_count] = {action, pid, std::time(nullptr)};
-      history_count++;
-
-      updated_at = std::time(nullptr);
-      editor_pid = pid;
-    }
-  }
+  uint64_t created_ns;  /**< Monotonic time the package entered the belt. */
+  uint64_t deadline_ns; /**< Monotonic time it must be loaded by. */
 };
 
 /**
@@ -303,6 +358,97 @@ struct UserSession {
   int current_processes; /**< Current number of running sub-processes. */
 };
 
+/**
+ * @enum DepartureReason
+ * @brief Why a truck left the dock, as recorded in the delivery ledger.
+ * * Set in `TruckState` by whoever requests the departure; the first reason
+ * written since docking wins.
+ */
+enum class DepartureReason : uint8_t {
+  Unknown = 0,     /**< Departed without a recorded request. */
+  Full = 1,        /**< Dispatcher: load, weight or volume limit reached. */
+  NoFit = 2,       /**< Dispatcher: next package did not fit. */
+  ExpressFull = 3, /**< Express batch did not fit. */
+  Forced = 4,      /**< Operator command from the terminal. */
+  Shutdown = 5,    /**< End of work with cargo on board. */
+  Total            /**< Number of reasons (not a reason). */
+};
+
+/**
+ * @enum DockPhase
+ * @brief Departure state machine of a docked truck (valid while present).
+ * * `Docked -> DepartureRequested` happens exactly once per visit, and only
+ * that transition sends `SIGNAL_DEPARTURE` (see requestDeparture). The truck
+ * moves to `Departing` when it consumes the message; messages left from an
+ * earlier visit are dropped before it docks again.
+ */
+enum class DockPhase : uint8_t {
+  Docked = 0,         /**< Being loaded, no departure requested. */
+  DepartureRequested, /**< DEPARTURE sent, truck has not reacted yet. */
+  Departing           /**< Truck consumed the request and is leaving. */
+};
+
+/** @name Dock Combining (see DockController.h)
+ * @{ */
+constexpr int DOCK_CLIENT_SLOTS = 16; /**< Loaders per dock that combine. */
+constexpr int DOCK_BATCH_MAX = 5;     /**< Packages per load request. */
+/** @} */
+
+/**
+ * @enum LoadOutcome
+ * @brief Result of one load request applied to a dock.
+ */
+enum class LoadOutcome : uint8_t {
+  NoTruck = 0, /**< No truck docked; nothing loaded. */
+  Loaded,      /**< Every package of the request was loaded. */
+  NoFit        /**< Loading stopped at a package that does not fit. */
+};
+
+/**
+ * @struct LoadSlot
+ * @brief Publication slot of one loader (a Dispatcher or Express instance).
+ *
+ * The owner fills the request and bumps `posted`; whichever loader holds
+ * the combiner role applies it, fills the result and sets `served` to
+ * `posted`.
+ */
+struct LoadSlot {
+  int owner;       /**< PID of the claiming process, 0 = free. */
+  uint32_t posted; /**< Sequence of the latest request. */
+  uint32_t served; /**< Sequence of the latest applied request. */
+
+  /** @name Request
+   * @{ */
+  uint8_t items;                   /**< Packages, 1..DOCK_BATCH_MAX. */
+  bool counts_load;                /**< Packages count towards max_load. */
+  bool check_full;                 /**< Request departure when ~full. */
+  DepartureReason no_fit_reason;   /**< Reason if a package does not fit. */
+  double weight[DOCK_BATCH_MAX];   /**< Package weights [kg]. */
+  double volume[DOCK_BATCH_MAX];   /**< Package volumes [m3]. */
+  /** @} */
+
+  /** @name Result
+   * @{ */
+  LoadOutcome outcome;     /**< What happened. */
+  uint8_t loaded;          /**< Packages loaded (a prefix of the request). */
+  bool departure_sent;     /**< This request sent the visit's DEPARTURE. */
+  bool departure_repeated; /**< A departure was already requested. */
+  int truck_id;            /**< Truck loaded into. */
+  double truck_weight;     /**< Truck payload after the request [kg]. */
+  double truck_volume;     /**< Truck payload after the request [m3]. */
+  /** @} */
+};
+
+/**
+ * @struct DockCombiner
+ * @brief Flat-combining state of one dock.
+ */
+struct DockCombiner {
+  int combiner;      /**< PID holding the combiner role, 0 = none. */
+  uint32_t rotation; /**< First slot served by the next pass. */
+  LoadSlot slots[DOCK_CLIENT_SLOTS];
+};
+
 /**
  * @struct TruckState
  * @brief Represents the vehicle currently stationed at the dock.
@@ -316,6 +462,424 @@ struct TruckState {
   double current_weight; /**< Current total weight loaded. */
   double max_weight;     /**< Maximum weight capacity. */
   double max_volume;     /**< Maximum volume of the truck */
+  DepartureReason departure_reason; /**< Why departure was requested. */
+  DockPhase phase;                  /**< Departure state machine. */
+  DockCombiner loaders;             /**< Combined load requests. */
+};
+
+/**
+ * @brief Requests departure of the docked truck, exactly once per visit.
+ *
+ * Records `reason` unless one is already set. Only the first request of a
+ * visit moves the dock to `DepartureRequested` and returns true; the caller
+ * then sends the one `SIGNAL_DEPARTURE`. Later requests return false and
+ * must not send anything, so no message outlives the visit.
+ *
+ * @param truck Dock state (caller holds the dock mutex where applicable).
+ * @param reason Reason of the request.
+ * @return true if the caller must signal the truck.
+ */
+inline bool requestDeparture(TruckState &truck, DepartureReason reason) {
+  if (truck.departure_reason == DepartureReason::Unknown)
+    truck.departure_reason = reason;
+  if (!truck.is_present || truck.phase != DockPhase::Docked)
+    return false;
+  truck.phase = DockPhase::DepartureRequested;
+  return true;
+}
+
+/**
+ * @enum SortKind
+ * @brief Package attribute a sorter rule routes by.
+ */
+enum class SortKind : uint8_t {
+  Type = 0, /**< Lane per PackageType: A, B, C. */
+  Weight,   /**< Ascending weight bounds [kg]. */
+  Volume    /**< Ascending volume bounds [m3]. */
+};
+
+/**
+ * @struct SortRule
+ * @brief Routing rule of the sorter, set by the IPC owner (see Sorter.h).
+ */
+struct SortRule {
+  SortKind kind; /**< Attribute compared. */
+  int lanes;     /**< Number of lanes the rule produces. */
+  double bounds[MAX_SORTER_LANES - 1]; /**< Upper bound (exclusive) per lane. */
+};
+
+/**
+ * @struct LaneState
+ * @brief Ring buffer and loading dock of one sorter lane.
+ */
+struct LaneState {
+  Package ring[LANE_CAPACITY]; /**< Circular buffer fed by the sorter. */
+  int head;                    /**< Consumer index. */
+  int tail;                    /**< Producer index. */
+  int count;                   /**< Packages in the ring. */
+  double weight;               /**< Weight in the ring. */
+  TruckState dock;             /**< Truck loading from this lane. */
+  uint64_t routed;             /**< Packages routed into the lane. */
+  uint64_t loaded;             /**< Packages loaded into lane trucks. */
+};
+
+/**
+ * @enum FaultSite
+ * @brief IPC operations the fault injector can perturb (see FaultInjector.h).
+ */
+enum class FaultSite : uint8_t {
+  LockBelt = 0,   /**< Belt mutex acquisition. */
+  LockDock,       /**< Dock mutex acquisition (main or lane dock). */
+  WaitForPackage, /**< Consumer wait on the belt's full slots. */
+  WaitForSlot,    /**< Producer wait on the belt's empty slots. */
+  SendSignal,     /**< Message queue send (msgsnd). */
+  Total           /**< Number of sites (not a site). */
+};
+
+constexpr int FAULT_SITES = static_cast<int>(FaultSite::Total);
+
+/**
+ * @struct WarehouseStats
+ * @brief Monotonic counters and histograms read by the metrics exporter.
+ * * Updated with relaxed atomics (see Telemetry.h) outside of any critical
+ * section, so observers never contend with the hot path.
+ */
+struct WarehouseStats {
+  uint64_t packages_loaded; /**< Belt packages placed into trucks. */
+  uint64_t express_loaded;  /**< Express (P4) packages placed. */
+  int packages_in_dispatch; /**< Popped by a Dispatcher, not yet loaded. */
+  int packages_in_sorter;   /**< Popped by the Sorter, not yet in a lane. */
+  uint64_t latency_buckets[LATENCY_BUCKETS]; /**< Belt-to-truck histogram. */
+  uint64_t latency_sum_ns;                   /**< Sum of observed latencies. */
+  uint64_t latency_count;                    /**< Number of observations. */
+  uint64_t dock_ns_total;        /**< Sum of truck dwell times at the dock. */
+  uint64_t departures_empty;     /**< Trucks that left with no cargo. */
+  uint64_t departures_stale;     /**< Leftover messages dropped at docking. */
+  uint64_t departures_coalesced; /**< Repeat requests sent no message. */
+  uint64_t combine_passes;       /**< Dock mutex holds by a combiner. */
+  uint64_t combined_requests;    /**< Load requests applied by them. */
+  uint64_t sla_loaded[SLA_TIERS]; /**< Belt packages loaded, per tier. */
+  uint64_t sla_missed[SLA_TIERS]; /**< ... of which after the deadline. */
+  uint64_t tardiness_buckets[LATENCY_BUCKETS]; /**< Lateness of misses. */
+  uint64_t tardiness_sum_ns;                   /**< Sum of the lateness. */
+  uint64_t faults_injected[FAULT_SITES]; /**< Perturbations, per site. */
+};
+
+/**
+ * @struct LockStats
+ * @brief Contention profile of one semaphore as used from one call site.
+ */
+struct LockStats {
+  uint64_t acquisitions;  /**< Successful P operations. */
+  uint64_t contended;     /**< Acquisitions that had to block. */
+  uint64_t wait_ns_total; /**< Time spent blocked in semop. */
+  uint64_t wait_ns_max;   /**< Longest single wait. */
+  uint64_t hold_ns_total; /**< Time between P and V (mutexes only). */
+  uint64_t hold_ns_max;   /**< Longest single hold. */
+};
+
+/**
+ * @enum Stage
+ * @brief Stages of the flow line, in the order packages traverse them.
+ */
+enum class Stage : uint8_t {
+  Workers = 0, /**< Package producers. */
+  Belt,        /**< Conveyor buffer (K slots, M kg). */
+  Dispatcher,  /**< Moves packages from the belt into the docked truck. */
+  Dock,        /**< Single loading bay, swapped between trucks. */
+  Fleet,       /**< Trucks on their delivery routes. */
+  Total        /**< Number of stages (not a stage). */
+};
+
+constexpr int STAGE_TOTAL = static_cast<int>(Stage::Total);
+
+/**
+ * @struct StageEstimate
+ * @brief Smoothed queueing estimates of one stage (see QueueAnalytics.h).
+ */
+struct StageEstimate {
+  double arrival_rate; /**< Items entering per second. */
+  double throughput;   /**< Items leaving per second. */
+  double utilization;  /**< Fraction of time active (not starved/blocked). */
+  double occupancy;    /**< Mean items in the stage (L). */
+  double sojourn_s;    /**< Mean time in the stage, L / lambda. */
+};
+
+/**
+ * @struct AnalyticsState
+ * @brief Flow-line analysis published by the belt process.
+ */
+struct AnalyticsState {
+  StageEstimate stages[STAGE_TOTAL]; /**< Indexed by Stage. */
+  double little_belt; /**< Belt-to-truck L / (lambda * W); 1 = consistent. */
+  double little_dock; /**< Dock L / (lambda * measured W); 1 = consistent. */
+  int bottleneck;     /**< Stage limiting throughput, -1 if unknown. */
+  double confidence;  /**< Confidence in `bottleneck`, 0..1. */
+  uint64_t samples;   /**< Snapshots folded into the estimates. */
+};
+
+/**
+ * @enum ProcessRole
+ * @brief Kind of process behind a session, derived from its username.
+ */
+enum class ProcessRole : uint8_t {
+  Worker = 0, /**< "Worker_<n>". */
+  Truck,      /**< "Truck_<n>". */
+  Dispatcher, /**< "System-Dispatcher[_<n>]". */
+  Belt,       /**< "System-Belt" (also hosts the exporters). */
+  Express,    /**< "System-Express". */
+  Sorter,     /**< "System-Sorter". */
+  Terminal,   /**< "AdminConsole". */
+  Other,      /**< Any other session. */
+  Total       /**< Number of roles (not a role). */
+};
+
+constexpr int PROCESS_ROLES = static_cast<int>(ProcessRole::Total);
+
+/**
+ * @struct RoleUsage
+ * @brief OS resources used by the processes of one role.
+ * * Counters accumulate what every process of the role used while it was
+ * sampled; gauges describe the processes alive at the last sample.
+ */
+struct RoleUsage {
+  int32_t processes;           /**< Live sessions of the role. */
+  uint64_t cpu_user_ns;        /**< User CPU time. */
+  uint64_t cpu_system_ns;      /**< Kernel CPU time. */
+  double cpu_cores;            /**< CPU used over the last interval. */
+  uint64_t rss_bytes;          /**< Resident set size (VmRSS). */
+  uint64_t pss_bytes;          /**< Proportional set size, 0 if unknown. */
+  uint64_t voluntary_switches; /**< Context switches while blocking. */
+  uint64_t preempted_switches; /**< Involuntary context switches. */
+  uint64_t runqueue_wait_ns;   /**< Time runnable but not running. */
+};
+
+/**
+ * @struct ResourceState
+ * @brief Per-role resource usage published by the belt process.
+ */
+struct ResourceState {
+  RoleUsage roles[PROCESS_ROLES]; /**< Indexed by ProcessRole. */
+  uint64_t samples;               /**< Completed sampling passes. */
+};
+
+/**
+ * @struct ProcessHealth
+ * @brief Liveness of the process in one session slot (see Watchdog.h).
+ * * Written by the process itself with relaxed atomics, never under a
+ * semaphore; read by the watchdog. Reset when the slot is logged into.
+ */
+struct ProcessHealth {
+  uint64_t beats;         /**< Bumped once per main-loop iteration. */
+  uint32_t held;          /**< Bit per SemIndex of the mutexes held. */
+  int32_t waiting;        /**< SemIndex + 1 blocked on in semop, 0 = none. */
+  uint64_t wait_since_ns; /**< When the current blocked wait began. */
+  int32_t parked;         /**< > 0 while idle on a message or a timer. */
+  int32_t stalled;        /**< Set by the watchdog while no progress. */
+};
+
+static_assert(SEM_TOTAL <= 32, "ProcessHealth::held has a bit per semaphore");
+
+/**
+ * @struct WatchdogState
+ * @brief Findings of the watchdog run by the belt process.
+ */
+struct WatchdogState {
+  uint64_t passes;     /**< Completed checks. */
+  uint64_t stalls;     /**< Processes found without progress. */
+  uint64_t recoveries; /**< Mutexes released or processes killed. */
+  int32_t stalled;     /**< Processes currently stalled. */
+};
+
+/**
+ * @enum EventKind
+ * @brief Operator alerts published to the event ring (see EventChannel.h).
+ */
+enum class EventKind : uint8_t {
+  None = 0,          /**< Empty slot. */
+  TruckDepartedFull, /**< A truck left at a capacity limit. */
+  BeltSaturated,     /**< The belt reached K packages. */
+  QuotaExhausted,    /**< A session hit its process quota. */
+  ProcessDied,       /**< The orchestrator reaped a role process. */
+  ProcessStalled,    /**< The watchdog found a process without progress. */
+  Shutdown,          /**< The simulation is stopping. */
+  Total              /**< Number of kinds (not a kind). */
+};
+
+constexpr int EVENT_KINDS = static_cast<int>(EventKind::Total);
+constexpr int EVENT_RING_SIZE = 64; /**< Events kept for late readers. */
+
+/**
+ * @struct SystemEvent
+ * @brief One published alert.
+ */
+struct SystemEvent {
+  uint64_t seq;     /**< Sequence number + 1 once complete, 0 while written. */
+  uint64_t time_ns; /**< Wall clock at publication. */
+  int32_t kind;     /**< EventKind. */
+  int32_t pid;      /**< Process concerned. */
+  int64_t value;    /**< Kind-specific: load, exit status, quota... */
+  char subject[32]; /**< Session name, if any. */
+};
+
+/**
+ * @struct EventRing
+ * @brief Multi-producer ring of alerts with a futex word for waiters.
+ */
+struct EventRing {
+  uint64_t head;                      /**< Next sequence number to claim. */
+  uint32_t wake;                      /**< Futex word, bumped per event. */
+  int32_t waiters;                    /**< Readers blocked on `wake`. */
+  uint64_t last_ns[EVENT_KINDS];      /**< Last publication, per kind. */
+  uint64_t coalesced[EVENT_KINDS];    /**< Dropped by the rate limit. */
+  SystemEvent slots[EVENT_RING_SIZE]; /**< By sequence modulo the size. */
+};
+
+/**
+ * @enum LogSubsystem
+ * @brief Groups of hot-path log call sites sharing a throttling policy.
+ */
+enum class LogSubsystem : uint8_t {
+  Belt = 0,   /**< Push and pop. */
+  Dispatcher, /**< Loads and departures requested by dispatchers. */
+  Truck,      /**< Docking, departures and routes. */
+  Express,    /**< Express batches. */
+  Session,    /**< Logins, logouts and quotas. */
+  Total       /**< Number of subsystems (not a subsystem). */
+};
+
+constexpr int LOG_SUBSYSTEMS = static_cast<int>(LogSubsystem::Total);
+
+/**
+ * @struct LogPolicy
+ * @brief Throttling of one subsystem's log call sites (see LogThrottle.h).
+ *
+ * Zero in any field keeps the default, so a zeroed policy logs everything
+ * and only folds repeats.
+ */
+struct LogPolicy {
+  uint32_t sample;     /**< Log 1 call in N per call site (0 = all). */
+  uint32_t rate;       /**< Records per second per call site (0 = no limit). */
+  uint32_t burst;      /**< Token bucket depth (0 = one second of `rate`). */
+  uint32_t repeat_ms;  /**< Repeat folding window (0 = 5000 ms). */
+  uint64_t suppressed; /**< Records dropped by this policy so far. */
+};
+
+/**
+ * @enum StateRegion
+ * @brief Parts of the state streamed to dashboards (see StateStream.h).
+ */
+enum class StateRegion : uint8_t {
+  Belt = 0, /**< Main belt load, weight, transit and workers. */
+  Dock,     /**< The truck at every dock. */
+  Fleet,    /**< Departed and waiting trucks, packages loaded. */
+  Sessions, /**< Active sessions and their process counts. */
+  Total     /**< Number of regions (not a region). */
+};
+
+constexpr int STATE_REGIONS = static_cast<int>(StateRegion::Total);
+
+/**
+ * @struct RegionGeneration
+ * @brief Change counter of one StateRegion, bumped after each update.
+ * * Each counter fills a cache line so that processes updating different
+ * regions do not contend for it.
+ */
+struct RegionGeneration {
+  uint64_t value;  /**< Updates made to the region so far. */
+  uint8_t pad[56]; /**< Up to 64 bytes. */
+};
+
+/** @brief Length of one belt transit tick (timer wheel resolution). */
+constexpr uint64_t BELT_TICK_NS = 1000000ULL;
+
+/**
+ * @struct BeltTransit
+ * @brief Conveyor transit model (`BELT_SPEED_MS`), guarded by the belt mutex.
+ * * A pushed package occupies its slot at once but only counts towards the
+ * full-slots semaphore once it reaches the end of the belt, which the belt
+ * process detects by advancing `wheel` (see Belt::advanceTransit). The
+ * wheel's payload is the belt slot, which is marked in `arrived`.
+ */
+struct BeltTransit {
+  int speed_ms;   /**< Transit time; 0 = packages arrive immediately. */
+  int in_transit; /**< Packages on the belt that have not arrived yet. */
+  uint8_t arrived[MAX_BELT_CAPACITY_K];  /**< Slot reached the belt's end. */
+  TimerWheel<MAX_BELT_CAPACITY_K> wheel; /**< Pending arrivals by slot. */
+};
+
+/**
+ * @enum BeltOrder
+ * @brief Order in which the Dispatchers take packages off the belt.
+ */
+enum class BeltOrder : uint8_t {
+  Fifo = 0, /**< Circular buffer, oldest first. */
+  Edf       /**< Earliest deadline first among arrived packages. */
+};
+
+/**
+ * @struct BeltSchedule
+ * @brief EDF service order (`BELT_ORDER=edf`), guarded by the belt mutex.
+ * * In EDF mode packages leave the belt out of order, so slots are not a
+ * ring: free slots are handed out from the `recycled` stack, then from a
+ * high-water mark. A package enters `ready` when it reaches the end of
+ * the belt (at once without a belt speed).
+ */
+struct BeltSchedule {
+  BeltOrder order;                         /**< Service order. */
+  int32_t used;                            /**< High-water mark of slots. */
+  int32_t recycled_count;                  /**< Entries in `recycled`. */
+  uint32_t recycled[MAX_BELT_CAPACITY_K];  /**< Freed slots. */
+  DeadlineHeap<MAX_BELT_CAPACITY_K> ready; /**< Arrived slots by deadline. */
+  int32_t budget_ms[SLA_TIERS]; /**< Per-tier budget, 0 = slaBudgetMs. */
+};
+
+/** @brief Belt-to-truck budget of a tier as configured [ns]. */
+inline uint64_t slaBudgetNs(const BeltSchedule &sched, SlaTier tier) {
+  int t = static_cast<int>(tier);
+  long long ms = t < SLA_TIERS && sched.budget_ms[t] > 0 ? sched.budget_ms[t]
+                                                         : slaBudgetMs(tier);
+  return static_cast<uint64_t>(ms) * 1000000ULL;
+}
+
+/** @name Segment ABI
+ * Stamped into `SharedState::layout` by the IPC owner and checked by every
+ * process that attaches (see Manager), so a binary built against another
+ * layout refuses to run instead of misreading the segment.
+ * @{ */
+constexpr uint32_t SHM_MAGIC = 0x57484d31; /**< "WHM1". */
+/** @brief Bump on any change to the shared structures. */
+constexpr uint32_t SHM_ABI_VERSION = 7;
+constexpr int SHM_LAYOUT_FIELDS = 16; /**< Offsets recorded in ShmLayout. */
+/** @} */
+
+/**
+ * @struct ShmLayout
+ * @brief Self-description at the start of the segment.
+ * * `offsets` holds the byte offsets of the top-level sections and the sizes
+ * of the element types, in the order of `currentLayout`. They catch layout
+ * changes made without bumping `SHM_ABI_VERSION`.
+ */
+struct ShmLayout {
+  uint32_t magic;                      /**< SHM_MAGIC once initialized. */
+  uint32_t abi_version;                /**< SHM_ABI_VERSION of the owner. */
+  uint64_t size;                       /**< sizeof(SharedState). */
+  uint32_t offsets[SHM_LAYOUT_FIELDS]; /**< See currentLayout. */
+};
+
+/** @brief Packages a draining Dispatcher can hand over (see HandoffShelf). */
+constexpr int HANDOFF_SLOTS = 8;
+
+/**
+ * @struct HandoffShelf
+ * @brief Packages left by Dispatchers that stopped before loading them.
+ * * Guarded by the belt mutex. They stay counted in `packages_in_dispatch`
+ * until the Dispatcher serving the same lane takes and loads them.
+ */
+struct HandoffShelf {
+  int count;                     /**< Entries in use. */
+  int lane[HANDOFF_SLOTS];       /**< Lane of the package, -1 = belt. */
+  Package parked[HANDOFF_SLOTS]; /**< The packages. */
 };
 
 /**
@@ -326,6 +890,8 @@ struct TruckState {
  * the circular buffer (belt), truck dock state, and user session registry.
  */
 struct SharedState {
+  ShmLayout layout; /**< ABI stamp; must stay the first member. */
+
   Package belt[MAX_BELT_CAPACITY_K]; /**< Circular buffer for packages. */
   int head;                          /**< Consumer index (Read/Pop). */
   int tail;                          /**< Producer index (Write/Push). */
@@ -334,9 +900,12 @@ struct SharedState {
 
   int current_items_count;    /**< Atomic-like counter of items on belt. */
   double current_belt_weight; /**< Total weight on the belt. */
+  BeltTransit transit;        /**< Belt transit model. */
+  BeltSchedule schedule;      /**< Service order of the belt. */
 
   bool running;               /**< System run-loop flag. */
   int trucks_completed;       /**< Statistics: Total trucks departed. */
+  int trucks_waiting;         /**< Trucks polling for an occupied dock. */
   int total_packages_created; /**< Global counter for generating Package IDs. */
 
   bool force_truck_departure; /**< Flag to signal immediate departure. */
@@ -344,8 +913,92 @@ struct SharedState {
 
   UserSession users[MAX_USERS_SESSIONS]; /**< Table of active sessions. */
   TruckState dock_truck;                 /**< State of the docking bay. */
+
+  SortRule sort_rule;                /**< Routing rule of the sorter. */
+  int lane_count;                    /**< 0 = single belt and dock. */
+  LaneState lanes[MAX_SORTER_LANES]; /**< Sorter lanes with their docks. */
+
+  WarehouseStats stats; /**< Counters exported as metrics. */
+
+  LockStats lock_stats[SEM_TOTAL][LOCK_SITE_TOTAL]; /**< Lock profiler data. */
+
+  AnalyticsState analytics; /**< Bottleneck analysis (see QueueAnalytics.h). */
+
+  uint64_t journal_cursor; /**< Next free audit journal record index. */
+
+  HandoffShelf handoff; /**< Packages handed over by stopped Dispatchers. */
+
+  ResourceState resources; /**< Per-role usage (see ResourceSampler.h). */
+
+  ProcessHealth health[MAX_USERS_SESSIONS]; /**< By session slot. */
+  WatchdogState watchdog;                   /**< Stall detection results. */
+
+  EventRing events; /**< Operator alerts (see EventChannel.h). */
+
+  LogPolicy log_policy[LOG_SUBSYSTEMS]; /**< Log throttling, by subsystem. */
+
+  RegionGeneration generations[STATE_REGIONS]; /**< By StateRegion. */
 };
 
+/** @brief Layout of `SharedState` as compiled into this binary. */
+inline ShmLayout currentLayout() {
+  const uint32_t offsets[SHM_LAYOUT_FIELDS] = {
+      offsetof(SharedState, belt),        offsetof(SharedState, head),
+      offsetof(SharedState, transit),     offsetof(SharedState, schedule),
+      offsetof(SharedState, running),     offsetof(SharedState, users),
+      offsetof(SharedState, dock_truck),  offsetof(SharedState, lanes),
+      offsetof(SharedState, stats),       offsetof(SharedState, lock_stats),
+      offsetof(SharedState, analytics),   offsetof(SharedState, handoff),
+      sizeof(Package),                    sizeof(TruckState),
+      sizeof(UserSession),                sizeof(LaneState)};
+  ShmLayout layout = {};
+  layout.magic = SHM_MAGIC;
+  layout.abi_version = SHM_ABI_VERSION;
+  layout.size = sizeof(SharedState);
+  for (int i = 0; i < SHM_LAYOUT_FIELDS; ++i)
+    layout.offsets[i] = offsets[i];
+  return layout;
+}
+
+/**
+ * @brief Checks a segment's stamp against this binary's layout.
+ * @param found Stamp read from the segment.
+ * @return nullptr if compatible, otherwise what differs.
+ */
+inline const char *layoutMismatch(const ShmLayout &found) {
+  ShmLayout mine = currentLayout();
+  if (found.magic != SHM_MAGIC)
+    return "no warehouse segment header (magic)";
+  if (found.abi_version != mine.abi_version)
+    return "ABI version";
+  if (found.size != mine.size)
+    return "segment size";
+  for (int i = 0; i < SHM_LAYOUT_FIELDS; ++i) {
+    if (found.offsets[i] != mine.offsets[i])
+      return "field offsets";
+  }
+  return nullptr;
+}
+
+/** @brief Number of loading docks: one per lane, or the single dock. */
+inline int dockCount(const SharedState *s) {
+  return s->lane_count > 0 ? s->lane_count : 1;
+}
+
+/** @brief Dock `i` (see dockCount). */
+inline TruckState &dockAt(SharedState *s, int i) {
+  return s->lane_count > 0 ? s->lanes[i].dock : s->dock_truck;
+}
+
+/**
+ * @brief Records an update of `region` for the state stream.
+ * * Call after the change (release order); one atomic add, no lock.
+ */
+inline void bumpGeneration(SharedState *s, StateRegion region) {
+  __atomic_add_fetch(&s->generations[static_cast<int>(region)].value, 1,
+                     __ATOMIC_RELEASE);
+}
+
 /**
  * @struct CommandMessage
  * @brief Data structure for System V Message Queue operations.
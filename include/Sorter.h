@@ -0,0 +1,297 @@
+/**
+ * @file Sorter.h
+ * @brief Sorter stage routing belt packages into per-lane rings and docks.
+ *
+ * With a sorter configured (`SORTER_RULE`), the Sorter process is the only
+ * consumer of the belt. It routes every package by a `SortRule` into one of
+ * up to `MAX_SORTER_LANES` lanes. Each lane is a ring buffer with its own
+ * semaphores and its own dock, drained by a dedicated Dispatcher and served
+ * by its own trucks, so lanes load in parallel and every truck fills to a
+ * homogeneous profile (e.g. only Type C packages, which fill by volume).
+ *
+ * Rules (`SORTER_RULE`):
+ * - `type`: lane 0 = Type A, 1 = Type B, 2 = Type C.
+ * - `weight:B1[,B2...]`: lane i takes packages lighter than Bi [kg], the
+ *   last lane takes the rest.
+ * - `volume:B1[,B2...]`: same, with bounds in m3.
+ */
+#pragma once
+
+#include "Belt.h"
+#include "LockProfiler.h"
+#include "Shared.h"
+#include "Telemetry.h"
+#include "Watchdog.h"
+#include "spdlog/spdlog.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Parses a `SORTER_RULE` specification.
+ * @param text Rule text (see file documentation).
+ * @param out Parsed rule; untouched on failure.
+ * @return true if the rule is valid.
+ */
+inline bool parseSortRule(const char *text, SortRule &out) {
+  SortRule rule = {};
+
+  if (std::strcmp(text, "type") == 0) {
+    rule.kind = SortKind::Type;
+    rule.lanes = 3;
+    out = rule;
+    return true;
+  }
+
+  const char *values = nullptr;
+  if (std::strncmp(text, "weight:", 7) == 0) {
+    rule.kind = SortKind::Weight;
+    values = text + 7;
+  } else if (std::strncmp(text, "volume:", 7) == 0) {
+    rule.kind = SortKind::Volume;
+    values = text + 7;
+  } else {
+    return false;
+  }
+
+  int n = 0;
+  while (*values) {
+    if (n == MAX_SORTER_LANES - 1)
+      return false;
+    char *end = nullptr;
+    double bound = std::strtod(values, &end);
+    if (end == values || bound <= 0 || (n > 0 && bound <= rule.bounds[n - 1]))
+      return false;
+    rule.bounds[n++] = bound;
+    values = *end == ',' ? end + 1 : end;
+    if (*end && *end != ',')
+      return false;
+  }
+  if (n == 0)
+    return false;
+
+  rule.lanes = n + 1;
+  out = rule;
+  return true;
+}
+
+/**
+ * @brief Lane a package is routed to under `rule`.
+ */
+inline int routeLane(const SortRule &rule, const Package &pkg) {
+  if (rule.kind == SortKind::Type) {
+    int lane = hasFlag(pkg.type, PackageType::TypeC)   ? 2
+               : hasFlag(pkg.type, PackageType::TypeB) ? 1
+                                                       : 0;
+    return lane < rule.lanes ? lane : rule.lanes - 1;
+  }
+
+  double value = rule.kind == SortKind::Weight ? pkg.weight : pkg.volume;
+  for (int i = 0; i < rule.lanes - 1; ++i) {
+    if (value < rule.bounds[i])
+      return i;
+  }
+  return rule.lanes - 1;
+}
+
+/**
+ * @class Lane
+ * @brief Bounded FIFO ring of one sorter lane.
+ *
+ * Same Producer-Consumer protocol as `Belt` (empty/full counting semaphores
+ * plus a mutex), but on `SharedState::lanes[index]` and the lane's own
+ * semaphores, so lanes never contend with each other or with the belt.
+ */
+class Lane {
+private:
+  LaneState *state;
+  int index;
+
+  /** @name Synchronization Callbacks
+   * @{ */
+  std::function<void()> wait_empty_fn;
+  std::function<void()> signal_empty_fn;
+  std::function<void()> wait_full_fn;
+  std::function<void()> signal_full_fn;
+  std::function<void()> lock_fn;
+  std::function<void()> unlock_fn;
+  std::function<bool()> wait_failed_fn; /**< See Belt::setWaitFailedCheck. */
+  /** @} */
+
+  bool waitFailed() const { return wait_failed_fn && wait_failed_fn(); }
+
+public:
+  /**
+   * @param shm Shared memory segment.
+   * @param lane Lane index in `[0, MAX_SORTER_LANES)`.
+   * @param wait_empty Waits for a free slot (Sorter).
+   * @param signal_empty Signals a freed slot (Dispatcher).
+   * @param wait_full Waits for a package (Dispatcher).
+   * @param signal_full Signals a new package (Sorter).
+   * @param lock Locks the lane mutex.
+   * @param unlock Unlocks the lane mutex.
+   */
+  Lane(SharedState *shm, int lane, std::function<void()> wait_empty,
+       std::function<void()> signal_empty, std::function<void()> wait_full,
+       std::function<void()> signal_full, std::function<void()> lock,
+       std::function<void()> unlock)
+      : state(&shm->lanes[lane]), index(lane), wait_empty_fn(wait_empty),
+        signal_empty_fn(signal_empty), wait_full_fn(wait_full),
+        signal_full_fn(signal_full), lock_fn(lock), unlock_fn(unlock) {}
+
+  /**
+   * @brief Appends a package, blocking while the ring is full.
+   * @return false if the wait was interrupted (package not stored).
+   */
+  bool push(const Package &pkg) {
+    LockSiteScope site(LockSite::LanePush);
+    wait_empty_fn();
+    if (waitFailed())
+      return false;
+    lock_fn();
+    if (waitFailed()) {
+      signal_empty_fn();
+      return false;
+    }
+
+    if (state->count >= LANE_CAPACITY) {
+      unlock_fn();
+      signal_empty_fn();
+      return false;
+    }
+
+    state->ring[state->tail] = pkg;
+    state->tail = (state->tail + 1) % LANE_CAPACITY;
+    state->count++;
+    state->weight += pkg.weight;
+
+    unlock_fn();
+    signal_full_fn();
+    return true;
+  }
+
+  /**
+   * @brief Removes the oldest package, blocking while the ring is empty.
+   * @return The package, or one with id 0 if the wait was interrupted.
+   */
+  Package pop() {
+    LockSiteScope site(LockSite::LanePop);
+    wait_full_fn();
+    if (waitFailed())
+      return {};
+    lock_fn();
+    if (waitFailed()) {
+      signal_full_fn();
+      return {};
+    }
+
+    if (state->count <= 0) {
+      unlock_fn();
+      signal_full_fn();
+      return {};
+    }
+
+    Package pkg = state->ring[state->head];
+    std::memset(&state->ring[state->head], 0, sizeof(Package));
+    state->head = (state->head + 1) % LANE_CAPACITY;
+    state->count--;
+    state->weight -= pkg.weight;
+
+    unlock_fn();
+    signal_empty_fn();
+    return pkg;
+  }
+
+  /** @brief Lets `push` and `pop` notice a wait interrupted by a signal. */
+  void setWaitFailedCheck(std::function<bool()> check) {
+    wait_failed_fn = std::move(check);
+  }
+
+  /** @brief Lane index. */
+  int id() const { return index; }
+
+  /** @brief Shared state of this lane (ring, dock, counters). */
+  LaneState &shared() { return *state; }
+
+  /** @brief Packages currently in the ring. */
+  int getCount() const { return state->count; }
+};
+
+/**
+ * @class Sorter
+ * @brief Moves packages from the belt into their lanes.
+ */
+class Sorter {
+private:
+  Belt *belt;
+  SharedState *shm;
+  std::vector<Lane *> lanes;
+
+  /** @brief Cleared by `stop()` to leave the service loop. */
+  bool active = true;
+
+  /** @brief Heartbeat target (nullptr = not watched). */
+  ProcessHealth *health = nullptr;
+
+public:
+  /**
+   * @param b Belt to drain.
+   * @param s Shared memory (holds the rule and lane counters).
+   * @param l One Lane per configured lane, indexed by lane number.
+   */
+  Sorter(Belt *b, SharedState *s, std::vector<Lane *> l)
+      : belt(b), shm(s), lanes(std::move(l)) {}
+
+  /** @brief Lane `pkg` belongs to under the shared rule. */
+  int route(const Package &pkg) const {
+    return routeLane(shm->sort_rule, pkg);
+  }
+
+  /**
+   * @brief Pops one package from the belt and stores it in its lane.
+   * * Blocks while the target lane is full; the belt then backs up, which is
+   * exactly the pressure a full lane should exert on the workers.
+   */
+  void processNextPackage() {
+    Package pkg = belt->pop();
+
+    if (pkg.id == 0) {
+      if (shm->running)
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      return;
+    }
+
+    atomicAdd(shm->stats.packages_in_sorter, 1);
+    int lane = route(pkg);
+    bool stored = false;
+
+    while (!stored && shm->running)
+      stored = lanes[lane]->push(pkg);
+
+    if (stored) {
+      atomicAdd(shm->stats.packages_in_sorter, -1);
+      atomicAdd(lanes[lane]->shared().routed, uint64_t{1});
+      spdlog::debug("[sorter] Pkg {} ({:.1f}kg, type {}) -> lane {}", pkg.id,
+                    pkg.weight, (int)pkg.type, lane);
+    }
+  }
+
+  /** @brief Requests the service loop to finish after the current package. */
+  void stop() { active = false; }
+
+  /** @brief Beats `h` once per package routed (see Watchdog.h). */
+  void setHealth(ProcessHealth *h) { health = h; }
+
+  /** @brief Main service loop. */
+  void run() {
+    spdlog::info("[sorter] Routing into {} lanes.", lanes.size());
+    while (active && shm && shm->running) {
+      heartbeat(health);
+      processNextPackage();
+    }
+    spdlog::info("[sorter] Service stopped.");
+  }
+};
@@ -0,0 +1,755 @@
+/**
+ * @file StateStream.h
+ * @brief Belt, dock, fleet and session state streamed to dashboards over a
+ * UNIX domain socket.
+ *
+ * Every update to a `StateRegion` bumps its generation counter in shared
+ * memory (`bumpGeneration`, one atomic add). The publisher (`StateStream`,
+ * a thread of the belt process) reads the four counters every
+ * STATE_STREAM_INTERVAL_MS; only regions whose generation moved are
+ * re-encoded, once per tick, and queued to each subscriber that has not
+ * seen that generation yet. The simulation never waits on the publisher:
+ * state is read with relaxed loads, without semaphores, like the metrics
+ * exporter does.
+ *
+ * **Framing.** All integers are little-endian. A frame is a 12-byte header
+ * followed by `length` payload bytes:
+ *
+ *   u8 type | u8 region | u16 length | u64 generation (or time for Hello and
+ *   Heartbeat, wall clock in ns)
+ *
+ * - Hello (1): u32 protocol version, u8 region count. Sent on connection,
+ *   followed by one Region frame per region (the snapshot).
+ * - Region (2): the full state of one region at `generation`:
+ *   - Belt: u16 items, u16 capacity, u16 in transit, u16 workers,
+ *     u32 packages created, f64 weight [kg];
+ *   - Dock: u8 docks, then per dock u8 present, u8 phase, u8 departure
+ *     reason, i32 truck, u16 load, u16 max load, f64 weight, f64 max weight,
+ *     f64 volume, f64 max volume;
+ *   - Fleet: u32 trucks departed, u32 trucks waiting, u64 empty departures,
+ *     u64 packages loaded, u64 express packages loaded;
+ *   - Sessions: u16 count, then per active session i32 pid, u16 role,
+ *     u8 org, u8 name length, u16 processes, u16 max processes, name.
+ * - Heartbeat (3): no payload; sent after a second without frames.
+ *
+ * Readers skip frame types and regions they do not know.
+ *
+ * **Backpressure.** Each subscriber has a queue of STREAM_QUEUE_BYTES. A
+ * region frame that does not fit is not queued; the region stays pending
+ * for that subscriber and its latest state is sent once the queue drains.
+ * A slow reader thus skips intermediate generations but never receives
+ * stale state, and never delays the others.
+ *
+ * A region read while it is being updated may mix two generations; its
+ * counter has then moved again, so the next tick sends it anew.
+ */
+#pragma once
+
+#include "Shared.h"
+#include "Telemetry.h"
+#include "spdlog/spdlog.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+/** @brief Version carried by the Hello frame. */
+constexpr uint32_t STREAM_PROTOCOL_VERSION = 1;
+
+/** @brief Bytes of a frame header. */
+constexpr size_t STREAM_HEADER_SIZE = 12;
+
+/** @brief Largest frame (the Sessions region with every slot active). */
+constexpr size_t STREAM_FRAME_MAX = 16 * 1024;
+
+/** @brief Bytes queued per subscriber before frames are held back. */
+constexpr size_t STREAM_QUEUE_BYTES = 64 * 1024;
+
+/** @brief Connections served at once; more are refused. */
+constexpr int STREAM_MAX_SUBSCRIBERS = 16;
+
+/** @brief Silence after which a Heartbeat frame is sent. */
+constexpr uint64_t STREAM_HEARTBEAT_NS = 1000000000ULL;
+
+static_assert(STREAM_HEADER_SIZE + 2 + MAX_USERS_SESSIONS * 43 <=
+                  STREAM_FRAME_MAX,
+              "A full Sessions frame fits STREAM_FRAME_MAX");
+
+/**
+ * @enum StreamFrameType
+ * @brief Type byte of a frame header.
+ */
+enum class StreamFrameType : uint8_t {
+  Hello = 1, /**< Start of the stream; a snapshot follows. */
+  Region,    /**< Full state of one StateRegion. */
+  Heartbeat  /**< Publisher alive, nothing changed. */
+};
+
+/**
+ * @struct StreamWriter
+ * @brief Little-endian encoder over a fixed buffer.
+ */
+struct StreamWriter {
+  uint8_t *buf;          /**< Destination. */
+  size_t cap;            /**< Capacity in bytes. */
+  size_t len = 0;        /**< Bytes written. */
+  bool overflow = false; /**< Set if a value did not fit. */
+
+  void put(uint64_t value, size_t n) {
+    if (len + n > cap) {
+      overflow = true;
+      return;
+    }
+    for (size_t i = 0; i < n; ++i)
+      buf[len++] = static_cast<uint8_t>(value >> (8 * i));
+  }
+
+  void u8(uint8_t v) { put(v, 1); }
+  void u16(uint16_t v) { put(v, 2); }
+  void u32(uint32_t v) { put(v, 4); }
+  void u64(uint64_t v) { put(v, 8); }
+
+  void f64(double v) {
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    put(bits, 8);
+  }
+
+  void bytes(const void *data, size_t n) {
+    if (len + n > cap) {
+      overflow = true;
+      return;
+    }
+    std::memcpy(buf + len, data, n);
+    len += n;
+  }
+};
+
+/**
+ * @struct StreamReader
+ * @brief Little-endian decoder over a frame payload.
+ */
+struct StreamReader {
+  const uint8_t *buf; /**< Source. */
+  size_t len;         /**< Bytes available. */
+  size_t pos = 0;     /**< Bytes consumed. */
+  bool ok = true;     /**< Cleared if a read ran past the end. */
+
+  uint64_t get(size_t n) {
+    if (pos + n > len) {
+      ok = false;
+      return 0;
+    }
+    uint64_t value = 0;
+    for (size_t i = 0; i < n; ++i)
+      value |= static_cast<uint64_t>(buf[pos++]) << (8 * i);
+    return value;
+  }
+
+  uint8_t u8() { return static_cast<uint8_t>(get(1)); }
+  uint16_t u16() { return static_cast<uint16_t>(get(2)); }
+  uint32_t u32() { return static_cast<uint32_t>(get(4)); }
+  uint64_t u64() { return get(8); }
+
+  double f64() {
+    uint64_t bits = get(8);
+    double v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+  }
+};
+
+/**
+ * @struct StreamDock
+ * @brief One dock as seen by a subscriber.
+ */
+struct StreamDock {
+  bool present;      /**< A truck is docked. */
+  uint8_t phase;     /**< DockPhase. */
+  uint8_t reason;    /**< DepartureReason. */
+  int32_t truck;     /**< Truck ID (PID). */
+  uint16_t load;     /**< Packages loaded. */
+  uint16_t max_load; /**< Package capacity. */
+  double weight;     /**< Weight loaded [kg]. */
+  double max_weight; /**< Weight capacity [kg]. */
+  double volume;     /**< Volume loaded [m3]. */
+  double max_volume; /**< Volume capacity [m3]. */
+};
+
+/**
+ * @struct StreamSession
+ * @brief One active session as seen by a subscriber.
+ */
+struct StreamSession {
+  int32_t pid;            /**< Session process. */
+  uint16_t role;          /**< UserRole mask. */
+  uint8_t org;            /**< Organization ID. */
+  uint16_t processes;     /**< Running sub-processes. */
+  uint16_t max_processes; /**< Process quota. */
+  char name[32];          /**< Username. */
+};
+
+/**
+ * @struct StreamView
+ * @brief Latest state received by a subscriber (see StreamDecoder).
+ */
+struct StreamView {
+  uint32_t received = 0;                   /**< Bit per region seen. */
+  uint64_t generation[STATE_REGIONS] = {}; /**< Of the last frame. */
+  uint64_t frames = 0;                     /**< Frames applied. */
+  uint64_t heartbeat_ns = 0; /**< Stamp of the last Hello or Heartbeat. */
+
+  /** @name Belt
+   * @{ */
+  uint16_t belt_items = 0;
+  uint16_t belt_capacity = 0;
+  uint16_t belt_in_transit = 0;
+  uint16_t workers = 0;
+  uint32_t packages_created = 0;
+  double belt_weight = 0.0;
+  /** @} */
+
+  /** @name Dock
+   * @{ */
+  int docks = 0;
+  StreamDock dock[MAX_SORTER_LANES] = {};
+  /** @} */
+
+  /** @name Fleet
+   * @{ */
+  uint32_t trucks_completed = 0;
+  uint32_t trucks_waiting = 0;
+  uint64_t departures_empty = 0;
+  uint64_t packages_loaded = 0;
+  uint64_t express_loaded = 0;
+  /** @} */
+
+  /** @name Sessions
+   * @{ */
+  int sessions = 0;
+  StreamSession session[MAX_USERS_SESSIONS] = {};
+  /** @} */
+
+  /** @brief True once a frame of `region` has been applied. */
+  bool has(StateRegion region) const {
+    return received & (1u << static_cast<int>(region));
+  }
+};
+
+/**
+ * @class StreamDecoder
+ * @brief Reassembles frames from a byte stream and applies them to a view.
+ */
+class StreamDecoder {
+private:
+  std::vector<uint8_t> pending; /**< Bytes of an incomplete frame. */
+  StreamView state;
+  bool failed = false;
+
+  bool applyRegion(int region, uint64_t gen, StreamReader &r) {
+    StreamView &v = state;
+    switch (static_cast<StateRegion>(region)) {
+    case StateRegion::Belt:
+      v.belt_items = r.u16();
+      v.belt_capacity = r.u16();
+      v.belt_in_transit = r.u16();
+      v.workers = r.u16();
+      v.packages_created = r.u32();
+      v.belt_weight = r.f64();
+      break;
+    case StateRegion::Dock: {
+      int docks = r.u8();
+      if (docks > MAX_SORTER_LANES)
+        return false;
+      v.docks = docks;
+      for (int i = 0; i < docks; ++i) {
+        StreamDock &d = v.dock[i];
+        d.present = r.u8() != 0;
+        d.phase = r.u8();
+        d.reason = r.u8();
+        d.truck = static_cast<int32_t>(r.u32());
+        d.load = r.u16();
+        d.max_load = r.u16();
+        d.weight = r.f64();
+        d.max_weight = r.f64();
+        d.volume = r.f64();
+        d.max_volume = r.f64();
+      }
+      break;
+    }
+    case StateRegion::Fleet:
+      v.trucks_completed = r.u32();
+      v.trucks_waiting = r.u32();
+      v.departures_empty = r.u64();
+      v.packages_loaded = r.u64();
+      v.express_loaded = r.u64();
+      break;
+    case StateRegion::Sessions: {
+      int count = r.u16();
+      if (count > MAX_USERS_SESSIONS)
+        return false;
+      v.sessions = count;
+      for (int i = 0; i < count && r.ok; ++i) {
+        StreamSession &s = v.session[i];
+        s.pid = static_cast<int32_t>(r.u32());
+        s.role = r.u16();
+        s.org = r.u8();
+        size_t name_len = r.u8();
+        s.processes = r.u16();
+        s.max_processes = r.u16();
+        if (name_len >= sizeof(s.name) || r.pos + name_len > r.len)
+          return false;
+        std::memcpy(s.name, r.buf + r.pos, name_len);
+        s.name[name_len] = '\0';
+        r.pos += name_len;
+      }
+      break;
+    }
+    default:
+      return true; // A region added by a newer publisher.
+    }
+    if (!r.ok)
+      return false;
+    v.received |= 1u << region;
+    v.generation[region] = gen;
+    return true;
+  }
+
+  bool apply(const uint8_t *frame, size_t payload) {
+    uint8_t type = frame[0];
+    uint8_t region = frame[1];
+    StreamReader hdr{frame + 4, 8};
+    uint64_t stamp = hdr.u64();
+    StreamReader r{frame + STREAM_HEADER_SIZE, payload};
+
+    switch (static_cast<StreamFrameType>(type)) {
+    case StreamFrameType::Hello:
+      if (r.u32() != STREAM_PROTOCOL_VERSION)
+        return false;
+      state.heartbeat_ns = stamp;
+      break;
+    case StreamFrameType::Region:
+      if (!applyRegion(region, stamp, r))
+        return false;
+      break;
+    case StreamFrameType::Heartbeat:
+      state.heartbeat_ns = stamp;
+      break;
+    default:
+      return true; // A type added by a newer publisher.
+    }
+    state.frames++;
+    return true;
+  }
+
+public:
+  /**
+   * @brief Consumes bytes read from the socket.
+   * @return Number of frames applied, or -1 on a malformed stream (the
+   * decoder then stays failed).
+   */
+  int feed(const void *data, size_t n) {
+    if (failed)
+      return -1;
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    pending.insert(pending.end(), bytes, bytes + n);
+
+    int applied = 0;
+    size_t pos = 0;
+    while (pending.size() - pos >= STREAM_HEADER_SIZE) {
+      const uint8_t *frame = pending.data() + pos;
+      size_t payload = frame[2] | (static_cast<size_t>(frame[3]) << 8);
+      if (pending.size() - pos < STREAM_HEADER_SIZE + payload)
+        break;
+      if (!apply(frame, payload)) {
+        failed = true;
+        return -1;
+      }
+      pos += STREAM_HEADER_SIZE + payload;
+      applied++;
+    }
+    pending.erase(pending.begin(), pending.begin() + pos);
+    return applied;
+  }
+
+  /** @brief The state received so far. */
+  const StreamView &view() const { return state; }
+};
+
+/**
+ * @class StateStream
+ * @brief Publishes region changes to the subscribers of a UNIX socket.
+ */
+class StateStream {
+private:
+  /**
+   * @struct Subscriber
+   * @brief One connection and what it has been sent.
+   */
+  struct Subscriber {
+    int fd = -1;
+    std::vector<uint8_t> queue;   /**< Unsent bytes from `offset`. */
+    size_t offset = 0;            /**< Bytes of `queue` already sent. */
+    uint64_t sent[STATE_REGIONS]; /**< Generation queued, ~0 = none. */
+    uint64_t last_frame_ns = 0;   /**< When a frame was last queued. */
+  };
+
+  SharedState *shm;
+  int interval_ms;
+  int listen_fd = -1;
+  std::string socket_path;
+  std::vector<Subscriber> subs;
+  std::atomic<int> connected{0}; /**< Live entries of `subs`. */
+
+  /** @name Encoded Regions
+   * Shared by all subscribers; re-encoded when the generation moves.
+   * @{ */
+  uint8_t frame[STATE_REGIONS][STREAM_FRAME_MAX];
+  size_t frame_len[STATE_REGIONS] = {};
+  uint64_t frame_gen[STATE_REGIONS];
+  /** @} */
+
+  uint64_t frames_sent = 0; /**< Frames queued to subscribers. */
+  uint64_t deferred = 0;    /**< Frames held back by backpressure. */
+
+  static constexpr uint64_t NONE = ~uint64_t{0};
+
+  static void header(uint8_t *out, StreamFrameType type, int region,
+                     size_t length, uint64_t stamp) {
+    StreamWriter w{out, STREAM_HEADER_SIZE};
+    w.u8(static_cast<uint8_t>(type));
+    w.u8(static_cast<uint8_t>(region));
+    w.u16(static_cast<uint16_t>(length));
+    w.u64(stamp);
+  }
+
+  static uint16_t clampU16(int v) {
+    return static_cast<uint16_t>(v < 0 ? 0 : v > 0xffff ? 0xffff : v);
+  }
+
+  static void encodeDock(StreamWriter &w, const TruckState &d) {
+    w.u8(atomicLoad(d.is_present) ? 1 : 0);
+    w.u8(static_cast<uint8_t>(atomicLoad(d.phase)));
+    w.u8(static_cast<uint8_t>(atomicLoad(d.departure_reason)));
+    w.u32(static_cast<uint32_t>(atomicLoad(d.id)));
+    w.u16(clampU16(atomicLoad(d.current_load)));
+    w.u16(clampU16(atomicLoad(d.max_load)));
+    w.f64(atomicLoad(d.current_weight));
+    w.f64(atomicLoad(d.max_weight));
+    w.f64(atomicLoad(d.current_volume));
+    w.f64(atomicLoad(d.max_volume));
+  }
+
+  void queueFrame(Subscriber &s, const uint8_t *data, size_t n) {
+    s.queue.insert(s.queue.end(), data, data + n);
+    s.last_frame_ns = monotonicNowNs();
+    frames_sent++;
+  }
+
+  /** @brief Sends queued bytes without blocking; false if the peer left. */
+  static bool flush(Subscriber &s) {
+    while (s.offset < s.queue.size()) {
+      ssize_t n = send(s.fd, s.queue.data() + s.offset,
+                       s.queue.size() - s.offset, MSG_NOSIGNAL | MSG_DONTWAIT);
+      if (n < 0) {
+        if (errno == EINTR)
+          continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+          break;
+        return false;
+      }
+      s.offset += static_cast<size_t>(n);
+    }
+    // Keeps the capacity reserved at connection: no allocation.
+    s.queue.erase(s.queue.begin(), s.queue.begin() + s.offset);
+    s.offset = 0;
+    return true;
+  }
+
+  void drop(Subscriber &s) {
+    close(s.fd);
+    s.fd = -1;
+    connected.fetch_sub(1);
+    spdlog::info("[stream] Subscriber left ({} remaining).", subscribers());
+  }
+
+  void acceptPending() {
+    for (;;) {
+      int fd = accept4(listen_fd, nullptr, nullptr,
+                       SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd == -1)
+        return;
+      if (subscribers() >= STREAM_MAX_SUBSCRIBERS) {
+        spdlog::warn("[stream] Refused a subscriber: {} already connected.",
+                     STREAM_MAX_SUBSCRIBERS);
+        close(fd);
+        continue;
+      }
+      addSubscriber(fd);
+    }
+  }
+
+public:
+  /**
+   * @param shared_state Shared Memory segment.
+   * @param interval Polling period of the generation counters [ms].
+   */
+  explicit StateStream(SharedState *shared_state, int interval = 2)
+      : shm(shared_state), interval_ms(interval > 0 ? interval : 1) {
+    for (int r = 0; r < STATE_REGIONS; ++r)
+      frame_gen[r] = NONE;
+    subs.reserve(STREAM_MAX_SUBSCRIBERS);
+  }
+
+  StateStream(const StateStream &) = delete;
+  StateStream &operator=(const StateStream &) = delete;
+
+  /** @brief Disconnects everyone and removes the socket file. */
+  ~StateStream() {
+    for (Subscriber &s : subs)
+      if (s.fd != -1)
+        close(s.fd);
+    if (listen_fd != -1) {
+      close(listen_fd);
+      unlink(socket_path.c_str());
+    }
+  }
+
+  /**
+   * @brief Starts listening on a UNIX domain socket.
+   * @param path Filesystem path of the socket (replaced if stale).
+   * @return true on success.
+   */
+  bool listen(const std::string &path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+      spdlog::error("[stream] Socket path too long: {}", path);
+      return false;
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1 ||
+        bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == -1 ||
+        ::listen(fd, STREAM_MAX_SUBSCRIBERS) == -1) {
+      spdlog::error("[stream] Cannot listen on {}: {}", path,
+                    std::strerror(errno));
+      if (fd != -1)
+        close(fd);
+      return false;
+    }
+    listen_fd = fd;
+    socket_path = path;
+    spdlog::info("[stream] Publishing state on unix:{} every {} ms.", path,
+                 interval_ms);
+    return true;
+  }
+
+  /**
+   * @brief Adds a connected socket as a subscriber and queues its Hello;
+   * the snapshot follows on the next pump().
+   * @param fd Non-blocking stream socket, owned from now on.
+   */
+  void addSubscriber(int fd) {
+    Subscriber s;
+    s.fd = fd;
+    s.queue.reserve(STREAM_QUEUE_BYTES);
+    for (int r = 0; r < STATE_REGIONS; ++r)
+      s.sent[r] = NONE;
+
+    uint8_t hello[STREAM_HEADER_SIZE + 5];
+    StreamWriter w{hello + STREAM_HEADER_SIZE, 5};
+    w.u32(STREAM_PROTOCOL_VERSION);
+    w.u8(static_cast<uint8_t>(STATE_REGIONS));
+    header(hello, StreamFrameType::Hello, 0, w.len, realtimeNowNs());
+    queueFrame(s, hello, sizeof(hello));
+    subs.push_back(std::move(s));
+    connected.fetch_add(1);
+    spdlog::info("[stream] Subscriber joined ({} of {}).", subscribers(),
+                 STREAM_MAX_SUBSCRIBERS);
+  }
+
+  /**
+   * @brief Encodes the current state of a region as one Region frame.
+   * @param out At least STREAM_FRAME_MAX bytes.
+   * @return Frame length.
+   */
+  size_t encodeRegion(StateRegion region, uint64_t gen, uint8_t *out) const {
+    StreamWriter w{out + STREAM_HEADER_SIZE,
+                   STREAM_FRAME_MAX - STREAM_HEADER_SIZE};
+    switch (region) {
+    case StateRegion::Belt:
+      w.u16(clampU16(atomicLoad(shm->current_items_count)));
+      w.u16(clampU16(MAX_BELT_CAPACITY_K));
+      w.u16(clampU16(atomicLoad(shm->transit.in_transit)));
+      w.u16(clampU16(atomicLoad(shm->current_workers_count)));
+      w.u32(static_cast<uint32_t>(atomicLoad(shm->total_packages_created)));
+      w.f64(atomicLoad(shm->current_belt_weight));
+      break;
+    case StateRegion::Dock: {
+      int docks = atomicLoad(shm->lane_count) > 0 ? shm->lane_count : 1;
+      if (docks > MAX_SORTER_LANES)
+        docks = MAX_SORTER_LANES;
+      w.u8(static_cast<uint8_t>(docks));
+      for (int i = 0; i < docks; ++i)
+        encodeDock(w, shm->lane_count > 0 ? shm->lanes[i].dock
+                                          : shm->dock_truck);
+      break;
+    }
+    case StateRegion::Fleet: {
+      const WarehouseStats &st = shm->stats;
+      int waiting = atomicLoad(shm->trucks_waiting);
+      w.u32(static_cast<uint32_t>(atomicLoad(shm->trucks_completed)));
+      w.u32(static_cast<uint32_t>(waiting > 0 ? waiting : 0));
+      w.u64(atomicLoad(st.departures_empty));
+      w.u64(atomicLoad(st.packages_loaded));
+      w.u64(atomicLoad(st.express_loaded));
+      break;
+    }
+    case StateRegion::Sessions: {
+      size_t count_at = w.len;
+      w.u16(0);
+      uint16_t count = 0;
+      for (int i = 0; i < MAX_USERS_SESSIONS; ++i) {
+        const UserSession &u = shm->users[i];
+        if (!atomicLoad(u.active))
+          continue;
+        size_t name_len = strnlen(u.username, sizeof(u.username) - 1);
+        w.u32(static_cast<uint32_t>(atomicLoad(u.session_pid)));
+        w.u16(static_cast<uint16_t>(atomicLoad(u.role)));
+        w.u8(static_cast<uint8_t>(atomicLoad(u.orgId)));
+        w.u8(static_cast<uint8_t>(name_len));
+        w.u16(clampU16(atomicLoad(u.current_processes)));
+        w.u16(clampU16(atomicLoad(u.max_processes)));
+        w.bytes(u.username, name_len);
+        count++;
+      }
+      StreamWriter patch{w.buf + count_at, 2};
+      patch.u16(count);
+      break;
+    }
+    default:
+      break;
+    }
+    header(out, StreamFrameType::Region, static_cast<int>(region), w.len,
+           gen);
+    return STREAM_HEADER_SIZE + w.len;
+  }
+
+  /**
+   * @brief One publishing step: encodes the regions that changed, queues
+   * them to the subscribers missing them and sends what the sockets take.
+   */
+  void pump() {
+    if (subs.empty())
+      return;
+    uint64_t now = monotonicNowNs();
+
+    for (int r = 0; r < STATE_REGIONS; ++r) {
+      uint64_t gen =
+          __atomic_load_n(&shm->generations[r].value, __ATOMIC_ACQUIRE);
+      if (gen == frame_gen[r])
+        continue;
+      bool wanted = false;
+      for (const Subscriber &s : subs)
+        wanted = wanted || s.sent[r] != gen;
+      if (!wanted)
+        continue;
+      frame_len[r] = encodeRegion(static_cast<StateRegion>(r), gen, frame[r]);
+      frame_gen[r] = gen;
+    }
+
+    for (Subscriber &s : subs) {
+      for (int r = 0; r < STATE_REGIONS; ++r) {
+        if (frame_gen[r] == NONE || s.sent[r] == frame_gen[r])
+          continue;
+        if (s.queue.size() + frame_len[r] > STREAM_QUEUE_BYTES) {
+          deferred++;
+          continue;
+        }
+        queueFrame(s, frame[r], frame_len[r]);
+        s.sent[r] = frame_gen[r];
+      }
+      if (s.queue.empty() && now - s.last_frame_ns >= STREAM_HEARTBEAT_NS) {
+        uint8_t beat[STREAM_HEADER_SIZE];
+        header(beat, StreamFrameType::Heartbeat, 0, 0, realtimeNowNs());
+        queueFrame(s, beat, sizeof(beat));
+      }
+      if (!flush(s))
+        drop(s);
+    }
+    removeDropped();
+  }
+
+  /** @brief Forgets subscribers whose connection was closed. */
+  void removeDropped() {
+    size_t kept = 0;
+    for (size_t i = 0; i < subs.size(); ++i) {
+      if (subs[i].fd == -1)
+        continue;
+      if (kept != i)
+        subs[kept] = std::move(subs[i]);
+      kept++;
+    }
+    subs.resize(kept);
+  }
+
+  /** @brief Connected subscribers (readable from any thread). */
+  int subscribers() const { return connected.load(); }
+
+  /** @brief Frames queued to subscribers so far. */
+  uint64_t framesSent() const { return frames_sent; }
+
+  /** @brief Region frames held back because a queue was full. */
+  uint64_t framesDeferred() const { return deferred; }
+
+  /**
+   * @brief Publisher loop (meant for a dedicated thread).
+   *
+   * Sleeps in poll() on the listener while nobody is connected; with
+   * subscribers it pumps every `interval_ms`, or earlier when a socket
+   * becomes writable again. Input from subscribers is read and ignored.
+   *
+   * @param stop Flag owned by the hosting process.
+   */
+  void run(const std::atomic<bool> &stop) {
+    struct pollfd fds[STREAM_MAX_SUBSCRIBERS + 1];
+    char discard[256];
+
+    while (!stop.load() && shm && shm->running) {
+      int n = 0;
+      if (listen_fd != -1)
+        fds[n++] = {listen_fd, POLLIN, 0};
+      for (const Subscriber &s : subs) {
+        short events = POLLIN;
+        if (!s.queue.empty())
+          events |= POLLOUT;
+        fds[n++] = {s.fd, events, 0};
+      }
+
+      int timeout = subs.empty() ? 100 : interval_ms;
+      if (poll(fds, n, timeout) > 0) {
+        int first = listen_fd != -1 ? 1 : 0;
+        for (int i = first; i < n; ++i) {
+          Subscriber &s = subs[i - first];
+          if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+            continue;
+          ssize_t got = recv(s.fd, discard, sizeof(discard), MSG_DONTWAIT);
+          if (got == 0 || (got < 0 && errno != EAGAIN && errno != EINTR))
+            drop(s);
+        }
+        removeDropped();
+        if (first && (fds[0].revents & POLLIN))
+          acceptPending();
+      }
+      pump();
+    }
+  }
+};
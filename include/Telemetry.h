@@ -0,0 +1,169 @@
+/**
+ * @file Telemetry.h
+ * @brief Lock-free counter helpers and clocks used by the instrumentation.
+ *
+ * Statistics live in plain fields of `SharedState` so the segment stays a
+ * trivially-copyable POD (tests `memset` it and keep it on the stack). These
+ * helpers wrap the compiler `__atomic` builtins so that several processes can
+ * update and read the counters without touching any semaphore.
+ */
+#pragma once
+
+#include "Shared.h"
+#include <cstdint>
+#include <ctime>
+
+/** @name Shared Counter Primitives
+ * Relaxed atomic operations on shared memory fields. Relaxed ordering is
+ * enough: counters are only ever aggregated, never used to publish data.
+ * @{ */
+template <typename T> inline T atomicLoad(const T &ref) {
+  T value;
+  __atomic_load(&ref, &value, __ATOMIC_RELAXED);
+  return value;
+}
+
+template <typename T> inline void atomicStore(T &ref, T value) {
+  __atomic_store(&ref, &value, __ATOMIC_RELAXED);
+}
+
+template <typename T> inline T atomicAdd(T &ref, T delta) {
+  return __atomic_fetch_add(&ref, delta, __ATOMIC_RELAXED);
+}
+
+/** @brief Raises `ref` to `value` if it is larger (CAS loop). */
+template <typename T> inline void atomicMax(T &ref, T value) {
+  T current = __atomic_load_n(&ref, __ATOMIC_RELAXED);
+  while (value > current &&
+         !__atomic_compare_exchange_n(&ref, &current, value, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+  }
+}
+/** @} */
+
+/**
+ * @brief Reads the system-wide monotonic clock.
+ * * CLOCK_MONOTONIC is shared by every process on the host, so timestamps
+ * taken by a Worker can be compared with ones taken by the Dispatcher. The
+ * call is served by the vDSO and does not enter the kernel.
+ * @return Nanoseconds since an arbitrary (boot-time) epoch.
+ */
+inline uint64_t monotonicNowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL +
+         static_cast<uint64_t>(ts.tv_nsec);
+}
+
+/**
+ * @brief Reads the wall clock, for records meant to outlive the run.
+ * @return Nanoseconds since the Unix epoch.
+ */
+inline uint64_t realtimeNowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL +
+         static_cast<uint64_t>(ts.tv_nsec);
+}
+
+/**
+ * @brief Maps a latency to its histogram bucket.
+ * * Buckets are powers of two in milliseconds (see `latencyBucketBoundMs`)
+ * with inclusive upper bounds, as Prometheus `le` labels are: bucket `i`
+ * holds `(2^(i-1), 2^i]` ms, so exactly 2^k ms lands in the `le = 2^k`
+ * bucket. The index is ceil(log2(ms)), a single count-leading-zeros
+ * instruction on `ms - 1`.
+ * @param ns Observed latency in nanoseconds.
+ * @return Bucket index in `[0, LATENCY_BUCKETS)`.
+ */
+inline int latencyBucketIndex(uint64_t ns) {
+  uint64_t ms = (ns + 999999ULL) / 1000000ULL;
+  if (ms <= 1)
+    return 0;
+  int idx = 64 - __builtin_clzll(ms - 1);
+  return idx < LATENCY_BUCKETS - 1 ? idx : LATENCY_BUCKETS - 1;
+}
+
+/**
+ * @brief Upper bound (inclusive, in ms) of a latency bucket.
+ * @return Bound in milliseconds, or -1 for the overflow (+Inf) bucket.
+ */
+inline constexpr long long latencyBucketBoundMs(int idx) {
+  return idx >= LATENCY_BUCKETS - 1 ? -1 : (1LL << idx);
+}
+
+/**
+ * @brief Records a belt-to-truck latency observation.
+ * @param stats Shared statistics block.
+ * @param ns Latency in nanoseconds.
+ */
+inline void recordLatency(WarehouseStats &stats, uint64_t ns) {
+  atomicAdd(stats.latency_buckets[latencyBucketIndex(ns)], uint64_t{1});
+  atomicAdd(stats.latency_sum_ns, ns);
+  atomicAdd(stats.latency_count, uint64_t{1});
+}
+
+/**
+ * @brief Records a belt package loaded into a truck against its deadline.
+ * * Late packages add their lateness to the tardiness histogram, which uses
+ * the latency buckets.
+ * @param stats Shared statistics block.
+ * @param pkg The loaded package.
+ * @param now_ns Monotonic time of the load.
+ */
+inline void recordDeadline(WarehouseStats &stats, const Package &pkg,
+                           uint64_t now_ns) {
+  int tier = static_cast<int>(pkg.tier);
+  if (tier >= SLA_TIERS)
+    tier = 0;
+  atomicAdd(stats.sla_loaded[tier], uint64_t{1});
+  if (pkg.deadline_ns == 0 || now_ns <= pkg.deadline_ns)
+    return;
+  uint64_t late = now_ns - pkg.deadline_ns;
+  atomicAdd(stats.sla_missed[tier], uint64_t{1});
+  atomicAdd(stats.tardiness_buckets[latencyBucketIndex(late)], uint64_t{1});
+  atomicAdd(stats.tardiness_sum_ns, late);
+}
+
+/**
+ * @brief Estimates a percentile from a histogram in the latency buckets.
+ * * Interpolates linearly inside the bucket that contains the requested
+ * rank. Observations in the +Inf bucket are reported as the last finite
+ * bound, so the estimate is a lower bound in that case.
+ * @param buckets Shared histogram (e.g. `latency_buckets`).
+ * @param q Quantile in `[0, 1]` (e.g. 0.99).
+ * @return Estimated value in milliseconds, or 0 with no observations.
+ */
+inline double
+histogramPercentileMs(const uint64_t (&buckets)[LATENCY_BUCKETS], double q) {
+  uint64_t counts[LATENCY_BUCKETS];
+  uint64_t total = 0;
+  for (int i = 0; i < LATENCY_BUCKETS; ++i) {
+    counts[i] = atomicLoad(buckets[i]);
+    total += counts[i];
+  }
+  if (total == 0)
+    return 0.0;
+
+  double rank = q * static_cast<double>(total);
+  uint64_t seen = 0;
+  for (int i = 0; i < LATENCY_BUCKETS; ++i) {
+    if (counts[i] == 0 || seen + counts[i] < rank) {
+      seen += counts[i];
+      continue;
+    }
+    double lower =
+        i == 0 ? 0.0 : static_cast<double>(latencyBucketBoundMs(i - 1));
+    long long bound = latencyBucketBoundMs(i);
+    if (bound < 0)
+      return lower;
+    double fraction = (rank - static_cast<double>(seen)) / counts[i];
+    return lower + fraction * (static_cast<double>(bound) - lower);
+  }
+  return static_cast<double>(latencyBucketBoundMs(LATENCY_BUCKETS - 2));
+}
+
+/** @brief Belt-to-truck latency percentile (see histogramPercentileMs). */
+inline double latencyPercentileMs(const WarehouseStats &stats, double q) {
+  return histogramPercentileMs(stats.latency_buckets, q);
+}
@@ -0,0 +1,473 @@
+/**
+ * @file TimeSeriesSampler.h
+ * @brief High-frequency sampler of warehouse gauges into a delta-encoded file.
+ *
+ * The sampler runs as a thread of the belt process and periodically takes a
+ * snapshot of `SharedState` with relaxed atomic loads (see Telemetry.h). It
+ * never takes a semaphore, so producers and consumers pay nothing for it no
+ * matter how fast it samples. The fields of one snapshot are individually
+ * consistent but may be a few nanoseconds apart from each other.
+ *
+ * Every gauge is stored as an integer (weights in grams, volumes in cm3) so
+ * the encoding is lossless. A frame holds the timestamp and all channels as
+ * zigzag varints of their difference to the previous frame; the timestamp is
+ * additionally taken relative to the nominal interval, so a steady 1 kHz
+ * stream costs roughly one byte per channel per sample.
+ *
+ * File layout (native endianness):
+ * @code
+ *   SeriesFileHeader
+ *   { varint(zigzag(dt - interval)) varint(zigzag(dv))[SERIES_CHANNELS] } *
+ * @endcode
+ *
+ * Frames are buffered and written whole, so a reader never sees half a frame
+ * unless the disk fills up; a truncated tail is ignored.
+ */
+#pragma once
+
+#include "Shared.h"
+#include "Telemetry.h"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/** @name Series Layout
+ * @{ */
+constexpr uint32_t SERIES_MAGIC = 0x53544857; /**< "WHTS". */
+constexpr uint32_t SERIES_VERSION = 1;
+constexpr int SERIES_MAX_HZ = 1000;            /**< Upper sampling rate. */
+constexpr size_t SERIES_BUFFER_BYTES = 1 << 16; /**< Write batch size. */
+/** @} */
+
+/**
+ * @enum SeriesChannel
+ * @brief Gauges and counters captured in every sample, in file order.
+ */
+enum SeriesChannel : int {
+  SER_BELT_COUNT = 0,  /**< Packages on the belt. */
+  SER_BELT_WEIGHT_G,   /**< Belt weight [g]. */
+  SER_WORKERS,         /**< Registered workers. */
+  SER_IN_DISPATCH,     /**< Popped by a dispatcher, not yet loaded. */
+  SER_DOCK_PRESENT,    /**< Docked trucks (1 per lane at most). */
+  SER_DOCK_LOAD,       /**< Packages in the docked truck. */
+  SER_DOCK_WEIGHT_G,   /**< Docked truck payload [g]. */
+  SER_DOCK_VOLUME_CM3, /**< Docked truck payload [cm3]. */
+  SER_DOCK_FILL_PM,    /**< Binding-limit fill (W, V or K) [per mille]. */
+  SER_TRUCKS_QUEUED,   /**< Trucks waiting for the dock. */
+  SER_CREATED,         /**< Cumulative packages created. */
+  SER_LOADED,          /**< Cumulative belt packages loaded. */
+  SER_EXPRESS_LOADED,  /**< Cumulative express packages loaded. */
+  SER_DEPARTED,        /**< Cumulative truck departures. */
+  SERIES_CHANNELS
+};
+
+/** @brief CSV column name of every channel. */
+inline const char *seriesChannelName(int channel) {
+  static const char *names[SERIES_CHANNELS] = {
+      "belt_count",    "belt_weight_g",   "workers",
+      "in_dispatch",   "dock_present",    "dock_load",
+      "dock_weight_g", "dock_volume_cm3", "dock_fill_permille",
+      "trucks_queued", "created",         "loaded",
+      "express_loaded", "departed"};
+  return channel >= 0 && channel < SERIES_CHANNELS ? names[channel] : "?";
+}
+
+/**
+ * @struct SeriesFileHeader
+ * @brief First bytes of a series file.
+ */
+struct SeriesFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t channels;
+  uint32_t reserved;
+  uint64_t interval_ns; /**< Nominal sampling interval. */
+  uint64_t start_ns;    /**< CLOCK_REALTIME when sampling started. */
+};
+
+/**
+ * @struct SeriesSample
+ * @brief One decoded frame.
+ */
+struct SeriesSample {
+  uint64_t timestamp_ns;            /**< CLOCK_REALTIME of the snapshot. */
+  int64_t values[SERIES_CHANNELS]; /**< Indexed by SeriesChannel. */
+};
+
+/** @name Varint Coding
+ * @{ */
+inline uint64_t zigzagEncode(int64_t v) {
+  return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t v) {
+  return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+/** @brief Writes `v` as LEB128; returns the number of bytes (1-10). */
+inline size_t putVarint(uint8_t *out, uint64_t v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    out[n++] = static_cast<uint8_t>(v) | 0x80;
+    v >>= 7;
+  }
+  out[n++] = static_cast<uint8_t>(v);
+  return n;
+}
+
+/** @brief Reads a LEB128 value; returns false on a truncated input. */
+inline bool getVarint(const uint8_t *&p, const uint8_t *end, uint64_t &v) {
+  v = 0;
+  for (int shift = 0; shift < 64 && p < end; shift += 7) {
+    uint8_t byte = *p++;
+    v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+/** @} */
+
+/**
+ * @class TimeSeriesSampler
+ * @brief Writes periodic SharedState snapshots to a series file.
+ */
+class TimeSeriesSampler {
+private:
+  static constexpr size_t MAX_FRAME_BYTES = 10 * (SERIES_CHANNELS + 1);
+
+  SharedState *shm;
+  int fd = -1;
+  uint64_t interval_ns;
+  uint64_t prev_ts;
+  int64_t prev[SERIES_CHANNELS] = {};
+  uint8_t buffer[SERIES_BUFFER_BYTES];
+  size_t used = 0;
+  uint64_t sample_count = 0;
+  uint64_t missed_ticks = 0;
+
+public:
+  /**
+   * @brief Creates (truncating) the series file at `path`.
+   * @param s Shared state to sample.
+   * @param path Output file.
+   * @param hz Sampling rate, clamped to [1, SERIES_MAX_HZ].
+   */
+  TimeSeriesSampler(SharedState *s, const std::string &path, int hz) : shm(s) {
+    if (hz < 1)
+      hz = 1;
+    if (hz > SERIES_MAX_HZ)
+      hz = SERIES_MAX_HZ;
+    interval_ns = 1000000000ULL / hz;
+    prev_ts = realtimeNowNs();
+
+    fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+      spdlog::error("[sampler] Cannot open {}: {}", path, std::strerror(errno));
+      return;
+    }
+
+    SeriesFileHeader header = {SERIES_MAGIC, SERIES_VERSION, SERIES_CHANNELS,
+                               0,            interval_ns,    prev_ts};
+    if (write(fd, &header, sizeof(header)) != sizeof(header)) {
+      spdlog::error("[sampler] Cannot write header: {}", std::strerror(errno));
+      close(fd);
+      fd = -1;
+    }
+  }
+
+  ~TimeSeriesSampler() {
+    flush();
+    if (fd != -1)
+      close(fd);
+  }
+
+  TimeSeriesSampler(const TimeSeriesSampler &) = delete;
+  TimeSeriesSampler &operator=(const TimeSeriesSampler &) = delete;
+
+  /** @brief True if the file could be created. */
+  bool isOpen() const { return fd != -1; }
+
+  /** @brief Nominal interval between samples. */
+  uint64_t intervalNs() const { return interval_ns; }
+
+  /** @brief Samples recorded so far. */
+  uint64_t samples() const { return sample_count; }
+
+  /** @brief Ticks skipped because a sample overran its deadline. */
+  uint64_t missed() const { return missed_ticks; }
+
+  /**
+   * @brief Reads every channel from shared memory without locking.
+   * Dock channels sum over the lane docks when a sorter is configured; the
+   * fill is that of the fullest docked truck.
+   */
+  static SeriesSample snapshot(SharedState *shm) {
+    SeriesSample s;
+    s.timestamp_ns = realtimeNowNs();
+    int64_t *v = s.values;
+
+    v[SER_BELT_COUNT] = atomicLoad(shm->current_items_count);
+    v[SER_BELT_WEIGHT_G] =
+        std::llround(atomicLoad(shm->current_belt_weight) * 1e3);
+    v[SER_WORKERS] = atomicLoad(shm->current_workers_count);
+    v[SER_IN_DISPATCH] = atomicLoad(shm->stats.packages_in_dispatch);
+
+    int docked = 0, load = 0;
+    double weight = 0.0, volume = 0.0, fill = 0.0;
+    for (int i = 0; i < dockCount(shm); ++i) {
+      const TruckState &dock = dockAt(shm, i);
+      if (!atomicLoad(dock.is_present))
+        continue;
+      int max_load = atomicLoad(dock.max_load);
+      double max_weight = atomicLoad(dock.max_weight);
+      double max_volume = atomicLoad(dock.max_volume);
+      int l = atomicLoad(dock.current_load);
+      double w = atomicLoad(dock.current_weight);
+      double vol = atomicLoad(dock.current_volume);
+
+      docked++;
+      load += l;
+      weight += w;
+      volume += vol;
+      if (max_load > 0)
+        fill = std::max(fill, static_cast<double>(l) / max_load);
+      if (max_weight > 0)
+        fill = std::max(fill, w / max_weight);
+      if (max_volume > 0)
+        fill = std::max(fill, vol / max_volume);
+    }
+
+    v[SER_DOCK_PRESENT] = docked;
+    v[SER_DOCK_LOAD] = load;
+    v[SER_DOCK_WEIGHT_G] = std::llround(weight * 1e3);
+    v[SER_DOCK_VOLUME_CM3] = std::llround(volume * 1e6);
+    v[SER_DOCK_FILL_PM] = std::llround(fill * 1e3);
+    v[SER_TRUCKS_QUEUED] = atomicLoad(shm->trucks_waiting);
+    v[SER_CREATED] = atomicLoad(shm->total_packages_created);
+    v[SER_LOADED] =
+        static_cast<int64_t>(atomicLoad(shm->stats.packages_loaded));
+    v[SER_EXPRESS_LOADED] =
+        static_cast<int64_t>(atomicLoad(shm->stats.express_loaded));
+    v[SER_DEPARTED] = atomicLoad(shm->trucks_completed);
+    return s;
+  }
+
+  /**
+   * @brief Encodes one sample; writes the buffer out when it is full.
+   */
+  void record(const SeriesSample &s) {
+    if (fd == -1)
+      return;
+    if (used + MAX_FRAME_BYTES > sizeof(buffer))
+      flush();
+
+    int64_t dt = static_cast<int64_t>(s.timestamp_ns - prev_ts) -
+                 static_cast<int64_t>(interval_ns);
+    used += putVarint(buffer + used, zigzagEncode(dt));
+    for (int c = 0; c < SERIES_CHANNELS; ++c) {
+      used += putVarint(buffer + used, zigzagEncode(s.values[c] - prev[c]));
+      prev[c] = s.values[c];
+    }
+    prev_ts = s.timestamp_ns;
+    sample_count++;
+  }
+
+  /**
+   * @brief Writes the buffered frames.
+   * @return false if the write failed (the frames are dropped).
+   */
+  bool flush() {
+    if (fd == -1 || used == 0)
+      return true;
+    ssize_t written = write(fd, buffer, used);
+    size_t expected = used;
+    used = 0;
+    if (written != static_cast<ssize_t>(expected)) {
+      spdlog::error("[sampler] Short write ({} of {} bytes)", written,
+                    expected);
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Samples at the configured rate until `stop` is set.
+   * * Deadlines are absolute on CLOCK_MONOTONIC, so the rate does not drift
+   * with the cost of a sample. If the thread falls behind by more than one
+   * interval, the missed ticks are counted and skipped instead of replayed
+   * in a burst. Buffered frames are written at least once per second.
+   */
+  void run(const std::atomic<bool> &stop) {
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    uint64_t deadline =
+        static_cast<uint64_t>(next.tv_sec) * 1000000000ULL + next.tv_nsec;
+    uint64_t last_flush = deadline;
+
+    while (!stop.load()) {
+      record(snapshot(shm));
+
+      deadline += interval_ns;
+      uint64_t now = monotonicNowNs();
+      if (now > deadline + interval_ns) {
+        uint64_t behind = (now - deadline) / interval_ns;
+        missed_ticks += behind;
+        deadline += behind * interval_ns;
+      }
+      if (now - last_flush >= 1000000000ULL) {
+        flush();
+        last_flush = now;
+      }
+
+      next.tv_sec = static_cast<time_t>(deadline / 1000000000ULL);
+      next.tv_nsec = static_cast<long>(deadline % 1000000000ULL);
+      while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr) ==
+             EINTR) {
+        if (stop.load())
+          break;
+      }
+    }
+    flush();
+  }
+};
+
+/**
+ * @class SeriesReader
+ * @brief Read-only, memory-mapped decoder of a series file.
+ */
+class SeriesReader {
+private:
+  const uint8_t *base = nullptr;
+  size_t size = 0;
+
+public:
+  explicit SeriesReader(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+      return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 &&
+        st.st_size >= static_cast<off_t>(sizeof(SeriesFileHeader))) {
+      void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      if (p != MAP_FAILED) {
+        base = static_cast<const uint8_t *>(p);
+        size = st.st_size;
+      }
+    }
+    close(fd);
+
+    if (base) {
+      const SeriesFileHeader &h = header();
+      if (h.magic != SERIES_MAGIC || h.version != SERIES_VERSION ||
+          h.channels != SERIES_CHANNELS || h.interval_ns == 0) {
+        munmap(const_cast<uint8_t *>(base), size);
+        base = nullptr;
+        size = 0;
+      }
+    }
+  }
+
+  ~SeriesReader() {
+    if (base)
+      munmap(const_cast<uint8_t *>(base), size);
+  }
+
+  SeriesReader(const SeriesReader &) = delete;
+  SeriesReader &operator=(const SeriesReader &) = delete;
+
+  /** @brief True if the file exists and has a valid header. */
+  bool valid() const { return base != nullptr; }
+
+  /** @brief File header; only meaningful when `valid()`. */
+  const SeriesFileHeader &header() const {
+    return *reinterpret_cast<const SeriesFileHeader *>(base);
+  }
+
+  /** @brief Bytes of encoded frames. */
+  size_t payloadBytes() const {
+    return base ? size - sizeof(SeriesFileHeader) : 0;
+  }
+
+  /**
+   * @brief Decodes every complete frame in order.
+   * @param fn Callable taking `(const SeriesSample &)`.
+   * @return Number of frames decoded.
+   */
+  template <typename Fn> uint64_t forEach(Fn fn) const {
+    if (!base)
+      return 0;
+    const SeriesFileHeader &h = header();
+    const uint8_t *p = base + sizeof(SeriesFileHeader);
+    const uint8_t *end = base + size;
+
+    SeriesSample s = {};
+    s.timestamp_ns = h.start_ns;
+    uint64_t count = 0;
+    uint64_t raw;
+
+    while (p < end) {
+      if (!getVarint(p, end, raw))
+        break;
+      uint64_t ts = s.timestamp_ns + h.interval_ns +
+                    static_cast<uint64_t>(zigzagDecode(raw));
+      int64_t values[SERIES_CHANNELS];
+      bool complete = true;
+      for (int c = 0; c < SERIES_CHANNELS && complete; ++c) {
+        complete = getVarint(p, end, raw);
+        values[c] = s.values[c] + zigzagDecode(raw);
+      }
+      if (!complete)
+        break;
+
+      s.timestamp_ns = ts;
+      std::memcpy(s.values, values, sizeof(values));
+      fn(s);
+      count++;
+    }
+    return count;
+  }
+
+  /**
+   * @brief Writes the series as CSV with per-row throughput columns.
+   * * Cumulative counters are kept as-is; `created_per_s`, `loaded_per_s`
+   * and `departed_per_s` are their rates since the previous row.
+   * @return Number of rows written.
+   */
+  uint64_t exportCsv(FILE *out) const {
+    std::fprintf(out, "time_s");
+    for (int c = 0; c < SERIES_CHANNELS; ++c)
+      std::fprintf(out, ",%s", seriesChannelName(c));
+    std::fprintf(out, ",created_per_s,loaded_per_s,departed_per_s\n");
+
+    bool first = true;
+    SeriesSample prev = {};
+    uint64_t start = base ? header().start_ns : 0;
+
+    return forEach([&](const SeriesSample &s) {
+      std::fprintf(out, "%.6f", (s.timestamp_ns - start) / 1e9);
+      for (int c = 0; c < SERIES_CHANNELS; ++c)
+        std::fprintf(out, ",%lld", static_cast<long long>(s.values[c]));
+
+      double dt = first ? 0.0 : (s.timestamp_ns - prev.timestamp_ns) / 1e9;
+      auto rate = [&](int c) {
+        return dt > 0 ? (s.values[c] - prev.values[c]) / dt : 0.0;
+      };
+      std::fprintf(out, ",%.1f,%.1f,%.2f\n", rate(SER_CREATED),
+                   rate(SER_LOADED) + rate(SER_EXPRESS_LOADED),
+                   rate(SER_DEPARTED));
+      prev = s;
+      first = false;
+    });
+  }
+};
@@ -0,0 +1,146 @@
+/**
+ * @file TimerWheel.h
+ * @brief Hierarchical timer wheel that lives in shared memory.
+ *
+ * Four levels of 64 buckets cover 2^24 ticks (about 4.6 hours at 1 ms per
+ * tick). A timer is filed in the lowest level whose span reaches its expiry
+ * and is moved one level down each time that level's bucket comes due, so
+ * scheduling and firing are O(1) amortized per timer, however many are
+ * pending. Idle stretches (no pending timers) are skipped in O(1). Longer
+ * delays are clamped to the span.
+ *
+ * The structure is POD and valid when zero-filled: node links store
+ * `index + 1` so 0 means "none", and unused nodes are handed out from a
+ * high-water mark before the free list is used. Callers serialize access
+ * (the belt keeps it under the belt mutex).
+ */
+#pragma once
+
+#include <cstdint>
+
+constexpr int WHEEL_LEVELS = 4;              /**< Levels of buckets. */
+constexpr int WHEEL_BITS = 6;                /**< log2(buckets per level). */
+constexpr int WHEEL_SLOTS = 1 << WHEEL_BITS; /**< Buckets per level. */
+constexpr uint64_t WHEEL_MASK = WHEEL_SLOTS - 1;
+/** @brief Longest delay [ticks]. */
+constexpr uint64_t WHEEL_SPAN = uint64_t{1} << (WHEEL_BITS * WHEEL_LEVELS);
+
+/**
+ * @struct TimerWheel
+ * @brief Pending timers carrying a 32-bit payload each.
+ * @tparam Capacity Maximum number of pending timers.
+ */
+template <int Capacity> struct TimerWheel {
+  /** @brief One pending timer. */
+  struct Node {
+    uint64_t expires; /**< Tick at which it fires. */
+    uint32_t payload; /**< Caller data (e.g. a belt slot). */
+    uint32_t next;    /**< Next node in the bucket or free list (+1). */
+  };
+
+  uint64_t current;  /**< Next tick to process. */
+  int32_t pending;   /**< Scheduled, not yet fired. */
+  uint32_t used;     /**< High-water mark of `nodes`. */
+  uint32_t free_head; /**< Free list of released nodes (+1). */
+  uint32_t bucket[WHEEL_LEVELS][WHEEL_SLOTS]; /**< Bucket heads (+1). */
+  Node nodes[Capacity];
+
+  /**
+   * @brief Schedules `payload` to fire at tick `expires`.
+   * @param now Current tick; an empty wheel fast-forwards to it.
+   * @param expires Expiry tick; past ticks fire on the next advance.
+   * @return false if `Capacity` timers are already pending.
+   */
+  bool schedule(uint64_t now, uint64_t expires, uint32_t payload) {
+    uint32_t n;
+    if (free_head) {
+      n = free_head;
+      free_head = nodes[n - 1].next;
+    } else if (used < static_cast<uint32_t>(Capacity)) {
+      n = ++used;
+    } else {
+      return false;
+    }
+
+    if (pending == 0 && now > current)
+      current = now;
+    nodes[n - 1].expires = expires;
+    nodes[n - 1].payload = payload;
+    file(n);
+    pending++;
+    return true;
+  }
+
+  /**
+   * @brief Processes every tick up to and including `now`.
+   * @param now Current tick.
+   * @param fire Called with the payload of each expired timer.
+   * @return Number of timers fired.
+   */
+  template <typename F> int advance(uint64_t now, F fire) {
+    int fired = 0;
+
+    while (current <= now) {
+      if (pending == 0) {
+        current = now + 1;
+        break;
+      }
+
+      uint64_t index = current & WHEEL_MASK;
+      for (int level = 1; index == 0 && level < WHEEL_LEVELS; ++level) {
+        index = (current >> (WHEEL_BITS * level)) & WHEEL_MASK;
+        cascade(level, index);
+      }
+
+      uint32_t n = bucket[0][current & WHEEL_MASK];
+      bucket[0][current & WHEEL_MASK] = 0;
+      while (n) {
+        Node &node = nodes[n - 1];
+        uint32_t next = node.next;
+        fire(node.payload);
+        node.next = free_head;
+        free_head = n;
+        pending--;
+        fired++;
+        n = next;
+      }
+      current++;
+    }
+    return fired;
+  }
+
+  /** @brief Number of pending timers. */
+  int size() const { return pending; }
+
+private:
+  /** @brief Links node `n` (+1) into the bucket matching its expiry. */
+  void file(uint32_t n) {
+    Node &node = nodes[n - 1];
+    if (node.expires < current)
+      node.expires = current;
+    if (node.expires - current >= WHEEL_SPAN)
+      node.expires = current + WHEEL_SPAN - 1;
+
+    uint64_t delta = node.expires - current;
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1 &&
+           delta >= (uint64_t{1} << (WHEEL_BITS * (level + 1))))
+      level++;
+
+    uint32_t &head =
+        bucket[level][(node.expires >> (WHEEL_BITS * level)) & WHEEL_MASK];
+    node.next = head;
+    head = n;
+  }
+
+  /** @brief Re-files every timer of one bucket at the level below. */
+  void cascade(int level, uint64_t index) {
+    uint32_t n = bucket[level][index];
+    bucket[level][index] = 0;
+    while (n) {
+      uint32_t next = nodes[n - 1].next;
+      file(n);
+      n = next;
+    }
+  }
+};
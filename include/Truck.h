@@ -10,13 +10,52 @@
 
 #pragma once
 
+#include "DeliveryLedger.h"
+#include "EventChannel.h"
+#include "JsonLog.h"
+#include "LockProfiler.h"
+#include "LogThrottle.h"
+#include "Probes.h"
 #include "Shared.h"
+#include "Telemetry.h"
+#include "Watchdog.h"
 #include "spdlog/spdlog.h"
 #include <functional>
 #include <random>
 #include <thread>
 #include <unistd.h>
 
+/**
+ * @brief Docks a truck with fresh random specifications.
+ *
+ * Sets the truck's unique constraints for the current trip:
+ * - **Max Weight (W):** Randomly selected between 200.0 kg and 600.0 kg.
+ * - **Max Volume (V):** Randomly selected between 1.0 m³ and 3.0 m³.
+ * - **ID:** Sets the current dock occupant ID to `id`.
+ *
+ * @param truck Dock state (caller holds the dock mutex).
+ * @param id Occupant ID (the truck's PID).
+ * @param gen Random engine of the truck.
+ */
+template <class Gen> void dockTruck(TruckState &truck, int id, Gen &gen) {
+  std::uniform_real_distribution<> weight_cap_dist(200.0, 600.0);
+  std::uniform_real_distribution<> vol_cap_dist(1.0, 3.0);
+
+  truck.id = id;
+
+  truck.current_load = 0;
+  truck.current_weight = 0.0;
+  truck.current_volume = 0.0;
+
+  truck.max_load = 100;
+  truck.max_weight = weight_cap_dist(gen);
+  truck.max_volume = vol_cap_dist(gen);
+  truck.departure_reason = DepartureReason::Unknown;
+  truck.phase = DockPhase::Docked;
+
+  truck.is_present = true;
+}
+
 /**
  * @class Truck
  * @brief Represents a delivery vehicle in the logistic system.
@@ -43,36 +82,99 @@ private:
   std::function<void()> unlock_dock_fn; /**< Releases the dock mutex. */
   std::function<SignalType(pid_t)>
       wait_for_signal_fn; /**< Blocks waiting for a message. */
+  std::function<SignalType(pid_t)>
+      drain_signal_fn; /**< Non-blocking receive (optional). */
+  std::function<bool()>
+      wait_failed_fn; /**< True if the last lock got no permit (optional). */
   /** @} */
 
+  bool waitFailed() const { return wait_failed_fn && wait_failed_fn(); }
+
+  /** @name Timing Parameters
+   * Defaults model real trucks; the stress harness shortens them.
+   * @{ */
+  int route_min_ms = 3000; /**< Shortest delivery round trip ($T_i$). */
+  int route_max_ms = 8000; /**< Longest delivery round trip ($T_i$). */
+  int dock_retry_ms = 1000; /**< Back-off while the dock is occupied. */
+  /** @} */
+
+  /** @brief Departure ledger (nullptr = disabled). */
+  DeliveryLedger *ledger = nullptr;
+
+  /** @brief Heartbeat target (nullptr = not watched). */
+  ProcessHealth *health = nullptr;
+
+  /** @brief Dock this truck queues for (the main dock or a sorter lane's). */
+  TruckState *dock;
+
+  /** @brief Cleared by `stop()`; the truck leaves as on END_WORK. */
+  bool active = true;
+
   /**
-   * @brief Generates random specifications for the truck upon arrival.
-   *
-   * Sets the truck's unique constraints for the current trip:
-   * - **Max Weight (W):** Randomly selected between 200.0 kg and 600.0 kg.
-   * - **Max Volume (V):** Randomly selected between 1.0 m³ and 3.0 m³.
-   * - **ID:** Sets the current dock occupant ID to this process's PID.
+   * @brief Discards DEPARTURE messages left over from an earlier visit.
    *
-   * @param truck Reference to the shared memory truck state structure.
+   * Requests are sent exactly once per visit (see requestDeparture), but a
+   * visit that ended with END_WORK or a crashed peer can leave one behind.
+   * Called with the dock mutex held and before docking, so nothing for this
+   * visit can have been sent yet.
    */
-  void randomizeTruckSpecs(TruckState &truck) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
+  void drainStaleSignals() {
+    if (!drain_signal_fn)
+      return;
+    while (drain_signal_fn(my_pid) != SIGNAL_NONE) {
+      atomicAdd(shm->stats.departures_stale, uint64_t{1});
+      spdlog::warn("[truck-{}] Dropped stale DEPARTURE message.", my_pid);
+    }
+  }
 
-    std::uniform_real_distribution<> weight_cap_dist(200.0, 600.0);
-    std::uniform_real_distribution<> vol_cap_dist(1.0, 3.0);
+  /**
+   * @brief Waits for DEPARTURE or END_WORK and moves the dock to `Departing`.
+   * @return The signal that ended the wait.
+   */
+  SignalType awaitDeparture() {
+    SignalType sig = SIGNAL_NONE;
+    while (sig != SIGNAL_DEPARTURE && sig != SIGNAL_END_WORK && active &&
+           shm->running)
+      sig = wait_for_signal_fn(my_pid);
 
-    truck.id = my_pid;
+    if (sig == SIGNAL_DEPARTURE) {
+      lock_dock_fn();
+      if (waitFailed())
+        return sig;
+      if (dock->id == my_pid)
+        dock->phase = DockPhase::Departing;
+      unlock_dock_fn();
+    }
+    return sig;
+  }
 
-    truck.current_load = 0;
-    truck.current_weight = 0.0;
-    truck.current_volume = 0.0;
+  /**
+   * @brief Captures the dock state of this truck as it departs.
+   * @note Caller holds the dock mutex.
+   */
+  DeliveryRecord departureRecord(uint64_t docked_at) const {
+    const TruckState &t = *dock;
+    return {my_pid,         docked_at,        realtimeNowNs(),
+            t.current_load, t.current_weight, t.current_volume,
+            t.max_weight,   t.max_volume,     t.departure_reason};
+  }
 
-    truck.max_load = 100;
-    truck.max_weight = weight_cap_dist(gen);
-    truck.max_volume = vol_cap_dist(gen);
+  /** @brief Draws a round-trip time from `[route_min_ms, route_max_ms)`. */
+  int drawRouteTime() const {
+    int span = route_max_ms - route_min_ms;
+    return route_min_ms + (span > 0 ? rand() % span : 0);
+  }
 
-    truck.is_present = true;
+  /**
+   * @brief Generates random specifications for the truck upon arrival.
+   *
+   * @param truck Reference to the shared memory truck state structure.
+   * @see dockTruck
+   */
+  void randomizeTruckSpecs(TruckState &truck) {
+    static std::random_device rd;
+    static std::mt19937 gen(rd());
+    dockTruck(truck, my_pid, gen);
   }
 
 public:
@@ -88,18 +190,80 @@ public:
         std::function<void()> unlock_dock,
         std::function<SignalType(pid_t)> wait_for_signal)
       : shm(s), lock_dock_fn(lock_dock), unlock_dock_fn(unlock_dock),
-        wait_for_signal_fn(wait_for_signal) {
+        wait_for_signal_fn(wait_for_signal), dock(&s->dock_truck) {
     my_pid = getpid();
   }
 
+  /**
+   * @brief Overrides the delivery round-trip range ($T_i$).
+   * @param min_ms Shortest round trip in milliseconds.
+   * @param max_ms Longest round trip in milliseconds.
+   */
+  void setRouteTime(int min_ms, int max_ms) {
+    route_min_ms = min_ms > 0 ? min_ms : 0;
+    route_max_ms = max_ms > route_min_ms ? max_ms : route_min_ms;
+  }
+
+  /**
+   * @brief Overrides the polling interval used while the dock is occupied.
+   * @param ms Back-off in milliseconds.
+   */
+  void setDockRetry(int ms) { dock_retry_ms = ms > 0 ? ms : 1; }
+
+  /**
+   * @brief Beats `h` once per dock attempt; routes count as parked (see
+   * Watchdog.h).
+   */
+  void setHealth(ProcessHealth *h) { health = h; }
+
+  /**
+   * @brief Sets the non-blocking receive used to drop stale messages before
+   * docking (unset: nothing is drained).
+   */
+  void setSignalDrain(std::function<SignalType(pid_t)> drain) {
+    drain_signal_fn = drain;
+  }
+
+  /**
+   * @brief Asks the truck to finish its shift (signal-safe).
+   * * A docked truck leaves with its cargo as on END_WORK, so a restarted
+   * truck process does not strand loaded packages at the dock.
+   */
+  void stop() { active = false; }
+
+  /**
+   * @brief Lets the truck notice a dock lock given up at shutdown, so it
+   * leaves without releasing a mutex it does not hold.
+   */
+  void setWaitFailedCheck(std::function<bool()> check) {
+    wait_failed_fn = std::move(check);
+  }
+
+  /** @brief Attaches the delivery ledger (nullptr disables it). */
+  void setLedger(DeliveryLedger *l) { ledger = l; }
+
+  /**
+   * @brief Rebinds the truck to another dock (e.g. a sorter lane's).
+   * @param d Dock state in shared memory.
+   * @param lock_dock Locks that dock.
+   * @param unlock_dock Unlocks that dock.
+   */
+  void setDock(TruckState *d, std::function<void()> lock_dock,
+               std::function<void()> unlock_dock) {
+    dock = d;
+    lock_dock_fn = lock_dock;
+    unlock_dock_fn = unlock_dock;
+  }
+
   /**
    * @brief Main operational loop of the Truck.
    *
    * This method executes the continuous cycle of the transport vehicle:
    * 1. **Queueing:** Checks if the dock is free. If occupied, sleeps for 1s.
    * 2. **Docking:** If free, acquires the dock and calls `randomizeTruckSpecs`.
-   * 3. **Service Wait:** Blocks on `wait_for_signal_fn`. The truck is passive
-   * here, waiting to be loaded by Dispatcher or Express Worker.
+   * 3. **Service Wait:** Blocks in `awaitDeparture`. The truck is passive
+   * here, waiting to be loaded by Dispatcher or Express Worker. Messages
+   * left from an earlier visit were dropped before docking.
    * 4. **Signal Handling:**
    * - `SIGNAL_DEPARTURE`: Normal cycle. Truck leaves the dock to deliver goods.
    * - `SIGNAL_END_WORK`: **Graceful Shutdown.** The truck checks if it has any
@@ -110,49 +274,84 @@ public:
    * clears dock state, and simulates travel time ($T_i$) between 3-8 seconds.
    *
    * @note This function runs until `SIGNAL_END_WORK` is received (and
-   * processed) or `shm->running` becomes false.
+   * processed), `stop()` is called or `shm->running` becomes false.
    */
   void run() {
+    LockSiteScope site(LockSite::DockTruck);
     spdlog::info("[truck-{}] Engine started. Joining fleet.", my_pid);
 
-    while (shm && shm->running) {
+    bool queued = false;
+
+    while (active && shm && shm->running) {
+      heartbeat(health);
+      if (ledger)
+        ledger->flushIfDue(monotonicNowNs());
       lock_dock_fn();
+      if (waitFailed())
+        break;
 
-      if (shm->dock_truck.is_present) {
+      if (dock->is_present) {
         unlock_dock_fn();
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        if (!queued) {
+          atomicAdd(shm->trucks_waiting, 1);
+          bumpGeneration(shm, StateRegion::Fleet);
+          queued = true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(dock_retry_ms));
         continue;
       }
 
-      randomizeTruckSpecs(shm->dock_truck);
-      spdlog::info(
-          "[truck-{}] Docked. Max W:{:.1f}kg, Max V:{:.3f}m3. Waiting.", my_pid,
-          shm->dock_truck.max_weight, shm->dock_truck.max_volume);
+      if (queued) {
+        atomicAdd(shm->trucks_waiting, -1);
+        bumpGeneration(shm, StateRegion::Fleet);
+        queued = false;
+      }
+      drainStaleSignals();
+      randomizeTruckSpecs(*dock);
+      bumpGeneration(shm, StateRegion::Dock);
+      uint64_t docked_at = realtimeNowNs();
+      WAREHOUSE_PROBE2(truck__dock, my_pid, dock->max_load);
+      WAREHOUSE_LOG(LogSubsystem::Truck, spdlog::level::info,
+                    "[truck-{}] Docked. Max W:{:.1f}kg, Max V:{:.3f}m3. "
+                    "Waiting.",
+                    my_pid, dock->max_weight, dock->max_volume);
 
       unlock_dock_fn();
 
-      SignalType sig = wait_for_signal_fn(my_pid);
+      SignalType sig = awaitDeparture();
 
-      if (sig == SIGNAL_END_WORK || !shm->running) {
+      if (sig == SIGNAL_END_WORK || !active || !shm->running) {
         lock_dock_fn();
+        if (waitFailed())
+          break;
 
-        if (shm->dock_truck.id == my_pid &&
-            shm->dock_truck.current_weight > 0.1) {
+        if (dock->id == my_pid && dock->current_weight > 0.1) {
           shm->trucks_completed++;
-          shm->dock_truck.is_present = false;
+          dock->is_present = false;
+          requestDeparture(*dock, DepartureReason::Shutdown);
+          bumpGeneration(shm, StateRegion::Dock);
+          bumpGeneration(shm, StateRegion::Fleet);
+          WAREHOUSE_PROBE3(truck__depart, my_pid, dock->current_load,
+                           static_cast<int>(dock->departure_reason));
+          DeliveryRecord record = departureRecord(docked_at);
+          atomicAdd(shm->stats.dock_ns_total, record.depart_ns - docked_at);
 
           spdlog::warn("[truck-{}] SHUTDOWN SIGNAL but cargo present! "
                        "Delivering final load ({:.1f}kg)...",
-                       my_pid, shm->dock_truck.current_weight);
+                       my_pid, dock->current_weight);
 
           unlock_dock_fn();
+          if (ledger)
+            ledger->append(record);
 
-          std::this_thread::sleep_for(std::chrono::milliseconds(3000));
+          std::this_thread::sleep_for(
+              std::chrono::milliseconds(route_min_ms));
           spdlog::info("[truck-{}] Final delivery complete. Shutting down.",
                        my_pid);
         } else {
-          if (shm->dock_truck.id == my_pid) {
-            shm->dock_truck.is_present = false;
+          if (dock->id == my_pid) {
+            dock->is_present = false;
+            bumpGeneration(shm, StateRegion::Dock);
           }
           unlock_dock_fn();
           spdlog::info("[truck-{}] Empty truck shutting down immediately.",
@@ -162,33 +361,82 @@ public:
       }
 
       lock_dock_fn();
+      if (waitFailed())
+        break;
+      bool departed = false;
+      bool full = false;
+      int load = 0;
+      DeliveryRecord record;
 
-      if (shm->dock_truck.id == my_pid) {
+      if (dock->id == my_pid) {
         shm->trucks_completed++;
-        shm->dock_truck.is_present = false;
+        if (dock->current_load == 0 && dock->current_weight <= 0.0)
+          atomicAdd(shm->stats.departures_empty, uint64_t{1});
+        dock->is_present = false;
+        dock->phase = DockPhase::Docked;
+        record = departureRecord(docked_at);
+        atomicAdd(shm->stats.dock_ns_total, record.depart_ns - docked_at);
+        departed = true;
+        full = dock->departure_reason == DepartureReason::Full ||
+               dock->departure_reason == DepartureReason::NoFit ||
+               dock->departure_reason == DepartureReason::ExpressFull;
+        load = dock->current_load;
+        WAREHOUSE_PROBE3(truck__depart, my_pid, dock->current_load,
+                         static_cast<int>(dock->departure_reason));
+        bumpGeneration(shm, StateRegion::Dock);
+        bumpGeneration(shm, StateRegion::Fleet);
 
-        spdlog::info("[truck-{}] Departing. Payload: {:.1f}kg / {:.3f}m3. "
-                     "Total dispatched: {}",
-                     my_pid, shm->dock_truck.current_weight,
-                     shm->dock_truck.current_volume, shm->trucks_completed);
+        if (WAREHOUSE_LOG_ENABLED(LogSubsystem::Truck, spdlog::level::info)) {
+          if (JsonLog::enabled(spdlog::level::info))
+            JsonRecord("depart")
+                .field("truck", my_pid)
+                .field("load", dock->current_load)
+                .field("kg", dock->current_weight)
+                .field("m3", dock->current_volume)
+                .field("reason", static_cast<int>(dock->departure_reason))
+                .field("docked_ms", (record.depart_ns - docked_at) / 1000000)
+                .field("total", shm->trucks_completed)
+                .log(spdlog::level::info);
+          else
+            spdlog::info("[truck-{}] Departing. Payload: {:.1f}kg / {:.3f}m3. "
+                         "Total dispatched: {}",
+                         my_pid, dock->current_weight,
+                         dock->current_volume, shm->trucks_completed);
+        }
       } else {
         spdlog::critical("[truck-{}] ERROR: Identity theft at dock!", my_pid);
       }
 
       unlock_dock_fn();
+      if (departed && ledger)
+        ledger->append(record);
+      if (full)
+        publishEvent(shm, EventKind::TruckDepartedFull, my_pid, load);
 
-      int route_time = 3000 + (rand() % 5000);
-      spdlog::info("[truck-{}] On route... returning in {}ms", my_pid,
-                   route_time);
+      int route_time = drawRouteTime();
+      WAREHOUSE_LOG(LogSubsystem::Truck, spdlog::level::info,
+                    "[truck-{}] On route... returning in {}ms", my_pid,
+                    route_time);
+      HealthParkScope on_route(health);
       std::this_thread::sleep_for(std::chrono::milliseconds(route_time));
     }
 
+    if (queued) {
+      atomicAdd(shm->trucks_waiting, -1);
+      bumpGeneration(shm, StateRegion::Fleet);
+    }
+
     lock_dock_fn();
-    if (shm->dock_truck.is_present && shm->dock_truck.id == my_pid) {
-      shm->dock_truck.is_present = false;
+    if (!waitFailed()) {
+      if (dock->is_present && dock->id == my_pid) {
+        dock->is_present = false;
+        bumpGeneration(shm, StateRegion::Dock);
+      }
+      unlock_dock_fn();
     }
-    unlock_dock_fn();
 
+    if (ledger)
+      ledger->flush();
     spdlog::info("[truck-{}] Shift ended.", my_pid);
   }
 };
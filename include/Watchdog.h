@@ -0,0 +1,329 @@
+/**
+ * @file Watchdog.h
+ * @brief Per-process heartbeats, lock-holder tracking and stall detection.
+ *
+ * Every process owns the `ProcessHealth` entry of its session slot:
+ * - its main loop bumps `beats` once per unit of work (heartbeat),
+ * - `Manager::semOperation` records the mutexes it holds and the semaphore
+ *   it is blocked on,
+ * - waits for a message or a timer are marked as parked (HealthParkScope).
+ *
+ * All of it is relaxed atomic stores and read-modify-writes on memory the
+ * process already maps; the blocked-since timestamp reuses the one the lock
+ * profiler takes on the contended path. No system call is added.
+ *
+ * The `Watchdog` (run by the belt process) samples the beats. A process that
+ * has beaten at least once and then makes no progress for the stall
+ * threshold is reported as stalled, unless it is parked or waits on a
+ * counting semaphore (an empty or full belt waits on its peers, which are
+ * checked themselves). A report logs the wait-for graph: who holds which
+ * mutex, who waits for it, and any cycle (deadlock).
+ *
+ * With recovery enabled the watchdog releases the mutexes of a process that
+ * died holding them (semaphores are not SEM_UNDO), and kills a stalled
+ * process that holds a mutex somebody else is blocked on; its mutexes are
+ * released on the next pass.
+ */
+#pragma once
+
+#include "EventChannel.h"
+#include "LockProfiler.h"
+#include "Shared.h"
+#include "Telemetry.h"
+#include "spdlog/spdlog.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+/** @brief Records one unit of progress; no-op without a session. */
+inline void heartbeat(ProcessHealth *h) {
+  if (h)
+    atomicAdd(h->beats, uint64_t{1});
+}
+
+/**
+ * @class HealthParkScope
+ * @brief Marks the process as idle by design (waiting for a message, on a
+ * route) for the duration of a scope.
+ */
+class HealthParkScope {
+private:
+  ProcessHealth *h;
+
+public:
+  explicit HealthParkScope(ProcessHealth *health) : h(health) {
+    if (h)
+      atomicAdd(h->parked, 1);
+  }
+  ~HealthParkScope() {
+    if (h)
+      atomicAdd(h->parked, -1);
+  }
+
+  HealthParkScope(const HealthParkScope &) = delete;
+  HealthParkScope &operator=(const HealthParkScope &) = delete;
+};
+
+/**
+ * @class Watchdog
+ * @brief Detects processes that stopped making progress.
+ */
+class Watchdog {
+private:
+  SharedState *shm;
+  uint64_t stall_ns;
+  bool recover;
+
+  /** @brief Posts one V operation on a semaphore (recovery). */
+  std::function<void(SemIndex)> release_fn;
+
+  /**
+   * @struct Seen
+   * @brief Progress of the process in one session slot.
+   */
+  struct Seen {
+    pid_t pid;         /**< 0 = slot not tracked. */
+    uint64_t beats;    /**< Beats at the last change. */
+    uint64_t since_ns; /**< When `beats` last changed. */
+  };
+
+  Seen seen[MAX_USERS_SESSIONS] = {};
+
+  /** @brief True if the process is gone (not merely unsignalable). */
+  static bool dead(pid_t pid) { return kill(pid, 0) == -1 && errno == ESRCH; }
+
+  /** @brief Slot of a live session holding mutex `sem`, or -1. */
+  static int holderOf(const SharedState *shm, int sem, int except) {
+    for (int i = 0; i < MAX_USERS_SESSIONS; ++i) {
+      if (i != except && atomicLoad(shm->users[i].active) &&
+          (atomicLoad(shm->health[i].held) & (1u << sem)))
+        return i;
+    }
+    return -1;
+  }
+
+  /** @brief Semaphore slot `i` is blocked on, -1 if none. */
+  static int waitingOn(const SharedState *shm, int i) {
+    return atomicLoad(shm->health[i].waiting) - 1;
+  }
+
+  /** @brief True if a live session other than `i` is blocked on `held`. */
+  static bool blocksOthers(const SharedState *shm, int i, uint32_t held) {
+    for (int j = 0; j < MAX_USERS_SESSIONS; ++j) {
+      int w = waitingOn(shm, j);
+      if (j != i && w >= 0 && atomicLoad(shm->users[j].active) &&
+          (held & (1u << w)))
+        return true;
+    }
+    return false;
+  }
+
+  /** @brief Releases the mutexes left held by dead process `i`. */
+  void releaseHeld(int i) {
+    ProcessHealth &h = shm->health[i];
+    uint32_t held = atomicLoad(h.held);
+    for (int s = 0; s < SEM_TOTAL; ++s) {
+      if (!(held & (1u << s)))
+        continue;
+      spdlog::error("[watchdog] Releasing {} left held by dead PID {}.",
+                    LockProfiler::semName(static_cast<SemIndex>(s)),
+                    atomicLoad(shm->users[i].session_pid));
+      __atomic_fetch_and(&h.held, ~(1u << s), __ATOMIC_RELAXED);
+      release_fn(static_cast<SemIndex>(s));
+      atomicAdd(shm->watchdog.recoveries, uint64_t{1});
+    }
+  }
+
+public:
+  /**
+   * @param s Shared state holding the sessions and their health.
+   * @param stall_ms Time without progress after which a process is stalled.
+   * @param release V operation used for recovery.
+   * @param recovery Whether to release and kill (else only report).
+   */
+  Watchdog(SharedState *s, int stall_ms, std::function<void(SemIndex)> release,
+           bool recovery = false)
+      : shm(s),
+        stall_ns(static_cast<uint64_t>(stall_ms > 0 ? stall_ms : 10000) *
+                 1000000ULL),
+        recover(recovery), release_fn(std::move(release)) {}
+
+  /** @brief Checks every session now. */
+  int check() { return check(monotonicNowNs()); }
+
+  /**
+   * @brief Compares the beats with the previous pass and reports stalls.
+   * @param now_ns Monotonic time of the pass.
+   * @return Number of processes currently stalled.
+   */
+  int check(uint64_t now_ns) {
+    int stalled_now = 0;
+    bool report = false;
+
+    for (int i = 0; i < MAX_USERS_SESSIONS; ++i) {
+      const UserSession &u = shm->users[i];
+      ProcessHealth &h = shm->health[i];
+      Seen &s = seen[i];
+      pid_t pid = atomicLoad(u.session_pid);
+      if (!atomicLoad(u.active) || pid <= 0) {
+        s.pid = 0;
+        continue;
+      }
+
+      if (recover && atomicLoad(h.held) && dead(pid)) {
+        releaseHeld(i);
+        continue;
+      }
+
+      uint64_t beats = atomicLoad(h.beats);
+      if (s.pid != pid || beats != s.beats) {
+        s = Seen{pid, beats, now_ns};
+        atomicStore(h.stalled, 0);
+        continue;
+      }
+
+      int w = waitingOn(shm, i);
+      bool counting =
+          w >= 0 && !LockProfiler::isMutex(static_cast<SemIndex>(w));
+      bool exempt = beats == 0 || atomicLoad(h.parked) > 0 || counting;
+      if (exempt || now_ns - s.since_ns < stall_ns) {
+        atomicStore(h.stalled, 0);
+        continue;
+      }
+
+      stalled_now++;
+      if (!atomicLoad(h.stalled)) {
+        atomicStore(h.stalled, 1);
+        atomicAdd(shm->watchdog.stalls, uint64_t{1});
+        report = true;
+        spdlog::error("[watchdog] PID {} '{:.31s}' made no progress for "
+                      "{:.1f} s ({} beats).",
+                      pid, u.username, (now_ns - s.since_ns) / 1e9, beats);
+        publishEvent(shm, EventKind::ProcessStalled, pid,
+                     static_cast<int64_t>((now_ns - s.since_ns) / 1000000ULL),
+                     u.username);
+
+        uint32_t held = atomicLoad(h.held);
+        if (recover && held && blocksOthers(shm, i, held)) {
+          spdlog::error("[watchdog] Killing PID {}: it blocks other "
+                        "processes.",
+                        pid);
+          if (kill(pid, SIGKILL) == 0)
+            atomicAdd(shm->watchdog.recoveries, uint64_t{1});
+        }
+      }
+    }
+
+    if (report) {
+      std::ostringstream graph;
+      describe(graph, shm, now_ns);
+      spdlog::error("[watchdog] Wait-for graph:\n{}", graph.str());
+    }
+    atomicStore(shm->watchdog.stalled, stalled_now);
+    atomicAdd(shm->watchdog.passes, uint64_t{1});
+    return stalled_now;
+  }
+
+  /**
+   * @brief Checks periodically until `stop` is set.
+   * @param period_ms Time between passes.
+   */
+  void run(const std::atomic<bool> &stop, int period_ms) {
+    while (!stop.load()) {
+      check();
+      for (int t = 0; t < period_ms && !stop.load(); t += 50)
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+  }
+
+  /**
+   * @brief Prints the holders and waiters of every semaphore, and cycles.
+   *
+   * One line per session that holds a mutex, waits in semop or is flagged
+   * as stalled; an arrow names the holder of the mutex it waits for.
+   *
+   * @param out Stream written to.
+   * @param shm Shared state to read.
+   * @param now_ns Monotonic time, for the age of waits.
+   */
+  static void describe(std::ostream &out, const SharedState *shm,
+                       uint64_t now_ns) {
+    char line[200];
+    bool any = false;
+    for (int i = 0; i < MAX_USERS_SESSIONS; ++i) {
+      const UserSession &u = shm->users[i];
+      const ProcessHealth &h = shm->health[i];
+      uint32_t held = atomicLoad(h.held);
+      int w = waitingOn(shm, i);
+      bool stalled = atomicLoad(h.stalled);
+      if (!atomicLoad(u.active) || (!held && w < 0 && !stalled))
+        continue;
+      any = true;
+
+      int n = std::snprintf(line, sizeof(line), "  %-7d %-20.31s%s holds:",
+                            atomicLoad(u.session_pid), u.username,
+                            stalled ? " STALLED" : "");
+      for (int s = 0; s < SEM_TOTAL && n < (int)sizeof(line); ++s) {
+        if (held & (1u << s))
+          n += std::snprintf(line + n, sizeof(line) - n, " %s",
+                             LockProfiler::semName(static_cast<SemIndex>(s)));
+      }
+      if (!held && n < (int)sizeof(line))
+        n += std::snprintf(line + n, sizeof(line) - n, " -");
+      if (w >= 0 && n < (int)sizeof(line)) {
+        uint64_t since = atomicLoad(h.wait_since_ns);
+        n += std::snprintf(line + n, sizeof(line) - n, "  waits: %s (%.1f s)",
+                           LockProfiler::semName(static_cast<SemIndex>(w)),
+                           since && now_ns > since ? (now_ns - since) / 1e9
+                                                   : 0.0);
+        int holder = holderOf(shm, w, i);
+        if (holder >= 0 && n < (int)sizeof(line))
+          std::snprintf(line + n, sizeof(line) - n, " -> %d",
+                        atomicLoad(shm->users[holder].session_pid));
+      }
+      out << line << "\n";
+    }
+    if (!any)
+      out << "  (no process holds or waits on a semaphore)\n";
+
+    for (int i = 0; i < MAX_USERS_SESSIONS; ++i) {
+      std::string cycle;
+      if (inCycle(shm, i, cycle))
+        out << "  DEADLOCK: " << cycle << "\n";
+    }
+  }
+
+  /**
+   * @brief Follows "waits for the holder of" edges from slot `start`.
+   *
+   * Reports a cycle once, from its lowest slot.
+   *
+   * @param cycle Receives "pid -> pid -> ... -> pid" if one is found.
+   * @return true if `start` is the lowest slot of a wait-for cycle.
+   */
+  static bool inCycle(const SharedState *shm, int start, std::string &cycle) {
+    if (!atomicLoad(shm->users[start].active))
+      return false;
+    int at = start;
+    cycle = std::to_string(atomicLoad(shm->users[start].session_pid));
+    for (int step = 0; step < MAX_USERS_SESSIONS; ++step) {
+      int w = waitingOn(shm, at);
+      if (w < 0 || !LockProfiler::isMutex(static_cast<SemIndex>(w)))
+        return false;
+      at = holderOf(shm, w, -1);
+      if (at < 0 || at < start)
+        return false;
+      cycle += " -> " + std::to_string(atomicLoad(shm->users[at].session_pid));
+      if (at == start)
+        return true;
+    }
+    return false;
+  }
+};
@@ -10,11 +10,66 @@
 
 #pragma once
 
+#include "ArrivalProcess.h"
 #include "Manager.h"
 #include <chrono>
+#include <memory>
 #include <random>
 #include <thread>
 
+/**
+ * @brief Draws the next package of a worker.
+ *
+ * - Picks a package type (A, B, or C) uniformly.
+ * - Assigns weight based on the package type to simulate "smaller = lighter":
+ *   - **Type A:** 0.1 kg - 8.0 kg
+ *   - **Type B:** 8.0 kg - 16.0 kg
+ *   - **Type C:** 16.0 kg - 25.0 kg
+ * - Draws an SLA tier (70% Standard, 20% Priority, 10% Urgent) and sets the
+ *   deadline to now plus the tier's budget (see slaBudgetNs).
+ *
+ * @param gen Random engine of the worker.
+ * @param schedule Belt schedule holding the SLA budgets.
+ * @return The package, without id and creator.
+ */
+template <class Gen>
+Package drawPackage(Gen &gen, const BeltSchedule &schedule) {
+  std::uniform_int_distribution<> type_dist(0, 2);
+  std::uniform_real_distribution<> weight_A(0.1, 8.0);
+  std::uniform_real_distribution<> weight_B(8.0, 16.0);
+  std::uniform_real_distribution<> weight_C(16.0, 25.0);
+  std::uniform_int_distribution<> tier_roll(0, 99);
+
+  Package p = {};
+  p.status = PackageStatus::Normal;
+
+  switch (type_dist(gen)) {
+  case 0:
+    p.type = PackageType::TypeA;
+    p.volume = VOL_A;
+    p.weight = weight_A(gen);
+    break;
+  case 1:
+    p.type = PackageType::TypeB;
+    p.volume = VOL_B;
+    p.weight = weight_B(gen);
+    break;
+  default:
+    p.type = PackageType::TypeC;
+    p.volume = VOL_C;
+    p.weight = weight_C(gen);
+    break;
+  }
+
+  // A discrete_distribution would allocate its weights on every call.
+  int roll = tier_roll(gen);
+  p.tier = roll < 70   ? SlaTier::Standard
+           : roll < 90 ? SlaTier::Priority
+                       : SlaTier::Urgent;
+  p.deadline_ns = monotonicNowNs() + slaBudgetNs(schedule, p.tier);
+  return p;
+}
+
 /**
  * @class Worker
  * @brief Represents a manual warehouse worker (e.g., P1, P2, P3).
@@ -47,6 +102,13 @@ private:
    */
   int worker_id;
 
+  /**
+   * @brief Paces the packages (see ArrivalProcess.h).
+   * nullptr keeps the legacy pacing (Belt's simulated workload) or, after
+   * `setArrivalRate(0)`, pushes as fast as the belt accepts.
+   */
+  std::unique_ptr<ArrivalProcess> arrivals;
+
 public:
   /**
    * @brief Constructs a new Worker instance.
@@ -57,6 +119,36 @@ public:
    */
   Worker(Manager *mgr, int id) : manager(mgr), active(true), worker_id(id) {}
 
+  /**
+   * @brief Paces the worker at a fixed package rate.
+   *
+   * Arrivals are scheduled on absolute deadlines, so time spent blocked on
+   * a full belt is caught up afterwards instead of drifting. Setting a rate
+   * disables the Belt's simulated workload delay.
+   *
+   * @param rate_hz Packages per second; 0 means unthrottled.
+   */
+  void setArrivalRate(double rate_hz) {
+    ArrivalSpec spec;
+    spec.rate_hz = rate_hz;
+    arrivals.reset(rate_hz > 0 ? new ArrivalProcess(spec, 0) : nullptr);
+    manager->belt->setWorkloadSimulation(rate_hz < 0);
+  }
+
+  /**
+   * @brief Shapes the worker's intake with an arrival process.
+   *
+   * Like `setArrivalRate`, arrivals are scheduled on absolute deadlines and
+   * the Belt's simulated workload delay is disabled.
+   *
+   * @param spec Process and base rate (see parseArrivalSpec).
+   * @param seed Seed of the schedule.
+   */
+  void setArrivalProcess(const ArrivalSpec &spec, uint64_t seed) {
+    arrivals = std::make_unique<ArrivalProcess>(spec, seed);
+    manager->belt->setWorkloadSimulation(false);
+  }
+
   /**
    * @brief The main operational loop of the worker.
    *
@@ -67,11 +159,7 @@ public:
    * generation.
    * 3. **Production Loop:**
    * - Checks session quotas via `trySpawnProcess()`.
-   * - Generates a package type (A, B, or C) using a uniform distribution.
-   * - Assigns weight based on the package type to simulate "smaller = lighter":
-   * - **Type A:** 0.1 kg - 8.0 kg
-   * - **Type B:** 8.0 kg - 16.0 kg
-   * - **Type C:** 16.0 kg - 25.0 kg
+   * - Draws a package with `drawPackage` (type, weight, SLA tier).
    * - Pushes the package to the Belt (blocking if belt is full).
    * 4. **Cleanup:** Unregisters the worker upon loop termination.
    *
@@ -91,37 +179,22 @@ public:
     std::random_device rd;
     std::mt19937 gen(rd());
 
-    std::uniform_int_distribution<> type_dist(0, 2);
-    std::uniform_real_distribution<> weight_A(0.1, 8.0);
-    std::uniform_real_distribution<> weight_B(8.0, 16.0);
-    std::uniform_real_distribution<> weight_C(16.0, 25.0);
+    auto next_arrival = std::chrono::steady_clock::now();
 
     while (active && manager->getState()->running) {
+      manager->heartbeat();
+      if (arrivals) {
+        next_arrival += std::chrono::duration_cast<
+            std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(arrivals->nextGap()));
+        HealthParkScope between_arrivals(manager->processHealth());
+        std::this_thread::sleep_until(next_arrival);
+      }
+
       if (manager->session_store->trySpawnProcess()) {
 
-        Package p;
+        Package p = drawPackage(gen, manager->getState()->schedule);
         p.creator_pid = getpid();
-        p.status = PackageStatus::Normal;
-
-        int type_roll = type_dist(gen);
-
-        switch (type_roll) {
-        case 0:
-          p.type = PackageType::TypeA;
-          p.volume = VOL_A;
-          p.weight = weight_A(gen);
-          break;
-        case 1:
-          p.type = PackageType::TypeB;
-          p.volume = VOL_B;
-          p.weight = weight_B(gen);
-          break;
-        case 2:
-          p.type = PackageType::TypeC;
-          p.volume = VOL_C;
-          p.weight = weight_C(gen);
-          break;
-        }
 
         manager->belt->push(p);
         manager->session_store->reportProcessFinished();
@@ -17,6 +17,10 @@ enum class CliCommand {
   Vip,    /**< Trigger a high-priority VIP package. */
   Depart, /**< Force the current truck to depart. */
   Stop,   /**< Emergency system shutdown. */
+  Locks,  /**< Print the lock contention report. */
+  Flow,   /**< Print stage rates and the current bottleneck. */
+  Usage,  /**< Print CPU, memory and scheduling per role. */
+  Log,    /**< Show or change the log throttling per subsystem. */
   Help,   /**< Display the menu. */
   Exit    /**< Terminate the CLI session (not the system). */
 };
@@ -39,7 +43,9 @@ public:
     static const std::unordered_map<std::string, CliCommand> commandMap = {
         {"vip", CliCommand::Vip},   {"depart", CliCommand::Depart},
         {"stop", CliCommand::Stop}, {"help", CliCommand::Help},
-        {"exit", CliCommand::Exit}, {"quit", CliCommand::Exit}};
+        {"exit", CliCommand::Exit}, {"quit", CliCommand::Exit},
+        {"locks", CliCommand::Locks}, {"flow", CliCommand::Flow},
+        {"usage", CliCommand::Usage}, {"log", CliCommand::Log}};
 
     auto it = commandMap.find(cmd);
     if (it != commandMap.end()) {
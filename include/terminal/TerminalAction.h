@@ -10,9 +10,16 @@
  */
 #pragma once
 
+#include "../EventChannel.h"
+#include "../LockProfiler.h"
+#include "../LogThrottle.h"
 #include "../Manager.h"
+#include "../QueueAnalytics.h"
+#include "../ResourceSampler.h"
 #include "../Shared.h"
 #include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <string>
 
@@ -70,9 +77,10 @@ public:
    *
    * **Logic:**
    * 1. Checks if the user is an **Operator** or **SysAdmin**.
-   * 2. Locks shared memory to safely read the dock state.
-   * 3. Checks if a truck is present (`dock_truck.is_present`).
-   * 4. Sends `SIGNAL_DEPARTURE` to the truck's PID.
+   * 2. Locks each dock to safely read and update its state.
+   * 3. Checks every dock (one per sorter lane) for a present truck.
+   * 4. Sends `SIGNAL_DEPARTURE` to each docked truck's PID, unless its
+   * departure was already requested (see requestDeparture).
    *
    * @param manager Pointer to the central Manager for IPC access.
    * @param role The role of the currently logged-in user.
@@ -86,12 +94,33 @@ public:
 
     SharedState *shm = manager->getState();
 
-    if (shm->dock_truck.is_present) {
-      pid_t truck_pid = shm->dock_truck.id;
-      manager->sendSignal(truck_pid, SIGNAL_DEPARTURE);
-      std::cout << "  └─ \033[33mDeparture Signal Sent to Truck PID "
-                << truck_pid << ".\033[0m\n";
-    } else {
+    bool any = false;
+
+    for (int i = 0; i < dockCount(shm); ++i) {
+      TruckState &dock = dockAt(shm, i);
+      manager->lockDockAt(i);
+      if (Manager::lastWaitFailed())
+        return;
+      bool present = dock.is_present;
+      pid_t truck_pid = dock.id;
+      bool send = present && requestDeparture(dock, DepartureReason::Forced);
+      manager->unlockDockAt(i);
+      if (!present)
+        continue;
+
+      if (send) {
+        manager->sendSignal(truck_pid, SIGNAL_DEPARTURE);
+        std::cout << "  └─ \033[33mDeparture Signal Sent to Truck PID "
+                  << truck_pid << ".\033[0m\n";
+      } else {
+        atomicAdd(shm->stats.departures_coalesced, uint64_t{1});
+        std::cout << "  └─ \033[33mTruck PID " << truck_pid
+                  << " is already leaving.\033[0m\n";
+      }
+      any = true;
+    }
+
+    if (!any) {
       std::cout << "  └─ \033[31mNo truck in dock to depart.\033[0m\n";
     }
   }
@@ -119,6 +148,7 @@ public:
 
       SharedState *shm = manager->getState();
       manager->getState()->running = false;
+      publishEvent(shm, EventKind::Shutdown, getpid(), 0);
 
       for (int i = 0; i < MAX_USERS_SESSIONS; ++i) {
         if (shm->users[i].active) {
@@ -135,6 +165,99 @@ public:
     }
   }
 
+  /**
+   * @brief Handles the 'locks' command.
+   *
+   * Prints the lock contention report: semaphores and (semaphore, call site)
+   * pairs ranked by total blocked time. The statistics are shared, so the
+   * report covers every process attached to the segment.
+   *
+   * @param manager Pointer to the central Manager for IPC access.
+   * @param role The role of the currently logged-in user.
+   */
+  static void handleLocks(Manager *manager, UserRole role) {
+    if (role == UserRole::None) {
+      printAccessDenied("Viewer");
+      return;
+    }
+
+    LockProfiler::printReport(std::cout, manager->getState());
+  }
+
+  /**
+   * @brief Handles the 'flow' command.
+   *
+   * Prints the per-stage arrival/service rates, utilization and Little's law
+   * checks published by the belt process, and names the bottleneck stage.
+   *
+   * @param manager Pointer to the central Manager for IPC access.
+   * @param role The role of the currently logged-in user.
+   */
+  static void handleFlow(Manager *manager, UserRole role) {
+    if (role == UserRole::None) {
+      printAccessDenied("Viewer");
+      return;
+    }
+
+    QueueAnalytics::printReport(std::cout, manager->getState());
+  }
+
+  /**
+   * @brief Handles the 'usage' command.
+   *
+   * Prints the CPU time, memory and context switches per process role, as
+   * sampled from procfs by the belt process.
+   *
+   * @param manager Pointer to the central Manager for IPC access.
+   * @param role The role of the currently logged-in user.
+   */
+  static void handleUsage(Manager *manager, UserRole role) {
+    if (role == UserRole::None) {
+      printAccessDenied("Viewer");
+      return;
+    }
+
+    ResourceSampler::printReport(std::cout, manager->getState());
+  }
+
+  /**
+   * @brief Handles the 'log' command.
+   *
+   * Without arguments, prints the log throttling of each subsystem. With
+   * arguments, e.g. `log belt sample=100 rate=50`, changes it for every
+   * process (see LogThrottle.h).
+   *
+   * @param manager Pointer to the central Manager for IPC access.
+   * @param role The role of the currently logged-in user.
+   * @param args Text after the command, may be empty.
+   */
+  static void handleLog(Manager *manager, UserRole role,
+                        const std::string &args) {
+    LogPolicy *policies = manager->getState()->log_policy;
+    if (args.empty()) {
+      if (role == UserRole::None) {
+        printAccessDenied("Viewer");
+        return;
+      }
+      LogThrottle::printReport(std::cout, policies);
+      return;
+    }
+    if (!hasFlag(role, UserRole::Operator)) {
+      printAccessDenied("Operator");
+      return;
+    }
+
+    std::string spec = args;
+    std::replace(spec.begin(), spec.end(), ' ', ':');
+    if (LogThrottle::parse(spec.c_str(), policies)) {
+      spdlog::info("[cli] Log throttling changed: {}", spec);
+      std::cout << "  └─ Log throttling updated.\n";
+    } else {
+      std::cout << "  └─ Usage: log <belt|dispatcher|truck|express|"
+                   "session> [sample=N] [rate=R] [burst=B] [repeat=MS]\n";
+    }
+  }
+
 private:
   /**
    * @brief Utility to print a standardized red "Permission Denied" message.
@@ -154,10 +277,12 @@ private:
    * @param name The username to search for.
    * @return pid_t The process ID if found, otherwise -1.
    */
-  static pid_t findProcessByRole(Manager *manager, const std::string &name) {
+  static pid_t findProcessByRole(Manager *manager, const char *name) {
     SharedState *shm = manager->getState();
     for (int i = 0; i < MAX_USERS_SESSIONS; ++i) {
-      if (shm->users[i].active && std::string(shm->users[i].username) == name) {
+      if (shm->users[i].active &&
+          std::strncmp(shm->users[i].username, name,
+                       sizeof(shm->users[i].username)) == 0) {
         return shm->users[i].session_pid;
       }
     }
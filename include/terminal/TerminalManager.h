@@ -5,9 +5,11 @@
  * This file defines the `TerminalManager` class, which serves as the User
  * Interface for the Warehouse Simulation. It handles user input, command
  * parsing, authorization checks, and visual rendering of the console menu.
+ * System alerts (see EventChannel.h) are printed as they are published.
  */
 #pragma once
 
+#include "../EventChannel.h"
 #include "../Shared.h"
 #include "CommandResolver.h"
 #include "TerminalAction.h"
@@ -29,14 +31,16 @@ extern std::atomic<bool> keep_running;
  * @class TerminalManager
  * @brief Controls the operator's console session.
  *
- * The TerminalManager implements a non-blocking Read-Eval-Print Loop (REPL).
- * It allows authorized users (Operators/Admins) to interact with the running
+ * The TerminalManager implements a Read-Eval-Print Loop (REPL) that sleeps
+ * until the operator types or the system publishes an alert. It allows
+ * authorized users (Operators/Admins) to interact with the running
  * simulation without halting the background processes.
  *
  * Key Responsibilities:
  * - **Session Context:** Retrieving the current user's identity and role.
- * - **Input Handling:** Reading stdin using `poll()` to avoid blocking the main
- * thread.
+ * - **Input Handling:** Waiting on stdin and the alert eventfd in a single
+ * blocking `poll()`; an idle console uses no CPU.
+ * - **Alerts:** Printing system events above the prompt as they arrive.
  * - **Command Dispatch:** Delegating resolved commands to `TerminalActions`.
  * - **UI Rendering:** Drawing the ASCII status header and command prompt.
  */
@@ -52,6 +56,12 @@ private:
    */
   bool header_printed = false;
 
+  /** @brief Alerts published since the console started. */
+  EventSubscriber events;
+
+  /** @brief Lost alert count already reported to the operator. */
+  uint64_t lost_reported = 0;
+
   /**
    * @brief Retrieves the active user session associated with this process.
    *
@@ -94,6 +104,10 @@ private:
     std::cout << "╠══════════════════════╬═══════════════════════════════╣\n";
     std::cout << "║ vip                  ║ Pass VIP package (Operator)   ║\n";
     std::cout << "║ depart               ║ Force TRUCK depart (Operator) ║\n";
+    std::cout << "║ locks                ║ Lock contention report        ║\n";
+    std::cout << "║ flow                 ║ Stage rates and bottleneck    ║\n";
+    std::cout << "║ usage                ║ CPU and memory per role       ║\n";
+    std::cout << "║ log [subsystem k=v]  ║ Log sampling and rate limits  ║\n";
     if (hasFlag(role, UserRole::SysAdmin)) {
       std::cout << "║ stop                 ║ \033[31mEMERGENCY STOP "
                    "(Admin)\033[0m        ║\n";
@@ -119,21 +133,52 @@ private:
     }
   }
 
+  /**
+   * @brief Prints the pending alerts above the prompt.
+   *
+   * A `Shutdown` alert ends the session like `exit`.
+   */
+  void printAlerts() {
+    events.acknowledge();
+    SystemEvent e;
+    char line[160];
+    bool any = false;
+    while (events.next(e)) {
+      EventSubscriber::describe(e, line, sizeof(line));
+      std::cout << "\r\033[K  \033[1;33m!\033[0m " << line << "\n";
+      any = true;
+      if (e.kind == static_cast<int>(EventKind::Shutdown)) {
+        active = false;
+        keep_running.store(false);
+      }
+    }
+    if (events.lost() > lost_reported) {
+      std::cout << "\r\033[K  \033[1;33m!\033[0m "
+                << events.lost() - lost_reported << " alerts missed.\n";
+      lost_reported = events.lost();
+      any = true;
+    }
+    if (any && active)
+      printPrompt();
+  }
+
 public:
   /**
    * @brief Constructs the Terminal Manager.
    * @param mgr Pointer to the main system Manager instance.
    */
-  TerminalManager(Manager *mgr) : manager(mgr), active(true) {}
+  TerminalManager(Manager *mgr)
+      : manager(mgr), active(true), events(mgr->getState()) {}
 
   /**
    * @brief Executes one iteration of the CLI loop.
    *
    * This method is designed to be called cyclically. It performs the following:
    * 1. **Header Check:** Prints the menu if it's the first run.
-   * 2. **Input Polling:** Checks `stdin` for data using `poll()` with a 100ms
-   * timeout. This prevents the terminal from blocking the main thread
-   * indefinitely.
+   * 2. **Waiting:** Blocks in `poll()` on `stdin` and the alert eventfd
+   * until either is readable (or a signal interrupts it); pending alerts are
+   * printed first. Without an eventfd it falls back to a 100 ms timeout so
+   * shutdown is still noticed.
    * 3. **Command Processing:**
    * - Reads the line if input is available.
    * - Resolves the string to a `CliCommand` enum via `CommandResolver`.
@@ -153,11 +198,16 @@ public:
     if (std::cin.rdbuf()->in_avail() > 0) {
       input_ready = true;
     } else {
-      struct pollfd fds;
-      fds.fd = STDIN_FILENO;
-      fds.events = POLLIN;
-      int ret = poll(&fds, 1, 100);
-      if (ret > 0 && (fds.revents & POLLIN)) {
+      struct pollfd fds[2];
+      fds[0] = {STDIN_FILENO, POLLIN, 0};
+      fds[1] = {events.fd(), POLLIN, 0};
+      int ret = poll(fds, 2, events.fd() >= 0 ? -1 : 100);
+      if (ret > 0 && (fds[1].revents & POLLIN)) {
+        printAlerts();
+        if (!active)
+          return;
+      }
+      if (ret > 0 && (fds[0].revents & (POLLIN | POLLHUP))) {
         input_ready = true;
       }
     }
@@ -178,6 +228,13 @@ public:
       std::transform(line.begin(), line.end(), line.begin(), ::tolower);
 
       CliCommand cmd = CommandResolver::resolve(line);
+      std::string args;
+      size_t space = line.find(' ');
+      if (cmd == CliCommand::Unknown && space != std::string::npos &&
+          CommandResolver::resolve(line.substr(0, space)) == CliCommand::Log) {
+        cmd = CliCommand::Log;
+        args = line.substr(space + 1);
+      }
       UserRole myRole = manager->session_store->getCurrentRole();
 
       switch (cmd) {
@@ -190,6 +247,18 @@ public:
       case CliCommand::Stop:
         TerminalActions::handleStop(manager, myRole, active);
         break;
+      case CliCommand::Locks:
+        TerminalActions::handleLocks(manager, myRole);
+        break;
+      case CliCommand::Flow:
+        TerminalActions::handleFlow(manager, myRole);
+        break;
+      case CliCommand::Usage:
+        TerminalActions::handleUsage(manager, myRole);
+        break;
+      case CliCommand::Log:
+        TerminalActions::handleLog(manager, myRole, args);
+        break;
       case CliCommand::Help:
         printHeader();
         break;
@@ -17,7 +17,38 @@ remove_ipc
 export LOG_LEVEL="info"
 export LOG_TO_CONSOLE="true"
 export LOG_TO_FILE="true"
-export BELT_SPEED_MS="1000"
+# "text" or "json" (one object per line, typed fields on the hot paths).
+export LOG_FORMAT="${LOG_FORMAT:-text}"
+# Hot-path log throttling per subsystem (belt, dispatcher, truck, express,
+# session): "sample=N" keeps 1 in N, "rate=R" caps records/s per call site,
+# "repeat=MS" folds repeated warnings. Empty logs everything.
+export LOG_THROTTLE="${LOG_THROTTLE-belt:rate=20,dispatcher:rate=20}"
+# Belt transit time in ms (0 = packages reach the dispatcher immediately).
+export BELT_SPEED_MS="${BELT_SPEED_MS:-0}"
+# Belt service order: "fifo" or "edf" (earliest SLA deadline first).
+export BELT_ORDER="${BELT_ORDER:-fifo}"
+# SLA budgets "STANDARD,PRIORITY,URGENT" in ms (empty = 15000,5000,2000).
+export SLA_BUDGET_MS="${SLA_BUDGET_MS:-}"
+export METRICS_PORT="9464"
+export METRICS_TEXTFILE="logs/warehouse.prom"
+export AUDIT_JOURNAL_DIR="logs/journal"
+export DELIVERY_LEDGER="logs/deliveries.ledger"
+export SAMPLER_FILE="logs/belt.series"
+export SAMPLER_HZ="100"
+export RESOURCE_SAMPLER_MS="1000"
+export WATCHDOG_STALL_MS="10000"
+export WATCHDOG_RECOVER="false"
+# Binary state-delta stream for dashboards (empty disables); read it with
+# ./build/stream. Changes are picked up every STATE_STREAM_INTERVAL_MS.
+export STATE_STREAM_SOCKET="${STATE_STREAM_SOCKET-logs/state.sock}"
+export STATE_STREAM_INTERVAL_MS="${STATE_STREAM_INTERVAL_MS:-2}"
+# Worker intake: per-worker rates "R1,R2,R3" in pkg/s (empty = legacy pacing)
+# and an arrival shape, e.g. "poisson", "bursty:6:2:0.5", "onoff:1:2" or
+# "diurnal:60:0.8" (see include/ArrivalProcess.h).
+export WORKER_RATE_HZ="${WORKER_RATE_HZ:-}"
+export WORKER_ARRIVAL="${WORKER_ARRIVAL:-}"
+# Sorter lanes are opt-in, e.g. SORTER_RULE="type" or "weight:5,15".
+export SORTER_RULE="${SORTER_RULE:-}"
 
 if [ ! -f "./build/main" ]; then
   echo -e "${CYAN}[error] Binary ./build/main not found! Run 'make build' first.${RESET}"
@@ -4,17 +4,37 @@
  * * Initializes IPC resources using Manager(true).
  * * Spawns worker processes using fork() and execv().
  * * Monitors child processes and handles clean shutdown (SIGINT).
+ * * SIGHUP rolls every role onto the binaries currently in ./build, one
+ * process at a time (workers, trucks, express, dispatchers, sorter, belt),
+ * while the shared segment and the rest of the fleet stay up:
+ *   make build && kill -HUP $(pgrep -x main)
+ * Each binary is first run with SHM_ABI_CHECK=1 to confirm it understands
+ * the segment's layout; an incompatible build stops the rollout before any
+ * process is replaced. A replaced process gets ROLL_STOP_MS (default 15000)
+ * to leave after SIGTERM before SIGKILL, and its successor must log in
+ * within ROLL_READY_MS (default 5000).
  */
 #include "../include/Config.h"
+#include "../include/EventChannel.h"
 #include "../include/Manager.h"
+#include <cerrno>
 #include <csignal>
 #include <filesystem>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <vector>
 
+/** @brief A spawned role process and how to spawn it again. */
+struct Child {
+  pid_t pid;
+  std::string binary;
+  std::string name;
+  std::string arg;
+};
+
 volatile std::sig_atomic_t stop_requested = 0;
-std::vector<pid_t> children_pids;
+volatile std::sig_atomic_t roll_requested = 0;
+std::vector<Child> children;
 
 /**
  * @brief Signal handler for Ctrl+C (SIGINT).
@@ -22,49 +42,162 @@ std::vector<pid_t> children_pids;
  */
 void handleSigint(int) { stop_requested = 1; }
 
+/** @brief Signal handler for SIGHUP: requests a rolling restart. */
+void handleSighup(int) { roll_requested = 1; }
+
 /**
- * @brief Spawns a child process using fork/exec pattern.
- * @param binary_path Relative or absolute path to the executable.
- * @param proc_name Name of the process (argv[0]).
- * @param arg Optional argument (argv[1]), e.g., Worker ID. Default is empty.
+ * @brief Forks and execs one role process.
+ * @param env_check If true, the child only validates the segment layout
+ * (SHM_ABI_CHECK) and exits.
+ * @return The child's PID.
  */
-void spawnChild(const std::string &binary_path, const std::string &proc_name,
-                const std::string &arg = "") {
+pid_t forkExec(const Child &c, bool env_check = false) {
   pid_t pid = fork();
 
   if (pid < 0) {
-    spdlog::critical("[master] Failed to fork process: {}", proc_name);
+    spdlog::critical("[master] Failed to fork process: {}", c.name);
     exit(1);
   }
 
   if (pid == 0) {
     std::vector<char *> args;
 
-    args.push_back(const_cast<char *>(proc_name.c_str()));
+    args.push_back(const_cast<char *>(c.name.c_str()));
 
-    if (!arg.empty()) {
-      args.push_back(const_cast<char *>(arg.c_str()));
+    if (!c.arg.empty()) {
+      args.push_back(const_cast<char *>(c.arg.c_str()));
     }
 
     args.push_back(nullptr);
 
-    execv(binary_path.c_str(), args.data());
+    if (env_check)
+      setenv("SHM_ABI_CHECK", "1", 1);
+    execv(c.binary.c_str(), args.data());
 
     perror("execv failed");
     exit(1);
+  }
+  return pid;
+}
+
+/**
+ * @brief Spawns a child process using fork/exec pattern.
+ * @param binary_path Relative or absolute path to the executable.
+ * @param proc_name Name of the process (argv[0]).
+ * @param arg Optional argument (argv[1]), e.g., Worker ID. Default is empty.
+ */
+void spawnChild(const std::string &binary_path, const std::string &proc_name,
+                const std::string &arg = "") {
+  Child c{0, binary_path, proc_name, arg};
+  c.pid = forkExec(c);
+  if (arg.empty()) {
+    spdlog::info("[master] Spawned {} (PID: {})", proc_name, c.pid);
   } else {
-    if (arg.empty()) {
-      spdlog::info("[master] Spawned {} (PID: {})", proc_name, pid);
-    } else {
-      spdlog::info("[master] Spawned {} with ID {} (PID: {})", proc_name, arg,
-                   pid);
+    spdlog::info("[master] Spawned {} with ID {} (PID: {})", proc_name, arg,
+                 c.pid);
+  }
+  children.push_back(c);
+}
+
+/** @brief True once `pid` has exited (reaping it if it was not yet). */
+bool hasExited(pid_t pid) {
+  pid_t r = waitpid(pid, nullptr, WNOHANG);
+  return r == pid || (r == -1 && errno == ECHILD);
+}
+
+/**
+ * @brief Waits for `pid` to exit, escalating to SIGKILL after `timeout_ms`.
+ * @return true if it left on its own.
+ */
+bool awaitExit(pid_t pid, int timeout_ms) {
+  auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (hasExited(pid))
+      return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  kill(pid, SIGKILL);
+  waitpid(pid, nullptr, 0);
+  return false;
+}
+
+/** @brief Waits until `pid` holds a session in shared memory. */
+bool awaitLogin(SharedState *shm, pid_t pid, int timeout_ms) {
+  auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (std::chrono::steady_clock::now() < deadline) {
+    for (const UserSession &u : shm->users) {
+      if (atomicLoad(u.active) && atomicLoad(u.session_pid) == pid)
+        return true;
+    }
+    if (hasExited(pid))
+      return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  return false;
+}
+
+/**
+ * @brief Replaces every child with a fresh process of the same role.
+ *
+ * Roles are rolled producers first and the belt last, so consumers keep
+ * draining while their sources restart. Each new binary passes the
+ * layout preflight before its first process is stopped; a failed preflight
+ * or a successor that does not log in aborts the rollout.
+ */
+void rollingRestart(Manager &manager) {
+  static const char *order[] = {"worker",     "truck",  "express",
+                                "dispatcher", "sorter", "belt"};
+  int stop_ms =
+      std::atoi(Config::get().getEnv("ROLL_STOP_MS", "15000").c_str());
+  int ready_ms =
+      std::atoi(Config::get().getEnv("ROLL_READY_MS", "5000").c_str());
+
+  spdlog::warn("[master] Rolling restart of {} processes.", children.size());
+  int rolled = 0;
+  for (const char *role : order) {
+    bool checked = false;
+    for (Child &c : children) {
+      if (c.name != role || stop_requested)
+        continue;
+
+      if (!checked) {
+        int status = 0;
+        waitpid(forkExec(c, true), &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+          spdlog::critical("[master] {} failed the layout check (status {}). "
+                           "Rollout aborted after {} processes.",
+                           c.binary, WEXITSTATUS(status), rolled);
+          return;
+        }
+        checked = true;
+      }
+
+      kill(c.pid, SIGTERM);
+      if (!awaitExit(c.pid, stop_ms))
+        spdlog::warn("[master] {} (PID {}) ignored SIGTERM; killed.", c.name,
+                     c.pid);
+
+      pid_t old_pid = c.pid;
+      c.pid = forkExec(c);
+      if (!awaitLogin(manager.getState(), c.pid, ready_ms)) {
+        spdlog::critical("[master] New {} (PID {}) did not come up. Rollout "
+                         "aborted after {} processes.",
+                         c.name, c.pid, rolled);
+        return;
+      }
+      spdlog::info("[master] Rolled {}{}: PID {} -> {}", c.name,
+                   c.arg.empty() ? "" : " " + c.arg, old_pid, c.pid);
+      rolled++;
     }
-    children_pids.push_back(pid);
   }
+  spdlog::info("[master] Rolling restart complete ({} processes).", rolled);
 }
 
 int main() {
   std::signal(SIGINT, handleSigint);
+  std::signal(SIGHUP, handleSighup);
 
   if (!std::filesystem::exists("logs")) {
     std::filesystem::create_directory("logs");
@@ -77,14 +210,19 @@ int main() {
       "[master] Starting Warehouse Orchestrator with Fleet Support...");
 
   Manager manager(true);
+  int lanes = manager.getState()->lane_count;
 
   spawnChild("./build/dispatcher", "dispatcher");
+  for (int i = 2; i <= lanes; ++i)
+    spawnChild("./build/dispatcher", "dispatcher", std::to_string(i));
+  if (lanes > 0)
+    spawnChild("./build/sorter", "sorter");
   spawnChild("./build/express", "express");
   spawnChild("./build/belt", "belt");
 
   std::this_thread::sleep_for(std::chrono::milliseconds(500));
 
-  int num_trucks = 2;
+  int num_trucks = lanes > 2 ? lanes : 2;
   for (int i = 1; i <= num_trucks; ++i) {
     spawnChild("./build/truck", "truck", std::to_string(i));
     std::this_thread::sleep_for(std::chrono::milliseconds(200));
@@ -108,6 +246,18 @@ int main() {
       spdlog::warn(
           "[master] Process PID {} died. Check logs for stability issues.",
           dead_pid);
+      const char *name = "";
+      for (const Child &c : children) {
+        if (c.pid == dead_pid)
+          name = c.name.c_str();
+      }
+      publishEvent(manager.getState(), EventKind::ProcessDied, dead_pid,
+                   status, name);
+    }
+
+    if (roll_requested) {
+      roll_requested = 0;
+      rollingRestart(manager);
     }
 
     std::this_thread::sleep_for(std::chrono::milliseconds(500));
@@ -116,9 +266,10 @@ int main() {
   spdlog::warn(
       "[master] Shutdown signal received. Terminating all processes...");
   manager.getState()->running = false;
+  publishEvent(manager.getState(), EventKind::Shutdown, getpid(), 0);
 
-  for (pid_t pid : children_pids) {
-    kill(pid, SIGTERM);
+  for (const Child &c : children) {
+    kill(c.pid, SIGTERM);
   }
 
   std::this_thread::sleep_for(std::chrono::seconds(1));
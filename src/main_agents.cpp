@@ -0,0 +1,204 @@
+/**
+ * @file main_agents.cpp
+ * @brief Benchmark of the in-process agent engine (see AgentEngine.h).
+ * * Runs one warehouse with tens of thousands of workers and trucks as agents
+ * on a small thread pool, for a fixed duration, and reports:
+ * - package conservation (created = loaded + on belt + in dispatch),
+ * - agent resumptions per second and work stealing,
+ * - throughput of the belt and the fleet,
+ * - belt-to-truck latency percentiles,
+ * - resident memory per agent,
+ * - with `--perf`, hardware and software counters per package loaded
+ *   (see PerfCounters.h).
+ * * Usage: ./agents [--workers N] [--trucks M] [--dispatchers D]
+ *                  [--express E] [--threads T] [--duration SEC]
+ *                  [--rate PKG_PER_SEC] [--arrival SPEC] [--seed N]
+ *                  [--fast-trucks] [--perf] [--log-level LEVEL]
+ * * `--rate` is the total offered load, split evenly over the workers and
+ * shaped by `--arrival` (WORKER_ARRIVAL syntax, default poisson).
+ */
+#include "../include/AgentEngine.h"
+#include "../include/Config.h"
+#include "../include/PerfCounters.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+
+/**
+ * @struct AgentBenchOptions
+ * @brief Command line parameters of a benchmark run.
+ */
+struct AgentBenchOptions {
+  AgentSimOptions sim;
+  int duration_s = 10;
+  double rate = 20000.0; /**< Total packages per second. */
+  std::string arrival = "poisson";
+  std::string log_level = "warn";
+  bool perf = false; /**< Capture hardware/software counters. */
+};
+
+void printUsage() {
+  std::printf("Usage: agents [--workers N] [--trucks M] [--dispatchers D]\n"
+              "              [--express E] [--threads T] [--duration SEC]\n"
+              "              [--rate PKG_PER_SEC] [--arrival SPEC] [--seed N]\n"
+              "              [--fast-trucks] [--perf] [--log-level LEVEL]\n");
+}
+
+bool parseOptions(int argc, char *argv[], AgentBenchOptions &opt) {
+  AgentSimOptions &sim = opt.sim;
+  sim.workers = 50000;
+  sim.trucks = 50000;
+  sim.threads = std::max(1u, std::thread::hardware_concurrency());
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (arg == "--workers" && has_value) {
+      sim.workers = std::atoi(argv[++i]);
+    } else if (arg == "--trucks" && has_value) {
+      sim.trucks = std::atoi(argv[++i]);
+    } else if (arg == "--dispatchers" && has_value) {
+      sim.dispatchers = std::atoi(argv[++i]);
+    } else if (arg == "--express" && has_value) {
+      sim.express = std::atoi(argv[++i]);
+    } else if (arg == "--threads" && has_value) {
+      sim.threads = std::atoi(argv[++i]);
+    } else if (arg == "--duration" && has_value) {
+      opt.duration_s = std::atoi(argv[++i]);
+    } else if (arg == "--rate" && has_value) {
+      opt.rate = std::atof(argv[++i]);
+    } else if (arg == "--arrival" && has_value) {
+      opt.arrival = argv[++i];
+    } else if (arg == "--seed" && has_value) {
+      sim.seed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--fast-trucks") {
+      sim.route_min_ms = 20;
+      sim.route_max_ms = 80;
+    } else if (arg == "--log-level" && has_value) {
+      opt.log_level = argv[++i];
+    } else if (arg == "--perf") {
+      opt.perf = true;
+    } else {
+      return false;
+    }
+  }
+
+  if (sim.workers < 1 || sim.trucks < 1 || sim.dispatchers < 1 ||
+      sim.dispatchers > DOCK_CLIENT_SLOTS || sim.express < 0 ||
+      sim.threads < 1 || opt.duration_s < 1 || !(opt.rate > 0)) {
+    std::fprintf(stderr,
+                 "[agents] Invalid sizing: >=1 worker, truck and thread, "
+                 "1..%d dispatchers, a positive --rate.\n",
+                 DOCK_CLIENT_SLOTS);
+    return false;
+  }
+  if (!parseArrivalSpec(opt.arrival.c_str(), opt.rate / sim.workers,
+                        sim.arrival)) {
+    std::fprintf(stderr, "[agents] Invalid arrival '%s'.\n",
+                 opt.arrival.c_str());
+    return false;
+  }
+  return true;
+}
+
+/** @brief Resident set size of this process [KiB]. */
+long residentKiB() {
+  std::ifstream status("/proc/self/status");
+  std::string key;
+  long value = 0;
+  while (status >> key) {
+    if (key == "VmRSS:") {
+      status >> value;
+      return value;
+    }
+    status.ignore(4096, '\n');
+  }
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  AgentBenchOptions opt;
+  if (!parseOptions(argc, argv, opt)) {
+    printUsage();
+    return EXIT_FAILURE;
+  }
+
+  setenv("LOG_LEVEL", opt.log_level.c_str(), 1);
+  setenv("LOG_TO_FILE", "false", 1);
+  setenv("LOG_TO_CONSOLE", "true", 1);
+  Config::get().setupLogger("agents");
+
+  const AgentSimOptions &sim = opt.sim;
+  std::printf("[agents] %d workers, %d trucks, %d dispatchers, %d express, "
+              "%d threads, %ds, %.0f pkg/s '%s'\n",
+              sim.workers, sim.trucks, sim.dispatchers, sim.express,
+              sim.threads, opt.duration_s, opt.rate, opt.arrival.c_str());
+
+  long rss_before = residentKiB();
+  AgentWarehouse warehouse(sim);
+  long rss_agents = residentKiB() - rss_before;
+  SharedState *shm = warehouse.shm.get();
+
+  // Opened before the pool starts: its threads inherit the counters.
+  std::unique_ptr<PerfCounters> perf;
+  if (opt.perf) {
+    perf = std::make_unique<PerfCounters>(true);
+    perf->start();
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  warehouse.start();
+  for (int t = 1; t <= opt.duration_s; ++t) {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    std::printf("[agents] t=%3ds created=%-9d loaded=%-9llu belt=%-2d "
+                "trucks=%d\n",
+                t, atomicLoad(shm->total_packages_created),
+                (unsigned long long)atomicLoad(shm->stats.packages_loaded),
+                atomicLoad(shm->current_items_count),
+                atomicLoad(shm->trucks_completed));
+  }
+  warehouse.stop();
+  if (perf)
+    perf->stop();
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  const WarehouseStats &st = shm->stats;
+  long long created = shm->total_packages_created;
+  long long loaded = st.packages_loaded;
+  long long on_belt = shm->current_items_count;
+  long long in_dispatch = st.packages_in_dispatch;
+  bool conserved = created == loaded + on_belt + in_dispatch;
+  uint64_t resumes = warehouse.engine.resumeCount();
+
+  std::printf("\n=== Agent engine report (%.1fs) ===\n", elapsed);
+  std::printf("Conservation: created=%lld loaded=%lld on_belt=%lld "
+              "in_dispatch=%lld -> %s\n",
+              created, loaded, on_belt, in_dispatch,
+              conserved ? "OK" : "VIOLATED");
+  std::printf("Agents:       %zu on %d threads, %.0f resumes/s, "
+              "%llu stolen\n",
+              warehouse.agentCount(), warehouse.engine.threadCount(),
+              resumes / elapsed,
+              (unsigned long long)warehouse.engine.stealCount());
+  std::printf("Throughput:   created %.1f pkg/s, loaded %.1f pkg/s, "
+              "%.2f trucks/s\n",
+              created / elapsed, loaded / elapsed,
+              shm->trucks_completed / elapsed);
+  std::printf("Express:      %llu packages loaded\n",
+              (unsigned long long)st.express_loaded);
+  std::printf("Latency (belt->truck, ms): p50 %.1f  p90 %.1f  p99 %.1f\n",
+              latencyPercentileMs(st, 0.50), latencyPercentileMs(st, 0.90),
+              latencyPercentileMs(st, 0.99));
+  std::printf("Memory:       %ld KiB for the agents, %.0f bytes/agent\n",
+              rss_agents, 1024.0 * rss_agents / warehouse.agentCount());
+  if (perf)
+    perf->report(stdout, loaded, elapsed * 1e9);
+
+  return conserved ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -4,9 +4,39 @@
  * * This worker connects to existing IPC resources (`owner=false`) and logs in
  * via the SessionManager. It operates in a loop, creating new packages with
  * randomized weights and pushing them into the circular buffer.
+ * * Also hosts the Prometheus exporter thread (see MetricsExporter.h),
+ * configured through METRICS_PORT, METRICS_SOCKET, METRICS_TEXTFILE and
+ * METRICS_INTERVAL_MS.
+ * * When SAMPLER_FILE is set, a second thread records lock-free snapshots of
+ * the belt, dock and throughput counters at SAMPLER_HZ (default 100, at most
+ * 1000) into a delta-encoded series file (see TimeSeriesSampler.h).
+ * * With a belt speed set (BELT_SPEED_MS, read by the IPC owner), a transit
+ * thread advances the belt's timer wheel every millisecond and releases
+ * packages that reached the end of the belt to the dispatcher.
+ * * A resource sampler thread reads CPU time, memory, context switches and
+ * run-queue wait of every session's process from procfs each
+ * RESOURCE_SAMPLER_MS (default 1000, 0 disables) and publishes them per
+ * role (see ResourceSampler.h).
+ * * A watchdog thread flags processes whose heartbeat has not moved for
+ * WATCHDOG_STALL_MS (default 10000, 0 disables) and logs the wait-for
+ * graph; WATCHDOG_RECOVER=true also releases mutexes of dead holders and
+ * kills stalled ones that block others (see Watchdog.h).
+ * * With STATE_STREAM_SOCKET set, a publisher thread streams belt, dock,
+ * fleet and session changes to dashboards connected to that UNIX socket,
+ * checking the regions' generation counters every STATE_STREAM_INTERVAL_MS
+ * (default 2; see StateStream.h).
+ * * The monitoring loop feeds QueueAnalytics every 100 ms (smoothing time
+ * constant ANALYTICS_TAU_S, default 10) and publishes the bottleneck
+ * estimate to shared memory.
  */
 #include "../include/Config.h"
 #include "../include/Manager.h"
+#include "../include/MetricsExporter.h"
+#include "../include/QueueAnalytics.h"
+#include "../include/ResourceSampler.h"
+#include "../include/StateStream.h"
+#include "../include/TimeSeriesSampler.h"
+#include "../include/Watchdog.h"
 #include <atomic>
 #include <chrono>
 #include <csignal>
@@ -46,27 +76,128 @@ int main() {
 
     spdlog::info("[belt-proc] Connected to IPC. Observing buffer metrics...");
 
+    auto exporter = std::make_unique<MetricsExporter>(manager.getState());
+    std::string port = Config::get().getEnv("METRICS_PORT", "");
+    std::string socket_path = Config::get().getEnv("METRICS_SOCKET", "");
+    std::string textfile = Config::get().getEnv("METRICS_TEXTFILE", "");
+    int interval_ms =
+        std::atoi(Config::get().getEnv("METRICS_INTERVAL_MS", "1000").c_str());
+
+    if (!port.empty())
+      exporter->listenLoopback(static_cast<uint16_t>(std::atoi(port.c_str())));
+    if (!socket_path.empty())
+      exporter->listenUnix(socket_path);
+    if (!textfile.empty())
+      exporter->setTextfile(textfile, interval_ms);
+
+    std::thread exporter_thread([&]() { exporter->run(stop_flag); });
+
+    std::unique_ptr<TimeSeriesSampler> sampler;
+    std::thread sampler_thread;
+    std::string series_path = Config::get().getEnv("SAMPLER_FILE", "");
+    if (!series_path.empty()) {
+      int hz = std::atoi(Config::get().getEnv("SAMPLER_HZ", "100").c_str());
+      sampler = std::make_unique<TimeSeriesSampler>(manager.getState(),
+                                                    series_path, hz);
+      if (sampler->isOpen()) {
+        spdlog::info("[belt-proc] Sampling every {} us into {}",
+                     sampler->intervalNs() / 1000, series_path);
+        sampler_thread = std::thread([&]() { sampler->run(stop_flag); });
+      }
+    }
+
+    std::unique_ptr<ResourceSampler> resources;
+    std::thread resources_thread;
+    int resources_ms = std::atoi(
+        Config::get().getEnv("RESOURCE_SAMPLER_MS", "1000").c_str());
+    if (resources_ms > 0) {
+      resources =
+          std::make_unique<ResourceSampler>(manager.getState(), resources_ms);
+      resources_thread = std::thread([&]() { resources->run(stop_flag); });
+    }
+
+    std::unique_ptr<Watchdog> watchdog;
+    std::thread watchdog_thread;
+    int stall_ms = std::atoi(
+        Config::get().getEnv("WATCHDOG_STALL_MS", "10000").c_str());
+    if (stall_ms > 0) {
+      bool recover =
+          Config::get().getEnv("WATCHDOG_RECOVER", "false") == "true";
+      watchdog = std::make_unique<Watchdog>(
+          manager.getState(), stall_ms,
+          [&](SemIndex s) { manager.semOperation(s, 1); }, recover);
+      int period_ms = std::min(1000, std::max(100, stall_ms / 4));
+      spdlog::info("[belt-proc] Watchdog: stall after {} ms{}.", stall_ms,
+                   recover ? ", recovery enabled" : "");
+      watchdog_thread = std::thread(
+          [&, period_ms]() { watchdog->run(stop_flag, period_ms); });
+    }
+
+    std::unique_ptr<StateStream> stream;
+    std::thread stream_thread;
+    std::string stream_path = Config::get().getEnv("STATE_STREAM_SOCKET", "");
+    if (!stream_path.empty()) {
+      int stream_ms = std::atoi(
+          Config::get().getEnv("STATE_STREAM_INTERVAL_MS", "2").c_str());
+      stream = std::make_unique<StateStream>(manager.getState(), stream_ms);
+      if (stream->listen(stream_path))
+        stream_thread = std::thread([&]() { stream->run(stop_flag); });
+    }
+
+    std::thread transit_thread;
+    if (manager.getState()->transit.speed_ms > 0) {
+      spdlog::info("[belt-proc] Belt transit time {} ms.",
+                   manager.getState()->transit.speed_ms);
+      transit_thread =
+          std::thread([&]() { manager.belt->runTransit(stop_flag); });
+    }
+
+    QueueAnalytics analytics(
+        manager.getState(),
+        std::atof(Config::get().getEnv("ANALYTICS_TAU_S", "10").c_str()));
     int log_counter = 0;
 
     while (!stop_flag.load() && manager.getState()->running) {
+      manager.heartbeat();
 
       if (++log_counter >= 5) {
         int count = manager.belt->getCount();
+        int moving = manager.belt->getInTransit();
         int workers = manager.belt->getWorkerCount();
+        const AnalyticsState &flow = analytics.current();
 
         spdlog::info(
-            "[belt-proc] Status: {:02d} items on belt | {:02d} active workers.",
-            count, workers);
+            "[belt-proc] Status: {:02d} items on belt ({} in transit) | "
+            "{:02d} active workers | bottleneck: {} ({:.0f}%).",
+            count, moving, workers, QueueAnalytics::stageName(flow.bottleneck),
+            100.0 * flow.confidence);
         log_counter = 0;
       }
 
       for (int i = 0; i < 10; ++i) {
         if (stop_flag.load() || !manager.getState()->running)
           break;
+        analytics.update();
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
       }
     }
 
+    stop_flag.store(true);
+    exporter_thread.join();
+    if (transit_thread.joinable())
+      transit_thread.join();
+    if (resources_thread.joinable())
+      resources_thread.join();
+    if (watchdog_thread.joinable())
+      watchdog_thread.join();
+    if (stream_thread.joinable())
+      stream_thread.join();
+    if (sampler_thread.joinable()) {
+      sampler_thread.join();
+      spdlog::info("[belt-proc] Recorded {} samples ({} ticks missed).",
+                   sampler->samples(), sampler->missed());
+    }
+
     spdlog::info("[belt-proc] Monitoring finished. Relinquishing control.");
 
   } catch (const std::exception &e) {
@@ -2,18 +2,30 @@
  * @file dispatcher_main.cpp
  * @brief Dispatcher consumer process.
  * Uses existing SessionManager with RAII safety wrapper.
+ * * Usage: ./dispatcher [ID]. The first dispatcher keeps the historical
+ * "System-Dispatcher" session name; additional ones append their ID.
+ * * With a sorter configured, dispatcher ID serves lane (ID - 1) % lanes.
  */
 
 #include "../include/Config.h"
 #include "../include/Manager.h"
+#include <csignal>
+#include <string>
+
+Dispatcher *global_dispatcher_ptr = nullptr;
+
+void signalHandler(int) {
+  if (global_dispatcher_ptr) {
+    global_dispatcher_ptr->stop();
+  }
+}
 
 class DispatcherSession {
   Manager &m;
 
 public:
-  DispatcherSession(Manager &manager) : m(manager) {
-    if (!m.session_store->login("System-Dispatcher", UserRole::Operator, 0,
-                                1)) {
+  DispatcherSession(Manager &manager, const std::string &name) : m(manager) {
+    if (!m.session_store->login(name, UserRole::Operator, 0, 1)) {
       throw std::runtime_error(
           "Critical: Could not log in to Warehouse System.");
     }
@@ -26,12 +38,22 @@ public:
   }
 };
 
-int main() {
+int main(int argc, char *argv[]) {
   try {
+    int dispatcher_id = (argc > 1) ? std::atoi(argv[1]) : 1;
+    std::string name = "System-Dispatcher";
+    if (dispatcher_id > 1)
+      name += "_" + std::to_string(dispatcher_id);
+
     Config::get().setupLogger("system-dispatcher");
 
     Manager manager(false);
-    DispatcherSession session(manager);
+    DispatcherSession session(manager, name);
+    manager.useLane(dispatcher_id - 1);
+
+    global_dispatcher_ptr = manager.dispatcher.get();
+    std::signal(SIGINT, signalHandler);
+    std::signal(SIGTERM, signalHandler);
 
     spdlog::info("[dispatcher] Ready to route packages. Entering main loop.");
 
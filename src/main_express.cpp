@@ -33,6 +33,7 @@ int main() {
 
     Manager manager(false);
     P4SessionGuard session(manager);
+    manager.useLane(0);
 
     spdlog::info("[express-proc] P4 Standing by. Waiting for Signal 2 (Express "
                  "Load)...");
@@ -47,6 +48,7 @@ int main() {
             "[express-proc] Signal 2 Received! Starting batch delivery.");
 
         manager.express->deliverExpressBatch();
+        manager.heartbeat();
 
         spdlog::info(
             "[express-proc] Batch delivery finished. Returning to standby.");
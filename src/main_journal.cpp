@@ -0,0 +1,119 @@
+/**
+ * @file main_journal.cpp
+ * @brief Offline reader for the package audit journal.
+ * * Maps the segment files written by the simulation (see AuditJournal.h)
+ * read-only, so it can be run while the warehouse is still working.
+ * * Usage: ./journal [--dir DIR] [--package ID | --tail N | --summary]
+ * * The directory defaults to `AUDIT_JOURNAL_DIR` or `logs/journal`.
+ */
+#include "../include/AuditJournal.h"
+#include "../include/Config.h"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <map>
+#include <string>
+
+void printUsage() {
+  std::printf("Usage: journal [--dir DIR] [--package ID | --tail N | "
+              "--summary]\n");
+}
+
+void printRecord(uint64_t index, const JournalRecord &rec) {
+  time_t secs = static_cast<time_t>(rec.timestamp_ns / 1000000000ULL);
+  struct tm tm_buf;
+  localtime_r(&secs, &tm_buf);
+
+  char when[32];
+  std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &tm_buf);
+  char action[96];
+
+  std::printf("#%-10llu %s.%09llu  pkg %-8u pid %-7d %s\n",
+              (unsigned long long)index, when,
+              (unsigned long long)(rec.timestamp_ns % 1000000000ULL),
+              rec.package_id, rec.pid,
+              describeAction(rec.action, action, sizeof(action)));
+}
+
+int main(int argc, char *argv[]) {
+  std::string dir = Config::getEnvRaw("AUDIT_JOURNAL_DIR", "logs/journal");
+  long long package = -1;
+  long long tail = -1;
+  bool summary = false;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (arg == "--dir" && has_value) {
+      dir = argv[++i];
+    } else if (arg == "--package" && has_value) {
+      package = std::atoll(argv[++i]);
+    } else if (arg == "--tail" && has_value) {
+      tail = std::atoll(argv[++i]);
+    } else if (arg == "--summary") {
+      summary = true;
+    } else {
+      printUsage();
+      return EXIT_FAILURE;
+    }
+  }
+
+  JournalReader reader(dir);
+  if (reader.capacity() == 0) {
+    std::fprintf(stderr, "[journal] No journal segments found in %s\n",
+                 dir.c_str());
+    return EXIT_FAILURE;
+  }
+
+  if (package >= 0) {
+    reader.buildIndex();
+    auto events = reader.history(static_cast<uint32_t>(package));
+    if (events.empty()) {
+      std::printf("Package %lld has no recorded events.\n", package);
+      return EXIT_FAILURE;
+    }
+    std::printf("Package %lld: %zu events\n", package, events.size());
+    for (size_t i = 0; i < events.size(); ++i)
+      printRecord(i, events[i]);
+    return EXIT_SUCCESS;
+  }
+
+  if (summary) {
+    size_t packages = reader.buildIndex();
+    std::map<uint8_t, uint64_t> per_action;
+    uint64_t first_ns = 0, last_ns = 0;
+    uint64_t total = reader.forEach([&](uint64_t, const JournalRecord &rec) {
+      per_action[rec.action]++;
+      if (first_ns == 0 || rec.timestamp_ns < first_ns)
+        first_ns = rec.timestamp_ns;
+      if (rec.timestamp_ns > last_ns)
+        last_ns = rec.timestamp_ns;
+    });
+
+    std::printf("Journal %s: %llu records, %zu packages, %.3f s span\n",
+                dir.c_str(), (unsigned long long)total, packages,
+                total ? (last_ns - first_ns) / 1e9 : 0.0);
+    char action[96];
+    for (const auto &[mask, count] : per_action) {
+      std::printf("  %-40s %llu\n",
+                  describeAction(mask, action, sizeof(action)),
+                  (unsigned long long)count);
+    }
+    return EXIT_SUCCESS;
+  }
+
+  if (tail >= 0) {
+    uint64_t total = reader.forEach([](uint64_t, const JournalRecord &) {});
+    uint64_t skip = total > (uint64_t)tail ? total - tail : 0;
+    uint64_t seen = 0;
+    reader.forEach([&](uint64_t index, const JournalRecord &rec) {
+      if (seen++ >= skip)
+        printRecord(index, rec);
+    });
+    return EXIT_SUCCESS;
+  }
+
+  reader.forEach(printRecord);
+  return EXIT_SUCCESS;
+}
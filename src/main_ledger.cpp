@@ -0,0 +1,131 @@
+/**
+ * @file main_ledger.cpp
+ * @brief Scan/aggregate tool for the columnar delivery ledger.
+ * * Maps the ledger read-only and aggregates departures, skipping blocks
+ * whose min/max statistics exclude the filter.
+ * * Usage: ./ledger [--file PATH] [--truck PID] [--reason NAME]
+ *                  [--since-s SEC] [--blocks]
+ * * The file defaults to `DELIVERY_LEDGER` or `logs/deliveries.ledger`.
+ */
+#include "../include/Config.h"
+#include "../include/DeliveryLedger.h"
+#include "../include/Telemetry.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+const char *reasonName(int reason) {
+  static const char *names[] = {"unknown", "full",   "no_fit",
+                                "express", "forced", "shutdown"};
+  return reason >= 0 && reason < static_cast<int>(DepartureReason::Total)
+             ? names[reason]
+             : "?";
+}
+
+int reasonFromName(const std::string &name) {
+  for (int r = 0; r < static_cast<int>(DepartureReason::Total); ++r) {
+    if (name == reasonName(r))
+      return r;
+  }
+  return -2;
+}
+
+void printUsage() {
+  std::printf("Usage: ledger [--file PATH] [--truck PID] [--reason NAME]\n"
+              "              [--since-s SEC] [--blocks]\n"
+              "Reasons: unknown full no_fit express forced shutdown\n");
+}
+
+int main(int argc, char *argv[]) {
+  std::string path =
+      Config::getEnvRaw("DELIVERY_LEDGER", "logs/deliveries.ledger");
+  LedgerFilter filter;
+  bool list_blocks = false;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (arg == "--file" && has_value) {
+      path = argv[++i];
+    } else if (arg == "--truck" && has_value) {
+      filter.truck_id = std::atoi(argv[++i]);
+    } else if (arg == "--reason" && has_value) {
+      filter.reason = reasonFromName(argv[++i]);
+      if (filter.reason == -2) {
+        printUsage();
+        return EXIT_FAILURE;
+      }
+    } else if (arg == "--since-s" && has_value) {
+      uint64_t window = std::strtoull(argv[++i], nullptr, 10) * 1000000000ULL;
+      uint64_t now = realtimeNowNs();
+      filter.from_ns = now > window ? now - window : 0;
+    } else if (arg == "--blocks") {
+      list_blocks = true;
+    } else {
+      printUsage();
+      return EXIT_FAILURE;
+    }
+  }
+
+  LedgerReader reader(path);
+  if (!reader.valid()) {
+    std::fprintf(stderr, "[ledger] %s is missing or not a delivery ledger\n",
+                 path.c_str());
+    return EXIT_FAILURE;
+  }
+
+  if (list_blocks) {
+    int n = 0;
+    reader.forEachBlock([&](const LedgerBlockHeader &h,
+                            const uint8_t *const *) {
+      std::printf("block %-5d rows %-5u trucks [%llu, %llu]  "
+                  "load [%llu, %llu]  weight [%.1f, %.1f] kg\n",
+                  n++, h.rows, (unsigned long long)h.min[COL_TRUCK_ID].u,
+                  (unsigned long long)h.max[COL_TRUCK_ID].u,
+                  (unsigned long long)h.min[COL_LOAD_COUNT].u,
+                  (unsigned long long)h.max[COL_LOAD_COUNT].u,
+                  h.min[COL_WEIGHT].f, h.max[COL_WEIGHT].f);
+    });
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  LedgerAggregate agg = reader.scan(filter);
+  double scan_ms = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  double span_s = agg.departures > 1
+                      ? (agg.last_depart_ns - agg.first_depart_ns) / 1e9
+                      : 0.0;
+
+  std::printf("Departures:        %llu (%llu blocks scanned, %llu skipped, "
+              "%.2f ms)\n",
+              (unsigned long long)agg.departures,
+              (unsigned long long)agg.blocks_scanned,
+              (unsigned long long)agg.blocks_skipped, scan_ms);
+  if (agg.departures == 0)
+    return EXIT_SUCCESS;
+
+  std::printf("Packages:          %llu (%.1f per truck)\n",
+              (unsigned long long)agg.packages,
+              (double)agg.packages / agg.departures);
+  std::printf("Payload:           %.1f kg, %.3f m3\n", agg.weight, agg.volume);
+  std::printf("Fleet utilization: %.1f%% weight, %.1f%% volume\n",
+              100.0 * agg.meanWeightUtilization(),
+              100.0 * agg.meanVolumeUtilization());
+  std::printf("Mean dock time:    %.3f s\n", agg.dock_seconds / agg.departures);
+  if (span_s > 0)
+    std::printf("Departure rate:    %.2f trucks/s over %.1f s\n",
+                (agg.departures - 1) / span_s, span_s);
+
+  std::printf("By reason:\n");
+  for (int r = 0; r < static_cast<int>(DepartureReason::Total); ++r) {
+    if (agg.by_reason[r]) {
+      std::printf("  %-10s %llu\n", reasonName(r),
+                  (unsigned long long)agg.by_reason[r]);
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file main_series.cpp
+ * @brief Decoder and CSV exporter for the belt time-series file.
+ * * Maps the file written by the belt process (see TimeSeriesSampler.h)
+ * read-only, so it can be run while sampling is still in progress.
+ * * Usage: ./series [--file PATH] [--csv OUT | --summary]
+ * * The file defaults to `SAMPLER_FILE` or `logs/belt.series`; `--csv -`
+ * writes to stdout.
+ */
+#include "../include/Config.h"
+#include "../include/TimeSeriesSampler.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+void printUsage() {
+  std::printf("Usage: series [--file PATH] [--csv OUT | --summary]\n");
+}
+
+int main(int argc, char *argv[]) {
+  std::string path = Config::getEnvRaw("SAMPLER_FILE", "logs/belt.series");
+  std::string csv_path;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (arg == "--file" && has_value) {
+      path = argv[++i];
+    } else if (arg == "--csv" && has_value) {
+      csv_path = argv[++i];
+    } else if (arg == "--summary") {
+      csv_path.clear();
+    } else {
+      printUsage();
+      return EXIT_FAILURE;
+    }
+  }
+
+  SeriesReader reader(path);
+  if (!reader.valid()) {
+    std::fprintf(stderr, "[series] %s is missing or not a series file\n",
+                 path.c_str());
+    return EXIT_FAILURE;
+  }
+
+  if (!csv_path.empty()) {
+    FILE *out = csv_path == "-" ? stdout : std::fopen(csv_path.c_str(), "w");
+    if (!out) {
+      std::fprintf(stderr, "[series] Cannot write %s\n", csv_path.c_str());
+      return EXIT_FAILURE;
+    }
+    uint64_t rows = reader.exportCsv(out);
+    if (out != stdout) {
+      std::fclose(out);
+      std::printf("Wrote %llu rows to %s\n", (unsigned long long)rows,
+                  csv_path.c_str());
+    }
+    return EXIT_SUCCESS;
+  }
+
+  int64_t peak[SERIES_CHANNELS] = {};
+  SeriesSample first = {}, last = {};
+  uint64_t max_gap_ns = 0;
+  bool seen = false;
+  uint64_t samples = reader.forEach([&](const SeriesSample &s) {
+    if (!seen)
+      first = s;
+    else
+      max_gap_ns = std::max(max_gap_ns, s.timestamp_ns - last.timestamp_ns);
+    for (int c = 0; c < SERIES_CHANNELS; ++c)
+      peak[c] = std::max(peak[c], s.values[c]);
+    last = s;
+    seen = true;
+  });
+
+  double span_s =
+      samples > 1 ? (last.timestamp_ns - first.timestamp_ns) / 1e9 : 0.0;
+  std::printf("Series %s: %llu samples at %.0f Hz nominal, %.3f s span\n",
+              path.c_str(), (unsigned long long)samples,
+              1e9 / reader.header().interval_ns, span_s);
+  if (samples == 0)
+    return EXIT_SUCCESS;
+
+  std::printf("Encoded size:      %.2f bytes/sample\n",
+              (double)reader.payloadBytes() / samples);
+  std::printf("Largest gap:       %.3f ms\n", max_gap_ns / 1e6);
+  std::printf("Peak belt:         %lld packages, %.1f kg\n",
+              (long long)peak[SER_BELT_COUNT], peak[SER_BELT_WEIGHT_G] / 1e3);
+  std::printf("Peak trucks queued: %lld\n", (long long)peak[SER_TRUCKS_QUEUED]);
+  if (span_s > 0) {
+    auto rate = [&](int c) {
+      return (last.values[c] - first.values[c]) / span_s;
+    };
+    std::printf("Throughput:        %.1f created/s, %.1f loaded/s, "
+                "%.2f trucks/s\n",
+                rate(SER_CREATED), rate(SER_LOADED) + rate(SER_EXPRESS_LOADED),
+                rate(SER_DEPARTED));
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file main_sorter.cpp
+ * @brief Sorter process: routes belt packages into the sorter lanes.
+ * * Only started when the IPC owner configured lanes (`SORTER_RULE`); it is
+ * then the single consumer of the belt (see Sorter.h).
+ */
+
+#include "../include/Config.h"
+#include "../include/Manager.h"
+#include <csignal>
+
+Sorter *global_sorter_ptr = nullptr;
+
+void signalHandler(int) {
+  if (global_sorter_ptr) {
+    global_sorter_ptr->stop();
+  }
+}
+
+class SorterSession {
+  Manager &m;
+
+public:
+  explicit SorterSession(Manager &manager) : m(manager) {
+    if (!m.session_store->login("System-Sorter", UserRole::Operator, 0, 1)) {
+      throw std::runtime_error(
+          "Critical: Could not log in to Warehouse System.");
+    }
+    spdlog::info("[sorter] Session authenticated successfully.");
+  }
+
+  ~SorterSession() {
+    m.session_store->logout();
+    spdlog::info("[sorter] Logged out.");
+  }
+};
+
+int main() {
+  try {
+    Config::get().setupLogger("system-sorter");
+
+    Manager manager(false);
+    if (!manager.sorter) {
+      throw std::runtime_error("No SORTER_RULE configured by the IPC owner.");
+    }
+    SorterSession session(manager);
+
+    global_sorter_ptr = manager.sorter.get();
+    std::signal(SIGINT, signalHandler);
+    std::signal(SIGTERM, signalHandler);
+
+    manager.sorter->run();
+
+  } catch (const std::exception &e) {
+    spdlog::critical("[sorter] Process terminated by exception: {}", e.what());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
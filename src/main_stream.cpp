@@ -0,0 +1,129 @@
+/**
+ * @file main_stream.cpp
+ * @brief Subscriber of the belt process's state stream.
+ * * Connects to the UNIX socket served by the belt process (see
+ * StateStream.h), prints the snapshot it receives on joining and then one
+ * line per region update. Doubles as a reference decoder for dashboards.
+ * * Usage: ./stream [--socket PATH] [--frames N]
+ * * The socket defaults to `STATE_STREAM_SOCKET` or `logs/state.sock`;
+ * `--frames N` exits after N frames.
+ */
+#include "../include/Config.h"
+#include "../include/StateStream.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+void printUsage() {
+  std::printf("Usage: stream [--socket PATH] [--frames N]\n");
+}
+
+/** @brief Prints the regions whose generation differs from `shown`. */
+void printChanges(const StreamView &v, uint64_t *shown) {
+  for (int r = 0; r < STATE_REGIONS; ++r) {
+    if (!(v.received & (1u << r)) || shown[r] == v.generation[r])
+      continue;
+    shown[r] = v.generation[r];
+    std::printf("[g%-8llu] ", (unsigned long long)v.generation[r]);
+
+    switch (static_cast<StateRegion>(r)) {
+    case StateRegion::Belt:
+      std::printf("belt     %u/%u packages (%u in transit), %.1f kg, "
+                  "%u workers, %u created\n",
+                  v.belt_items, v.belt_capacity, v.belt_in_transit,
+                  v.belt_weight, v.workers, v.packages_created);
+      break;
+    case StateRegion::Dock:
+      std::printf("dock    ");
+      for (int i = 0; i < v.docks; ++i) {
+        const StreamDock &d = v.dock[i];
+        if (d.present)
+          std::printf(" [truck %d: %u/%u, %.1f/%.1f kg, %.2f/%.2f m3]",
+                      d.truck, d.load, d.max_load, d.weight, d.max_weight,
+                      d.volume, d.max_volume);
+        else
+          std::printf(" [empty]");
+      }
+      std::printf("\n");
+      break;
+    case StateRegion::Fleet:
+      std::printf("fleet    %u departed (%llu empty), %u waiting, "
+                  "%llu loaded, %llu express\n",
+                  v.trucks_completed, (unsigned long long)v.departures_empty,
+                  v.trucks_waiting, (unsigned long long)v.packages_loaded,
+                  (unsigned long long)v.express_loaded);
+      break;
+    case StateRegion::Sessions: {
+      unsigned processes = 0;
+      for (int i = 0; i < v.sessions; ++i)
+        processes += v.session[i].processes;
+      std::printf("sessions %d active, %u sub-processes\n", v.sessions,
+                  processes);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  std::fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+  std::string path =
+      Config::getEnvRaw("STATE_STREAM_SOCKET", "logs/state.sock");
+  long long max_frames = -1;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (arg == "--socket" && has_value) {
+      path = argv[++i];
+    } else if (arg == "--frames" && has_value) {
+      max_frames = std::atoll(argv[++i]);
+    } else {
+      printUsage();
+      return EXIT_FAILURE;
+    }
+  }
+
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd == -1 ||
+      connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == -1) {
+    std::fprintf(stderr, "[stream] Cannot connect to %s: %s\n", path.c_str(),
+                 std::strerror(errno));
+    return EXIT_FAILURE;
+  }
+
+  StreamDecoder decoder;
+  uint64_t shown[STATE_REGIONS];
+  for (uint64_t &g : shown)
+    g = ~uint64_t{0};
+  char buf[16 * 1024];
+
+  for (;;) {
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0) {
+      std::printf("[stream] Publisher closed the stream.\n");
+      break;
+    }
+    if (decoder.feed(buf, static_cast<size_t>(n)) < 0) {
+      std::fprintf(stderr, "[stream] Malformed stream from %s\n",
+                   path.c_str());
+      close(fd);
+      return EXIT_FAILURE;
+    }
+    printChanges(decoder.view(), shown);
+    if (max_frames >= 0 &&
+        decoder.view().frames >= static_cast<uint64_t>(max_frames))
+      break;
+  }
+
+  close(fd);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,533 @@
+/**
+ * @file main_stress.cpp
+ * @brief End-to-end multi-process stress harness.
+ * * Boots an isolated warehouse instance on private IPC keys, spawns the real
+ * role binaries (dispatcher, express, belt, truck, worker) next to this
+ * executable, applies load for a fixed duration and then reports:
+ * - package conservation (created = loaded + on belt + in flight, where
+ *   in flight includes the sorter and its lanes),
+ * - throughput of the belt and the fleet,
+ * - belt-to-truck latency percentiles,
+ * - CPU time consumed per role.
+ * * Usage: ./stress [--workers N] [--trucks M] [--dispatchers D]
+ *                  [--duration SEC] [--rate PKG_PER_SEC] [--fast-trucks]
+ *                  [--sorter RULE] [--belt-speed MS] [--log-level LEVEL]
+ * * Without `--rate` the workers run open-loop (unthrottled).
+ * * `--arrival SPEC` shapes each worker's share of `--rate` with an arrival
+ * process (WORKER_ARRIVAL, see ArrivalProcess.h), seeded by
+ * `--arrival-seed` so surges repeat between runs. The report adds the belt
+ * depth sampled every 10 ms.
+ * * `--sorter` runs the sorter stage with the given `SORTER_RULE` (see
+ * Sorter.h); dispatchers and trucks are raised to at least one per lane and
+ * the report adds per-lane throughput, to compare against the single-lane
+ * baseline of the same run without it.
+ * * `--belt-speed` sets BELT_SPEED_MS (belt transit time); by default
+ * packages arrive at the end of the belt immediately.
+ * * `--faults PLAN` injects faults into every role (FAULT_PLAN, see
+ * FaultInjector.h) with the schedule seeded by `--fault-seed` (default 1).
+ * Roles killed by the plan are respawned, and the report adds the faults
+ * fired and the longest stretch without a package loaded (recovery time).
+ * * `--perf` counts cycles, instructions, cache misses, context switches and
+ * page faults of every role over the measured window (see PerfCounters.h)
+ * and reports them per package loaded next to ns/op. Counters the host
+ * does not provide are reported as unavailable.
+ */
+#include "../include/ArrivalProcess.h"
+#include "../include/Config.h"
+#include "../include/FaultInjector.h"
+#include "../include/Manager.h"
+#include "../include/PerfCounters.h"
+#include "../include/Telemetry.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+volatile std::sig_atomic_t stop_requested = 0;
+
+void handleSigint(int) { stop_requested = 1; }
+
+/**
+ * @struct StressOptions
+ * @brief Command line parameters of a stress run.
+ */
+struct StressOptions {
+  int workers = 3;
+  int trucks = 2;
+  int dispatchers = 1;
+  int duration_s = 10;
+  double rate = 0.0; /**< Total packages per second, 0 = open-loop. */
+  bool fast_trucks = false;
+  std::string sorter_rule;    /**< Empty = single belt and dock. */
+  int belt_speed_ms = 0;      /**< Belt transit time, 0 = instant. */
+  std::string order = "fifo"; /**< Belt service order, fifo or edf. */
+  std::string sla_budgets;    /**< SLA_BUDGET_MS, empty = defaults. */
+  std::string faults;         /**< FAULT_PLAN, empty = no injection. */
+  std::string fault_seed = "1";
+  std::string arrival; /**< WORKER_ARRIVAL, empty = fixed rate. */
+  std::string arrival_seed = "1";
+  std::string log_level = "warn";
+  bool perf = false; /**< Capture hardware/software counters. */
+};
+
+/**
+ * @struct StressChild
+ * @brief Book-keeping for one spawned role process.
+ */
+struct StressChild {
+  pid_t pid;
+  std::string role;
+  std::string arg;
+  bool exited = false;
+  bool killed = false; /**< Ended by SIGKILL (an injected fault). */
+  struct rusage usage = {};
+};
+
+std::vector<StressChild> children;
+
+void printUsage() {
+  std::printf("Usage: stress [--workers N] [--trucks M] [--dispatchers D]\n"
+              "              [--duration SEC] [--rate PKG_PER_SEC]\n"
+              "              [--fast-trucks] [--sorter RULE]\n"
+              "              [--belt-speed MS] [--order fifo|edf]\n"
+              "              [--sla STANDARD,PRIORITY,URGENT (ms)]\n"
+              "              [--faults PLAN] [--fault-seed N]\n"
+              "              [--arrival SPEC] [--arrival-seed N]\n"
+              "              [--perf] [--log-level LEVEL]\n");
+}
+
+bool parseOptions(int argc, char *argv[], StressOptions &opt) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (arg == "--workers" && has_value) {
+      opt.workers = std::atoi(argv[++i]);
+    } else if (arg == "--trucks" && has_value) {
+      opt.trucks = std::atoi(argv[++i]);
+    } else if (arg == "--dispatchers" && has_value) {
+      opt.dispatchers = std::atoi(argv[++i]);
+    } else if (arg == "--duration" && has_value) {
+      opt.duration_s = std::atoi(argv[++i]);
+    } else if (arg == "--rate" && has_value) {
+      opt.rate = std::atof(argv[++i]);
+    } else if (arg == "--fast-trucks") {
+      opt.fast_trucks = true;
+    } else if (arg == "--sorter" && has_value) {
+      opt.sorter_rule = argv[++i];
+    } else if (arg == "--belt-speed" && has_value) {
+      opt.belt_speed_ms = std::atoi(argv[++i]);
+    } else if (arg == "--order" && has_value) {
+      opt.order = argv[++i];
+      if (opt.order != "fifo" && opt.order != "edf")
+        return false;
+    } else if (arg == "--sla" && has_value) {
+      opt.sla_budgets = argv[++i];
+    } else if (arg == "--faults" && has_value) {
+      opt.faults = argv[++i];
+      std::vector<FaultRule> rules;
+      if (!parseFaultPlan(opt.faults.c_str(), rules))
+        return false;
+    } else if (arg == "--fault-seed" && has_value) {
+      opt.fault_seed = argv[++i];
+    } else if (arg == "--arrival" && has_value) {
+      opt.arrival = argv[++i];
+      ArrivalSpec spec;
+      if (!parseArrivalSpec(opt.arrival.c_str(), 1.0, spec))
+        return false;
+    } else if (arg == "--arrival-seed" && has_value) {
+      opt.arrival_seed = argv[++i];
+    } else if (arg == "--log-level" && has_value) {
+      opt.log_level = argv[++i];
+    } else if (arg == "--perf") {
+      opt.perf = true;
+    } else {
+      return false;
+    }
+  }
+
+  if (!opt.sorter_rule.empty()) {
+    SortRule rule;
+    if (!parseSortRule(opt.sorter_rule.c_str(), rule)) {
+      std::fprintf(stderr, "[stress] Invalid sorter rule '%s'.\n",
+                   opt.sorter_rule.c_str());
+      return false;
+    }
+    opt.dispatchers = std::max(opt.dispatchers, rule.lanes);
+    opt.trucks = std::max(opt.trucks, rule.lanes);
+  }
+
+  int sessions = opt.workers + opt.trucks + opt.dispatchers + 2 +
+                 (opt.sorter_rule.empty() ? 0 : 1);
+  if (opt.workers < 1 || opt.workers > MAX_WORKERS_PER_BELT ||
+      opt.trucks < 1 || opt.dispatchers < 1 || opt.duration_s < 1 ||
+      opt.rate < 0 || opt.belt_speed_ms < 0 || sessions > MAX_USERS_SESSIONS ||
+      (!opt.arrival.empty() && opt.rate <= 0)) {
+    std::fprintf(stderr,
+                 "[stress] Invalid sizing: 1..%d workers, >=1 truck and "
+                 "dispatcher, at most %d sessions in total, --arrival "
+                 "needs --rate.\n",
+                 MAX_WORKERS_PER_BELT, MAX_USERS_SESSIONS);
+    return false;
+  }
+  return true;
+}
+
+/** @brief Directory containing this executable (and its sibling roles). */
+std::string binaryDir() {
+  char path[4096];
+  ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+  if (n <= 0)
+    return "./build";
+  path[n] = '\0';
+  std::string full(path);
+  return full.substr(0, full.find_last_of('/'));
+}
+
+void spawnRole(const std::string &dir, const std::string &role,
+               const std::string &arg = "") {
+  std::string binary = dir + "/" + role;
+  pid_t pid = fork();
+
+  if (pid < 0) {
+    spdlog::critical("[stress] Failed to fork {}", role);
+    exit(1);
+  }
+
+  if (pid == 0) {
+    std::vector<char *> args;
+    args.push_back(const_cast<char *>(role.c_str()));
+    if (!arg.empty())
+      args.push_back(const_cast<char *>(arg.c_str()));
+    args.push_back(nullptr);
+
+    execv(binary.c_str(), args.data());
+    perror("execv failed");
+    _exit(1);
+  }
+
+  children.push_back({pid, role, arg});
+}
+
+/** @brief Reaps exited children without blocking. @return Reaped count. */
+int reapChildren(int options) {
+  int reaped = 0;
+  for (auto &child : children) {
+    if (child.exited)
+      continue;
+    int status;
+    if (wait4(child.pid, &status, options, &child.usage) == child.pid) {
+      child.exited = true;
+      reaped++;
+      if (!stop_requested && WIFSIGNALED(status)) {
+        spdlog::warn("[stress] {} (PID {}) killed by signal {}", child.role,
+                     child.pid, WTERMSIG(status));
+        child.killed = WTERMSIG(status) == SIGKILL;
+      }
+    }
+  }
+  return reaped;
+}
+
+/** @brief Stops every role process, escalating to SIGKILL after a grace. */
+void shutdownChildren(Manager &manager) {
+  SharedState *shm = manager.getState();
+  shm->running = false;
+
+  for (int i = 0; i < MAX_USERS_SESSIONS; ++i) {
+    if (shm->users[i].active)
+      manager.sendSignal(shm->users[i].session_pid, SIGNAL_END_WORK);
+  }
+  for (auto &child : children)
+    kill(child.pid, SIGTERM);
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  size_t alive = children.size();
+  while (alive > 0 && std::chrono::steady_clock::now() < deadline) {
+    alive -= reapChildren(WNOHANG);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+
+  for (auto &child : children) {
+    if (!child.exited) {
+      spdlog::warn("[stress] {} (PID {}) did not stop, killing.", child.role,
+                   child.pid);
+      kill(child.pid, SIGKILL);
+    }
+  }
+  reapChildren(0);
+}
+
+double cpuSeconds(const struct rusage &u) {
+  return u.ru_utime.tv_sec + u.ru_utime.tv_usec / 1e6 + u.ru_stime.tv_sec +
+         u.ru_stime.tv_usec / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+  StressOptions opt;
+  if (!parseOptions(argc, argv, opt)) {
+    printUsage();
+    return EXIT_FAILURE;
+  }
+
+  std::signal(SIGINT, handleSigint);
+
+  setenv("IPC_KEY_OFFSET", std::to_string(100000 + getpid()).c_str(), 1);
+  setenv("LOG_LEVEL", opt.log_level.c_str(), 1);
+  setenv("LOG_TO_FILE", "false", 1);
+  setenv("LOG_TO_CONSOLE", "true", 1);
+  unsetenv("METRICS_PORT");
+  unsetenv("METRICS_SOCKET");
+  unsetenv("METRICS_TEXTFILE");
+  unsetenv("AUDIT_JOURNAL_DIR");
+  unsetenv("DELIVERY_LEDGER");
+  unsetenv("SAMPLER_FILE");
+  setenv("WORKER_RATE_HZ", std::to_string(opt.rate / opt.workers).c_str(), 1);
+  if (opt.fast_trucks)
+    setenv("TRUCK_ROUTE_MS", "20:80", 1);
+  setenv("BELT_SPEED_MS", std::to_string(opt.belt_speed_ms).c_str(), 1);
+  setenv("BELT_ORDER", opt.order.c_str(), 1);
+  if (opt.sla_budgets.empty())
+    unsetenv("SLA_BUDGET_MS");
+  else
+    setenv("SLA_BUDGET_MS", opt.sla_budgets.c_str(), 1);
+  if (opt.arrival.empty()) {
+    unsetenv("WORKER_ARRIVAL");
+  } else {
+    setenv("WORKER_ARRIVAL", opt.arrival.c_str(), 1);
+    setenv("ARRIVAL_SEED", opt.arrival_seed.c_str(), 1);
+  }
+  if (opt.faults.empty()) {
+    unsetenv("FAULT_PLAN");
+  } else {
+    setenv("FAULT_PLAN", opt.faults.c_str(), 1);
+    setenv("FAULT_SEED", opt.fault_seed.c_str(), 1);
+  }
+  if (opt.sorter_rule.empty())
+    unsetenv("SORTER_RULE");
+  else
+    setenv("SORTER_RULE", opt.sorter_rule.c_str(), 1);
+
+  Config::get().setupLogger("stress");
+  Manager manager(true);
+  SharedState *shm = manager.getState();
+
+  std::string dir = binaryDir();
+  std::printf("[stress] %d workers, %d trucks, %d dispatchers, %ds, %s%s\n",
+              opt.workers, opt.trucks, opt.dispatchers, opt.duration_s,
+              opt.rate > 0 ? (std::to_string(opt.rate) + " pkg/s").c_str()
+                           : "open-loop",
+              opt.fast_trucks ? ", fast trucks" : "");
+  if (opt.belt_speed_ms > 0)
+    std::printf("[stress] Belt transit %d ms\n", opt.belt_speed_ms);
+  if (opt.order == "edf")
+    std::printf("[stress] Belt served earliest deadline first\n");
+  if (!opt.arrival.empty())
+    std::printf("[stress] Arrivals '%s' (seed %s)\n", opt.arrival.c_str(),
+                opt.arrival_seed.c_str());
+  if (!opt.faults.empty())
+    std::printf("[stress] Injecting '%s' (seed %s)\n", opt.faults.c_str(),
+                opt.fault_seed.c_str());
+  int lanes = shm->lane_count;
+  if (lanes > 0)
+    std::printf("[stress] Sorter '%s' over %d lanes\n",
+                opt.sorter_rule.c_str(), lanes);
+
+  // Opened before forking: the roles inherit the counters.
+  std::unique_ptr<PerfCounters> perf;
+  if (opt.perf)
+    perf = std::make_unique<PerfCounters>(true);
+
+  for (int i = 1; i <= opt.dispatchers; ++i)
+    spawnRole(dir, "dispatcher", std::to_string(i));
+  if (lanes > 0)
+    spawnRole(dir, "sorter");
+  spawnRole(dir, "express");
+  spawnRole(dir, "belt");
+  for (int i = 1; i <= opt.trucks; ++i)
+    spawnRole(dir, "truck", std::to_string(i));
+  for (int i = 1; i <= opt.workers; ++i)
+    spawnRole(dir, "worker", std::to_string(i));
+
+  auto warmup = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (shm->current_workers_count < opt.workers &&
+         std::chrono::steady_clock::now() < warmup && !stop_requested) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  long long created_start = atomicLoad(shm->total_packages_created);
+  long long loaded_start = (long long)atomicLoad(shm->stats.packages_loaded);
+  long long trucks_start = atomicLoad(shm->trucks_completed);
+  uint64_t lane_start[MAX_SORTER_LANES] = {};
+  for (int l = 0; l < lanes; ++l)
+    lane_start[l] = atomicLoad(shm->lanes[l].loaded);
+  auto start = std::chrono::steady_clock::now();
+  auto end = start + std::chrono::seconds(opt.duration_s);
+  if (perf)
+    perf->start();
+
+  int tick = 0;
+  int respawned = 0;
+  uint64_t last_loaded = atomicLoad(shm->stats.packages_loaded);
+  auto last_progress = start;
+  std::chrono::steady_clock::duration longest_stall{};
+  long long depth_sum = 0, depth_samples = 0, depth_full = 0;
+  int depth_max = 0;
+  while (!stop_requested && std::chrono::steady_clock::now() < end) {
+    auto next_tick = start + std::chrono::seconds(++tick);
+    while (std::chrono::steady_clock::now() < next_tick) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      auto now = std::chrono::steady_clock::now();
+      uint64_t loaded_now = atomicLoad(shm->stats.packages_loaded);
+      if (loaded_now != last_loaded) {
+        last_loaded = loaded_now;
+        last_progress = now;
+      }
+      longest_stall = std::max(longest_stall, now - last_progress);
+      int depth = atomicLoad(shm->current_items_count);
+      depth_sum += depth;
+      depth_samples++;
+      depth_max = std::max(depth_max, depth);
+      if (depth >= MAX_BELT_CAPACITY_K)
+        depth_full++;
+    }
+    reapChildren(WNOHANG);
+    size_t spawned = children.size();
+    for (size_t i = 0; i < spawned; ++i) {
+      if (!children[i].killed || opt.faults.empty())
+        continue;
+      children[i].killed = false;
+      spawnRole(dir, children[i].role, children[i].arg);
+      respawned++;
+    }
+    std::printf("[stress] t=%3ds created=%-8d loaded=%-8llu belt=%-2d "
+                "trucks=%d\n",
+                tick, atomicLoad(shm->total_packages_created),
+                (unsigned long long)atomicLoad(shm->stats.packages_loaded),
+                atomicLoad(shm->current_items_count),
+                atomicLoad(shm->trucks_completed));
+  }
+
+  if (perf)
+    perf->stop();
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  long long created_window =
+      atomicLoad(shm->total_packages_created) - created_start;
+  long long loaded_window =
+      (long long)atomicLoad(shm->stats.packages_loaded) - loaded_start;
+  long long trucks_window = atomicLoad(shm->trucks_completed) - trucks_start;
+  uint64_t lane_window[MAX_SORTER_LANES] = {};
+  for (int l = 0; l < lanes; ++l)
+    lane_window[l] = atomicLoad(shm->lanes[l].loaded) - lane_start[l];
+
+  shutdownChildren(manager);
+
+  long long created = shm->total_packages_created;
+  long long loaded = (long long)shm->stats.packages_loaded;
+  long long on_belt = shm->current_items_count;
+  long long in_flight =
+      shm->stats.packages_in_dispatch + shm->stats.packages_in_sorter;
+  for (int l = 0; l < lanes; ++l)
+    in_flight += shm->lanes[l].count;
+  bool conserved = created == loaded + on_belt + in_flight;
+
+  std::printf("\n=== Stress report (%.1fs measured) ===\n", elapsed);
+  std::printf("Conservation: created=%lld loaded=%lld on_belt=%lld "
+              "in_flight=%lld -> %s\n",
+              created, loaded, on_belt, in_flight,
+              conserved ? "OK" : "VIOLATED");
+  std::printf("Throughput:   created %.1f pkg/s, loaded %.1f pkg/s, "
+              "%.2f trucks/s\n",
+              created_window / elapsed, loaded_window / elapsed,
+              trucks_window / elapsed);
+  if (!opt.arrival.empty()) {
+    std::printf("Belt depth:   mean %.1f, max %d of %d, full %.1f%% of the "
+                "time\n",
+                depth_samples ? (double)depth_sum / depth_samples : 0.0,
+                depth_max, MAX_BELT_CAPACITY_K,
+                depth_samples ? 100.0 * depth_full / depth_samples : 0.0);
+  }
+  std::printf("Express:      %llu packages loaded\n",
+              (unsigned long long)shm->stats.express_loaded);
+  std::printf("Departures:   %llu empty, %llu stale messages, "
+              "%llu repeat requests coalesced\n",
+              (unsigned long long)shm->stats.departures_empty,
+              (unsigned long long)shm->stats.departures_stale,
+              (unsigned long long)shm->stats.departures_coalesced);
+  uint64_t passes = shm->stats.combine_passes;
+  std::printf("Dock:         %llu combining passes, %.2f requests/pass\n",
+              (unsigned long long)passes,
+              passes ? (double)shm->stats.combined_requests / passes : 0.0);
+  for (int l = 0; l < lanes; ++l) {
+    std::printf("Lane %d:       routed %llu, loaded %.1f pkg/s, %d waiting\n",
+                l, (unsigned long long)shm->lanes[l].routed,
+                lane_window[l] / elapsed, shm->lanes[l].count);
+  }
+
+  const WarehouseStats &st = shm->stats;
+  double mean_ms =
+      st.latency_count ? st.latency_sum_ns / 1e6 / st.latency_count : 0.0;
+  std::printf("Latency (belt->truck, ms): mean %.1f  p50 %.1f  p90 %.1f  "
+              "p99 %.1f  p99.9 %.1f\n",
+              mean_ms, latencyPercentileMs(st, 0.50),
+              latencyPercentileMs(st, 0.90), latencyPercentileMs(st, 0.99),
+              latencyPercentileMs(st, 0.999));
+
+  static const char *const tiers[SLA_TIERS] = {"standard", "priority",
+                                               "urgent"};
+  uint64_t missed = 0;
+  std::printf("Deadlines:   ");
+  for (int t = 0; t < SLA_TIERS; ++t) {
+    missed += st.sla_missed[t];
+    std::printf(" %s %llu/%llu missed (%.1f%%)", tiers[t],
+                (unsigned long long)st.sla_missed[t],
+                (unsigned long long)st.sla_loaded[t],
+                st.sla_loaded[t] ? 100.0 * st.sla_missed[t] / st.sla_loaded[t]
+                                 : 0.0);
+  }
+  std::printf("\n");
+  std::printf("Tardiness (ms): mean %.1f  p50 %.1f  p90 %.1f  p99 %.1f\n",
+              missed ? st.tardiness_sum_ns / 1e6 / missed : 0.0,
+              histogramPercentileMs(st.tardiness_buckets, 0.50),
+              histogramPercentileMs(st.tardiness_buckets, 0.90),
+              histogramPercentileMs(st.tardiness_buckets, 0.99));
+
+  if (!opt.faults.empty()) {
+    std::printf("Faults:      ");
+    for (int f = 0; f < FAULT_SITES; ++f)
+      std::printf(" %s %llu", faultSiteName(static_cast<FaultSite>(f)),
+                  (unsigned long long)st.faults_injected[f]);
+    std::printf("\n");
+    std::printf("Recovery:     %d roles respawned, longest stall %.0f ms\n",
+                respawned,
+                std::chrono::duration<double, std::milli>(longest_stall)
+                    .count());
+  }
+  if (perf)
+    perf->report(stdout, loaded_window, elapsed * 1e9);
+
+  std::map<std::string, std::pair<int, double>> cpu;
+  for (const auto &child : children) {
+    auto &entry = cpu[child.role];
+    entry.first++;
+    entry.second += cpuSeconds(child.usage);
+  }
+  std::printf("CPU per role:\n");
+  std::printf("  %-12s %5s %10s %8s\n", "ROLE", "PROCS", "CPU[s]", "CPU[%]");
+  for (const auto &[role, entry] : cpu) {
+    std::printf("  %-12s %5d %10.3f %7.1f%%\n", role.c_str(), entry.first,
+                entry.second, 100.0 * entry.second / elapsed);
+  }
+
+  return conserved ? EXIT_SUCCESS : EXIT_FAILURE;
+}
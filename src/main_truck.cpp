@@ -1,16 +1,17 @@
 #include "../include/Config.h"
 #include "../include/Manager.h"
-#include <atomic>
 #include <csignal>
 #include <iostream>
+#include <memory>
 #include <string>
 
-std::atomic<bool> truck_stop{false};
+Truck *global_truck_ptr = nullptr;
 
 void signalHandler(int signum) {
   spdlog::warn("[truck] Signal ({}) received. Driver finishing the shift...",
                signum);
-  truck_stop.store(true);
+  if (global_truck_ptr)
+    global_truck_ptr->stop();
 }
 
 struct TruckSessionGuard {
@@ -48,10 +49,31 @@ int main(int argc, char *argv[]) {
 
     std::string unique_username = "Truck_" + id_str;
     TruckSessionGuard session(manager, unique_username);
+    manager.useLane(truck_id - 1);
+
+    std::string route = Config::get().getEnv("TRUCK_ROUTE_MS", "");
+    if (!route.empty()) {
+      int min_ms = std::atoi(route.c_str());
+      size_t sep = route.find(':');
+      int max_ms = sep == std::string::npos
+                       ? min_ms
+                       : std::atoi(route.c_str() + sep + 1);
+      manager.truck->setRouteTime(min_ms, max_ms);
+      manager.truck->setDockRetry(std::min(1000, std::max(1, min_ms)));
+    }
+
+    std::unique_ptr<DeliveryLedger> ledger;
+    std::string ledger_path = Config::get().getEnv("DELIVERY_LEDGER", "");
+    if (!ledger_path.empty()) {
+      ledger = std::make_unique<DeliveryLedger>(ledger_path);
+      manager.truck->setLedger(ledger.get());
+    }
 
     spdlog::info("[truck] Truck process #{} online. Heading to the dock...",
                  truck_id);
+    global_truck_ptr = manager.truck.get();
     manager.truck->run();
+    global_truck_ptr = nullptr;
 
   } catch (const std::exception &e) {
     spdlog::critical("[truck] Critical Driver Error: {}", e.what());
@@ -4,12 +4,19 @@
  * * Usage: ./worker <ID>
  * * Connects to the system, registers on the belt, and starts generating
  * packages.
+ * * WORKER_RATE_HZ sets the base rate; a comma-separated list gives each
+ * worker its own rate (worker ID n takes entry (n - 1) modulo the list).
+ * WORKER_ARRIVAL shapes the intake (see ArrivalProcess.h), seeded from
+ * ARRIVAL_SEED and the worker ID when set, randomly otherwise.
  */
 #include "../include/Config.h"
 #include "../include/Manager.h"
 #include "../include/Worker.h"
 #include <csignal>
 #include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
 
 std::atomic<bool> should_stop{false};
 Worker *global_worker_ptr = nullptr;
@@ -22,6 +29,19 @@ void signalHandler(int signum) {
   }
 }
 
+/** @brief Entry of a comma-separated WORKER_RATE_HZ for `worker_id`. */
+std::string rateFor(const std::string &rates, int worker_id) {
+  std::vector<std::string> entries;
+  std::stringstream ss(rates);
+  std::string entry;
+  while (std::getline(ss, entry, ','))
+    entries.push_back(entry);
+  if (entries.empty())
+    return rates;
+  int n = static_cast<int>(entries.size());
+  return entries[((worker_id - 1) % n + n) % n];
+}
+
 struct WorkerSessionGuard {
   Manager &m;
   std::string name;
@@ -53,6 +73,31 @@ int main(int argc, char *argv[]) {
     Worker worker(&manager, worker_id);
     global_worker_ptr = &worker;
 
+    std::string rate =
+        rateFor(Config::get().getEnv("WORKER_RATE_HZ", ""), worker_id);
+    std::string shape = Config::get().getEnv("WORKER_ARRIVAL", "");
+    if (!rate.empty()) {
+      worker.setArrivalRate(std::atof(rate.c_str()));
+      spdlog::info("[main] Worker {} paced at {} pkg/s (0 = unthrottled).",
+                   worker_id, rate);
+    }
+    if (!shape.empty()) {
+      ArrivalSpec spec;
+      std::string seed = Config::get().getEnv("ARRIVAL_SEED", "");
+      if (parseArrivalSpec(shape.c_str(), std::atof(rate.c_str()), spec)) {
+        worker.setArrivalProcess(
+            spec, seed.empty() ? std::random_device{}()
+                               : std::strtoull(seed.c_str(), nullptr, 10) +
+                                     static_cast<uint64_t>(worker_id));
+        spdlog::info("[main] Worker {} arrivals: {} around {} pkg/s.",
+                     worker_id, shape, rate);
+      } else {
+        spdlog::error("[main] Invalid WORKER_ARRIVAL '{}' (needs a positive "
+                      "WORKER_RATE_HZ). Keeping the default pacing.",
+                      shape);
+      }
+    }
+
     spdlog::info("[main] Worker {} starting shift.", worker_id);
     worker.run();
 
@@ -0,0 +1,191 @@
+/**
+ * @file agent_engine_test.cpp
+ * @brief Unit tests for the agent engine and the in-process warehouse.
+ */
+
+#include "../include/AgentEngine.h"
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace {
+
+/** @brief Waits up to `timeout` for `done`. */
+template <class Pred>
+bool eventually(Pred done, std::chrono::milliseconds timeout =
+                               std::chrono::milliseconds(2000)) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!done() && std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  return done();
+}
+
+/** @brief Takes a permit, records it, ends. */
+class TakerAgent : public Agent {
+public:
+  AgentSemaphore &sem;
+  std::atomic<bool> taken{false};
+
+  explicit TakerAgent(AgentSemaphore &s) : sem(s) {}
+
+  void resume(AgentEngine &) override {
+    if (pc == 0) {
+      pc = 1;
+      if (!sem.acquire(*this))
+        return;
+    }
+    taken = true;
+  }
+};
+
+/** @brief Sleeps once, then records the time it woke up. */
+class SleeperAgent : public Agent {
+public:
+  uint64_t sleep_ns;
+  std::atomic<uint64_t> woke_ns{0};
+
+  explicit SleeperAgent(uint64_t ns) : sleep_ns(ns) {}
+
+  void resume(AgentEngine &engine) override {
+    if (pc++ == 0) {
+      engine.sleepFor(*this, sleep_ns);
+      return;
+    }
+    woke_ns = monotonicNowNs();
+  }
+};
+
+/** @brief Busy agent counting its runs. */
+class SpinAgent : public Agent {
+public:
+  std::atomic<int> &done;
+
+  explicit SpinAgent(std::atomic<int> &d) : done(d) {}
+
+  void resume(AgentEngine &) override {
+    auto until = std::chrono::steady_clock::now() +
+                 std::chrono::microseconds(200);
+    while (std::chrono::steady_clock::now() < until) {
+    }
+    done++;
+  }
+};
+
+/** @brief Schedules its children from a pool thread (onto its own queue). */
+class SpawnerAgent : public Agent {
+public:
+  std::vector<std::unique_ptr<SpinAgent>> &children;
+
+  explicit SpawnerAgent(std::vector<std::unique_ptr<SpinAgent>> &c)
+      : children(c) {}
+
+  void resume(AgentEngine &engine) override {
+    for (auto &c : children)
+      engine.schedule(c.get());
+  }
+};
+
+} // namespace
+
+/**
+ * @test SemaphoreHandsPermitToWaiter
+ * @brief A waiter suspends on an empty semaphore and is resumed owning the
+ * permit of the next release.
+ */
+TEST(AgentEngineTest, SemaphoreHandsPermitToWaiter) {
+  AgentEngine engine(2);
+  AgentSemaphore sem(&engine, 0);
+  TakerAgent taker(sem);
+
+  engine.schedule(&taker);
+  engine.start();
+  ASSERT_TRUE(eventually([&]() { return sem.waiting() == 1; }));
+  EXPECT_FALSE(taker.taken);
+
+  sem.release();
+  EXPECT_TRUE(eventually([&]() { return taker.taken.load(); }));
+  EXPECT_EQ(sem.available(), 0) << "The permit went to the waiter";
+  engine.stop();
+}
+
+/**
+ * @test TimersResumeAfterTheirDelay
+ * @brief Sleeping agents wake no earlier than due, shortest first.
+ */
+TEST(AgentEngineTest, TimersResumeAfterTheirDelay) {
+  AgentEngine engine(2);
+  SleeperAgent slow(30000000);
+  SleeperAgent fast(5000000);
+
+  uint64_t start = monotonicNowNs();
+  engine.schedule(&slow);
+  engine.schedule(&fast);
+  engine.start();
+  ASSERT_TRUE(eventually([&]() { return slow.woke_ns.load() != 0; }));
+  engine.stop();
+
+  EXPECT_GE(fast.woke_ns - start, 5000000u);
+  EXPECT_GE(slow.woke_ns - start, 30000000u);
+  EXPECT_LT(fast.woke_ns, slow.woke_ns);
+}
+
+/**
+ * @test IdleThreadsStealWork
+ * @brief Agents scheduled onto one thread's queue are shared out.
+ */
+TEST(AgentEngineTest, IdleThreadsStealWork) {
+  AgentEngine engine(2);
+  std::atomic<int> done{0};
+  std::vector<std::unique_ptr<SpinAgent>> children;
+  for (int i = 0; i < 200; ++i)
+    children.push_back(std::make_unique<SpinAgent>(done));
+  SpawnerAgent spawner(children);
+
+  engine.schedule(&spawner);
+  engine.start();
+  ASSERT_TRUE(eventually([&]() { return done.load() == 200; }));
+  engine.stop();
+
+  EXPECT_GT(engine.stealCount(), 0u);
+  EXPECT_EQ(engine.resumeCount(), 201u);
+}
+
+/**
+ * @test WarehouseConservesPackages
+ * @brief A small in-process warehouse loads packages, cycles trucks and
+ * accounts for every package it created.
+ */
+TEST(AgentEngineTest, WarehouseConservesPackages) {
+  spdlog::set_level(spdlog::level::warn);
+  AgentSimOptions opt;
+  opt.threads = 3;
+  opt.workers = 500;
+  opt.trucks = 200;
+  opt.dispatchers = 2;
+  opt.express_period_ms = 20;
+  opt.route_min_ms = 5;
+  opt.route_max_ms = 10;
+  ASSERT_TRUE(parseArrivalSpec("poisson", 4.0, opt.arrival));
+
+  AgentWarehouse w(opt);
+  EXPECT_EQ(w.agentCount(), 703u);
+  SharedState *shm = w.shm.get();
+  w.start();
+  EXPECT_TRUE(eventually(
+      [&]() {
+        return atomicLoad(shm->stats.packages_loaded) > 200 &&
+               atomicLoad(shm->trucks_completed) > 2;
+      },
+      std::chrono::milliseconds(5000)));
+  w.stop();
+  spdlog::set_level(spdlog::level::info);
+
+  long long created = shm->total_packages_created;
+  long long accounted = shm->stats.packages_loaded +
+                        shm->current_items_count +
+                        shm->stats.packages_in_dispatch;
+  EXPECT_EQ(created, accounted);
+  EXPECT_LE(shm->current_items_count, MAX_BELT_CAPACITY_K);
+  EXPECT_LE(w.packages.available(), shm->current_items_count)
+      << "No permit without a package on the belt";
+}
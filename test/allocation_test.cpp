@@ -0,0 +1,311 @@
+/**
+ * @file allocation_test.cpp
+ * @brief Enforces heap-allocation-free steady state on the per-package paths.
+ * * Replaces the global operator new/delete with a counting hook for the whole
+ * test binary. Each test warms a component up, then checks that a window of
+ * packages does not touch the heap. Logging stays enabled at info level, into
+ * a /dev/null file sink, so the spdlog formatting path is covered too.
+ */
+
+#include "../include/Belt.h"
+#include "../include/Dispatcher.h"
+#include "../include/Express.h"
+#include "../include/Manager.h"
+#include "../include/Truck.h"
+#include "../include/Worker.h"
+#include "spdlog/sinks/basic_file_sink.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <new>
+
+namespace {
+/** @brief Number of calls to the global operator new since start-up. */
+std::atomic<size_t> heap_allocations{0};
+} // namespace
+
+void *operator new(std::size_t size) {
+  heap_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+/** @brief Packages processed before the measured window starts. */
+constexpr int WARMUP_PACKAGES = 16;
+
+/** @brief Packages inside the measured window. */
+constexpr int MEASURED_PACKAGES = 200;
+
+/**
+ * @class AllocationManager
+ * @brief Manager whose components run on a mocked, lock-free SharedState.
+ */
+class AllocationManager : public Manager {
+public:
+  AllocationManager() : Manager(true) {}
+
+  void injectMockShm(SharedState *mock) { this->shm = mock; }
+
+  ~AllocationManager() { this->shm = nullptr; }
+};
+
+/**
+ * @class AllocationTest
+ * @brief Fixture providing a zeroed SharedState and an info-level logger.
+ */
+class AllocationTest : public ::testing::Test {
+protected:
+  SharedState mock_shared_memory;
+  std::function<void()> no_op = []() {};
+  std::shared_ptr<spdlog::logger> previous_logger;
+
+  void SetUp() override {
+    std::memset(&mock_shared_memory, 0, sizeof(SharedState));
+    mock_shared_memory.running = true;
+
+    previous_logger = spdlog::default_logger();
+    auto logger = std::make_shared<spdlog::logger>(
+        "alloc", std::make_shared<spdlog::sinks::basic_file_sink_mt>(
+                     "/dev/null", false));
+    logger->set_pattern("[%H:%M:%S.%e] [%n] [%^%l%$] %v");
+    logger->set_level(spdlog::level::info);
+    spdlog::set_default_logger(logger);
+  }
+
+  void TearDown() override { spdlog::set_default_logger(previous_logger); }
+
+  /** @brief Parks a truck large enough to never fill up during a test. */
+  void dockInfiniteTruck() {
+    TruckState &truck = mock_shared_memory.dock_truck;
+    truck.is_present = true;
+    truck.id = 77;
+    truck.max_load = 1 << 30;
+    truck.max_weight = 1e12;
+    truck.max_volume = 1e12;
+  }
+
+  static size_t allocations() {
+    return heap_allocations.load(std::memory_order_relaxed);
+  }
+};
+
+/**
+ * @test HookCountsAllocations
+ * @brief Sanity check that the replacement operator new is in effect.
+ */
+TEST_F(AllocationTest, HookCountsAllocations) {
+  size_t before = allocations();
+  std::unique_ptr<int> p(new int(5));
+  EXPECT_EQ(allocations() - before, 1u);
+}
+
+/**
+ * @test BeltPushPopIsAllocationFree
+ * @brief A push/pop round trip through the circular buffer.
+ */
+TEST_F(AllocationTest, BeltPushPopIsAllocationFree) {
+  Belt belt(&mock_shared_memory, no_op, no_op, no_op, no_op, no_op, no_op);
+  belt.setWorkloadSimulation(false);
+
+  size_t start = 0;
+  for (int i = 0; i < WARMUP_PACKAGES + MEASURED_PACKAGES; ++i) {
+    if (i == WARMUP_PACKAGES)
+      start = allocations();
+    Package p;
+    p.weight = 5.0;
+    p.volume = VOL_A;
+    belt.push(p);
+    belt.pop();
+  }
+
+  EXPECT_EQ(allocations() - start, 0u);
+  EXPECT_EQ(mock_shared_memory.total_packages_created,
+            WARMUP_PACKAGES + MEASURED_PACKAGES);
+}
+
+/**
+ * @test DispatcherLoadIsAllocationFree
+ * @brief Pop, fit check, truck update and latency accounting per package.
+ */
+TEST_F(AllocationTest, DispatcherLoadIsAllocationFree) {
+  Belt belt(&mock_shared_memory, no_op, no_op, no_op, no_op, no_op, no_op);
+  belt.setWorkloadSimulation(false);
+  Dispatcher dispatcher(&belt, &mock_shared_memory, no_op, no_op,
+                        [](pid_t, SignalType) {});
+  dockInfiniteTruck();
+
+  size_t start = 0;
+  for (int i = 0; i < WARMUP_PACKAGES + MEASURED_PACKAGES; ++i) {
+    if (i == WARMUP_PACKAGES)
+      start = allocations();
+    Package p;
+    p.weight = 5.0;
+    p.volume = VOL_B;
+    belt.push(p);
+    dispatcher.processNextPackage();
+  }
+
+  EXPECT_EQ(allocations() - start, 0u);
+  EXPECT_EQ(mock_shared_memory.stats.packages_loaded,
+            uint64_t(WARMUP_PACKAGES + MEASURED_PACKAGES));
+}
+
+/**
+ * @test DispatcherRejectionIsAllocationFree
+ * @brief The "does not fit" branch used to build a std::string reason.
+ */
+TEST_F(AllocationTest, DispatcherRejectionIsAllocationFree) {
+  Belt belt(&mock_shared_memory, no_op, no_op, no_op, no_op, no_op, no_op);
+  belt.setWorkloadSimulation(false);
+  int departures = 0;
+  Dispatcher dispatcher(&belt, &mock_shared_memory, no_op, no_op,
+                        [&](pid_t, SignalType) {
+                          // Let the truck leave so the loop can finish.
+                          mock_shared_memory.dock_truck.current_weight = 0;
+                          mock_shared_memory.dock_truck.phase =
+                              DockPhase::Docked;
+                          departures++;
+                        });
+  dockInfiniteTruck();
+  mock_shared_memory.dock_truck.max_weight = 10.0;
+
+  size_t start = 0;
+  for (int i = 0; i < WARMUP_PACKAGES + MEASURED_PACKAGES; ++i) {
+    if (i == WARMUP_PACKAGES)
+      start = allocations();
+    mock_shared_memory.dock_truck.current_weight = 9.0;
+    Package p;
+    p.weight = 5.0;
+    p.volume = VOL_A;
+    belt.push(p);
+    dispatcher.processNextPackage();
+  }
+
+  EXPECT_EQ(allocations() - start, 0u);
+  EXPECT_GE(departures, WARMUP_PACKAGES + MEASURED_PACKAGES);
+}
+
+/**
+ * @test StructuredLoggingIsAllocationFree
+ * @brief Push, pop, load and express records in LOG_FORMAT=json mode.
+ */
+TEST_F(AllocationTest, StructuredLoggingIsAllocationFree) {
+  spdlog::default_logger()->set_formatter(std::make_unique<JsonFormatter>());
+  JsonLog::setEnabled(true);
+  Belt belt(&mock_shared_memory, no_op, no_op, no_op, no_op, no_op, no_op);
+  belt.setWorkloadSimulation(false);
+  Dispatcher dispatcher(&belt, &mock_shared_memory, no_op, no_op,
+                        [](pid_t, SignalType) {});
+  Express express(&mock_shared_memory, no_op, no_op, [](pid_t, SignalType) {});
+  dockInfiniteTruck();
+
+  size_t start = 0;
+  for (int i = 0; i < WARMUP_PACKAGES + MEASURED_PACKAGES; ++i) {
+    if (i == WARMUP_PACKAGES)
+      start = allocations();
+    Package p;
+    p.weight = 5.0;
+    p.volume = VOL_B;
+    belt.push(p);
+    dispatcher.processNextPackage();
+    express.deliverExpressBatch();
+  }
+  size_t used = allocations() - start;
+  JsonLog::setEnabled(false);
+
+  EXPECT_EQ(used, 0u);
+  EXPECT_EQ(mock_shared_memory.stats.packages_loaded,
+            uint64_t(WARMUP_PACKAGES + MEASURED_PACKAGES));
+}
+
+/**
+ * @test ExpressBatchIsAllocationFree
+ * @brief Express batches reuse their RNG instead of opening a random device.
+ */
+TEST_F(AllocationTest, ExpressBatchIsAllocationFree) {
+  Express express(&mock_shared_memory, no_op, no_op, [](pid_t, SignalType) {});
+  dockInfiniteTruck();
+
+  size_t start = 0;
+  for (int i = 0; i < WARMUP_PACKAGES + MEASURED_PACKAGES; ++i) {
+    if (i == WARMUP_PACKAGES)
+      start = allocations();
+    express.deliverExpressBatch();
+  }
+
+  EXPECT_EQ(allocations() - start, 0u);
+  EXPECT_GE(mock_shared_memory.stats.express_loaded,
+            uint64_t(3 * (WARMUP_PACKAGES + MEASURED_PACKAGES)));
+}
+
+/**
+ * @test TruckCycleIsAllocationFree
+ * @brief Dock, wait, depart and route, repeated with zero travel time.
+ */
+TEST_F(AllocationTest, TruckCycleIsAllocationFree) {
+  int cycles = 0;
+  size_t start = 0, end = 0;
+
+  Truck truck(&mock_shared_memory, no_op, no_op, [&](pid_t) {
+    if (cycles == WARMUP_PACKAGES)
+      start = allocations();
+    if (cycles == WARMUP_PACKAGES + MEASURED_PACKAGES) {
+      end = allocations();
+      mock_shared_memory.running = false;
+      return SIGNAL_END_WORK;
+    }
+    cycles++;
+    return SIGNAL_DEPARTURE;
+  });
+  truck.setRouteTime(0, 0);
+  truck.run();
+
+  EXPECT_EQ(end - start, 0u);
+  EXPECT_EQ(mock_shared_memory.trucks_completed,
+            WARMUP_PACKAGES + MEASURED_PACKAGES);
+}
+
+/**
+ * @test WorkerProductionIsAllocationFree
+ * @brief Session quota check, package generation and belt push per package.
+ * * The belt's "full slot" signal drains the package straight away, standing
+ * in for a dispatcher, and stops the worker once the window is complete.
+ */
+TEST_F(AllocationTest, WorkerProductionIsAllocationFree) {
+  AllocationManager manager;
+  manager.injectMockShm(&mock_shared_memory);
+
+  int produced = 0;
+  size_t start = 0, end = 0;
+  Belt *belt = nullptr;
+  std::function<void()> drain = [&]() {
+    belt->pop();
+    produced++;
+    if (produced == WARMUP_PACKAGES)
+      start = allocations();
+    if (produced == WARMUP_PACKAGES + MEASURED_PACKAGES) {
+      end = allocations();
+      mock_shared_memory.running = false;
+    }
+  };
+  manager.belt.reset(
+      new Belt(&mock_shared_memory, no_op, no_op, no_op, drain, no_op, no_op));
+  belt = manager.belt.get();
+  manager.session_store.reset(
+      new SessionManager(&mock_shared_memory, no_op, no_op));
+  ASSERT_TRUE(
+      manager.session_store->login("alloc-worker", UserRole::Operator, 1, 10));
+
+  Worker worker(&manager, 1);
+  worker.setArrivalRate(0);
+  worker.run();
+
+  EXPECT_EQ(produced, WARMUP_PACKAGES + MEASURED_PACKAGES);
+  EXPECT_EQ(end - start, 0u);
+}
@@ -0,0 +1,153 @@
+/**
+ * @file arrival_process_test.cpp
+ * @brief Unit tests for the worker arrival processes.
+ * * The statistical checks use fixed seeds and enough arrivals that the
+ * tolerances hold by a wide margin.
+ */
+
+#include "../include/ArrivalProcess.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+
+/** @brief Arrivals per one-second window over `seconds` of process time. */
+std::vector<int> countsPerSecond(ArrivalProcess &p, int seconds) {
+  std::vector<int> counts(seconds, 0);
+  for (;;) {
+    p.nextGap();
+    int window = static_cast<int>(p.clock());
+    if (window >= seconds)
+      return counts;
+    counts[window]++;
+  }
+}
+
+/** @brief Variance-to-mean ratio of `counts` (1 for a Poisson process). */
+double dispersion(const std::vector<int> &counts) {
+  double mean = 0, var = 0;
+  for (int c : counts)
+    mean += c;
+  mean /= counts.size();
+  for (int c : counts)
+    var += (c - mean) * (c - mean);
+  var /= counts.size();
+  return var / mean;
+}
+
+} // namespace
+
+/**
+ * @test ParsesEveryShape
+ * @brief Each documented specification is accepted with its parameters.
+ */
+TEST(ArrivalProcessTest, ParsesEveryShape) {
+  ArrivalSpec spec;
+  ASSERT_TRUE(parseArrivalSpec("bursty:8:2:0.5", 10, spec));
+  EXPECT_EQ(spec.kind, ArrivalKind::Bursty);
+  EXPECT_DOUBLE_EQ(spec.burst_factor, 8);
+  EXPECT_DOUBLE_EQ(spec.dwell_s[0], 2);
+  EXPECT_DOUBLE_EQ(spec.dwell_s[1], 0.5);
+
+  ASSERT_TRUE(parseArrivalSpec("diurnal:60:0.5", 10, spec));
+  EXPECT_EQ(spec.kind, ArrivalKind::Diurnal);
+  EXPECT_DOUBLE_EQ(spec.period_s, 60);
+  EXPECT_TRUE(parseArrivalSpec("poisson", 10, spec));
+  EXPECT_TRUE(parseArrivalSpec("onoff:1:3", 10, spec));
+  EXPECT_TRUE(parseArrivalSpec("fixed", 10, spec));
+
+  EXPECT_FALSE(parseArrivalSpec("poisson", 0, spec)) << "Needs a rate";
+  EXPECT_FALSE(parseArrivalSpec("bursty:8:2", 10, spec));
+  EXPECT_FALSE(parseArrivalSpec("onoff:1:3:4", 10, spec));
+  EXPECT_FALSE(parseArrivalSpec("diurnal:60:1.5", 10, spec));
+  EXPECT_FALSE(parseArrivalSpec("weekly", 10, spec));
+}
+
+/**
+ * @test PoissonMatchesItsRate
+ * @brief Long-run rate is the base rate and counts are not over-dispersed.
+ */
+TEST(ArrivalProcessTest, PoissonMatchesItsRate) {
+  ArrivalSpec spec;
+  ASSERT_TRUE(parseArrivalSpec("poisson", 50, spec));
+  ArrivalProcess p(spec, 1);
+
+  std::vector<int> counts = countsPerSecond(p, 2000);
+  double total = 0;
+  for (int c : counts)
+    total += c;
+  EXPECT_NEAR(total / counts.size(), 50, 1.0);
+  EXPECT_NEAR(dispersion(counts), 1.0, 0.15);
+}
+
+/**
+ * @test BurstsAreOverDispersed
+ * @brief The modulated process keeps its long-run mean but arrives in
+ * clumps, which is what separates it from a Poisson stream.
+ */
+TEST(ArrivalProcessTest, BurstsAreOverDispersed) {
+  ArrivalSpec spec;
+  ASSERT_TRUE(parseArrivalSpec("bursty:5:4:1", 20, spec));
+  ArrivalProcess p(spec, 7);
+
+  std::vector<int> counts = countsPerSecond(p, 4000);
+  double total = 0;
+  for (int c : counts)
+    total += c;
+  // Calm 4 s at 20/s, bursts 1 s at 100/s: (4 * 20 + 1 * 100) / 5 = 36.
+  EXPECT_NEAR(total / counts.size(), 36, 2.5);
+  EXPECT_GT(dispersion(counts), 5.0);
+}
+
+/**
+ * @test OnOffIsSilentWhileOff
+ * @brief The long-run rate is scaled by the on fraction.
+ */
+TEST(ArrivalProcessTest, OnOffIsSilentWhileOff) {
+  ArrivalSpec spec;
+  ASSERT_TRUE(parseArrivalSpec("onoff:1:3", 40, spec));
+  ArrivalProcess p(spec, 3);
+
+  std::vector<int> counts = countsPerSecond(p, 4000);
+  double total = 0;
+  int silent = 0;
+  for (int c : counts) {
+    total += c;
+    silent += c == 0;
+  }
+  EXPECT_NEAR(total / counts.size(), 10, 1.0);
+  EXPECT_GT(silent, 1000) << "Off periods leave whole seconds empty";
+}
+
+/**
+ * @test DiurnalFollowsTheCurve
+ * @brief Peaks and troughs of the cycle see the expected rates.
+ */
+TEST(ArrivalProcessTest, DiurnalFollowsTheCurve) {
+  ArrivalSpec spec;
+  ASSERT_TRUE(parseArrivalSpec("diurnal:40:0.8", 50, spec));
+  ArrivalProcess p(spec, 11);
+
+  std::vector<int> counts = countsPerSecond(p, 4000);
+  double peak = 0, trough = 0;
+  int cycles = 4000 / 40;
+  for (int c = 0; c < cycles; ++c) {
+    peak += counts[c * 40 + 10];   // sin = 1
+    trough += counts[c * 40 + 30]; // sin = -1
+  }
+  EXPECT_NEAR(peak / cycles, 50 * 1.8, 5.0);
+  EXPECT_NEAR(trough / cycles, 50 * 0.2, 2.0);
+}
+
+/**
+ * @test FixedIsEvenlySpaced
+ * @brief The default process reproduces the old constant pacing.
+ */
+TEST(ArrivalProcessTest, FixedIsEvenlySpaced) {
+  ArrivalSpec spec;
+  ASSERT_TRUE(parseArrivalSpec("fixed", 4, spec));
+  ArrivalProcess p(spec, 0);
+  for (int i = 0; i < 3; ++i)
+    EXPECT_DOUBLE_EQ(p.nextGap(), 0.25);
+  EXPECT_DOUBLE_EQ(p.clock(), 0.75);
+}
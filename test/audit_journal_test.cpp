@@ -0,0 +1,172 @@
+/**
+ * @file audit_journal_test.cpp
+ * @brief Tests for the memory-mapped package audit journal.
+ * * Writers run against a mocked SharedState (the cursor is just a field) and
+ * a scratch directory; the reader maps the produced segment files.
+ */
+
+#include "../include/AuditJournal.h"
+#include "../include/Belt.h"
+#include "../include/Dispatcher.h"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <thread>
+
+/**
+ * @class AuditJournalTest
+ * @brief Fixture providing a zeroed SharedState and an empty journal dir.
+ */
+class AuditJournalTest : public ::testing::Test {
+protected:
+  SharedState mock_shared_memory;
+  std::string dir = "audit_journal_test.d";
+  std::function<void()> no_op = []() {};
+
+  void SetUp() override {
+    std::memset(&mock_shared_memory, 0, sizeof(SharedState));
+    mock_shared_memory.running = true;
+    AuditJournal::reset(dir);
+  }
+
+  void TearDown() override {
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+  }
+};
+
+/**
+ * @test HistoryIsUnbounded
+ * @brief The old per-package buffer stopped at 6 events; the journal keeps all.
+ */
+TEST_F(AuditJournalTest, HistoryIsUnbounded) {
+  {
+    AuditJournal journal(&mock_shared_memory, dir);
+    for (int i = 0; i < 50; ++i)
+      ASSERT_TRUE(journal.append(7, ActionType::PlacedOnBelt, 1000 + i));
+    journal.append(8, ActionType::Created);
+  }
+
+  JournalReader reader(dir);
+  EXPECT_EQ(reader.buildIndex(), 2u);
+
+  auto events = reader.history(7);
+  ASSERT_EQ(events.size(), 50u);
+  EXPECT_EQ(events.front().pid, 1000);
+  EXPECT_EQ(events.back().pid, 1049);
+  EXPECT_EQ(events[3].action, static_cast<uint8_t>(ActionType::PlacedOnBelt));
+  EXPECT_LE(events.front().timestamp_ns, events.back().timestamp_ns);
+
+  ASSERT_EQ(reader.history(8).size(), 1u);
+  EXPECT_EQ(reader.history(8)[0].pid, getpid());
+  EXPECT_TRUE(reader.history(9).empty());
+}
+
+/**
+ * @test RollsOverIntoNewSegments
+ * @brief Records past the first segment land in journal.000001.seg.
+ */
+TEST_F(AuditJournalTest, RollsOverIntoNewSegments) {
+  AuditJournal journal(&mock_shared_memory, dir);
+  mock_shared_memory.journal_cursor = JOURNAL_SEGMENT_RECORDS - 2;
+  for (uint32_t i = 1; i <= 4; ++i)
+    ASSERT_TRUE(journal.append(i, ActionType::PickedUp));
+
+  EXPECT_TRUE(std::filesystem::exists(dir + "/journal.000001.seg"));
+
+  JournalReader reader(dir);
+  EXPECT_EQ(reader.capacity(), 2 * JOURNAL_SEGMENT_RECORDS);
+  EXPECT_EQ(reader.at(0), nullptr);
+  ASSERT_NE(reader.at(JOURNAL_SEGMENT_RECORDS), nullptr);
+  EXPECT_EQ(reader.at(JOURNAL_SEGMENT_RECORDS)->package_id, 3u);
+  EXPECT_EQ(reader.forEach([](uint64_t, const JournalRecord &) {}), 4u);
+}
+
+/**
+ * @test ConcurrentWritersNeverCollide
+ * @brief Lock-free reservation gives every writer a distinct slot.
+ */
+TEST_F(AuditJournalTest, ConcurrentWritersNeverCollide) {
+  AuditJournal journal(&mock_shared_memory, dir);
+  constexpr int THREADS = 4;
+  constexpr int PER_THREAD = 5000;
+
+  std::vector<std::thread> writers;
+  for (int t = 0; t < THREADS; ++t) {
+    writers.emplace_back([&journal, t]() {
+      for (int i = 0; i < PER_THREAD; ++i)
+        journal.append(t + 1, ActionType::LoadedToTruck, i + 1);
+    });
+  }
+  for (auto &w : writers)
+    w.join();
+
+  EXPECT_EQ(journal.size(), uint64_t(THREADS * PER_THREAD));
+
+  JournalReader reader(dir);
+  reader.buildIndex();
+  for (int t = 0; t < THREADS; ++t) {
+    auto events = reader.history(t + 1);
+    ASSERT_EQ(events.size(), size_t(PER_THREAD));
+    for (int i = 0; i < PER_THREAD; ++i)
+      EXPECT_EQ(events[i].pid, i + 1);
+  }
+}
+
+/**
+ * @test RecordsFullPackageLifecycle
+ * @brief Belt push, pop and Dispatcher load each leave one event.
+ */
+TEST_F(AuditJournalTest, RecordsFullPackageLifecycle) {
+  AuditJournal journal(&mock_shared_memory, dir);
+  Belt belt(&mock_shared_memory, no_op, no_op, no_op, no_op, no_op, no_op);
+  belt.setWorkloadSimulation(false);
+  belt.setJournal(&journal);
+  Dispatcher dispatcher(&belt, &mock_shared_memory, no_op, no_op,
+                        [](pid_t, SignalType) {});
+  dispatcher.setJournal(&journal);
+
+  TruckState &truck = mock_shared_memory.dock_truck;
+  truck.is_present = true;
+  truck.max_load = 100;
+  truck.max_weight = 100.0;
+  truck.max_volume = 10.0;
+
+  Package p;
+  p.creator_pid = 4242;
+  p.weight = 3.0;
+  p.volume = VOL_A;
+  belt.push(p);
+  dispatcher.processNextPackage();
+
+  JournalReader reader(dir);
+  reader.buildIndex();
+  auto events = reader.history(p.id);
+  ASSERT_EQ(events.size(), 3u);
+  EXPECT_EQ(events[0].pid, 4242);
+  EXPECT_TRUE(hasFlag(static_cast<ActionType>(events[0].action),
+                      ActionType::PlacedOnBelt));
+  EXPECT_EQ(events[1].action, static_cast<uint8_t>(ActionType::PickedUp));
+  EXPECT_TRUE(hasFlag(static_cast<ActionType>(events[2].action),
+                      ActionType::LoadedToTruck));
+
+  char buf[96];
+  EXPECT_STREQ(describeAction(events[0].action, buf, sizeof(buf)),
+               "CREATED|ON_BELT|BY_WORKER");
+}
+
+/**
+ * @test ResetRemovesStaleSegments
+ * @brief A new owner starts from an empty journal.
+ */
+TEST_F(AuditJournalTest, ResetRemovesStaleSegments) {
+  {
+    AuditJournal journal(&mock_shared_memory, dir);
+    journal.append(1, ActionType::Created);
+  }
+  ASSERT_TRUE(std::filesystem::exists(dir + "/journal.000000.seg"));
+
+  AuditJournal::reset(dir);
+
+  EXPECT_FALSE(std::filesystem::exists(dir + "/journal.000000.seg"));
+  EXPECT_EQ(JournalReader(dir).capacity(), 0u);
+}
@@ -7,8 +7,10 @@
  */
 
 #include "../include/Belt.h"
+#include <atomic>
 #include <cstring>
 #include <gtest/gtest.h>
+#include <thread>
 
 /**
  * @class BeltTest
@@ -225,3 +227,188 @@ TEST_F(BeltTest, SafetyNullCheck) {
   Package out = unsafe_belt.pop();
   EXPECT_EQ(out.id, 0);
 }
+
+/**
+ * @test TransitHoldsPackagesUntilArrival
+ * @brief With a belt speed, packages take a slot at once but are only
+ * signalled to the consumer when the timer wheel reports their arrival.
+ * * **Logic Check**:
+ * - No 'Full Slots' signal and no pop before the transit time has elapsed.
+ * - Both packages are released together once due, and pop in FIFO order.
+ */
+TEST_F(BeltTest, TransitHoldsPackagesUntilArrival) {
+  int full_signals = 0;
+  Belt belt(&mock_shared_memory, no_op, no_op, no_op,
+            [&]() { full_signals++; }, no_op, no_op);
+  belt.setWorkloadSimulation(false);
+  mock_shared_memory.transit.speed_ms = 50;
+
+  Package p1 = {};
+  p1.weight = 10;
+  Package p2 = {};
+  p2.weight = 20;
+  belt.push(p1);
+  belt.push(p2);
+
+  EXPECT_EQ(belt.getCount(), 2);
+  EXPECT_EQ(belt.getInTransit(), 2);
+  EXPECT_EQ(full_signals, 0);
+  EXPECT_EQ(belt.pop().id, 0) << "Nothing has reached the end of the belt";
+  full_signals = 0;
+
+  EXPECT_EQ(belt.advanceTransit(p1.created_ns + 49000000), 0);
+  EXPECT_EQ(full_signals, 0);
+
+  EXPECT_EQ(belt.advanceTransit(p2.created_ns + 51000000), 2);
+  EXPECT_EQ(full_signals, 2);
+  EXPECT_TRUE(mock_shared_memory.transit.arrived[0]);
+  EXPECT_TRUE(mock_shared_memory.transit.arrived[1]);
+  EXPECT_EQ(belt.getInTransit(), 0);
+  EXPECT_EQ(belt.pop().id, 1);
+  EXPECT_EQ(belt.pop().id, 2);
+  EXPECT_EQ(belt.advanceTransit(p2.created_ns + 60000000), 0);
+}
+
+/**
+ * @test TransitTickerReleasesInRealTime
+ * @brief `runTransit` delivers a package after roughly the belt speed.
+ */
+TEST_F(BeltTest, TransitTickerReleasesInRealTime) {
+  std::atomic<int> full_signals{0};
+  Belt belt(&mock_shared_memory, no_op, no_op, no_op,
+            [&]() { full_signals++; }, no_op, no_op);
+  belt.setWorkloadSimulation(false);
+  mock_shared_memory.running = true;
+  mock_shared_memory.transit.speed_ms = 30;
+
+  std::atomic<bool> stop{false};
+  std::thread ticker([&]() { belt.runTransit(stop); });
+
+  Package p = {};
+  p.weight = 5;
+  belt.push(p);
+  std::this_thread::sleep_for(std::chrono::milliseconds(15));
+  EXPECT_EQ(full_signals.load(), 0);
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+  while (full_signals.load() == 0 &&
+         std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  uint64_t delivered_ns = monotonicNowNs();
+
+  stop.store(true);
+  ticker.join();
+  EXPECT_EQ(full_signals.load(), 1);
+  EXPECT_GE(delivered_ns, p.created_ns + 30000000);
+}
+
+/**
+ * @test EdfServesEarliestDeadline
+ * @brief In EDF mode the package with the earliest deadline leaves first
+ * and freed slots are reused.
+ */
+TEST_F(BeltTest, EdfServesEarliestDeadline) {
+  Belt belt(&mock_shared_memory, no_op, no_op, no_op, no_op, no_op, no_op);
+  belt.setWorkloadSimulation(false);
+  mock_shared_memory.schedule.order = BeltOrder::Edf;
+
+  const uint64_t deadlines[] = {4000, 1000, 3000, 2000};
+  for (uint64_t d : deadlines) {
+    Package p = {};
+    p.deadline_ns = d;
+    belt.push(p);
+  }
+
+  EXPECT_EQ(belt.pop().deadline_ns, 1000u);
+  EXPECT_EQ(belt.pop().deadline_ns, 2000u);
+
+  Package urgent = {};
+  urgent.deadline_ns = 500;
+  belt.push(urgent);
+  EXPECT_EQ(mock_shared_memory.schedule.used, 4) << "A freed slot is reused";
+
+  EXPECT_EQ(belt.pop().deadline_ns, 500u);
+  EXPECT_EQ(belt.pop().deadline_ns, 3000u);
+  EXPECT_EQ(belt.pop().deadline_ns, 4000u);
+  EXPECT_EQ(belt.getCount(), 0);
+}
+
+/**
+ * @test EdfOnlyServesArrivedPackages
+ * @brief With a belt speed, a package in transit is not served before one
+ * that has arrived, whatever its deadline; missing deadlines are filled in.
+ */
+TEST_F(BeltTest, EdfOnlyServesArrivedPackages) {
+  Belt belt(&mock_shared_memory, no_op, no_op, no_op, no_op, no_op, no_op);
+  belt.setWorkloadSimulation(false);
+  mock_shared_memory.schedule.order = BeltOrder::Edf;
+  mock_shared_memory.transit.speed_ms = 50;
+
+  Package late = {};
+  late.tier = SlaTier::Standard;
+  belt.push(late);
+  EXPECT_EQ(late.deadline_ns,
+            late.created_ns + slaBudgetMs(SlaTier::Standard) * 1000000ULL)
+      << "Unconfigured budgets fall back to the defaults";
+
+  EXPECT_EQ(belt.advanceTransit(late.created_ns + 51000000), 1);
+
+  Package urgent = {};
+  urgent.deadline_ns = 1;
+  belt.push(urgent);
+
+  EXPECT_EQ(belt.pop().id, late.id) << "The urgent one is still in transit";
+  EXPECT_EQ(belt.pop().id, 0);
+  EXPECT_EQ(belt.advanceTransit(urgent.created_ns + 100000000), 1);
+  EXPECT_EQ(belt.pop().id, urgent.id);
+}
+
+/**
+ * @test ParkedPackagesAreTakenByTheirLane
+ * @brief Handed-over packages are only given to the lane they came from.
+ */
+TEST_F(BeltTest, ParkedPackagesAreTakenByTheirLane) {
+  Belt belt(&mock_shared_memory, no_op, no_op, no_op, no_op, no_op, no_op);
+
+  Package a = {};
+  a.id = 1;
+  Package b = {};
+  b.id = 2;
+  EXPECT_TRUE(belt.park(a, -1));
+  EXPECT_TRUE(belt.park(b, 1));
+
+  Package out = {};
+  EXPECT_FALSE(belt.unpark(0, out));
+  ASSERT_TRUE(belt.unpark(1, out));
+  EXPECT_EQ(out.id, 2);
+  ASSERT_TRUE(belt.unpark(-1, out));
+  EXPECT_EQ(out.id, 1);
+  EXPECT_EQ(mock_shared_memory.handoff.count, 0);
+
+  for (int i = 0; i < HANDOFF_SLOTS; ++i)
+    EXPECT_TRUE(belt.park(a, -1));
+  EXPECT_FALSE(belt.park(a, -1)) << "Shelf is bounded";
+}
+
+/**
+ * @test InterruptedWaitTakesNoSlot
+ * @brief A wait that returned without a permit leaves the belt untouched.
+ */
+TEST_F(BeltTest, InterruptedWaitTakesNoSlot) {
+  Belt belt(&mock_shared_memory, no_op, no_op, no_op, no_op, no_op, no_op);
+  belt.setWorkloadSimulation(false);
+
+  Package p = {};
+  belt.push(p);
+
+  belt.setWaitFailedCheck([]() { return true; });
+  belt.push(p);
+  EXPECT_EQ(belt.getCount(), 1);
+  EXPECT_EQ(belt.pop().id, 0);
+  EXPECT_EQ(belt.getCount(), 1);
+
+  EXPECT_EQ(mock_shared_memory.total_packages_created, 1);
+
+  belt.setWaitFailedCheck(nullptr);
+  EXPECT_EQ(belt.pop().id, 1);
+}
@@ -0,0 +1,83 @@
+/**
+ * @file deadline_heap_test.cpp
+ * @brief Tests for the shared-memory d-ary deadline heap.
+ */
+
+#include "../include/DeadlineHeap.h"
+#include <algorithm>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+/** @brief Heap-allocated, zero-filled heap (the state shared memory has). */
+template <int N, int D> std::unique_ptr<DeadlineHeap<N, D>> makeHeap() {
+  std::unique_ptr<DeadlineHeap<N, D>> heap(new DeadlineHeap<N, D>);
+  std::memset(heap.get(), 0, sizeof(DeadlineHeap<N, D>));
+  return heap;
+}
+
+/** @brief Interleaves random pushes and pops against a sorted reference. */
+template <int D> void checkAgainstSort() {
+  constexpr int N = 512;
+  auto heap = makeHeap<N, D>();
+  std::mt19937 gen(D);
+  std::uniform_int_distribution<uint64_t> deadline(0, 1000);
+  std::vector<std::pair<uint64_t, uint32_t>> model; // (deadline, payload)
+
+  uint32_t next = 0;
+  for (int round = 0; round < 20000; ++round) {
+    if (model.size() < N && (model.empty() || gen() % 3 != 0)) {
+      uint64_t d = deadline(gen);
+      ASSERT_TRUE(heap->push(d, next));
+      model.emplace_back(d, next++);
+      continue;
+    }
+    // Equal deadlines leave in insertion order, which payloads follow.
+    auto it = std::min_element(model.begin(), model.end());
+    typename DeadlineHeap<N, D>::Entry e;
+    ASSERT_TRUE(heap->pop(e));
+    EXPECT_EQ(e.deadline, it->first);
+    EXPECT_EQ(e.payload, it->second);
+    model.erase(it);
+  }
+  EXPECT_EQ(heap->size, static_cast<int32_t>(model.size()));
+}
+
+} // namespace
+
+/**
+ * @test PopsInDeadlineOrder
+ * @brief Binary and 4-ary heaps agree with a sorted reference.
+ */
+TEST(DeadlineHeapTest, PopsInDeadlineOrder) {
+  checkAgainstSort<2>();
+  checkAgainstSort<4>();
+}
+
+/**
+ * @test BoundedAndReusable
+ * @brief A full heap rejects pushes and accepts them again once drained.
+ */
+TEST(DeadlineHeapTest, BoundedAndReusable) {
+  auto heap = makeHeap<4, 4>();
+  typename DeadlineHeap<4, 4>::Entry e;
+  EXPECT_EQ(heap->top(), nullptr);
+  EXPECT_FALSE(heap->pop(e));
+
+  for (uint32_t i = 0; i < 4; ++i)
+    EXPECT_TRUE(heap->push(100 - i, i));
+  EXPECT_FALSE(heap->push(1, 99)) << "Capacity reached";
+  EXPECT_EQ(heap->top()->payload, 3u);
+
+  for (uint32_t i = 0; i < 4; ++i) {
+    ASSERT_TRUE(heap->pop(e));
+    EXPECT_EQ(e.payload, 3 - i);
+  }
+  EXPECT_TRUE(heap->push(5, 42));
+  ASSERT_TRUE(heap->pop(e));
+  EXPECT_EQ(e.payload, 42u);
+}
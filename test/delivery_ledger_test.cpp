@@ -0,0 +1,189 @@
+/**
+ * @file delivery_ledger_test.cpp
+ * @brief Tests for the columnar delivery ledger and its truck integration.
+ */
+
+#include "../include/DeliveryLedger.h"
+#include "../include/Truck.h"
+#include <cstdio>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+
+/**
+ * @class DeliveryLedgerTest
+ * @brief Fixture providing an empty ledger file.
+ */
+class DeliveryLedgerTest : public ::testing::Test {
+protected:
+  std::string path = "delivery_ledger_test.ledger";
+
+  void SetUp() override { DeliveryLedger::reset(path); }
+  void TearDown() override { std::remove(path.c_str()); }
+
+  static DeliveryRecord row(int truck, int load, double weight,
+                            DepartureReason reason) {
+    return {truck, 1000, 3000, load, weight, 1.0, 400.0, 2.0, reason};
+  }
+};
+
+/**
+ * @test AggregatesAcrossWriters
+ * @brief Two writers (e.g. two truck processes) share one file.
+ */
+TEST_F(DeliveryLedgerTest, AggregatesAcrossWriters) {
+  {
+    auto a = std::make_unique<DeliveryLedger>(path);
+    auto b = std::make_unique<DeliveryLedger>(path);
+    a->append(row(1, 10, 200.0, DepartureReason::Full));
+    b->append(row(2, 20, 100.0, DepartureReason::NoFit));
+    a->append(row(1, 30, 400.0, DepartureReason::Full));
+    EXPECT_EQ(a->pending(), 2u);
+  }
+
+  LedgerReader reader(path);
+  ASSERT_TRUE(reader.valid());
+  LedgerAggregate agg = reader.scan();
+
+  EXPECT_EQ(agg.departures, 3u);
+  EXPECT_EQ(agg.packages, 60u);
+  EXPECT_DOUBLE_EQ(agg.weight, 700.0);
+  EXPECT_DOUBLE_EQ(agg.meanWeightUtilization(), 700.0 / 400.0 / 3);
+  EXPECT_DOUBLE_EQ(agg.meanVolumeUtilization(), 0.5);
+  EXPECT_NEAR(agg.dock_seconds, 3 * 2e-6, 1e-12);
+  EXPECT_EQ(agg.by_reason[static_cast<int>(DepartureReason::Full)], 2u);
+  EXPECT_EQ(agg.by_reason[static_cast<int>(DepartureReason::NoFit)], 1u);
+  EXPECT_EQ(agg.blocks_scanned, 2u);
+}
+
+/**
+ * @test StatisticsSkipBlocks
+ * @brief Blocks whose truck-id range excludes the filter are not read.
+ */
+TEST_F(DeliveryLedgerTest, StatisticsSkipBlocks) {
+  {
+    auto ledger = std::make_unique<DeliveryLedger>(path);
+    ledger->setFlushPolicy(LEDGER_BLOCK_ROWS, 0);
+    for (uint32_t i = 0; i < LEDGER_BLOCK_ROWS; ++i)
+      ledger->append(row(7, 1, 50.0, DepartureReason::Full));
+    EXPECT_EQ(ledger->pending(), 0u) << "A full block is written eagerly";
+    for (int i = 0; i < 5; ++i)
+      ledger->append(row(9, 2, 50.0, DepartureReason::Forced));
+  }
+
+  LedgerReader reader(path);
+  LedgerFilter filter;
+  filter.truck_id = 9;
+  LedgerAggregate agg = reader.scan(filter);
+
+  EXPECT_EQ(agg.departures, 5u);
+  EXPECT_EQ(agg.packages, 10u);
+  EXPECT_EQ(agg.blocks_scanned, 1u);
+  EXPECT_EQ(agg.blocks_skipped, 1u);
+
+  filter = {};
+  filter.reason = static_cast<int>(DepartureReason::Forced);
+  EXPECT_EQ(reader.scan(filter).departures, 5u);
+  EXPECT_EQ(reader.scan().departures, LEDGER_BLOCK_ROWS + 5);
+}
+
+/**
+ * @test TimestampStatisticsAreExact
+ * @brief Realistic ns timestamps (> 2^53) one nanosecond apart are told
+ * apart when blocks are skipped.
+ */
+TEST_F(DeliveryLedgerTest, TimestampStatisticsAreExact) {
+  const uint64_t t = 1700000000000000000ULL;
+  ASSERT_EQ(static_cast<double>(t), static_cast<double>(t + 1))
+      << "The case a double cannot represent";
+  {
+    DeliveryLedger ledger(path);
+    DeliveryRecord r = row(3, 1, 10.0, DepartureReason::Full);
+    r.dock_ns = t - 1000;
+    r.depart_ns = t;
+    ledger.append(r);
+  }
+
+  LedgerReader reader(path);
+  LedgerFilter filter;
+  filter.to_ns = t + 1;
+  EXPECT_EQ(reader.scan(filter).departures, 1u);
+  filter.to_ns = t;
+  EXPECT_EQ(reader.scan(filter).blocks_skipped, 1u);
+  filter = {};
+  filter.from_ns = t + 1;
+  EXPECT_EQ(reader.scan(filter).blocks_skipped, 1u);
+}
+
+/**
+ * @test PartialBlocksAreFlushed
+ * @brief Rows reach the file by row count or age, not only when a block
+ * fills, so a killed writer loses little.
+ */
+TEST_F(DeliveryLedgerTest, PartialBlocksAreFlushed) {
+  DeliveryLedger ledger(path);
+  ledger.setFlushPolicy(2, 0);
+  ledger.append(row(1, 1, 10.0, DepartureReason::Full));
+  EXPECT_EQ(ledger.pending(), 1u);
+  ledger.append(row(1, 1, 10.0, DepartureReason::Full));
+  EXPECT_EQ(ledger.pending(), 0u) << "Row threshold reached";
+
+  ledger.setFlushPolicy(100, 1);
+  ledger.append(row(2, 1, 10.0, DepartureReason::NoFit));
+  ledger.flushIfDue(monotonicNowNs());
+  EXPECT_EQ(ledger.pending(), 1u) << "Not old enough yet";
+  ledger.flushIfDue(monotonicNowNs() + 2000000ULL);
+  EXPECT_EQ(ledger.pending(), 0u) << "Age threshold reached";
+
+  LedgerAggregate agg = LedgerReader(path).scan();
+  EXPECT_EQ(agg.departures, 3u);
+  EXPECT_EQ(agg.blocks_scanned, 2u);
+}
+
+/**
+ * @test RejectsForeignFiles
+ * @brief A file without the ledger header is reported invalid.
+ */
+TEST_F(DeliveryLedgerTest, RejectsForeignFiles) {
+  FILE *f = std::fopen(path.c_str(), "w");
+  std::fputs("not a ledger, just some text", f);
+  std::fclose(f);
+
+  EXPECT_FALSE(LedgerReader(path).valid());
+  EXPECT_FALSE(LedgerReader("does_not_exist.ledger").valid());
+}
+
+/**
+ * @test TruckRecordsEveryDeparture
+ * @brief Truck::run writes one row per departure with payload and reason.
+ */
+TEST_F(DeliveryLedgerTest, TruckRecordsEveryDeparture) {
+  SharedState shm;
+  std::memset(&shm, 0, sizeof(SharedState));
+  shm.running = true;
+  std::function<void()> no_op = []() {};
+  auto ledger = std::make_unique<DeliveryLedger>(path);
+
+  int cycles = 0;
+  Truck truck(&shm, no_op, no_op, [&](pid_t) {
+    shm.dock_truck.current_load = 4;
+    shm.dock_truck.current_weight = 42.0;
+    if (++cycles <= 3) {
+      requestDeparture(shm.dock_truck, DepartureReason::Forced);
+      requestDeparture(shm.dock_truck, DepartureReason::Full);
+      return SIGNAL_DEPARTURE;
+    }
+    return SIGNAL_END_WORK;
+  });
+  truck.setRouteTime(0, 0);
+  truck.setLedger(ledger.get());
+  truck.run();
+  ledger.reset();
+
+  LedgerAggregate agg = LedgerReader(path).scan();
+  EXPECT_EQ(agg.departures, 4u);
+  EXPECT_EQ(agg.packages, 16u);
+  EXPECT_DOUBLE_EQ(agg.weight, 4 * 42.0);
+  EXPECT_EQ(agg.by_reason[static_cast<int>(DepartureReason::Forced)], 3u);
+  EXPECT_EQ(agg.by_reason[static_cast<int>(DepartureReason::Shutdown)], 1u);
+}
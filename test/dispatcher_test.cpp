@@ -81,3 +81,94 @@ TEST_F(DispatcherTest, SuccessfulLoad) {
   EXPECT_DOUBLE_EQ(m.getState()->dock_truck.current_volume, 0.1);
   m.unlockDock();
 }
+
+/**
+ * @test DepartureIsSignalledOnce
+ * @brief A full truck followed by a package that does not fit yields one
+ * DEPARTURE message, not one per retry.
+ * * Scenario:
+ * 1. The first package fills the truck to its weight limit (Full request).
+ * 2. The second does not fit; the Dispatcher retries every 200 ms while the
+ *    truck (which never reacts here) stays docked.
+ * * Expected Result:
+ * - Exactly one SIGNAL_DEPARTURE is queued for the truck.
+ * - The repeated requests are counted as coalesced.
+ */
+TEST_F(DispatcherTest, DepartureIsSignalledOnce) {
+  Manager m(true);
+  SharedState *shm = m.getState();
+
+  TruckState &truck = shm->dock_truck;
+  truck.is_present = true;
+  truck.id = 101;
+  truck.max_load = 100;
+  truck.max_weight = 10.0;
+  truck.max_volume = 10.0;
+
+  Package full = {};
+  full.id = 1;
+  full.weight = 9.95;
+  full.volume = 0.1;
+  Package next = full;
+  next.id = 2;
+  next.weight = 5.0;
+  m.belt->push(full);
+  m.belt->push(next);
+
+  m.dispatcher->processNextPackage();
+  EXPECT_EQ(truck.phase, DockPhase::DepartureRequested);
+  EXPECT_EQ(truck.departure_reason, DepartureReason::Full);
+
+  std::thread dispatcher([&]() { m.dispatcher->processNextPackage(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(700));
+  shm->running = false;
+  dispatcher.join();
+
+  EXPECT_EQ(m.receiveSignalNonBlocking(101), SIGNAL_DEPARTURE);
+  EXPECT_EQ(m.receiveSignalNonBlocking(101), SIGNAL_NONE)
+      << "Retries must not queue further DEPARTURE messages";
+  EXPECT_GE(shm->stats.departures_coalesced, 3u);
+}
+
+/**
+ * @test StoppedDispatcherHandsOverPackage
+ * @brief A Dispatcher stopped while its package does not fit parks it, and
+ * the next Dispatcher loads it before popping the belt.
+ * * This is what a rolling restart relies on: the package is neither lost
+ * nor counted twice in `packages_in_dispatch`.
+ */
+TEST_F(DispatcherTest, StoppedDispatcherHandsOverPackage) {
+  Manager m(true);
+  SharedState *shm = m.getState();
+
+  TruckState &truck = shm->dock_truck;
+  truck.is_present = true;
+  truck.id = 101;
+  truck.max_load = 100;
+  truck.max_weight = 5.0;
+  truck.max_volume = 10.0;
+
+  Package heavy = {};
+  heavy.id = 7;
+  heavy.weight = 8.0;
+  heavy.volume = 0.1;
+  m.belt->push(heavy);
+
+  m.dispatcher->stop();
+  m.dispatcher->processNextPackage();
+  EXPECT_EQ(shm->handoff.count, 1);
+  EXPECT_EQ(shm->stats.packages_in_dispatch, 1);
+  EXPECT_EQ(m.belt->getCount(), 0);
+
+  truck.max_weight = 100.0;
+  truck.phase = DockPhase::Docked;
+  Dispatcher successor(
+      m.belt.get(), shm, [&m]() { m.lockDock(); }, [&m]() { m.unlockDock(); },
+      [&m](pid_t target, SignalType s) { m.sendSignal(target, s); });
+  successor.processNextPackage();
+
+  EXPECT_EQ(shm->handoff.count, 0);
+  EXPECT_EQ(shm->stats.packages_in_dispatch, 0);
+  EXPECT_EQ(shm->stats.packages_loaded, 1u);
+  EXPECT_DOUBLE_EQ(truck.current_weight, 8.0);
+}
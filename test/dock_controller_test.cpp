@@ -0,0 +1,150 @@
+/**
+ * @file dock_controller_test.cpp
+ * @brief Unit tests for the flat-combining dock controller.
+ * * Loaders run as threads over a heap-allocated SharedState with a
+ * std::mutex standing in for the dock semaphore.
+ */
+
+#include "../include/DockController.h"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <sys/wait.h>
+#include <thread>
+#include <vector>
+
+/**
+ * @class DockControllerTest
+ * @brief Docks a truck and counts the DEPARTURE signals sent to it.
+ */
+class DockControllerTest : public ::testing::Test {
+protected:
+  std::unique_ptr<SharedState> shm;
+  std::mutex dock_mutex;
+  int departures = 0;
+
+  void SetUp() override {
+    shm = std::make_unique<SharedState>();
+    std::memset(shm.get(), 0, sizeof(SharedState));
+
+    TruckState &truck = shm->dock_truck;
+    truck.is_present = true;
+    truck.id = 7;
+    truck.max_load = 1000000;
+    truck.max_weight = 1e9;
+    truck.max_volume = 1e9;
+  }
+
+  std::unique_ptr<DockController> makeLoader() {
+    return std::make_unique<DockController>(
+        &shm->dock_truck, shm.get(), [this]() { dock_mutex.lock(); },
+        [this]() { dock_mutex.unlock(); },
+        [this](pid_t, SignalType) { departures++; });
+  }
+};
+
+/**
+ * @test BatchStopsAtFirstMisfit
+ * @brief Packages after the first that does not fit stay with the caller.
+ */
+TEST_F(DockControllerTest, BatchStopsAtFirstMisfit) {
+  shm->dock_truck.max_weight = 25.0;
+  auto loader = makeLoader();
+
+  double weights[] = {10.0, 10.0, 10.0, 1.0};
+  double volumes[] = {0.1, 0.1, 0.1, 0.1};
+  const LoadSlot &r = loader->load(weights, volumes, 4, false, false,
+                                   DepartureReason::ExpressFull);
+
+  EXPECT_EQ(r.outcome, LoadOutcome::NoFit);
+  EXPECT_EQ(r.loaded, 2);
+  EXPECT_TRUE(r.departure_sent);
+  EXPECT_EQ(r.truck_id, 7);
+  EXPECT_DOUBLE_EQ(r.truck_weight, 20.0);
+  EXPECT_EQ(shm->dock_truck.current_load, 0) << "Express does not count";
+  EXPECT_EQ(shm->dock_truck.departure_reason, DepartureReason::ExpressFull);
+
+  const LoadSlot &again = loader->load(weights, volumes, 1, false, false,
+                                       DepartureReason::ExpressFull);
+  EXPECT_EQ(again.loaded, 0);
+  EXPECT_TRUE(again.departure_repeated);
+  EXPECT_EQ(departures, 1);
+}
+
+/**
+ * @test FullTruckIsSentAway
+ * @brief `check_full` requests departure once max_load is reached.
+ */
+TEST_F(DockControllerTest, FullTruckIsSentAway) {
+  shm->dock_truck.max_load = 2;
+  auto loader = makeLoader();
+
+  double w = 1.0, v = 0.01;
+  EXPECT_FALSE(
+      loader->load(&w, &v, 1, true, true, DepartureReason::NoFit)
+          .departure_sent);
+  const LoadSlot &r =
+      loader->load(&w, &v, 1, true, true, DepartureReason::NoFit);
+  EXPECT_EQ(r.outcome, LoadOutcome::Loaded);
+  EXPECT_TRUE(r.departure_sent);
+  EXPECT_EQ(shm->dock_truck.departure_reason, DepartureReason::Full);
+
+  shm->dock_truck.is_present = false;
+  EXPECT_EQ(loader->load(&w, &v, 1, true, true, DepartureReason::NoFit)
+                .outcome,
+            LoadOutcome::NoTruck);
+}
+
+/**
+ * @test ConcurrentLoadsAreAllApplied
+ * @brief Every request of every loader is applied exactly once.
+ */
+TEST_F(DockControllerTest, ConcurrentLoadsAreAllApplied) {
+  constexpr int loaders = 8;
+  constexpr int per_loader = 2000;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < loaders; ++t) {
+    threads.emplace_back([this]() {
+      auto loader = makeLoader();
+      double w = 1.0, v = 0.001;
+      for (int i = 0; i < per_loader; ++i)
+        EXPECT_EQ(loader->load(&w, &v, 1, true, true, DepartureReason::NoFit)
+                      .outcome,
+                  LoadOutcome::Loaded);
+    });
+  }
+  for (auto &t : threads)
+    t.join();
+
+  EXPECT_EQ(shm->dock_truck.current_load, loaders * per_loader);
+  EXPECT_DOUBLE_EQ(shm->dock_truck.current_weight, loaders * per_loader);
+  EXPECT_EQ(shm->stats.combined_requests, uint64_t{loaders * per_loader});
+  EXPECT_LE(shm->stats.combine_passes, shm->stats.combined_requests);
+  for (const LoadSlot &s : shm->dock_truck.loaders.slots)
+    EXPECT_EQ(s.owner, 0) << "Slots are released with the controller";
+}
+
+/**
+ * @test DeadCombinerIsReplaced
+ * @brief A combiner role left by a dead process does not wedge the dock.
+ */
+TEST_F(DockControllerTest, DeadCombinerIsReplaced) {
+  pid_t child = fork();
+  ASSERT_GE(child, 0);
+  if (child == 0)
+    _exit(0);
+  waitpid(child, nullptr, 0);
+
+  shm->dock_truck.loaders.combiner = child;
+  shm->dock_truck.loaders.slots[0].owner = child;
+
+  auto loader = makeLoader();
+  double w = 1.0, v = 0.01;
+  EXPECT_EQ(
+      loader->load(&w, &v, 1, true, false, DepartureReason::NoFit).outcome,
+      LoadOutcome::Loaded);
+  EXPECT_EQ(shm->dock_truck.current_load, 1);
+  EXPECT_EQ(shm->dock_truck.loaders.combiner, 0);
+}
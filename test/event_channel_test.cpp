@@ -0,0 +1,138 @@
+/**
+ * @file event_channel_test.cpp
+ * @brief Tests for the shared-memory alert ring and its eventfd wake-up.
+ * * Publishers and the subscriber share a zeroed SharedState in this
+ * process; the futex is process-shared, so the same holds across fork().
+ */
+
+#include "../include/EventChannel.h"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+/**
+ * @class EventChannelTest
+ * @brief Fixture providing a zeroed SharedState.
+ */
+class EventChannelTest : public ::testing::Test {
+protected:
+  std::unique_ptr<SharedState> shm = std::make_unique<SharedState>();
+
+  void SetUp() override { std::memset(shm.get(), 0, sizeof(SharedState)); }
+
+  /** @brief Waits up to `ms` for the subscriber's descriptor. */
+  static bool readable(const EventSubscriber &sub, int ms) {
+    struct pollfd pfd = {sub.fd(), POLLIN, 0};
+    return poll(&pfd, 1, ms) == 1 && (pfd.revents & POLLIN);
+  }
+};
+
+/**
+ * @test DeliversInOrderFromSubscription
+ * @brief A subscriber sees the events published after it, in order.
+ */
+TEST_F(EventChannelTest, DeliversInOrderFromSubscription) {
+  publishEvent(shm.get(), EventKind::ProcessDied, 7, 9, "worker");
+  EventSubscriber sub(shm.get());
+  ASSERT_GE(sub.fd(), 0);
+
+  SystemEvent e;
+  EXPECT_FALSE(sub.next(e)) << "Earlier events are not replayed";
+  EXPECT_TRUE(publishEvent(shm.get(), EventKind::TruckDepartedFull, 11, 25));
+  EXPECT_TRUE(publishEvent(shm.get(), EventKind::ProcessDied, 12, 9, "truck"));
+
+  ASSERT_TRUE(sub.next(e));
+  EXPECT_EQ(e.kind, static_cast<int>(EventKind::TruckDepartedFull));
+  EXPECT_EQ(e.pid, 11);
+  EXPECT_EQ(e.value, 25);
+  ASSERT_TRUE(sub.next(e));
+  EXPECT_STREQ(e.subject, "truck");
+  EXPECT_FALSE(sub.next(e));
+
+  char line[160];
+  EventSubscriber::describe(e, line, sizeof(line));
+  EXPECT_NE(std::strstr(line, "truck (PID 12) died"), nullptr) << line;
+  EXPECT_STREQ(EventSubscriber::kindName(e.kind), "process_died");
+}
+
+/**
+ * @test RateLimitsNoisyKinds
+ * @brief Saturation alerts are published once per interval; the rest are
+ * counted, and other kinds are never limited.
+ */
+TEST_F(EventChannelTest, RateLimitsNoisyKinds) {
+  EXPECT_TRUE(publishEvent(shm.get(), EventKind::BeltSaturated, 1, 10));
+  EXPECT_FALSE(publishEvent(shm.get(), EventKind::BeltSaturated, 1, 10));
+  EXPECT_FALSE(publishEvent(shm.get(), EventKind::BeltSaturated, 1, 10));
+  EXPECT_TRUE(publishEvent(shm.get(), EventKind::QuotaExhausted, 1, 4, "w"));
+  EXPECT_TRUE(publishEvent(shm.get(), EventKind::ProcessDied, 1, 0));
+  EXPECT_TRUE(publishEvent(shm.get(), EventKind::ProcessDied, 1, 0));
+
+  const EventRing &ring = shm->events;
+  EXPECT_EQ(ring.head, 4u);
+  EXPECT_EQ(ring.coalesced[static_cast<int>(EventKind::BeltSaturated)], 2u);
+
+  shm->events.last_ns[static_cast<int>(EventKind::BeltSaturated)] -=
+      EVENT_COALESCE_NS;
+  EXPECT_TRUE(publishEvent(shm.get(), EventKind::BeltSaturated, 1, 10));
+}
+
+/**
+ * @test SkipsOverwrittenEvents
+ * @brief A reader lapped by the publishers resumes at the oldest event
+ * still in the ring and reports how many it lost.
+ */
+TEST_F(EventChannelTest, SkipsOverwrittenEvents) {
+  EventSubscriber sub(shm.get());
+  for (int i = 0; i < EVENT_RING_SIZE + 10; ++i)
+    publishEvent(shm.get(), EventKind::ProcessDied, i, 0);
+
+  SystemEvent e;
+  ASSERT_TRUE(sub.next(e));
+  EXPECT_EQ(e.pid, 10);
+  EXPECT_EQ(sub.lost(), 10u);
+  int read = 1;
+  while (sub.next(e))
+    read++;
+  EXPECT_EQ(read, EVENT_RING_SIZE);
+  EXPECT_EQ(e.pid, EVENT_RING_SIZE + 9);
+}
+
+/**
+ * @test WakesPollerAcrossProcesses
+ * @brief The descriptor stays quiet while idle and becomes readable when
+ * another process publishes.
+ */
+TEST_F(EventChannelTest, WakesPollerAcrossProcesses) {
+  auto *shared = static_cast<SharedState *>(
+      mmap(nullptr, sizeof(SharedState), PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+  ASSERT_NE(shared, MAP_FAILED);
+
+  {
+    EventSubscriber sub(shared);
+    EXPECT_FALSE(readable(sub, 50)) << "Idle";
+
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+      usleep(20000);
+      publishEvent(shared, EventKind::Shutdown, getpid(), 0);
+      _exit(0);
+    }
+
+    EXPECT_TRUE(readable(sub, 5000));
+    sub.acknowledge();
+    SystemEvent e;
+    ASSERT_TRUE(sub.next(e));
+    EXPECT_EQ(e.kind, static_cast<int>(EventKind::Shutdown));
+    EXPECT_EQ(e.pid, child);
+    EXPECT_FALSE(readable(sub, 0)) << "Acknowledged";
+    waitpid(child, nullptr, 0);
+  }
+  EXPECT_EQ(shared->events.waiters, 0) << "Helper thread joined";
+  munmap(shared, sizeof(SharedState));
+}
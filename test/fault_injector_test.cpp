@@ -0,0 +1,98 @@
+/**
+ * @file fault_injector_test.cpp
+ * @brief Unit tests for the FAULT_PLAN parser and the seeded injector.
+ */
+
+#include "../include/FaultInjector.h"
+#include <chrono>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+
+/**
+ * @test ParsesRolesSitesAndActions
+ * @brief A plan with several rules keeps their order and parameters.
+ */
+TEST(FaultInjectorTest, ParsesRolesSitesAndActions) {
+  std::vector<FaultRule> rules;
+  ASSERT_TRUE(parseFaultPlan(
+      "lock_dock:pause=0.25@2000;truck/send_signal:fail=1;", rules));
+  ASSERT_EQ(rules.size(), 2u);
+
+  EXPECT_TRUE(rules[0].role.empty());
+  EXPECT_EQ(rules[0].site, FaultSite::LockDock);
+  EXPECT_EQ(rules[0].action, FaultAction::Pause);
+  EXPECT_DOUBLE_EQ(rules[0].probability, 0.25);
+  EXPECT_EQ(rules[0].duration_us, 2000u);
+
+  EXPECT_EQ(rules[1].role, "truck");
+  EXPECT_EQ(rules[1].site, FaultSite::SendSignal);
+  EXPECT_EQ(rules[1].action, FaultAction::Fail);
+}
+
+/**
+ * @test RejectsInvalidPlans
+ * @brief Unknown names, bad probabilities and missing durations fail, and
+ * leave the output untouched.
+ */
+TEST(FaultInjectorTest, RejectsInvalidPlans) {
+  std::vector<FaultRule> rules(3);
+  EXPECT_FALSE(parseFaultPlan("lock_door:delay=0.1@10", rules));
+  EXPECT_FALSE(parseFaultPlan("lock_dock:explode=0.1", rules));
+  EXPECT_FALSE(parseFaultPlan("lock_dock:delay=1.5@10", rules));
+  EXPECT_FALSE(parseFaultPlan("lock_dock:delay=0.1", rules));
+  EXPECT_FALSE(parseFaultPlan("lock_dock:fail=0.1", rules))
+      << "Only sends can fail";
+  EXPECT_FALSE(parseFaultPlan("lock_dock:kill=0.1x", rules));
+  EXPECT_EQ(rules.size(), 3u);
+}
+
+/**
+ * @test ScheduleIsSeeded
+ * @brief The same seed and role replay the same faults; another seed does
+ * not, and rules for other roles never fire.
+ */
+TEST(FaultInjectorTest, ScheduleIsSeeded) {
+  std::vector<FaultRule> plan;
+  ASSERT_TRUE(parseFaultPlan("dispatcher/send_signal:fail=0.5", plan));
+
+  auto schedule = [&](const char *role, uint64_t seed) {
+    FaultInjector faults(nullptr, plan, role, seed);
+    std::string fired;
+    for (int i = 0; i < 64; ++i)
+      fired += faults.dropped(FaultSite::SendSignal) ? '1' : '0';
+    return fired;
+  };
+
+  std::string first = schedule("system-dispatcher", 42);
+  EXPECT_EQ(first, schedule("system-dispatcher", 42));
+  EXPECT_NE(first, schedule("system-dispatcher", 43));
+  EXPECT_NE(first.find('1'), std::string::npos);
+  EXPECT_NE(first.find('0'), std::string::npos);
+  EXPECT_EQ(schedule("truck-1", 42), std::string(64, '0'));
+  EXPECT_TRUE(FaultInjector(nullptr, plan, "truck-1", 42).empty());
+}
+
+/**
+ * @test FiredFaultsAreCounted
+ * @brief Delays sleep for their duration and count against their site.
+ */
+TEST(FaultInjectorTest, FiredFaultsAreCounted) {
+  auto shm = std::make_unique<SharedState>();
+  std::memset(shm.get(), 0, sizeof(SharedState));
+
+  std::vector<FaultRule> plan;
+  ASSERT_TRUE(parseFaultPlan("lock_belt:delay=1@3000;lock_belt:pause=0@1000",
+                             plan));
+  FaultInjector faults(shm.get(), plan, "worker-1", 1);
+
+  auto start = std::chrono::steady_clock::now();
+  faults.before(FaultSite::LockBelt);
+  faults.after(FaultSite::LockBelt);
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::microseconds(3000));
+
+  const uint64_t *counts = shm->stats.faults_injected;
+  EXPECT_EQ(counts[static_cast<int>(FaultSite::LockBelt)], 1u);
+  EXPECT_EQ(counts[static_cast<int>(FaultSite::LockDock)], 0u);
+}
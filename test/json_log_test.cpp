@@ -0,0 +1,114 @@
+/**
+ * @file json_log_test.cpp
+ * @brief Tests for the structured JSON log writer and formatter.
+ * * Records go through a real spdlog logger with an ostream sink, so the
+ * checks see the exact lines the log pipeline would ingest.
+ */
+
+#include "../include/JsonLog.h"
+#include "spdlog/sinks/ostream_sink.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <string>
+
+/**
+ * @class JsonLogTest
+ * @brief Fixture installing a JSON logger over a string stream.
+ */
+class JsonLogTest : public ::testing::Test {
+protected:
+  std::ostringstream out;
+  std::shared_ptr<spdlog::logger> previous_logger;
+
+  void SetUp() override {
+    previous_logger = spdlog::default_logger();
+    auto logger = std::make_shared<spdlog::logger>(
+        "belt", std::make_shared<spdlog::sinks::ostream_sink_st>(out));
+    logger->set_formatter(std::make_unique<JsonFormatter>());
+    logger->set_level(spdlog::level::info);
+    spdlog::set_default_logger(logger);
+    JsonLog::setEnabled(true);
+  }
+
+  void TearDown() override {
+    JsonLog::setEnabled(false);
+    spdlog::set_default_logger(previous_logger);
+  }
+};
+
+/**
+ * @test WritesTypedFields
+ * @brief Integers, decimals, booleans and strings keep their JSON types,
+ * after the common fields.
+ */
+TEST_F(JsonLogTest, WritesTypedFields) {
+  JsonRecord("push")
+      .field("id", 17)
+      .field("big", uint64_t{18446744073709551615ULL})
+      .field("neg", int64_t{-5})
+      .field("kg", 12.3456)
+      .field("m3", 0.0)
+      .field("nan", 0.0 / 0.0)
+      .field("full", true)
+      .field("who", "a \"b\"\n\\")
+      .log(spdlog::level::info);
+
+  std::string line = out.str();
+  ASSERT_EQ(line.rfind("{\"ts\":\"", 0), 0u) << line;
+  EXPECT_EQ(line[17], 'T') << line;
+  EXPECT_NE(line.find("Z\",\"proc\":\"belt\",\"pid\":" +
+                      std::to_string(getpid()) +
+                      ",\"level\":\"info\",\"event\":\"push\",\"id\":17,"
+                      "\"big\":18446744073709551615,\"neg\":-5,"
+                      "\"kg\":12.346,\"m3\":0.000,\"nan\":null,"
+                      "\"full\":true,\"who\":\"a \\\"b\\\"\\n\\\\\"}\n"),
+            std::string::npos)
+      << line;
+}
+
+/**
+ * @test EscapesTextMessages
+ * @brief Ordinary spdlog calls become a "msg" field with escaped text.
+ */
+TEST_F(JsonLogTest, EscapesTextMessages) {
+  spdlog::warn("[belt] REJECTED: \"full\"\t{}/{}\x01", 10, 10);
+  std::string line = out.str();
+  EXPECT_NE(line.find("\"level\":\"warning\",\"msg\":\"[belt] REJECTED: "
+                      "\\\"full\\\"\\t10/10\\u0001\"}\n"),
+            std::string::npos)
+      << line;
+}
+
+/**
+ * @test TruncatesOversizedRecords
+ * @brief Fields beyond the buffer are dropped and the record says so, and
+ * stays well-formed.
+ */
+TEST_F(JsonLogTest, TruncatesOversizedRecords) {
+  std::string long_value(400, 'x');
+  JsonRecord("pop")
+      .field("id", 1)
+      .field("note", long_value.c_str())
+      .field("after", 2)
+      .log(spdlog::level::info);
+
+  std::string line = out.str();
+  EXPECT_NE(line.find("\"id\":1,\"note\":\"xxx"), std::string::npos) << line;
+  EXPECT_EQ(line.find("\"after\""), std::string::npos) << line;
+  EXPECT_NE(line.find("xx\",\"truncated\":true}\n"), std::string::npos)
+      << line;
+  EXPECT_LT(line.size(), 100 + JSON_RECORD_SIZE);
+}
+
+/**
+ * @test FollowsLevelAndSwitch
+ * @brief Structured records are skipped below the logger level or in text
+ * mode.
+ */
+TEST_F(JsonLogTest, FollowsLevelAndSwitch) {
+  EXPECT_TRUE(JsonLog::enabled(spdlog::level::info));
+  EXPECT_FALSE(JsonLog::enabled(spdlog::level::debug));
+  JsonLog::setEnabled(false);
+  EXPECT_FALSE(JsonLog::enabled(spdlog::level::info));
+}
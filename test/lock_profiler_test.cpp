@@ -0,0 +1,158 @@
+/**
+ * @file lock_profiler_test.cpp
+ * @brief Tests for the per-semaphore lock contention profiler.
+ * * Uses real System V semaphores through the Manager to provoke contention,
+ * and a mocked SharedState to verify the ranking logic.
+ */
+
+#include "../include/LockProfiler.h"
+#include "../include/Manager.h"
+#include <chrono>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <thread>
+
+/**
+ * @class LockProfilerTest
+ * @brief Fixture resetting System V IPC resources around every test.
+ */
+class LockProfilerTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    shmctl(shmget(SHM_KEY_ID, 0, 0666), IPC_RMID, nullptr);
+    semctl(semget(SEM_KEY_ID, 0, 0666), 0, IPC_RMID);
+    msgctl(msgget(MSG_KEY_ID, 0666), IPC_RMID, nullptr);
+  }
+
+  void TearDown() override {
+    shmctl(shmget(SHM_KEY_ID, 0, 0666), IPC_RMID, nullptr);
+    semctl(semget(SEM_KEY_ID, 0, 0666), 0, IPC_RMID);
+    msgctl(msgget(MSG_KEY_ID, 0666), IPC_RMID, nullptr);
+  }
+
+  static const LockStats &stats(Manager &m, SemIndex sem, LockSite site) {
+    return m.getState()->lock_stats[sem][static_cast<int>(site)];
+  }
+};
+
+/**
+ * @test ScopesNestAndRestore
+ * @brief Inner scopes override the site and restore the outer one on exit.
+ */
+TEST_F(LockProfilerTest, ScopesNestAndRestore) {
+  EXPECT_EQ(current_lock_site, LockSite::Unknown);
+  {
+    LockSiteScope outer(LockSite::DockDispatcher);
+    {
+      LockSiteScope inner(LockSite::BeltPop);
+      EXPECT_EQ(current_lock_site, LockSite::BeltPop);
+    }
+    EXPECT_EQ(current_lock_site, LockSite::DockDispatcher);
+  }
+  EXPECT_EQ(current_lock_site, LockSite::Unknown);
+}
+
+/**
+ * @test UncontendedAcquisitionIsAttributedToSite
+ * @brief A free mutex counts an acquisition with no contention or wait.
+ */
+TEST_F(LockProfilerTest, UncontendedAcquisitionIsAttributedToSite) {
+  Manager m(true);
+  {
+    LockSiteScope site(LockSite::SessionTable);
+    m.lockBelt();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    m.unlockBelt();
+  }
+
+  const LockStats &st = stats(m, SEM_MUTEX_BELT, LockSite::SessionTable);
+  EXPECT_EQ(st.acquisitions, 1u);
+  EXPECT_EQ(st.contended, 0u);
+  EXPECT_EQ(st.wait_ns_total, 0u);
+  EXPECT_GE(st.hold_ns_total, 5000000u);
+  EXPECT_EQ(st.hold_ns_total, st.hold_ns_max);
+}
+
+/**
+ * @test ContendedAcquisitionMeasuresWait
+ * @brief A blocked P operation is flagged contended and its wait is timed.
+ */
+TEST_F(LockProfilerTest, ContendedAcquisitionMeasuresWait) {
+  Manager owner(true);
+  owner.lockDock();
+
+  std::thread waiter([]() {
+    Manager client(false);
+    LockSiteScope site(LockSite::DockExpress);
+    client.lockDock();
+    client.unlockDock();
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  owner.unlockDock();
+  waiter.join();
+
+  const LockStats &st = stats(owner, SEM_DOCK_MUTEX, LockSite::DockExpress);
+  EXPECT_EQ(st.acquisitions, 1u);
+  EXPECT_EQ(st.contended, 1u);
+  EXPECT_GE(st.wait_ns_total, 30000000u);
+  EXPECT_EQ(st.wait_ns_max, st.wait_ns_total);
+}
+
+/**
+ * @test BeltOperationsDeclareTheirSites
+ * @brief Belt push/pop and worker registration land in distinct rows.
+ */
+TEST_F(LockProfilerTest, BeltOperationsDeclareTheirSites) {
+  Manager m(true);
+  m.belt->registerWorker();
+
+  Package p;
+  p.weight = 1.0;
+  m.belt->push(p);
+  m.belt->pop();
+
+  EXPECT_EQ(stats(m, SEM_MUTEX_BELT, LockSite::WorkerRegistry).acquisitions,
+            1u);
+  EXPECT_EQ(stats(m, SEM_MUTEX_BELT, LockSite::BeltPush).acquisitions, 1u);
+  EXPECT_EQ(stats(m, SEM_MUTEX_BELT, LockSite::BeltPop).acquisitions, 1u);
+  EXPECT_EQ(stats(m, SEM_EMPTY_SLOTS, LockSite::BeltPush).acquisitions, 1u);
+  EXPECT_EQ(stats(m, SEM_FULL_SLOTS, LockSite::BeltPop).acquisitions, 1u);
+}
+
+/**
+ * @test RankingOrdersByWaitTime
+ * @brief The hottest (semaphore, site) pair is the one with the most wait.
+ */
+TEST_F(LockProfilerTest, RankingOrdersByWaitTime) {
+  SharedState mock;
+  std::memset(&mock, 0, sizeof(SharedState));
+
+  auto &dock = mock.lock_stats[SEM_DOCK_MUTEX][(int)LockSite::DockTruck];
+  dock.acquisitions = 10;
+  dock.wait_ns_total = 100;
+  auto &belt = mock.lock_stats[SEM_MUTEX_BELT][(int)LockSite::SessionTable];
+  belt.acquisitions = 5;
+  belt.wait_ns_total = 900;
+  auto &push = mock.lock_stats[SEM_MUTEX_BELT][(int)LockSite::BeltPush];
+  push.acquisitions = 50;
+  push.wait_ns_total = 200;
+
+  LockReportRow rows[SEM_TOTAL * LOCK_SITE_TOTAL];
+  int n = LockProfiler::rankSites(&mock, rows, SEM_TOTAL * LOCK_SITE_TOTAL);
+  ASSERT_EQ(n, 3);
+  EXPECT_EQ(rows[0].site, LockSite::SessionTable);
+  EXPECT_EQ(rows[1].site, LockSite::BeltPush);
+  EXPECT_EQ(rows[2].site, LockSite::DockTruck);
+
+  n = LockProfiler::rankLocks(&mock, rows);
+  ASSERT_EQ(n, 2);
+  EXPECT_EQ(rows[0].sem, SEM_MUTEX_BELT);
+  EXPECT_EQ(rows[0].stats.acquisitions, 55u);
+  EXPECT_EQ(rows[0].stats.wait_ns_total, 1100u);
+
+  std::stringstream out;
+  LockProfiler::printReport(out, &mock);
+  EXPECT_NE(out.str().find("session_table"), std::string::npos);
+}
@@ -0,0 +1,182 @@
+/**
+ * @file log_throttle_test.cpp
+ * @brief Tests for sampled, rate-limited and repeat-folded logging.
+ * * Call sites are checked with a synthetic clock; the macros go through a
+ * real spdlog logger with an ostream sink.
+ */
+
+#include "../include/LogThrottle.h"
+#include "spdlog/sinks/ostream_sink.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <string>
+
+/**
+ * @class LogThrottleTest
+ * @brief Fixture attaching local policies and a string logger.
+ */
+class LogThrottleTest : public ::testing::Test {
+protected:
+  LogPolicy policies[LOG_SUBSYSTEMS] = {};
+  std::ostringstream out;
+  std::shared_ptr<spdlog::logger> previous_logger;
+
+  static constexpr uint64_t MS = 1000000ULL;
+
+  void SetUp() override {
+    LogThrottle::attach(policies);
+    previous_logger = spdlog::default_logger();
+    auto logger = std::make_shared<spdlog::logger>(
+        "throttle", std::make_shared<spdlog::sinks::ostream_sink_st>(out));
+    logger->set_pattern("%v");
+    logger->set_level(spdlog::level::info);
+    spdlog::set_default_logger(logger);
+  }
+
+  void TearDown() override {
+    spdlog::set_default_logger(previous_logger);
+    LogThrottle::detach(policies);
+  }
+
+  LogPolicy &policy(LogSubsystem s) {
+    return policies[static_cast<int>(s)];
+  }
+
+  /** @brief Lines written so far that contain `text`. */
+  int count(const std::string &text) const {
+    std::istringstream lines(out.str());
+    std::string line;
+    int n = 0;
+    while (std::getline(lines, line))
+      n += line.find(text) != std::string::npos;
+    return n;
+  }
+};
+
+/**
+ * @test SamplesOneInN
+ * @brief A site with sample=N logs its 1st, (N+1)th... call.
+ */
+TEST_F(LogThrottleTest, SamplesOneInN) {
+  LogSite site;
+  int logged = 0;
+  for (int i = 0; i < 100; ++i)
+    logged += site.admit(LogSubsystem::Belt, 1);
+  EXPECT_EQ(logged, 100) << "Zeroed policy logs everything";
+
+  policy(LogSubsystem::Belt).sample = 4;
+  logged = 0;
+  for (int i = 0; i < 100; ++i)
+    logged += site.admit(LogSubsystem::Belt, 1);
+  EXPECT_EQ(logged, 25);
+  EXPECT_EQ(policy(LogSubsystem::Belt).suppressed, 75u);
+  EXPECT_EQ(policy(LogSubsystem::Truck).suppressed, 0u);
+}
+
+/**
+ * @test RateLimitsWithBurst
+ * @brief rate=10/s with burst=3: three at once, then one per 100 ms.
+ */
+TEST_F(LogThrottleTest, RateLimitsWithBurst) {
+  policy(LogSubsystem::Dispatcher).rate = 10;
+  policy(LogSubsystem::Dispatcher).burst = 3;
+  LogSite site;
+  uint64_t t = 1000 * MS;
+
+  EXPECT_TRUE(site.admit(LogSubsystem::Dispatcher, t));
+  EXPECT_TRUE(site.admit(LogSubsystem::Dispatcher, t));
+  EXPECT_TRUE(site.admit(LogSubsystem::Dispatcher, t));
+  EXPECT_FALSE(site.admit(LogSubsystem::Dispatcher, t));
+  EXPECT_FALSE(site.admit(LogSubsystem::Dispatcher, t + 50 * MS));
+  EXPECT_TRUE(site.admit(LogSubsystem::Dispatcher, t + 100 * MS));
+  EXPECT_FALSE(site.admit(LogSubsystem::Dispatcher, t + 100 * MS));
+
+  int logged = 0;
+  for (uint64_t ms = 1000; ms < 2000; ms += 10)
+    logged += site.admit(LogSubsystem::Dispatcher, t + ms * MS);
+  EXPECT_EQ(logged, 12) << "Refilled bucket (2 tokens) plus 10 per second";
+}
+
+/**
+ * @test FoldsRepeatsPerKey
+ * @brief Calls with the same key inside the window are folded and counted
+ * on the next record shown.
+ */
+TEST_F(LogThrottleTest, FoldsRepeatsPerKey) {
+  policy(LogSubsystem::Express).repeat_ms = 1000;
+  LogSite site;
+  uint64_t repeated = 99;
+  uint64_t t = 5000 * MS;
+
+  EXPECT_TRUE(site.admitRepeat(LogSubsystem::Express, 7, repeated, t));
+  EXPECT_EQ(repeated, 0u);
+  EXPECT_FALSE(site.admitRepeat(LogSubsystem::Express, 7, repeated, t + MS));
+  EXPECT_FALSE(
+      site.admitRepeat(LogSubsystem::Express, 7, repeated, t + 2 * MS));
+
+  EXPECT_TRUE(
+      site.admitRepeat(LogSubsystem::Express, 8, repeated, t + 3 * MS));
+  EXPECT_EQ(repeated, 2u) << "Folded calls of key 7";
+  EXPECT_FALSE(
+      site.admitRepeat(LogSubsystem::Express, 8, repeated, t + 500 * MS));
+  EXPECT_TRUE(
+      site.admitRepeat(LogSubsystem::Express, 8, repeated, t + 1100 * MS));
+  EXPECT_EQ(repeated, 1u) << "Shown again once the window has passed";
+  EXPECT_EQ(policy(LogSubsystem::Express).suppressed, 3u);
+}
+
+/**
+ * @test ParsesSpecifications
+ * @brief Valid settings are applied; any error leaves every policy as is.
+ */
+TEST_F(LogThrottleTest, ParsesSpecifications) {
+  ASSERT_TRUE(LogThrottle::parse("belt:sample=100,dispatcher:rate=20:burst=5",
+                                 policies));
+  EXPECT_EQ(policy(LogSubsystem::Belt).sample, 100u);
+  EXPECT_EQ(policy(LogSubsystem::Dispatcher).rate, 20u);
+  EXPECT_EQ(policy(LogSubsystem::Dispatcher).burst, 5u);
+
+  ASSERT_TRUE(LogThrottle::parse("belt:rate=3", policies));
+  EXPECT_EQ(policy(LogSubsystem::Belt).sample, 100u) << "Others unchanged";
+  EXPECT_EQ(policy(LogSubsystem::Belt).rate, 3u);
+
+  EXPECT_FALSE(LogThrottle::parse("truck:sample=2,sorter:rate=1", policies));
+  EXPECT_FALSE(LogThrottle::parse("truck:speed=2", policies));
+  EXPECT_FALSE(LogThrottle::parse("truck:sample=x", policies));
+  EXPECT_FALSE(LogThrottle::parse("truck", policies));
+  EXPECT_EQ(policy(LogSubsystem::Truck).sample, 0u);
+  EXPECT_TRUE(LogThrottle::parse("", policies));
+
+  std::ostringstream report;
+  LogThrottle::printReport(report, policies);
+  EXPECT_NE(report.str().find("belt        1/100         3"),
+            std::string::npos)
+      << report.str();
+}
+
+/**
+ * @test MacrosKeepStatePerCallSite
+ * @brief Each expansion samples on its own, and repeats are announced.
+ */
+TEST_F(LogThrottleTest, MacrosKeepStatePerCallSite) {
+  policy(LogSubsystem::Belt).sample = 10;
+  for (int i = 0; i < 100; ++i) {
+    WAREHOUSE_LOG(LogSubsystem::Belt, spdlog::level::info, "site-a {}", i);
+    WAREHOUSE_LOG(LogSubsystem::Belt, spdlog::level::info, "site-b {}", i);
+    WAREHOUSE_LOG(LogSubsystem::Belt, spdlog::level::debug, "hidden {}", i);
+  }
+  EXPECT_EQ(count("site-a"), 10);
+  EXPECT_EQ(count("site-b"), 10);
+  EXPECT_EQ(count("hidden"), 0);
+  EXPECT_EQ(policy(LogSubsystem::Belt).suppressed, 180u)
+      << "Calls below the level are not counted";
+
+  for (int key : {1, 1, 1, 2}) {
+    WAREHOUSE_LOG_REPEAT(LogSubsystem::Dispatcher, spdlog::level::warn, key,
+                         "no fit {}", key);
+  }
+  EXPECT_EQ(count("no fit 1"), 1);
+  EXPECT_EQ(count("no fit 2"), 1);
+  EXPECT_EQ(count("[dispatcher] Last message repeated 2 times."), 1);
+}
@@ -15,8 +15,11 @@
 
 #include "../include/Manager.h"
 #include "../include/Shared.h"
+#include <atomic>
 #include <chrono>
+#include <csignal>
 #include <gtest/gtest.h>
+#include <pthread.h>
 #include <thread>
 #include <vector>
 
@@ -155,6 +158,89 @@ TEST_F(ManagerTest, SemaphoreBlockingLogic) {
   EXPECT_TRUE(critical_section_visited);
 }
 
+static void ignoreSignal(int) {}
+
+/**
+ * @test InterruptedMutexWaitIsRetried
+ * @brief A signal delivered to a thread blocked in `lockBelt` (e.g. SIGTERM
+ * during a rolling restart) must not count as a hold: the matching V would
+ * raise the belt mutex to 2.
+ */
+TEST_F(ManagerTest, InterruptedMutexWaitIsRetried) {
+  struct sigaction sa = {}, old = {};
+  sa.sa_handler = ignoreSignal;
+  sigaction(SIGUSR1, &sa, &old);
+
+  Manager owner(true);
+  int sem = semget(SEM_KEY_ID, 0, 0666);
+  std::atomic<bool> visited{false};
+
+  owner.lockBelt();
+  std::thread worker([&]() {
+    Manager client(false);
+    client.lockBelt();
+    EXPECT_FALSE(Manager::lastWaitFailed());
+    visited = true;
+    client.unlockBelt();
+  });
+
+  for (int i = 0; i < 5; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    pthread_kill(worker.native_handle(), SIGUSR1);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(visited);
+  EXPECT_LE(semctl(sem, SEM_MUTEX_BELT, GETVAL), 1);
+
+  owner.unlockBelt();
+  worker.join();
+  EXPECT_TRUE(visited);
+  EXPECT_EQ(semctl(sem, SEM_MUTEX_BELT, GETVAL), 1);
+
+  sigaction(SIGUSR1, &old, nullptr);
+}
+
+/**
+ * @test InterruptedMutexWaitGivesUpAtShutdown
+ * @brief Once `running` is cleared an interrupted mutex wait returns with
+ * `lastWaitFailed()` set and `Belt::push` leaves without releasing the
+ * mutex or keeping the slot it took.
+ */
+TEST_F(ManagerTest, InterruptedMutexWaitGivesUpAtShutdown) {
+  struct sigaction sa = {}, old = {};
+  sa.sa_handler = ignoreSignal;
+  sigaction(SIGUSR1, &sa, &old);
+
+  Manager owner(true);
+  int sem = semget(SEM_KEY_ID, 0, 0666);
+  std::atomic<bool> returned{false};
+
+  owner.lockBelt();
+  std::thread worker([&]() {
+    Manager client(false);
+    Package pkg = {};
+    pkg.weight = 1.0;
+    client.belt->setWorkloadSimulation(false);
+    client.belt->push(pkg);
+    returned = true;
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  owner.getState()->running = false;
+  while (!returned) {
+    pthread_kill(worker.native_handle(), SIGUSR1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  worker.join();
+
+  EXPECT_EQ(semctl(sem, SEM_MUTEX_BELT, GETVAL), 0);
+  EXPECT_EQ(semctl(sem, SEM_EMPTY_SLOTS, GETVAL), MAX_BELT_CAPACITY_K);
+  EXPECT_EQ(owner.getState()->current_items_count, 0);
+  owner.unlockBelt();
+
+  sigaction(SIGUSR1, &old, nullptr);
+}
+
 /**
  * @test SessionManager_BasicLifecycle
  * @brief Verifies login, process spawning limits, and logout flow for a single
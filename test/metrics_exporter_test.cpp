@@ -0,0 +1,270 @@
+/**
+ * @file metrics_exporter_test.cpp
+ * @brief Unit tests for the Prometheus exporter.
+ * * Renders a mocked SharedState and checks the exposition format, the
+ * textfile output and a scrape over a UNIX domain socket.
+ */
+
+#include "../include/MetricsExporter.h"
+#include <cstring>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+/**
+ * @class MetricsExporterTest
+ * @brief Fixture providing a zeroed SharedState and a page buffer.
+ */
+class MetricsExporterTest : public ::testing::Test {
+protected:
+  SharedState mock_shared_memory;
+  std::unique_ptr<MetricsExporter> exporter;
+  std::unique_ptr<char[]> page{new char[METRICS_BUFFER_SIZE]};
+
+  void SetUp() override {
+    std::memset(&mock_shared_memory, 0, sizeof(SharedState));
+    mock_shared_memory.running = true;
+    exporter = std::make_unique<MetricsExporter>(&mock_shared_memory);
+  }
+
+  std::string renderPage() {
+    size_t len = exporter->render(page.get(), METRICS_BUFFER_SIZE);
+    return std::string(page.get(), len);
+  }
+};
+
+/**
+ * @test RendersBeltAndDockGauges
+ * @brief Verifies that gauges mirror the shared memory fields.
+ */
+TEST_F(MetricsExporterTest, RendersBeltAndDockGauges) {
+  mock_shared_memory.current_items_count = 7;
+  mock_shared_memory.current_workers_count = 3;
+  mock_shared_memory.total_packages_created = 42;
+  mock_shared_memory.trucks_completed = 5;
+  mock_shared_memory.dock_truck.is_present = true;
+  mock_shared_memory.dock_truck.current_load = 12;
+
+  std::string out = renderPage();
+
+  EXPECT_NE(out.find("# TYPE warehouse_belt_items gauge\n"),
+            std::string::npos);
+  EXPECT_NE(out.find("\nwarehouse_belt_items 7\n"), std::string::npos);
+  EXPECT_NE(out.find("\nwarehouse_workers_active 3\n"), std::string::npos);
+  EXPECT_NE(out.find("\nwarehouse_packages_created_total 42\n"),
+            std::string::npos);
+  EXPECT_NE(out.find("\nwarehouse_trucks_completed_total 5\n"),
+            std::string::npos);
+  EXPECT_NE(out.find("\nwarehouse_dock_truck_present 1\n"), std::string::npos);
+  EXPECT_NE(out.find("\nwarehouse_dock_load_packages 12\n"),
+            std::string::npos);
+}
+
+/**
+ * @test RendersSessionLabelsEscaped
+ * @brief Only active sessions are listed and label values are escaped.
+ */
+TEST_F(MetricsExporterTest, RendersSessionLabelsEscaped) {
+  UserSession &u = mock_shared_memory.users[4];
+  u.active = true;
+  std::strncpy(u.username, "Wo\"rker", sizeof(u.username) - 1);
+  u.current_processes = 2;
+  u.max_processes = 10;
+
+  std::string out = renderPage();
+
+  EXPECT_NE(out.find("\nwarehouse_sessions_active 1\n"), std::string::npos);
+  EXPECT_NE(out.find("warehouse_session_processes{user=\"Wo\\\"rker\"} 2\n"),
+            std::string::npos);
+  EXPECT_NE(
+      out.find("warehouse_session_process_quota{user=\"Wo\\\"rker\"} 10\n"),
+      std::string::npos);
+}
+
+/**
+ * @test LatencyHistogramIsCumulative
+ * @brief Prometheus buckets must be cumulative and end with +Inf == count.
+ */
+TEST_F(MetricsExporterTest, LatencyHistogramIsCumulative) {
+  recordLatency(mock_shared_memory.stats, 500000ULL);       // 0.5 ms
+  recordLatency(mock_shared_memory.stats, 3000000ULL);      // 3 ms
+  recordLatency(mock_shared_memory.stats, 100000000000ULL); // 100 s
+
+  std::string out = renderPage();
+
+  EXPECT_NE(
+      out.find("warehouse_package_latency_seconds_bucket{le=\"0.001\"} 1\n"),
+      std::string::npos);
+  EXPECT_NE(
+      out.find("warehouse_package_latency_seconds_bucket{le=\"0.004\"} 2\n"),
+      std::string::npos);
+  EXPECT_NE(
+      out.find("warehouse_package_latency_seconds_bucket{le=\"+Inf\"} 3\n"),
+      std::string::npos);
+  EXPECT_NE(out.find("warehouse_package_latency_seconds_count 3\n"),
+            std::string::npos);
+}
+
+/**
+ * @test TruncatesInsteadOfOverflowing
+ * @brief A buffer that is too small yields a truncated page, never overflow.
+ */
+TEST_F(MetricsExporterTest, TruncatesInsteadOfOverflowing) {
+  char small[64];
+  std::memset(small, 'x', sizeof(small));
+
+  size_t len = exporter->render(small, 32);
+
+  EXPECT_LE(len, 32u);
+  EXPECT_EQ(small[40], 'x');
+}
+
+/**
+ * @test WritesTextfileAtomically
+ * @brief The textfile output contains the page and no staging file is left.
+ */
+TEST_F(MetricsExporterTest, WritesTextfileAtomically) {
+  std::string path = "metrics_exporter_test.prom";
+  mock_shared_memory.current_items_count = 9;
+
+  exporter->setTextfile(path, 1000);
+  ASSERT_TRUE(exporter->writeTextfile());
+
+  std::ifstream in(path);
+  std::stringstream content;
+  content << in.rdbuf();
+  EXPECT_NE(content.str().find("\nwarehouse_belt_items 9\n"),
+            std::string::npos);
+  EXPECT_FALSE(std::ifstream(path + ".tmp").good());
+
+  std::remove(path.c_str());
+}
+
+/**
+ * @test ServesScrapeOverUnixSocket
+ * @brief Full HTTP round trip over a UNIX domain socket.
+ */
+TEST_F(MetricsExporterTest, ServesScrapeOverUnixSocket) {
+  std::string path = "metrics_exporter_test.sock";
+  ASSERT_TRUE(exporter->listenUnix(path));
+  mock_shared_memory.current_items_count = 4;
+
+  std::thread server([&]() { exporter->serveOnce(2000); });
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  ASSERT_EQ(connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)), 0);
+
+  const char req[] = "GET /metrics HTTP/1.0\r\n\r\n";
+  ASSERT_GT(send(fd, req, sizeof(req) - 1, 0), 0);
+
+  std::string response;
+  char chunk[4096];
+  ssize_t n;
+  while ((n = recv(fd, chunk, sizeof(chunk), 0)) > 0) {
+    response.append(chunk, n);
+  }
+  close(fd);
+  server.join();
+
+  EXPECT_EQ(response.rfind("HTTP/1.0 200 OK\r\n", 0), 0u);
+  EXPECT_NE(response.find("Content-Type: text/plain; version=0.0.4"),
+            std::string::npos);
+  EXPECT_NE(response.find("\nwarehouse_belt_items 4\n"), std::string::npos);
+}
+
+/**
+ * @test LatencyBucketBoundsAreInclusive
+ * @brief Exactly 2^k ms is counted under `le = 2^k`, one nanosecond more
+ * under the next bucket.
+ */
+TEST_F(MetricsExporterTest, LatencyBucketBoundsAreInclusive) {
+  EXPECT_EQ(latencyBucketIndex(0), 0);
+  EXPECT_EQ(latencyBucketIndex(1), 0);
+  for (int k = 0; k < LATENCY_BUCKETS - 1; ++k) {
+    uint64_t ns = (uint64_t{1} << k) * 1000000ULL;
+    EXPECT_EQ(latencyBucketBoundMs(latencyBucketIndex(ns)), 1LL << k) << k;
+    EXPECT_EQ(latencyBucketIndex(ns + 1), k + 1) << k;
+  }
+  EXPECT_EQ(latencyBucketBoundMs(latencyBucketIndex(UINT64_MAX / 2)), -1);
+
+  recordLatency(mock_shared_memory.stats, 1000000ULL); // 1 ms
+  recordLatency(mock_shared_memory.stats, 2000000ULL); // 2 ms
+  std::string out = renderPage();
+  EXPECT_NE(
+      out.find("warehouse_package_latency_seconds_bucket{le=\"0.001\"} 1\n"),
+      std::string::npos);
+  EXPECT_NE(
+      out.find("warehouse_package_latency_seconds_bucket{le=\"0.002\"} 2\n"),
+      std::string::npos);
+}
+
+/**
+ * @test LatencyPercentilesInterpolateWithinBuckets
+ * @brief Percentiles used by the stress report stay inside their bucket.
+ */
+TEST_F(MetricsExporterTest, LatencyPercentilesInterpolateWithinBuckets) {
+  WarehouseStats &st = mock_shared_memory.stats;
+  EXPECT_EQ(latencyPercentileMs(st, 0.5), 0.0);
+
+  for (int i = 0; i < 99; ++i)
+    recordLatency(st, 3000000ULL); // 3 ms -> (2, 4] bucket
+  recordLatency(st, 100000000ULL);  // 100 ms
+
+  double p50 = latencyPercentileMs(st, 0.50);
+  EXPECT_GE(p50, 2.0);
+  EXPECT_LE(p50, 4.0);
+  EXPECT_GT(latencyPercentileMs(st, 0.999), 64.0);
+}
+
+/**
+ * @test DeadlineMissesAreCountedPerTier
+ * @brief Only late loads count as misses and feed the tardiness histogram.
+ */
+TEST_F(MetricsExporterTest, DeadlineMissesAreCountedPerTier) {
+  WarehouseStats &st = mock_shared_memory.stats;
+  Package pkg = {};
+  pkg.tier = SlaTier::Urgent;
+  pkg.deadline_ns = 10000000ULL;
+
+  recordDeadline(st, pkg, 5000000ULL);  // 5 ms early
+  recordDeadline(st, pkg, 13000000ULL); // 3 ms late
+  pkg.tier = SlaTier::Standard;
+  recordDeadline(st, pkg, 10000000ULL); // exactly on time
+
+  EXPECT_EQ(st.sla_loaded[static_cast<int>(SlaTier::Urgent)], 2u);
+  EXPECT_EQ(st.sla_missed[static_cast<int>(SlaTier::Urgent)], 1u);
+  EXPECT_EQ(st.sla_missed[static_cast<int>(SlaTier::Standard)], 0u);
+  EXPECT_EQ(st.tardiness_sum_ns, 3000000ULL);
+  EXPECT_GT(histogramPercentileMs(st.tardiness_buckets, 0.5), 2.0);
+
+  std::string out = renderPage();
+  EXPECT_NE(out.find("warehouse_sla_missed_total{tier=\"urgent\"} 1\n"),
+            std::string::npos);
+  EXPECT_NE(out.find("warehouse_sla_tardiness_seconds_bucket{le=\"0.004\"} 1"
+                     "\n"),
+            std::string::npos);
+  EXPECT_NE(out.find("warehouse_sla_tardiness_seconds_count 1\n"),
+            std::string::npos);
+}
+
+/**
+ * @test FaultsAreExportedPerSite
+ * @brief Every injection site has a counter, including unused ones.
+ */
+TEST_F(MetricsExporterTest, FaultsAreExportedPerSite) {
+  mock_shared_memory.stats
+      .faults_injected[static_cast<int>(FaultSite::SendSignal)] = 4;
+
+  std::string out = renderPage();
+  EXPECT_NE(out.find("warehouse_faults_injected_total{site=\"send_signal\"} "
+                     "4\n"),
+            std::string::npos);
+  EXPECT_NE(out.find("warehouse_faults_injected_total{site=\"lock_belt\"} "
+                     "0\n"),
+            std::string::npos);
+}
@@ -0,0 +1,72 @@
+/**
+ * @file perf_counters_test.cpp
+ * @brief Unit tests for the optional perf_event counters.
+ */
+
+#include "../include/PerfCounters.h"
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+
+/**
+ * @test UnavailableCountersReadAsMissing
+ * @brief Every counter is either readable or reported unavailable with a
+ * reason; a report never fails.
+ */
+TEST(PerfCountersTest, UnavailableCountersReadAsMissing) {
+  PerfCounters perf;
+  perf.start();
+  perf.stop();
+
+  for (int i = 0; i < PERF_COUNTERS; ++i) {
+    PerfCounter c = static_cast<PerfCounter>(i);
+    if (perf.available(c)) {
+      EXPECT_GE(perf.value(c), 0) << PerfCounters::name(c);
+    } else {
+      EXPECT_EQ(perf.value(c), -1) << PerfCounters::name(c);
+      EXPECT_STRNE(perf.error(c), "") << PerfCounters::name(c);
+    }
+  }
+
+  char *buf = nullptr;
+  size_t len = 0;
+  FILE *out = open_memstream(&buf, &len);
+  perf.report(out, 10, 1000.0);
+  std::fclose(out);
+  EXPECT_NE(std::string(buf).find("100 ns/op"), std::string::npos) << buf;
+  free(buf);
+}
+
+/**
+ * @test PageFaultsAreCountedWhileStarted
+ * @brief Touching fresh pages counts faults only between start and stop.
+ */
+TEST(PerfCountersTest, PageFaultsAreCountedWhileStarted) {
+  PerfCounters perf(false);
+  if (!perf.available(PerfCounter::PageFaults))
+    GTEST_SKIP() << "page-faults unavailable: "
+                 << perf.error(PerfCounter::PageFaults);
+
+  const size_t pages = 256;
+  long page = sysconf(_SC_PAGESIZE);
+  auto touch = [&]() {
+    void *mem = mmap(nullptr, pages * page, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(mem, MAP_FAILED);
+    for (size_t i = 0; i < pages; ++i)
+      static_cast<volatile char *>(mem)[i * page] = 1;
+    munmap(mem, pages * page);
+  };
+
+  touch();
+  EXPECT_EQ(perf.value(PerfCounter::PageFaults), 0) << "Not started yet";
+
+  perf.start();
+  touch();
+  perf.stop();
+  double faults = perf.value(PerfCounter::PageFaults);
+  EXPECT_GE(faults, pages);
+
+  touch();
+  EXPECT_EQ(perf.value(PerfCounter::PageFaults), faults) << "Stopped";
+}
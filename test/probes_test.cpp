@@ -0,0 +1,67 @@
+/**
+ * @file probes_test.cpp
+ * @brief Checks the static tracepoints are recorded in the test binary.
+ */
+
+#include "../include/Manager.h"
+#include "../include/Probes.h"
+#include <cstring>
+#include <elf.h>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <set>
+#include <string>
+
+namespace {
+
+/** @brief Names of the `warehouse` probes in the ELF notes of this binary. */
+std::set<std::string> probeNames() {
+  std::ifstream in("/proc/self/exe", std::ios::binary);
+  std::string image((std::istreambuf_iterator<char>(in)),
+                    std::istreambuf_iterator<char>());
+  std::set<std::string> names;
+  if (image.size() < sizeof(Elf64_Ehdr))
+    return names;
+
+  const char *base = image.data();
+  const auto *eh = reinterpret_cast<const Elf64_Ehdr *>(base);
+  const auto *sh = reinterpret_cast<const Elf64_Shdr *>(base + eh->e_shoff);
+  const char *strtab = base + sh[eh->e_shstrndx].sh_offset;
+
+  for (int i = 0; i < eh->e_shnum; ++i) {
+    if (std::strcmp(strtab + sh[i].sh_name, ".note.stapsdt") != 0)
+      continue;
+    const char *p = base + sh[i].sh_offset;
+    const char *end = p + sh[i].sh_size;
+    while (p + sizeof(Elf64_Nhdr) <= end) {
+      const auto *nh = reinterpret_cast<const Elf64_Nhdr *>(p);
+      const char *desc = p + sizeof(Elf64_Nhdr) + ((nh->n_namesz + 3) & ~3u);
+      // Three addresses, then provider, name and arguments.
+      const char *provider = desc + 3 * sizeof(uint64_t);
+      if (std::strcmp(provider, "warehouse") == 0)
+        names.insert(provider + std::strlen(provider) + 1);
+      p = desc + ((nh->n_descsz + 3) & ~3u);
+    }
+  }
+  return names;
+}
+
+} // namespace
+
+/**
+ * @test EveryProbeIsRecorded
+ * @brief The probes compiled into the roles are visible to tracers.
+ */
+TEST(ProbesTest, EveryProbeIsRecorded) {
+#if defined(WAREHOUSE_PROBES_SDT) || defined(WAREHOUSE_PROBES_NOTE)
+  std::set<std::string> names = probeNames();
+  for (const char *probe :
+       {"package__create", "belt__push", "belt__pop", "dock__load",
+        "package__load", "truck__dock", "truck__depart", "express__begin",
+        "express__end", "sem__enter", "sem__exit"})
+    EXPECT_TRUE(names.count(probe)) << probe;
+#else
+  GTEST_SKIP() << "Probes are compiled out on this target";
+#endif
+}
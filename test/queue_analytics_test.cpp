@@ -0,0 +1,212 @@
+/**
+ * @file queue_analytics_test.cpp
+ * @brief Tests for the online queueing estimates and bottleneck detection.
+ * * Each scenario holds the mocked SharedState in a fixed regime, advances the
+ * counters at a known rate and feeds the analyser with a synthetic clock.
+ */
+
+#include "../include/MetricsExporter.h"
+#include "../include/QueueAnalytics.h"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+
+/**
+ * @class QueueAnalyticsTest
+ * @brief Fixture providing a zeroed SharedState and a simulated clock.
+ */
+class QueueAnalyticsTest : public ::testing::Test {
+protected:
+  SharedState mock_shared_memory;
+  uint64_t now_ns = 1000000000ULL;
+
+  static constexpr uint64_t STEP_NS = 10000000ULL; /**< 100 Hz. */
+
+  void SetUp() override {
+    std::memset(&mock_shared_memory, 0, sizeof(SharedState));
+    mock_shared_memory.running = true;
+    mock_shared_memory.current_workers_count = 4;
+  }
+
+  /**
+   * @brief Runs `seconds` of simulated time; each step adds `per_step`
+   * created and loaded packages.
+   */
+  void drive(QueueAnalytics &qa, double seconds, int per_step) {
+    int steps = static_cast<int>(seconds * 1e9 / STEP_NS);
+    for (int i = 0; i < steps; ++i) {
+      mock_shared_memory.total_packages_created += per_step;
+      mock_shared_memory.stats.packages_loaded += per_step;
+      now_ns += STEP_NS;
+      qa.update(now_ns);
+    }
+  }
+
+  const StageEstimate &stage(Stage s) const {
+    return mock_shared_memory.analytics.stages[static_cast<int>(s)];
+  }
+};
+
+/**
+ * @test SourceLimitedLineBlamesWorkers
+ * @brief Empty belt, truck waiting at the dock: producers set the pace.
+ */
+TEST_F(QueueAnalyticsTest, SourceLimitedLineBlamesWorkers) {
+  QueueAnalytics qa(&mock_shared_memory, 1.0);
+  mock_shared_memory.dock_truck.is_present = true;
+  mock_shared_memory.trucks_waiting = 2;
+  drive(qa, 10.0, 1);
+
+  const AnalyticsState &a = mock_shared_memory.analytics;
+  EXPECT_EQ(a.bottleneck, static_cast<int>(Stage::Workers));
+  EXPECT_GT(a.confidence, 0.95);
+  EXPECT_NEAR(stage(Stage::Workers).arrival_rate, 100.0, 1.0);
+  EXPECT_NEAR(stage(Stage::Dispatcher).throughput, 100.0, 1.0);
+  EXPECT_NEAR(stage(Stage::Fleet).occupancy, 2.0, 0.01);
+  EXPECT_LT(stage(Stage::Dock).utilization, 0.01);
+  EXPECT_EQ(a.samples, 999u) << "The first snapshot is only a baseline";
+}
+
+/**
+ * @test FullBeltWithoutTrucksBlamesFleet
+ */
+TEST_F(QueueAnalyticsTest, FullBeltWithoutTrucksBlamesFleet) {
+  QueueAnalytics qa(&mock_shared_memory, 1.0);
+  mock_shared_memory.current_items_count = MAX_BELT_CAPACITY_K;
+  drive(qa, 10.0, 0);
+
+  EXPECT_EQ(mock_shared_memory.analytics.bottleneck,
+            static_cast<int>(Stage::Fleet));
+  EXPECT_GT(stage(Stage::Fleet).utilization, 0.99);
+  EXPECT_LT(stage(Stage::Workers).utilization, 0.01);
+}
+
+/**
+ * @test QueuedTrucksAtEmptyBayBlameDock
+ */
+TEST_F(QueueAnalyticsTest, QueuedTrucksAtEmptyBayBlameDock) {
+  QueueAnalytics qa(&mock_shared_memory, 1.0);
+  mock_shared_memory.current_items_count = MAX_BELT_CAPACITY_K;
+  mock_shared_memory.trucks_waiting = 3;
+  drive(qa, 10.0, 0);
+
+  EXPECT_EQ(mock_shared_memory.analytics.bottleneck,
+            static_cast<int>(Stage::Dock));
+}
+
+/**
+ * @test ShiftingBottleneckLowersConfidence
+ * @brief Half the time fleet-bound, half dispatcher-bound: no clear winner.
+ */
+TEST_F(QueueAnalyticsTest, ShiftingBottleneckLowersConfidence) {
+  QueueAnalytics qa(&mock_shared_memory, 5.0);
+  mock_shared_memory.current_items_count = MAX_BELT_CAPACITY_K;
+  for (int i = 0; i < 40; ++i) {
+    mock_shared_memory.dock_truck.is_present = i % 2;
+    drive(qa, 0.5, 0);
+  }
+
+  const AnalyticsState &a = mock_shared_memory.analytics;
+  EXPECT_TRUE(a.bottleneck == static_cast<int>(Stage::Fleet) ||
+              a.bottleneck == static_cast<int>(Stage::Dispatcher));
+  EXPECT_LT(a.confidence, 0.3);
+}
+
+/**
+ * @test IdleLineHasNoBottleneck
+ */
+TEST_F(QueueAnalyticsTest, IdleLineHasNoBottleneck) {
+  QueueAnalytics qa(&mock_shared_memory, 1.0);
+  mock_shared_memory.current_workers_count = 0;
+  mock_shared_memory.dock_truck.is_present = true;
+  drive(qa, 5.0, 0);
+
+  EXPECT_EQ(mock_shared_memory.analytics.bottleneck, -1);
+  EXPECT_EQ(mock_shared_memory.analytics.confidence, 0.0);
+}
+
+/**
+ * @test LittlesLawHoldsForConsistentCounters
+ * @brief L = 4 on the belt at 100 pkg/s with 40 ms measured latency; one
+ * truck always docked, departing every second after a 1 s dwell.
+ */
+TEST_F(QueueAnalyticsTest, LittlesLawHoldsForConsistentCounters) {
+  QueueAnalytics qa(&mock_shared_memory, 10.0);
+  SharedState &shm = mock_shared_memory;
+  shm.current_items_count = 4;
+  shm.dock_truck.is_present = true;
+
+  int steps = 6000;
+  for (int i = 0; i < steps; ++i) {
+    shm.total_packages_created += 1;
+    shm.stats.packages_loaded += 1;
+    shm.stats.latency_count += 1;
+    shm.stats.latency_sum_ns += 40000000ULL;
+    if (i % 100 == 99) {
+      shm.trucks_completed += 1;
+      shm.stats.dock_ns_total += 1000000000ULL;
+    }
+    now_ns += STEP_NS;
+    qa.update(now_ns);
+  }
+
+  EXPECT_NEAR(shm.analytics.little_belt, 1.0, 0.05);
+  EXPECT_NEAR(stage(Stage::Belt).sojourn_s, 0.04, 0.002);
+  EXPECT_NEAR(shm.analytics.little_dock, 1.0, 0.1);
+}
+
+/**
+ * @test LittlesLawCountsPackagesHeldInDispatch
+ * @brief The measured latency includes the dispatch hold, so packages
+ * popped but not yet loaded count towards L: 2 on the belt plus 2 held at
+ * 100 pkg/s and 40 ms is consistent.
+ */
+TEST_F(QueueAnalyticsTest, LittlesLawCountsPackagesHeldInDispatch) {
+  QueueAnalytics qa(&mock_shared_memory, 10.0);
+  SharedState &shm = mock_shared_memory;
+  shm.current_items_count = 2;
+  shm.stats.packages_in_dispatch = 2;
+  shm.dock_truck.is_present = true;
+
+  for (int i = 0; i < 6000; ++i) {
+    shm.total_packages_created += 1;
+    shm.stats.packages_loaded += 1;
+    shm.stats.latency_count += 1;
+    shm.stats.latency_sum_ns += 40000000ULL;
+    now_ns += STEP_NS;
+    qa.update(now_ns);
+  }
+
+  EXPECT_NEAR(shm.analytics.little_belt, 1.0, 0.05);
+}
+
+/**
+ * @test PublishedToTerminalAndMetrics
+ */
+TEST_F(QueueAnalyticsTest, PublishedToTerminalAndMetrics) {
+  std::ostringstream empty;
+  QueueAnalytics::printReport(empty, &mock_shared_memory);
+  EXPECT_NE(empty.str().find("no flow analysis"), std::string::npos);
+
+  QueueAnalytics qa(&mock_shared_memory, 1.0);
+  mock_shared_memory.current_items_count = MAX_BELT_CAPACITY_K;
+  drive(qa, 5.0, 0);
+
+  std::ostringstream report;
+  QueueAnalytics::printReport(report, &mock_shared_memory);
+  EXPECT_NE(report.str().find("Bottleneck: \033[33mfleet"), std::string::npos);
+
+  auto exporter = std::make_unique<MetricsExporter>(&mock_shared_memory);
+  std::unique_ptr<char[]> page{new char[METRICS_BUFFER_SIZE]};
+  std::string out(page.get(),
+                  exporter->render(page.get(), METRICS_BUFFER_SIZE));
+  EXPECT_NE(out.find("\nwarehouse_bottleneck{stage=\"fleet\"} 1\n"),
+            std::string::npos);
+  EXPECT_NE(out.find("\nwarehouse_bottleneck{stage=\"workers\"} 0\n"),
+            std::string::npos);
+  EXPECT_NE(out.find("# TYPE warehouse_stage_utilization gauge\n"),
+            std::string::npos);
+  EXPECT_NE(out.find("warehouse_little_law_ratio{queue=\"dock\"}"),
+            std::string::npos);
+}
@@ -0,0 +1,159 @@
+/**
+ * @file resource_sampler_test.cpp
+ * @brief Tests for the per-role procfs sampler.
+ * * The session table of a zeroed SharedState points at this test process
+ * and at children forked for the purpose.
+ */
+
+#include "../include/MetricsExporter.h"
+#include "../include/ResourceSampler.h"
+#include <csignal>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <sys/wait.h>
+
+/**
+ * @class ResourceSamplerTest
+ * @brief Fixture providing a zeroed SharedState with a session table.
+ */
+class ResourceSamplerTest : public ::testing::Test {
+protected:
+  std::unique_ptr<SharedState> shm = std::make_unique<SharedState>();
+
+  void SetUp() override { std::memset(shm.get(), 0, sizeof(SharedState)); }
+
+  void addSession(int slot, const char *name, pid_t pid) {
+    UserSession &u = shm->users[slot];
+    u.active = true;
+    std::strncpy(u.username, name, sizeof(u.username) - 1);
+    u.session_pid = pid;
+  }
+
+  const RoleUsage &role(ProcessRole r) const {
+    return shm->resources.roles[static_cast<int>(r)];
+  }
+
+  /** @brief Spins for `ms` of CPU time. */
+  static void burn(int ms) {
+    timespec start, now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &start);
+    volatile uint64_t x = 0;
+    do {
+      for (int i = 0; i < 10000; ++i)
+        x = x + i;
+      clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    } while ((now.tv_sec - start.tv_sec) * 1000 +
+                 (now.tv_nsec - start.tv_nsec) / 1000000 <
+             ms);
+  }
+};
+
+/**
+ * @test RolesFollowUsernames
+ * @brief Every session name the binaries log in with maps to its role.
+ */
+TEST_F(ResourceSamplerTest, RolesFollowUsernames) {
+  EXPECT_EQ(ResourceSampler::roleOf("Worker_3"), ProcessRole::Worker);
+  EXPECT_EQ(ResourceSampler::roleOf("Truck_17"), ProcessRole::Truck);
+  EXPECT_EQ(ResourceSampler::roleOf("System-Dispatcher"),
+            ProcessRole::Dispatcher);
+  EXPECT_EQ(ResourceSampler::roleOf("System-Dispatcher_2"),
+            ProcessRole::Dispatcher);
+  EXPECT_EQ(ResourceSampler::roleOf("System-Belt"), ProcessRole::Belt);
+  EXPECT_EQ(ResourceSampler::roleOf("System-Express"), ProcessRole::Express);
+  EXPECT_EQ(ResourceSampler::roleOf("System-Sorter"), ProcessRole::Sorter);
+  EXPECT_EQ(ResourceSampler::roleOf("AdminConsole"), ProcessRole::Terminal);
+  EXPECT_EQ(ResourceSampler::roleOf("someone"), ProcessRole::Other);
+}
+
+/**
+ * @test ParsesProcfsFormats
+ * @brief The parsers pick the right fields, including from a command name
+ * with spaces and parentheses.
+ */
+TEST_F(ResourceSamplerTest, ParsesProcfsFormats) {
+  ProcSample s;
+  const char *stat = "42 (a) b (c) S 1 42 42 0 -1 4194560 100 0 0 0 "
+                     "250 75 0 0 20 0 3 0 1000 0 0";
+  ASSERT_TRUE(ResourceSampler::parseStat(stat, 10000000ULL, s));
+  EXPECT_EQ(s.user_ns, 2500000000ULL);
+  EXPECT_EQ(s.system_ns, 750000000ULL);
+  EXPECT_FALSE(ResourceSampler::parseStat("42 (x) S 1", 10000000ULL, s));
+
+  const char *status = "Name:\tworker\nVmRSS:\t    2048 kB\n"
+                       "voluntary_ctxt_switches:\t7\n"
+                       "nonvoluntary_ctxt_switches:\t3\n";
+  ASSERT_TRUE(ResourceSampler::parseRss(status, s));
+  ASSERT_TRUE(ResourceSampler::parseStatus(status, s));
+  ASSERT_TRUE(ResourceSampler::parseStatus(status, s));
+  EXPECT_EQ(s.rss_bytes, 2048u * 1024);
+  EXPECT_EQ(s.voluntary, 14u) << "Summed over threads";
+  EXPECT_EQ(s.preempted, 6u);
+
+  ASSERT_TRUE(ResourceSampler::parseSchedstat("900 300 12\n", s));
+  EXPECT_EQ(s.wait_ns, 300u);
+
+  ASSERT_TRUE(ResourceSampler::parsePss("00400000-ff [rollup]\nRss: 9 kB\n"
+                                        "Pss:                 5 kB\n",
+                                        s));
+  EXPECT_EQ(s.pss_bytes, 5u * 1024);
+}
+
+/**
+ * @test AggregatesLiveSessionsPerRole
+ * @brief CPU burnt by a worker session shows up under "worker" only, and
+ * exited processes leave the gauges but not the counters.
+ */
+TEST_F(ResourceSamplerTest, AggregatesLiveSessionsPerRole) {
+  pid_t child = fork();
+  ASSERT_GE(child, 0);
+  if (child == 0) {
+    pause();
+    _exit(0);
+  }
+
+  addSession(0, "Worker_1", getpid());
+  addSession(5, "Truck_9", child);
+  addSession(7, "Truck_10", 0x3fffffff); // No such process.
+
+  ResourceSampler sampler(shm.get());
+  sampler.update(1000000000ULL);
+  uint64_t first = role(ProcessRole::Worker).cpu_user_ns +
+                   role(ProcessRole::Worker).cpu_system_ns;
+  burn(50);
+  sampler.update(2000000000ULL);
+
+  const RoleUsage &w = role(ProcessRole::Worker);
+  EXPECT_EQ(w.processes, 1);
+  EXPECT_GT(w.rss_bytes, 0u);
+  EXPECT_GE(w.cpu_user_ns + w.cpu_system_ns, first + 40000000ULL);
+  EXPECT_GT(w.cpu_cores, 0.03) << "50 ms of CPU in a 1 s interval";
+  EXPECT_GT(w.voluntary_switches + w.preempted_switches, 0u);
+  EXPECT_EQ(role(ProcessRole::Truck).processes, 1);
+  EXPECT_EQ(role(ProcessRole::Other).processes, 0);
+  EXPECT_EQ(shm->resources.samples, 2u);
+
+  kill(child, SIGKILL);
+  waitpid(child, nullptr, 0);
+  uint64_t worker_cpu = w.cpu_user_ns + w.cpu_system_ns;
+  sampler.update(3000000000ULL);
+  EXPECT_EQ(role(ProcessRole::Truck).processes, 0);
+  EXPECT_EQ(role(ProcessRole::Truck).rss_bytes, 0u);
+  EXPECT_GE(w.cpu_user_ns + w.cpu_system_ns, worker_cpu) << "Monotonic";
+
+  std::ostringstream out;
+  ResourceSampler::printReport(out, shm.get());
+  EXPECT_NE(out.str().find("worker"), std::string::npos) << out.str();
+  EXPECT_EQ(out.str().find("other"), std::string::npos) << out.str();
+
+  auto exporter = std::make_unique<MetricsExporter>(shm.get());
+  auto page = std::make_unique<char[]>(METRICS_BUFFER_SIZE);
+  size_t len = exporter->render(page.get(), METRICS_BUFFER_SIZE);
+  std::string text(page.get(), len);
+  EXPECT_NE(text.find("warehouse_role_processes{role=\"worker\"} 1"),
+            std::string::npos);
+  EXPECT_NE(text.find("warehouse_role_cpu_user_seconds_total{role=\"truck\"}"),
+            std::string::npos);
+}
@@ -0,0 +1,197 @@
+/**
+ * @file sorter_test.cpp
+ * @brief Tests for the sorter rules, the lane rings and lane-bound loading.
+ * * Rule and ring tests run on a zeroed SharedState with no-op callbacks; the
+ * end-to-end tests boot a Manager with `SORTER_RULE` set, like the
+ * Dispatcher integration tests.
+ */
+
+#include "../include/Manager.h"
+#include <cstdlib>
+#include <cstring>
+#include <gtest/gtest.h>
+
+namespace {
+
+Package makePackage(int id, PackageType type, double weight, double volume) {
+  Package p = {};
+  p.id = id;
+  p.type = type;
+  p.weight = weight;
+  p.volume = volume;
+  return p;
+}
+
+void noop() {}
+
+} // namespace
+
+/**
+ * @class SorterTest
+ * @brief Fixture clearing stale IPC resources and the rule variable.
+ */
+class SorterTest : public ::testing::Test {
+protected:
+  SharedState mock_shared_memory;
+
+  void SetUp() override {
+    std::memset(&mock_shared_memory, 0, sizeof(SharedState));
+    mock_shared_memory.running = true;
+
+    shmctl(shmget(SHM_KEY_ID, 0, 0), IPC_RMID, nullptr);
+    semctl(semget(SEM_KEY_ID, 0, 0), 0, IPC_RMID);
+    msgctl(msgget(MSG_KEY_ID, 0), IPC_RMID, nullptr);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  void TearDown() override { unsetenv("SORTER_RULE"); }
+};
+
+/**
+ * @test ParsesRules
+ */
+TEST_F(SorterTest, ParsesRules) {
+  SortRule rule = {};
+  ASSERT_TRUE(parseSortRule("type", rule));
+  EXPECT_EQ(rule.kind, SortKind::Type);
+  EXPECT_EQ(rule.lanes, 3);
+
+  ASSERT_TRUE(parseSortRule("weight:5,15.5", rule));
+  EXPECT_EQ(rule.kind, SortKind::Weight);
+  EXPECT_EQ(rule.lanes, 3);
+  EXPECT_DOUBLE_EQ(rule.bounds[1], 15.5);
+
+  ASSERT_TRUE(parseSortRule("volume:0.05", rule));
+  EXPECT_EQ(rule.kind, SortKind::Volume);
+  EXPECT_EQ(rule.lanes, 2);
+
+  const char *invalid[] = {"",          "size",      "weight:",
+                           "weight:5,2", "weight:-1", "weight:5x",
+                           "weight:1,2,3,4"};
+  for (const char *text : invalid) {
+    SortRule untouched = rule;
+    EXPECT_FALSE(parseSortRule(text, untouched)) << text;
+    EXPECT_EQ(untouched.lanes, rule.lanes) << text;
+  }
+}
+
+/**
+ * @test RoutesByRule
+ */
+TEST_F(SorterTest, RoutesByRule) {
+  SortRule type_rule, weight_rule;
+  ASSERT_TRUE(parseSortRule("type", type_rule));
+  ASSERT_TRUE(parseSortRule("weight:5,15", weight_rule));
+
+  EXPECT_EQ(routeLane(type_rule, makePackage(1, PackageType::TypeA, 1, 0)), 0);
+  EXPECT_EQ(routeLane(type_rule, makePackage(2, PackageType::TypeB, 1, 0)), 1);
+  EXPECT_EQ(routeLane(type_rule, makePackage(3, PackageType::TypeC, 1, 0)), 2);
+
+  Package light = makePackage(4, PackageType::TypeC, 4.9, 0);
+  Package bound = makePackage(5, PackageType::TypeA, 5.0, 0);
+  Package heavy = makePackage(6, PackageType::TypeA, 24, 0);
+  EXPECT_EQ(routeLane(weight_rule, light), 0);
+  EXPECT_EQ(routeLane(weight_rule, bound), 1) << "Bounds are exclusive";
+  EXPECT_EQ(routeLane(weight_rule, heavy), 2);
+}
+
+/**
+ * @test LaneRingIsFifo
+ * @brief The ring wraps around and keeps its weight in step.
+ */
+TEST_F(SorterTest, LaneRingIsFifo) {
+  Lane lane(&mock_shared_memory, 2, noop, noop, noop, noop, noop, noop);
+  LaneState &state = mock_shared_memory.lanes[2];
+
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 1; i <= LANE_CAPACITY; ++i)
+      ASSERT_TRUE(lane.push(makePackage(i, PackageType::TypeA, 1.5, 0.1)));
+    EXPECT_FALSE(lane.push(makePackage(99, PackageType::TypeA, 1.5, 0.1)))
+        << "A full ring refuses the package";
+    EXPECT_DOUBLE_EQ(state.weight, 1.5 * LANE_CAPACITY);
+
+    for (int i = 1; i <= LANE_CAPACITY; ++i)
+      EXPECT_EQ(lane.pop().id, i);
+    EXPECT_EQ(lane.pop().id, 0) << "An empty ring yields no package";
+  }
+  EXPECT_EQ(lane.getCount(), 0);
+  EXPECT_NEAR(state.weight, 0.0, 1e-9);
+  EXPECT_EQ(mock_shared_memory.lanes[1].count, 0) << "Lanes are independent";
+}
+
+/**
+ * @test ManagerBuildsLanesFromEnvironment
+ * @brief Without a rule nothing changes; with one, lanes and a sorter exist.
+ */
+TEST_F(SorterTest, ManagerBuildsLanesFromEnvironment) {
+  {
+    unsetenv("SORTER_RULE");
+    Manager m(true);
+    EXPECT_EQ(m.getState()->lane_count, 0);
+    EXPECT_EQ(m.sorter, nullptr);
+    EXPECT_EQ(dockCount(m.getState()), 1);
+    EXPECT_EQ(&dockAt(m.getState(), 0), &m.getState()->dock_truck);
+  }
+  SetUp();
+  {
+    setenv("SORTER_RULE", "weight:", 1);
+    Manager m(true);
+    EXPECT_EQ(m.getState()->lane_count, 0) << "Invalid rules are ignored";
+  }
+  SetUp();
+  {
+    setenv("SORTER_RULE", "volume:0.05", 1);
+    Manager m(true);
+    EXPECT_EQ(m.getState()->lane_count, 2);
+    EXPECT_EQ(m.lanes.size(), 2u);
+    ASSERT_NE(m.sorter, nullptr);
+    EXPECT_EQ(&dockAt(m.getState(), 1), &m.getState()->lanes[1].dock);
+  }
+}
+
+/**
+ * @test SortsAndLoadsPerLane
+ * @brief Belt -> Sorter -> lane ring -> lane Dispatcher -> lane dock.
+ * * Packages of every type go onto the belt; after sorting, the dispatcher
+ * bound to lane 2 loads only the Type C package, into lane 2's truck, and
+ * the single dock stays untouched.
+ */
+TEST_F(SorterTest, SortsAndLoadsPerLane) {
+  setenv("SORTER_RULE", "type", 1);
+  Manager m(true);
+  SharedState *shm = m.getState();
+  ASSERT_EQ(shm->lane_count, 3);
+
+  Package packages[] = {makePackage(1, PackageType::TypeA, 2.0, 0.02),
+                        makePackage(2, PackageType::TypeC, 20.0, 0.1),
+                        makePackage(3, PackageType::TypeB, 8.0, 0.05)};
+  for (Package &p : packages)
+    m.belt->push(p);
+  for (int i = 0; i < 3; ++i)
+    m.sorter->processNextPackage();
+
+  EXPECT_EQ(shm->current_items_count, 0);
+  EXPECT_EQ(shm->stats.packages_in_sorter, 0);
+  for (int l = 0; l < 3; ++l) {
+    EXPECT_EQ(shm->lanes[l].count, 1) << "lane " << l;
+    EXPECT_EQ(shm->lanes[l].routed, 1u) << "lane " << l;
+  }
+
+  TruckState &dock = shm->lanes[2].dock;
+  dock.is_present = true;
+  dock.id = 202;
+  dock.max_load = 10;
+  dock.max_weight = 100.0;
+  dock.max_volume = 10.0;
+
+  m.useLane(5);
+  m.dispatcher->processNextPackage();
+
+  EXPECT_EQ(dock.current_load, 1);
+  EXPECT_DOUBLE_EQ(dock.current_weight, 20.0);
+  EXPECT_EQ(shm->lanes[2].count, 0);
+  EXPECT_EQ(shm->lanes[2].loaded, 1u);
+  EXPECT_EQ(shm->lanes[0].count, 1) << "Other lanes are not drained";
+  EXPECT_EQ(shm->dock_truck.current_load, 0);
+  EXPECT_EQ(shm->stats.packages_loaded, 1u);
+}
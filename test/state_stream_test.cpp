@@ -0,0 +1,263 @@
+/**
+ * @file state_stream_test.cpp
+ * @brief Tests for the state-delta stream: framing, snapshot on join,
+ * deltas, backpressure and the socket service loop.
+ * * Subscribers are socketpairs handed to the publisher, so each test reads
+ * exactly the bytes a dashboard would.
+ */
+
+#include "../include/SessionManager.h"
+#include "../include/StateStream.h"
+#include <chrono>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+
+/**
+ * @class StateStreamTest
+ * @brief Fixture providing a zeroed SharedState and a publisher.
+ */
+class StateStreamTest : public ::testing::Test {
+protected:
+  std::unique_ptr<SharedState> shm = std::make_unique<SharedState>();
+  std::unique_ptr<StateStream> stream;
+
+  void SetUp() override {
+    std::memset(shm.get(), 0, sizeof(SharedState));
+    shm->running = true;
+    stream = std::make_unique<StateStream>(shm.get(), 1);
+  }
+
+  /** @brief Connects a subscriber; returns the dashboard's end. */
+  int subscribe() {
+    int sv[2];
+    EXPECT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv), 0);
+    stream->addSubscriber(sv[0]);
+    return sv[1];
+  }
+
+  /** @brief Feeds everything readable on `fd`; returns the frames applied. */
+  static int drain(int fd, StreamDecoder &decoder) {
+    char buf[4096];
+    int frames = 0;
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+      int applied = decoder.feed(buf, static_cast<size_t>(n));
+      EXPECT_GE(applied, 0);
+      frames += applied;
+    }
+    return frames;
+  }
+
+  void setBelt(int items, double kg) {
+    shm->current_items_count = items;
+    shm->current_belt_weight = kg;
+    bumpGeneration(shm.get(), StateRegion::Belt);
+  }
+};
+
+/**
+ * @test EncodesEveryRegion
+ * @brief Region frames decode to the shared state, also when the bytes
+ * arrive one at a time.
+ */
+TEST_F(StateStreamTest, EncodesEveryRegion) {
+  shm->current_items_count = 7;
+  shm->current_workers_count = 3;
+  shm->transit.in_transit = 2;
+  shm->total_packages_created = 123456;
+  shm->current_belt_weight = 81.25;
+  shm->lane_count = 2;
+  shm->lanes[1].dock = {};
+  shm->lanes[1].dock.is_present = true;
+  shm->lanes[1].dock.id = 4242;
+  shm->lanes[1].dock.current_load = 12;
+  shm->lanes[1].dock.max_load = 100;
+  shm->lanes[1].dock.current_weight = 350.5;
+  shm->lanes[1].dock.phase = DockPhase::DepartureRequested;
+  shm->trucks_completed = 9;
+  shm->trucks_waiting = 2;
+  shm->stats.packages_loaded = 1ULL << 40;
+  shm->stats.express_loaded = 17;
+  UserSession &u = shm->users[5];
+  u.active = true;
+  u.session_pid = 77;
+  u.role = UserRole::Operator;
+  u.current_processes = 2;
+  u.max_processes = 10;
+  std::strncpy(u.username, "dock-operator", sizeof(u.username) - 1);
+
+  std::vector<uint8_t> bytes;
+  uint8_t frame[STREAM_FRAME_MAX];
+  for (int r = 0; r < STATE_REGIONS; ++r) {
+    size_t n = stream->encodeRegion(static_cast<StateRegion>(r), 40 + r, frame);
+    bytes.insert(bytes.end(), frame, frame + n);
+  }
+
+  StreamDecoder decoder;
+  int frames = 0;
+  for (uint8_t b : bytes)
+    frames += decoder.feed(&b, 1);
+  ASSERT_EQ(frames, STATE_REGIONS);
+
+  const StreamView &v = decoder.view();
+  EXPECT_EQ(v.belt_items, 7);
+  EXPECT_EQ(v.belt_capacity, MAX_BELT_CAPACITY_K);
+  EXPECT_EQ(v.belt_in_transit, 2);
+  EXPECT_EQ(v.workers, 3);
+  EXPECT_EQ(v.packages_created, 123456u);
+  EXPECT_DOUBLE_EQ(v.belt_weight, 81.25);
+  ASSERT_EQ(v.docks, 2);
+  EXPECT_FALSE(v.dock[0].present);
+  EXPECT_TRUE(v.dock[1].present);
+  EXPECT_EQ(v.dock[1].truck, 4242);
+  EXPECT_EQ(v.dock[1].load, 12);
+  EXPECT_DOUBLE_EQ(v.dock[1].weight, 350.5);
+  EXPECT_EQ(v.dock[1].phase,
+            static_cast<uint8_t>(DockPhase::DepartureRequested));
+  EXPECT_EQ(v.trucks_completed, 9u);
+  EXPECT_EQ(v.trucks_waiting, 2u);
+  EXPECT_EQ(v.packages_loaded, 1ULL << 40);
+  EXPECT_EQ(v.express_loaded, 17u);
+  ASSERT_EQ(v.sessions, 1);
+  EXPECT_STREQ(v.session[0].name, "dock-operator");
+  EXPECT_EQ(v.session[0].pid, 77);
+  EXPECT_EQ(v.session[0].processes, 2);
+  EXPECT_EQ(v.session[0].max_processes, 10);
+  EXPECT_EQ(v.generation[static_cast<int>(StateRegion::Sessions)], 43u);
+}
+
+/**
+ * @test SendsSnapshotThenOnlyDeltas
+ * @brief A new subscriber gets Hello and every region; afterwards only
+ * regions whose generation moved are sent.
+ */
+TEST_F(StateStreamTest, SendsSnapshotThenOnlyDeltas) {
+  setBelt(4, 20.0);
+  int fd = subscribe();
+  StreamDecoder decoder;
+
+  stream->pump();
+  EXPECT_EQ(drain(fd, decoder), 1 + STATE_REGIONS);
+  EXPECT_EQ(decoder.view().received, (1u << STATE_REGIONS) - 1);
+  EXPECT_EQ(decoder.view().belt_items, 4);
+
+  stream->pump();
+  EXPECT_EQ(drain(fd, decoder), 0) << "Nothing changed";
+
+  setBelt(5, 25.0);
+  SessionManager sessions(shm.get(), []() {}, []() {});
+  ASSERT_TRUE(sessions.login("dashboard", UserRole::Operator, 1, 4));
+  stream->pump();
+  EXPECT_EQ(drain(fd, decoder), 2) << "Belt and Sessions only";
+  EXPECT_EQ(decoder.view().belt_items, 5);
+  ASSERT_EQ(decoder.view().sessions, 1);
+  EXPECT_STREQ(decoder.view().session[0].name, "dashboard");
+
+  int late = subscribe();
+  StreamDecoder late_decoder;
+  stream->pump();
+  EXPECT_EQ(drain(late, late_decoder), 1 + STATE_REGIONS);
+  EXPECT_EQ(drain(fd, decoder), 0) << "Snapshot only to the newcomer";
+  EXPECT_EQ(late_decoder.view().belt_items, 5);
+
+  sessions.logout();
+  close(fd);
+  close(late);
+}
+
+/**
+ * @test SlowSubscriberGetsLatestState
+ * @brief A subscriber that stops reading has frames held back instead of
+ * queued without bound, does not delay another subscriber, and converges
+ * to the latest state once it reads again.
+ */
+TEST_F(StateStreamTest, SlowSubscriberGetsLatestState) {
+  for (int i = 0; i < MAX_USERS_SESSIONS; ++i) {
+    shm->users[i].active = true;
+    std::snprintf(shm->users[i].username, sizeof(shm->users[i].username),
+                  "session-with-a-long-name-%03d", i);
+  }
+  int slow = subscribe();
+  int fast = subscribe();
+  StreamDecoder slow_decoder, fast_decoder;
+
+  for (int i = 1; i <= 400; ++i) {
+    setBelt(i % MAX_BELT_CAPACITY_K, i);
+    shm->users[0].current_processes = i;
+    bumpGeneration(shm.get(), StateRegion::Sessions);
+    stream->pump();
+    drain(fast, fast_decoder);
+    EXPECT_EQ(fast_decoder.view().session[0].processes, i);
+  }
+  EXPECT_GT(stream->framesDeferred(), 0u);
+  EXPECT_EQ(stream->subscribers(), 2);
+
+  for (int i = 0; i < 100; ++i) {
+    drain(slow, slow_decoder);
+    stream->pump();
+  }
+  drain(slow, slow_decoder);
+  const StreamView &v = slow_decoder.view();
+  EXPECT_EQ(v.session[0].processes, 400);
+  EXPECT_DOUBLE_EQ(v.belt_weight, 400.0);
+  EXPECT_EQ(v.generation[static_cast<int>(StateRegion::Belt)],
+            shm->generations[static_cast<int>(StateRegion::Belt)].value);
+  EXPECT_LT(v.frames, fast_decoder.view().frames) << "Generations skipped";
+
+  close(slow);
+  close(fast);
+}
+
+/**
+ * @test ServesSubscribersOverUnixSocket
+ * @brief The service loop accepts connections, streams a change within
+ * milliseconds and forgets subscribers that hang up.
+ */
+TEST_F(StateStreamTest, ServesSubscribersOverUnixSocket) {
+  std::string path =
+      "/tmp/warehouse_stream_test_" + std::to_string(getpid()) + ".sock";
+  ASSERT_TRUE(stream->listen(path));
+  std::atomic<bool> stop{false};
+  std::thread publisher([&]() { stream->run(stop); });
+
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_EQ(connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)),
+            0);
+
+  StreamDecoder decoder;
+  auto readUntil = [&](auto done) {
+    char buf[4096];
+    struct pollfd pfd = {fd, POLLIN, 0};
+    while (!done() && poll(&pfd, 1, 2000) == 1) {
+      ssize_t n = recv(fd, buf, sizeof(buf), 0);
+      if (n <= 0)
+        break;
+      decoder.feed(buf, static_cast<size_t>(n));
+    }
+    return done();
+  };
+  ASSERT_TRUE(readUntil([&]() {
+    return decoder.view().received == (1u << STATE_REGIONS) - 1;
+  }));
+
+  auto start = std::chrono::steady_clock::now();
+  setBelt(9, 99.0);
+  ASSERT_TRUE(readUntil([&]() { return decoder.view().belt_items == 9; }));
+  EXPECT_LT(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(500));
+
+  close(fd);
+  for (int i = 0; i < 200 && stream->subscribers() > 0; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  EXPECT_EQ(stream->subscribers(), 0);
+
+  stop.store(true);
+  publisher.join();
+  stream.reset();
+  EXPECT_NE(access(path.c_str(), F_OK), 0) << "Socket file removed";
+}
@@ -108,3 +108,20 @@ TEST_F(TerminalTest, PermissionDeniedForViewer) {
   runTestLoop(terminal);
   EXPECT_EQ(manager.receiveSignalNonBlocking(getpid()), SIGNAL_NONE);
 }
+
+TEST_F(TerminalTest, ChangesLogThrottling) {
+  mock_input << "log dispatcher rate=20 repeat=1000\nlog\nlog belt speed=3\n"
+                "exit\n";
+
+  TerminalManager terminal(&manager);
+  runTestLoop(terminal);
+
+  const LogPolicy &p = manager.getState()->log_policy[static_cast<int>(
+      LogSubsystem::Dispatcher)];
+  EXPECT_EQ(p.rate, 20u);
+  EXPECT_EQ(p.repeat_ms, 1000u);
+  std::string out = mock_output.str();
+  EXPECT_NE(out.find("Log throttling updated."), std::string::npos);
+  EXPECT_NE(out.find("dispatcher  1/1"), std::string::npos) << out;
+  EXPECT_NE(out.find("Usage: log"), std::string::npos) << "Unknown key";
+}
@@ -0,0 +1,189 @@
+/**
+ * @file time_series_sampler_test.cpp
+ * @brief Tests for the belt time-series sampler and its file format.
+ */
+
+#include "../include/TimeSeriesSampler.h"
+#include <cstdio>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+ * @class TimeSeriesSamplerTest
+ * @brief Fixture providing a zeroed SharedState and a scratch file.
+ */
+class TimeSeriesSamplerTest : public ::testing::Test {
+protected:
+  SharedState mock_shared_memory;
+  std::string path = "time_series_sampler_test.series";
+
+  void SetUp() override {
+    std::memset(&mock_shared_memory, 0, sizeof(SharedState));
+    mock_shared_memory.running = true;
+  }
+  void TearDown() override { std::remove(path.c_str()); }
+};
+
+/**
+ * @test ZigzagVarintRoundTrip
+ * @brief Small magnitudes of either sign encode in one byte.
+ */
+TEST_F(TimeSeriesSamplerTest, ZigzagVarintRoundTrip) {
+  const int64_t values[] = {0, 1, -1, 63, -64, 64, 300, -123456789,
+                            INT64_MAX, INT64_MIN};
+  uint8_t buf[16];
+  for (int64_t v : values) {
+    size_t n = putVarint(buf, zigzagEncode(v));
+    const uint8_t *p = buf;
+    uint64_t raw;
+    ASSERT_TRUE(getVarint(p, buf + n, raw));
+    EXPECT_EQ(zigzagDecode(raw), v);
+    EXPECT_EQ(p, buf + n);
+  }
+  EXPECT_EQ(putVarint(buf, zigzagEncode(-64)), 1u);
+  EXPECT_EQ(putVarint(buf, zigzagEncode(64)), 2u);
+}
+
+/**
+ * @test SnapshotReadsGauges
+ * @brief Weights and volumes are converted to integer units.
+ */
+TEST_F(TimeSeriesSamplerTest, SnapshotReadsGauges) {
+  SharedState &shm = mock_shared_memory;
+  shm.current_items_count = 7;
+  shm.current_belt_weight = 12.3456;
+  shm.current_workers_count = 3;
+  shm.trucks_waiting = 2;
+  shm.total_packages_created = 100;
+  shm.stats.packages_loaded = 80;
+  shm.trucks_completed = 4;
+  shm.dock_truck.is_present = true;
+  shm.dock_truck.current_load = 5;
+  shm.dock_truck.max_load = 10;
+  shm.dock_truck.current_weight = 30.0;
+  shm.dock_truck.max_weight = 40.0;
+  shm.dock_truck.current_volume = 0.25;
+  shm.dock_truck.max_volume = 1.0;
+
+  SeriesSample s = TimeSeriesSampler::snapshot(&shm);
+  EXPECT_EQ(s.values[SER_BELT_COUNT], 7);
+  EXPECT_EQ(s.values[SER_BELT_WEIGHT_G], 12346);
+  EXPECT_EQ(s.values[SER_WORKERS], 3);
+  EXPECT_EQ(s.values[SER_TRUCKS_QUEUED], 2);
+  EXPECT_EQ(s.values[SER_DOCK_LOAD], 5);
+  EXPECT_EQ(s.values[SER_DOCK_VOLUME_CM3], 250000);
+  EXPECT_EQ(s.values[SER_DOCK_FILL_PM], 750) << "Weight is the binding limit";
+  EXPECT_EQ(s.values[SER_LOADED], 80);
+  EXPECT_EQ(s.values[SER_DEPARTED], 4);
+
+  shm.dock_truck.is_present = false;
+  s = TimeSeriesSampler::snapshot(&shm);
+  EXPECT_EQ(s.values[SER_DOCK_WEIGHT_G], 0);
+  EXPECT_EQ(s.values[SER_DOCK_FILL_PM], 0);
+}
+
+/**
+ * @test RoundTripIsLossless
+ * @brief Decoded frames equal the recorded ones, including jittered clocks.
+ */
+TEST_F(TimeSeriesSamplerTest, RoundTripIsLossless) {
+  std::vector<SeriesSample> written;
+  uint64_t interval;
+  {
+    TimeSeriesSampler sampler(&mock_shared_memory, path, 1000);
+    ASSERT_TRUE(sampler.isOpen());
+    interval = sampler.intervalNs();
+    EXPECT_EQ(interval, 1000000u);
+
+    SeriesSample s = TimeSeriesSampler::snapshot(&mock_shared_memory);
+    for (int i = 0; i < 5000; ++i) {
+      s.timestamp_ns += interval + (i % 7) * 1000 - 3000;
+      for (int c = 0; c < SERIES_CHANNELS; ++c)
+        s.values[c] += (i * (c + 1)) % 5 - 2;
+      s.values[SER_CREATED] = 1000000LL * i;
+      sampler.record(s);
+      written.push_back(s);
+    }
+    EXPECT_EQ(sampler.samples(), 5000u);
+  }
+
+  SeriesReader reader(path);
+  ASSERT_TRUE(reader.valid());
+  EXPECT_EQ(reader.header().interval_ns, interval);
+
+  size_t i = 0;
+  uint64_t n = reader.forEach([&](const SeriesSample &s) {
+    ASSERT_LT(i, written.size());
+    EXPECT_EQ(s.timestamp_ns, written[i].timestamp_ns);
+    EXPECT_EQ(std::memcmp(s.values, written[i].values, sizeof(s.values)), 0);
+    i++;
+  });
+  EXPECT_EQ(n, 5000u);
+  EXPECT_LT(reader.payloadBytes() / n, 2u * (SERIES_CHANNELS + 1))
+      << "Small deltas should stay well under 16 bytes per value";
+}
+
+/**
+ * @test TruncatedTailIsIgnored
+ * @brief A partial last frame is dropped, earlier frames still decode.
+ */
+TEST_F(TimeSeriesSamplerTest, TruncatedTailIsIgnored) {
+  {
+    TimeSeriesSampler sampler(&mock_shared_memory, path, 10);
+    for (int i = 0; i < 3; ++i) {
+      mock_shared_memory.total_packages_created = 1000 * i;
+      sampler.record(TimeSeriesSampler::snapshot(&mock_shared_memory));
+    }
+  }
+  FILE *f = std::fopen(path.c_str(), "a");
+  std::fputc(0x80, f);
+  std::fclose(f);
+
+  SeriesReader reader(path);
+  std::vector<int64_t> created;
+  EXPECT_EQ(reader.forEach([&](const SeriesSample &s) {
+    created.push_back(s.values[SER_CREATED]);
+  }),
+            3u);
+  EXPECT_EQ(created, (std::vector<int64_t>{0, 1000, 2000}));
+  EXPECT_FALSE(SeriesReader("does_not_exist.series").valid());
+}
+
+/**
+ * @test RunPacesAndExportsCsv
+ * @brief The sampling thread honours its rate; CSV has one row per sample.
+ */
+TEST_F(TimeSeriesSamplerTest, RunPacesAndExportsCsv) {
+  auto sampler =
+      std::make_unique<TimeSeriesSampler>(&mock_shared_memory, path, 1000);
+  std::atomic<bool> stop{false};
+  std::thread t([&]() { sampler->run(stop); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  stop.store(true);
+  t.join();
+
+  uint64_t taken = sampler->samples();
+  EXPECT_GE(taken + sampler->missed(), 100u);
+  EXPECT_LE(taken, 260u);
+  sampler.reset();
+
+  SeriesReader reader(path);
+  std::string csv_path = path + ".csv";
+  FILE *out = std::fopen(csv_path.c_str(), "w");
+  EXPECT_EQ(reader.exportCsv(out), taken);
+  std::fclose(out);
+
+  FILE *in = std::fopen(csv_path.c_str(), "r");
+  char line[1024];
+  ASSERT_NE(std::fgets(line, sizeof(line), in), nullptr);
+  EXPECT_EQ(std::strncmp(line, "time_s,belt_count,", 18), 0);
+  uint64_t rows = 0;
+  while (std::fgets(line, sizeof(line), in))
+    rows++;
+  std::fclose(in);
+  std::remove(csv_path.c_str());
+  EXPECT_EQ(rows, taken);
+}
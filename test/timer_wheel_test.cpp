@@ -0,0 +1,126 @@
+/**
+ * @file timer_wheel_test.cpp
+ * @brief Tests for the shared-memory hierarchical timer wheel.
+ */
+
+#include "../include/TimerWheel.h"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+/** @brief Heap-allocated, zero-filled wheel (the state shared memory has). */
+template <int N> std::unique_ptr<TimerWheel<N>> makeWheel() {
+  std::unique_ptr<TimerWheel<N>> wheel(new TimerWheel<N>);
+  std::memset(wheel.get(), 0, sizeof(TimerWheel<N>));
+  return wheel;
+}
+
+} // namespace
+
+/**
+ * @test FiresExactlyAtExpiry
+ * @brief Timers on every level fire at their tick, not before or after.
+ */
+TEST(TimerWheelTest, FiresExactlyAtExpiry) {
+  auto wheel = makeWheel<16>();
+  const uint64_t start = 1000;
+  const uint64_t delays[] = {0, 1, 63, 64, 65, 4095, 4096, 300000, 5000000};
+
+  for (uint32_t i = 0; i < sizeof(delays) / sizeof(delays[0]); ++i)
+    ASSERT_TRUE(wheel->schedule(start, start + delays[i], i));
+  EXPECT_EQ(wheel->size(), 9);
+
+  std::vector<uint64_t> fired_at(9, 0);
+  for (uint64_t tick = start; tick <= start + 5000000; ++tick) {
+    wheel->advance(tick, [&](uint32_t i) { fired_at[i] = tick; });
+  }
+  for (uint32_t i = 0; i < 9; ++i)
+    EXPECT_EQ(fired_at[i], start + delays[i]) << "delay " << delays[i];
+  EXPECT_EQ(wheel->size(), 0);
+}
+
+/**
+ * @test CatchesUpAfterLongGap
+ * @brief One advance over many ticks fires everything due, nothing later.
+ */
+TEST(TimerWheelTest, CatchesUpAfterLongGap) {
+  auto wheel = makeWheel<8>();
+  ASSERT_TRUE(wheel->schedule(0, 10, 1));
+  ASSERT_TRUE(wheel->schedule(0, 5000, 2));
+  ASSERT_TRUE(wheel->schedule(0, 9000, 3));
+
+  std::vector<uint32_t> fired;
+  EXPECT_EQ(wheel->advance(8999, [&](uint32_t p) { fired.push_back(p); }), 2);
+  EXPECT_EQ(fired, (std::vector<uint32_t>{1, 2}));
+  EXPECT_EQ(wheel->advance(9000, [&](uint32_t p) { fired.push_back(p); }), 1);
+  EXPECT_EQ(wheel->size(), 0);
+}
+
+/**
+ * @test CapacityAndReuse
+ * @brief A full wheel refuses timers; fired nodes are reused.
+ */
+TEST(TimerWheelTest, CapacityAndReuse) {
+  auto wheel = makeWheel<4>();
+  for (uint32_t i = 0; i < 4; ++i)
+    ASSERT_TRUE(wheel->schedule(0, 100 + i, i));
+  EXPECT_FALSE(wheel->schedule(0, 200, 9));
+
+  EXPECT_EQ(wheel->advance(101, [](uint32_t) {}), 2);
+  EXPECT_TRUE(wheel->schedule(101, 150, 7));
+  EXPECT_TRUE(wheel->schedule(101, 150, 8));
+  EXPECT_FALSE(wheel->schedule(101, 150, 9));
+  EXPECT_EQ(wheel->used, 4u) << "Freed nodes are recycled";
+}
+
+/**
+ * @test IdleWheelFastForwards
+ * @brief An empty wheel jumps to the present instead of walking every tick.
+ */
+TEST(TimerWheelTest, IdleWheelFastForwards) {
+  auto wheel = makeWheel<4>();
+  EXPECT_EQ(wheel->advance(uint64_t{1} << 40, [](uint32_t) {}), 0);
+  EXPECT_EQ(wheel->current, (uint64_t{1} << 40) + 1);
+
+  uint64_t now = uint64_t{1} << 41;
+  ASSERT_TRUE(wheel->schedule(now, now + 3, 5));
+  uint32_t got = 0;
+  EXPECT_EQ(wheel->advance(now + 2, [&](uint32_t p) { got = p; }), 0);
+  EXPECT_EQ(wheel->advance(now + 3, [&](uint32_t p) { got = p; }), 1);
+  EXPECT_EQ(got, 5u);
+}
+
+/**
+ * @test ScalesToTensOfThousands
+ * @brief 50k timers with random delays each fire once, on time.
+ */
+TEST(TimerWheelTest, ScalesToTensOfThousands) {
+  constexpr int N = 50000;
+  auto wheel = makeWheel<N>();
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<uint64_t> delay(0, 200000);
+
+  std::vector<uint64_t> expires(N);
+  uint64_t now = 123456789;
+  for (int i = 0; i < N; ++i) {
+    expires[i] = now + delay(gen);
+    ASSERT_TRUE(wheel->schedule(now, expires[i], i));
+  }
+
+  int fired = 0, late = 0;
+  for (uint64_t t = now; t <= now + 200000; t += 7) {
+    fired += wheel->advance(t, [&](uint32_t i) {
+      if (expires[i] > t || expires[i] + 7 <= t)
+        late++;
+      expires[i] = 0;
+    });
+  }
+  fired += wheel->advance(now + 200000, [](uint32_t) {});
+  EXPECT_EQ(fired, N);
+  EXPECT_EQ(late, 0);
+  EXPECT_EQ(wheel->size(), 0);
+}
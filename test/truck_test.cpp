@@ -98,3 +98,82 @@ TEST_F(TruckTest, InitializesTruckDataInSharedMemory) {
   EXPECT_NE(mock_shared_memory.dock_truck.id, 0);
   EXPECT_GT(mock_shared_memory.dock_truck.max_load, 0);
 }
+
+/**
+ * @class TruckDepartureTest
+ * @brief Truck fixture whose signal source behaves like the real senders:
+ * every DEPARTURE is preceded by its `requestDeparture`, and messages left
+ * in the queue can be drained without blocking.
+ */
+class TruckDepartureTest : public TruckTest {
+protected:
+  std::queue<SignalType> leftover; /**< Messages queued before docking. */
+
+  std::function<SignalType(pid_t)> requesting_wait = [this](pid_t pid) {
+    SignalType s = mock_wait(pid);
+    if (s == SIGNAL_DEPARTURE)
+      requestDeparture(mock_shared_memory.dock_truck, DepartureReason::Full);
+    return s;
+  };
+
+  std::function<SignalType(pid_t)> drain = [this](pid_t) {
+    if (leftover.empty())
+      return SIGNAL_NONE;
+    SignalType s = leftover.front();
+    leftover.pop();
+    return s;
+  };
+};
+
+/**
+ * @test StaleMessagesAreDroppedBeforeDocking
+ * @brief A DEPARTURE left from an earlier visit does not send the truck away
+ * empty: it is drained and counted, and the requested one is honoured.
+ */
+TEST_F(TruckDepartureTest, StaleMessagesAreDroppedBeforeDocking) {
+  leftover.push(SIGNAL_DEPARTURE);
+  signal_scenario.push(SIGNAL_DEPARTURE);
+  signal_scenario.push(SIGNAL_END_WORK);
+
+  Truck truck(&mock_shared_memory, mock_lock, mock_unlock, requesting_wait);
+  truck.setSignalDrain(drain);
+  truck.setRouteTime(0, 0);
+  truck.run();
+
+  EXPECT_TRUE(leftover.empty());
+  EXPECT_EQ(mock_shared_memory.stats.departures_stale, 1u);
+  EXPECT_EQ(mock_shared_memory.trucks_completed, 1);
+}
+
+/**
+ * @test DepartureWalksThePhases
+ * @brief Docked -> DepartureRequested (once) -> Departing -> Docked again
+ * for the next visit.
+ */
+TEST_F(TruckDepartureTest, DepartureWalksThePhases) {
+  TruckState &dock = mock_shared_memory.dock_truck;
+  DockPhase seen = DockPhase::Docked;
+  DepartureReason reason = DepartureReason::Unknown;
+  bool second_request = true;
+
+  Truck truck(&mock_shared_memory, mock_lock, mock_unlock, [&](pid_t) {
+    if (mock_shared_memory.trucks_completed > 0)
+      return SIGNAL_END_WORK;
+    EXPECT_EQ(dock.phase, DockPhase::Docked);
+    EXPECT_TRUE(requestDeparture(dock, DepartureReason::NoFit));
+    second_request = requestDeparture(dock, DepartureReason::Forced);
+    seen = dock.phase;
+    reason = dock.departure_reason;
+    return SIGNAL_DEPARTURE;
+  });
+  truck.setRouteTime(0, 0);
+  truck.run();
+
+  EXPECT_EQ(seen, DockPhase::DepartureRequested);
+  EXPECT_FALSE(second_request);
+  EXPECT_EQ(reason, DepartureReason::NoFit) << "The first reason is kept";
+  EXPECT_EQ(dock.phase, DockPhase::Docked) << "Reset for the next visit";
+  EXPECT_EQ(mock_shared_memory.trucks_completed, 1);
+  EXPECT_EQ(mock_shared_memory.stats.departures_empty, 1u)
+      << "Nothing was loaded in this visit";
+}
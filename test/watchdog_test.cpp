@@ -0,0 +1,183 @@
+/**
+ * @file watchdog_test.cpp
+ * @brief Tests for heartbeats, lock-holder tracking and the stall watchdog.
+ * * The watchdog runs on a zeroed SharedState with a synthetic clock; the
+ * lock tracking test goes through a real Manager and its semaphores.
+ */
+
+#include "../include/Manager.h"
+#include "../include/Watchdog.h"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <sys/wait.h>
+#include <vector>
+
+/**
+ * @class WatchdogTest
+ * @brief Fixture providing a zeroed SharedState and a recording release.
+ */
+class WatchdogTest : public ::testing::Test {
+protected:
+  std::unique_ptr<SharedState> shm = std::make_unique<SharedState>();
+  std::vector<SemIndex> released;
+
+  static constexpr uint64_t SEC = 1000000000ULL;
+
+  void SetUp() override { std::memset(shm.get(), 0, sizeof(SharedState)); }
+
+  void addSession(int slot, const char *name, pid_t pid) {
+    UserSession &u = shm->users[slot];
+    u.active = true;
+    std::strncpy(u.username, name, sizeof(u.username) - 1);
+    u.session_pid = pid;
+  }
+
+  std::unique_ptr<Watchdog> makeWatchdog(bool recover) {
+    return std::make_unique<Watchdog>(
+        shm.get(), 5000, [this](SemIndex s) { released.push_back(s); },
+        recover);
+  }
+};
+
+/**
+ * @test FlagsOnlyProcessesWithoutProgress
+ * @brief A process is stalled once its beats stop for the threshold, unless
+ * it is parked, waits on a counting semaphore or never beat at all.
+ */
+TEST_F(WatchdogTest, FlagsOnlyProcessesWithoutProgress) {
+  addSession(0, "System-Dispatcher", getpid());
+  addSession(1, "Truck_1", getpid());
+  addSession(2, "Worker_1", getpid());
+  addSession(3, "System-Express", getpid());
+  addSession(4, "AdminConsole", getpid());
+  for (int i = 0; i < 4; ++i)
+    heartbeat(&shm->health[i]);
+  HealthParkScope on_route(&shm->health[1]);
+  shm->health[2].waiting = SEM_EMPTY_SLOTS + 1;
+
+  auto wd = makeWatchdog(false);
+  EXPECT_EQ(wd->check(1 * SEC), 0);
+  heartbeat(&shm->health[3]);
+  EXPECT_EQ(wd->check(4 * SEC), 0);
+  heartbeat(&shm->health[3]);
+  EXPECT_EQ(wd->check(7 * SEC), 1) << "Only the dispatcher";
+  EXPECT_EQ(shm->health[0].stalled, 1);
+  EXPECT_EQ(shm->health[3].stalled, 0);
+  EXPECT_EQ(shm->watchdog.stalls, 1u);
+
+  EXPECT_EQ(wd->check(8 * SEC), 1);
+  EXPECT_EQ(shm->watchdog.stalls, 1u) << "Reported once per stall";
+
+  heartbeat(&shm->health[0]);
+  EXPECT_EQ(wd->check(9 * SEC), 0);
+  EXPECT_EQ(shm->health[0].stalled, 0);
+  EXPECT_EQ(shm->watchdog.stalled, 0);
+  EXPECT_EQ(shm->watchdog.passes, 5u);
+}
+
+/**
+ * @test DescribesHoldersAndDeadlocks
+ * @brief The wait-for graph names holders and reports a cycle once.
+ */
+TEST_F(WatchdogTest, DescribesHoldersAndDeadlocks) {
+  addSession(0, "System-Dispatcher", 100);
+  addSession(1, "Truck_1", 200);
+  addSession(2, "Worker_1", 300);
+  shm->health[0].held = 1u << SEM_DOCK_MUTEX;
+  shm->health[0].waiting = SEM_MUTEX_BELT + 1;
+  shm->health[1].held = 1u << SEM_MUTEX_BELT;
+  shm->health[1].waiting = SEM_DOCK_MUTEX + 1;
+  shm->health[2].waiting = SEM_MUTEX_BELT + 1;
+
+  std::ostringstream out;
+  Watchdog::describe(out, shm.get(), 0);
+  std::string text = out.str();
+  EXPECT_NE(text.find("holds: dock_mutex  waits: belt_mutex"),
+            std::string::npos)
+      << text;
+  EXPECT_NE(text.find("-> 200"), std::string::npos) << text;
+  EXPECT_NE(text.find("DEADLOCK: 100 -> 200 -> 100"), std::string::npos)
+      << text;
+  EXPECT_EQ(text.find("DEADLOCK: 200"), std::string::npos) << "Once";
+  EXPECT_EQ(text.find("DEADLOCK: 300"), std::string::npos) << "Not in it";
+}
+
+/**
+ * @test ReleasesMutexesOfDeadHolders
+ * @brief With recovery, mutexes left by an exited process are posted back.
+ */
+TEST_F(WatchdogTest, ReleasesMutexesOfDeadHolders) {
+  pid_t child = fork();
+  ASSERT_GE(child, 0);
+  if (child == 0)
+    _exit(0);
+  waitpid(child, nullptr, 0);
+
+  addSession(0, "Worker_1", child);
+  shm->health[0].held = (1u << SEM_MUTEX_BELT) | (1u << SEM_DOCK_MUTEX);
+
+  makeWatchdog(false)->check(1 * SEC);
+  EXPECT_TRUE(released.empty()) << "Report only without recovery";
+
+  makeWatchdog(true)->check(1 * SEC);
+  EXPECT_EQ(released,
+            (std::vector<SemIndex>{SEM_MUTEX_BELT, SEM_DOCK_MUTEX}));
+  EXPECT_EQ(shm->health[0].held, 0u);
+  EXPECT_EQ(shm->watchdog.recoveries, 2u);
+}
+
+/**
+ * @class WatchdogIpcTest
+ * @brief Fixture clearing the System V resources around each test.
+ */
+class WatchdogIpcTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    shmctl(shmget(SHM_KEY_ID, 0, 0666), IPC_RMID, nullptr);
+    semctl(semget(SEM_KEY_ID, 0, 0666), 0, IPC_RMID);
+    msgctl(msgget(MSG_KEY_ID, 0666), IPC_RMID, nullptr);
+  }
+
+  void TearDown() override { SetUp(); }
+};
+
+/**
+ * @test ManagerTracksHeldMutexes
+ * @brief The session's health shows the mutexes held between P and V, and
+ * the beats of the process.
+ */
+TEST_F(WatchdogIpcTest, ManagerTracksHeldMutexes) {
+  Manager manager(true);
+  EXPECT_EQ(manager.processHealth(), nullptr) << "No session yet";
+  manager.lockDock();
+  manager.unlockDock();
+
+  ASSERT_TRUE(manager.session_store->login("System-Dispatcher",
+                                           UserRole::Operator, 0, 1));
+  ProcessHealth *h = manager.processHealth();
+  ASSERT_NE(h, nullptr);
+  EXPECT_EQ(h, &manager.getState()->health[0]);
+
+  manager.lockDock();
+  manager.lockBelt();
+  EXPECT_EQ(h->held, (1u << SEM_DOCK_MUTEX) | (1u << SEM_MUTEX_BELT));
+  manager.unlockBelt();
+  EXPECT_EQ(h->held, 1u << SEM_DOCK_MUTEX);
+  manager.unlockDock();
+  EXPECT_EQ(h->held, 0u);
+
+  manager.signalPackageAdded();
+  manager.waitForPackage();
+  EXPECT_EQ(h->held, 0u) << "Counting semaphores are not held";
+  EXPECT_EQ(h->waiting, 0);
+
+  manager.heartbeat();
+  manager.heartbeat();
+  EXPECT_EQ(h->beats, 2u);
+
+  manager.session_store->logout();
+  EXPECT_EQ(manager.processHealth(), nullptr);
+  EXPECT_EQ(h->held, 0u) << "The registry lock is released after logout";
+}